@@ -6,6 +6,9 @@
 #include "net_api.h"
 #include "sys_plat.h"
 
+#define UDP_ECHO_BATCH 16      // 每次批量收发的数据报数量
+#define UDP_ECHO_BUF_SIZE 128  // 每个数据报的缓冲区大小
+
 void udp_echo_server_run(void *arg) {
   int port = (int)arg;
 
@@ -36,21 +39,30 @@ void udp_echo_server_run(void *arg) {
     goto client_end;
   }
 
-  char buf[128];
-  plat_memset(buf, 0, sizeof(buf));
-  struct sockaddr_in from_addr;
-  int from_len = sizeof(from_addr);
-  int len = 0;
-  while ((len = recvfrom(server_socket, buf, sizeof(buf), 0,
-                         (struct sockaddr *)&from_addr, &from_len)) > 0) {
-    ret = sendto(server_socket, buf, len, 0, (struct sockaddr *)&from_addr,
-                 from_len);
-    if (ret < 0) {
+  // 批量接收已到达的数据报, 并原样批量发回给各自的发送方
+  char buf[UDP_ECHO_BATCH][UDP_ECHO_BUF_SIZE];
+  struct sockaddr_in from_addr[UDP_ECHO_BATCH];
+  struct mmsghdr msgs[UDP_ECHO_BATCH];
+  int cnt = 0;
+  while (1) {
+    for (int i = 0; i < UDP_ECHO_BATCH; i++) {
+      msgs[i].msg_buf = buf[i];
+      msgs[i].msg_buflen = sizeof(buf[i]);
+      msgs[i].msg_name = (struct sockaddr *)&from_addr[i];
+      msgs[i].msg_namelen = sizeof(from_addr[i]);
+    }
+    if ((cnt = recvmmsg(server_socket, msgs, UDP_ECHO_BATCH, 0)) <= 0) {
+      break;
+    }
+
+    for (int i = 0; i < cnt; i++) {
+      msgs[i].msg_buflen = msgs[i].msg_len;
+    }
+    ret = sendmmsg(server_socket, msgs, cnt, 0);
+    if (ret < cnt) {
       plat_printf("udp server sendto error\n");
       goto client_end;
     }
-
-    plat_memset(buf, 0, sizeof(buf));
   }
 
   close(server_socket);
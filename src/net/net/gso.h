@@ -0,0 +1,23 @@
+/**
+ * @file gso.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 分段卸载(GSO)模块
+ * @version 0.1
+ * @date 2024-11-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef GSO_H
+#define GSO_H
+
+#include "ipaddr.h"
+#include "net_err.h"
+#include "netif.h"
+#include "pktbuf.h"
+
+int gso_offload(netif_t *netif, pktbuf_t *buf);
+net_err_t gso_segment(netif_t *netif, const ipaddr_t *ipaddr, pktbuf_t *buf);
+
+#endif  // GSO_H
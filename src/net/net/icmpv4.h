@@ -33,6 +33,12 @@ typedef struct _icmpv4_hdr_t {
     // 其他类型的icmpv4报文对该4字节的使用不同
     // TODO: 本地未对其进行读写，暂时忽略其字节序
     uint32_t reserve;
+
+    // 需要分片的不可达报文(RFC 1191): 16位未使用 + 16位下一跳网络的mtu
+    struct {
+      uint16_t unused;
+      uint16_t next_mtu;
+    } frag;
   };
 } icmpv4_hdr_t;
 
@@ -57,6 +63,7 @@ typedef enum _icmpv4_type_t {
 typedef enum _icmpv4_code_t {
   ICMPv4_CODE_ECHO = 0,
   ICMPv4_CODE_UNREACH_PORT = 3,
+  ICMPv4_CODE_UNREACH_FRAG = 4,  // 需要分片但设置了禁止分片标志
 } icmpv4_code_t;
 
 net_err_t icmpv4_module_init(void);
@@ -21,6 +21,12 @@
 #define IPV4_ADDR_SIZE 4  // ipv4地址长度
 #define IPV4_VERSION 4    // ipv4版本号
 
+// 定义ecn字段的码点(RFC 3168)
+#define IPV4_ECN_NOT_ECT 0  // 传输层不支持ECN
+#define IPV4_ECN_ECT1 1     // 传输层支持ECN, ECT(1)
+#define IPV4_ECN_ECT0 2     // 传输层支持ECN, ECT(0)
+#define IPV4_ECN_CE 3       // 途经的路由器发生了拥塞(Congestion Experienced)
+
 #pragma pack(1)
 
 //!!! 小端模式下结构体位域的存储顺序是从低位到高位，而大端模式下是从高位到低位(寄存器中的位序)
@@ -118,12 +124,23 @@ typedef struct _ipv4_frag_t {
   nlist_t buf_list;   // 用于记录分片数据包的链表
 } ipv4_frag_t;
 
+// 定义路径mtu缓存表项结构, 记录通过icmp"需要分片"报文得知的到达目的主机的路径mtu
+typedef struct _ipv4_pmtu_t {
+  nlist_node_t node;  // 用于挂载到全局路径mtu链表的节点, 最近更新的表项位于表头
+  ipaddr_t dest_ip;   // 目的主机ip地址
+  int mtu;            // 路径mtu
+  int tmo;            // 有效周期数 = 有效时间(s) / 扫描周期所用时间(s)
+} ipv4_pmtu_t;
+
 net_err_t ipv4_module_init(void);
 
 net_err_t ipv4_recv(const netif_t *netif, pktbuf_t *buf);
 net_err_t ipv4_send(uint8_t tran_protocol, const ipaddr_t *dest_ipaddr,
                     const ipaddr_t *src_ipaddr, pktbuf_t *buf);
 
+int ipv4_pmtu_get(const ipaddr_t *dest_ip, int mtu);
+void ipv4_pmtu_update(const ipaddr_t *dest_ip, int mtu);
+
 /**
  * @brief 获取数据包头部大小
  *
@@ -58,6 +58,16 @@ const char *net_inet_ntop(int family, const void *addrptr, char *strptr,
 #undef recvfrom
 #define recvfrom(sock, buf, buf_len, flags, src, src_len) \
   net_recvfrom(sock, buf, buf_len, flags, src, src_len)
+#undef mmsghdr
+#define mmsghdr net_mmsghdr
+#undef sendmmsg
+#define sendmmsg(sock, msgvec, vlen, flags) net_sendmmsg(sock, msgvec, vlen, flags)
+#undef recvmmsg
+#define recvmmsg(sock, msgvec, vlen, flags) net_recvmmsg(sock, msgvec, vlen, flags)
+#undef msghdr
+#define msghdr net_msghdr
+#undef recvmsg
+#define recvmsg(sock, msg, flags) net_recvmsg(sock, msg, flags)
 #undef close
 #define close(sock) net_close(sock)
 #undef connect
@@ -68,8 +78,15 @@ const char *net_inet_ntop(int family, const void *addrptr, char *strptr,
 #define recv(sock, buf, buf_len, flags) net_recv(sock, buf, buf_len, flags)
 #undef bind
 #define bind(sock, addr, addrlen) net_bind(sock, addr, addrlen)
+#undef listen
+#define listen(sock, backlog) net_listen(sock, backlog)
+#undef accept
+#define accept(sock, addr, addrlen) net_accept(sock, addr, addrlen)
 #undef setsockopt
 #define setsockopt(sock, level, optname, optval, optlen) \
   net_setsockopt(sock, level, optname, optval, optlen)
+#undef getsockopt
+#define getsockopt(sock, level, optname, optval, optlen) \
+  net_getsockopt(sock, level, optname, optval, optlen)
 
 #endif  // NET_API_H
\ No newline at end of file
@@ -54,8 +54,9 @@
 // 数据包相关配置
 #define PKTBUF_LOCKER_TYPE NLOCKER_THREAD  // 数据包模块锁类型
 #define PKTBUF_BLK_SIZE 128                // 数据包有效载荷大小
-#define PKTBUF_BLK_CNT 128                 // 数据块池中的数据块数量
-#define PKTBUF_BUF_CNT 128                 // 数据包池中的数据包数量
+#define PKTBUF_BLK_CNT 1024                // 数据块池中的数据块数量(tcp接收队列直接缓存数据包, 需容纳各连接未读取的数据)
+#define PKTBUF_BUF_CNT \
+  (PKTBUF_BLK_CNT * PKTBUF_BLK_SIZE / TCP_RCVQ_COPYBREAK)  // 数据包池中的数据包数量, tcp接收队列每个不小于TCP_RCVQ_COPYBREAK的数据段占用一个数据包, 数据块用完前不会先耗尽数据包
 
 // 网络接口相关配置
 #define NETIF_HWADDR_SIZE 10   // 网络接口硬件地址长度
@@ -63,6 +64,8 @@
 #define NETIF_RECV_BUFSIZE 50  // 网络接口接收缓冲区大小
 #define NETIF_SEND_BUFSIZE 50  // 网络接口发送缓冲区大小
 #define NETIF_MAX_CNT 10       // 网络接口最大数量
+#define NETIF_LOOP_MTU 1500    // 环回接口最大传输单元
+#define NETIF_LOOP_TSO 1       // 环回接口是否支持tcp分段卸载(直接传递超级数据段)
 
 // ARP模块相关配置
 #define ARP_CACHE_TBL_CNT 50  // arp缓存表大小
@@ -81,6 +84,13 @@
 #define IPV4_FRAG_SCAN_PERIOD 1  // ipv4分片缓存表的扫描周期(s)
 #define IPV4_FRAG_TMO \
   (10 * IPV4_FRAG_SCAN_PERIOD)  // ipv4分片缓存表项的超时时间(s)
+#define IPV4_PMTU_DISC_ENABLE 1  // 是否进行路径mtu发现(RFC 1191), tcp报文段设置禁止分片标志
+#define IPV4_PMTU_MAXCNT 16      // 路径mtu缓存表大小
+#define IPV4_PMTU_MIN 576        // 接受的最小路径mtu, 防止伪造的icmp报文将路径mtu降得过小
+#define IPV4_PMTU_SCAN_PERIOD 10  // 路径mtu缓存表的扫描周期(s)
+#define IPV4_PMTU_TMO \
+  (60 * IPV4_PMTU_SCAN_PERIOD)  // 路径mtu缓存表项的有效时间(s), 超时后重新使用网络接口的mtu(RFC 1191建议10分钟)
+#define IPV4_ECN_MARK_QLEN 0  // 转发时网络接口发送队列积压到该数量时为支持ECN的数据包标记CE, 0表示不标记(主机不应标记自己发出的报文)
 
 // ROUTE(路由)模块相关配置
 #define ROUTE_ENTRY_MAXCNT 20  // 路由表大小
@@ -92,14 +102,59 @@
 // udp模块相关配置
 #define UDP_MAXCNT 10  // udp socket对象表大小
 #define UDP_RECV_MAXCNT 128  // udp接收缓冲区链表最大长度
+#define UDP_PORT_HASH_SIZE 16  // udp对象(按本地端口)哈希表的桶数量, 必须为2的幂
+#define UDP_GSO_MAX_SEGS (NETIF_SEND_BUFSIZE / 2)  // 分段发送(UDP_SEGMENT)时一次发送可切分的最大数据报数量, 不超过发送队列容量的一半, 为其他数据包留出空间
+#define UDP_MAX_PAYLOAD 65507  // udp数据报的最大数据量, 也是接收合并(UDP_GRO)后的数据量上限
 
 // tcp模块相关配置
-#define TCP_MAXCNT 10  // tcp socket对象表大小
+#define TCP_MAXCNT 10240  // tcp socket对象表大小(控制块不含缓冲区, 空闲连接只占用控制块)
 #define TCP_SBUF_SIZE 4096  // tcp发送缓冲区大小
 #define TCP_RBUF_SIZE 4096  // tcp接收缓冲区大小
+#define TCP_BUF_PAGE_SIZE 4096  // tcp发送缓冲区页面大小, 不能小于TCP_SBUF_SIZE
+#define TCP_BUF_PAGE_CNT 32     // 所有tcp连接共享的缓冲区页面数量, 有数据待发送的连接才持有页面
+#define TCP_RCVQ_COPYBREAK 512  // 小于该长度的数据段拷贝到接收队列尾部的数据包中, 而不是直接挂载
+#define TCP_RBUF_AUTOTUNE 1  // tcp是否根据对端每个rtt的发送量自动扩大接收缓冲区
+#define TCP_RBUF_MAX 65535   // tcp接收缓冲区自动扩大的默认上限(SO_RCVBUF), 未实现窗口扩大选项, 不能超过65535
+#define TCP_RMEM_LIMIT (PKTBUF_BLK_CNT * PKTBUF_BLK_SIZE / 2)  // 所有tcp连接接收缓冲区超出TCP_RBUF_SIZE部分的总量上限
+#define TCP_RMEM_LOW_DIV 8   // 数据包池或数据块池的空闲数量低于总量的1/8时视为内存紧张, 收缩已扩大的接收缓冲区
+#define TCP_ZC_EXT_CNT 64  // 所有tcp连接共享的零拷贝发送数据区描述结构数量
+#define TCP_ZC_MAX_SIZE (512 * 1024)  // 每个tcp连接零拷贝发送时最多引用的未确认应用程序数据量
+#define TCP_CONN_HASH_SIZE 4096  // tcp已连接对象(按四元组)哈希表的桶数量, 必须为2的幂
+#define TCP_BIND_HASH_SIZE 64   // tcp绑定及监听对象(按本地端口)哈希表的桶数量, 必须为2的幂
 #define TCP_KEEPALIVE_IDLE (2*60*60)  // tcp默认保活时长(s)
 #define TCP_KEEPALIVE_INTVL (5)  // tcp默认保活间隔(s)
 #define TCP_KEEPALIVE_CNT (10)    // tcp默认保活次数
+#define TCP_OOO_MAXSIZE (TCP_RBUF_SIZE / 2)  // 每个tcp连接乱序队列可缓存的最大数据量的下限(接收缓冲区扩大后为整个接收缓冲区)
+#define TCP_OOO_SEG_MAXCNT 32  // 所有tcp连接共享的乱序数据段描述结构数量
+#define TCP_TS_ENABLE 1  // tcp默认是否启用时间戳选项(RFC 7323)
+#define TCP_ECN_ENABLE 1  // tcp默认是否启用显式拥塞通知(ECN, RFC 3168)
+#define TCP_PAWS_IDLE (24 * 24 * 60 * 60 * 1000U)  // ts_recent的有效时长(ms), 超过后不再进行PAWS检查
+#define TCP_RTO_INIT 1000   // tcp初始重传超时时间(ms)
+#define TCP_RTO_MIN 200     // tcp最小重传超时时间(ms)
+#define TCP_RTO_MAX 60000   // tcp最大重传超时时间(ms)
+#define TCP_RETRY_MAX 8     // tcp连续超时重传的最大次数
+#define TCP_SYN_BACKLOG 4   // 每个监听tcp对象的半连接(SYN_RCVD)队列最大长度, 队列满后使用SYN cookie
+#define TCP_ACCEPT_BACKLOG 8  // 每个监听tcp对象的全连接(accept)队列最大长度上限
+#define TCP_SYNCOOKIE_ENABLE 1  // tcp是否在半连接队列满时启用SYN cookie
+#define TCP_GSO_MAX_SIZE 65535  // tcp超级数据段(含ip及tcp头部)的最大大小, 不超过mtu时即关闭分段卸载
+#define TCP_INIT_CWND 10  // tcp初始拥塞窗口(mss个数), RFC 6928
+#define TCP_DELACK_TMO 200  // tcp延迟确认的最大等待时间(ms), RFC 1122要求不超过500ms
+#define TCP_RACK_ENABLE 1  // tcp是否启用RACK-TLP丢包检测及尾部丢失探测(RFC 8985)
+#define TCP_RACK_SEG_CNT 16  // 每个tcp连接记录发送时间的在途数据段数量
+#define TCP_TLP_MIN_PTO 10  // tcp尾部丢失探测超时的最小值(ms), 避免rtt很小时探测过早发出
+#define TCP_FASTOPEN_ENABLE 1  // tcp是否支持快速打开(TFO, RFC 7413), 监听对象还需设置TCP_FASTOPEN选项
+#define TCP_FASTOPEN_CACHE_SIZE 16  // 客户端按目的ip地址缓存的快速打开cookie数量
+#define TCP_HDR_PRED_ENABLE 1  // tcp是否对已建立连接上按序到达的纯数据及纯ack报文段使用首部预测快速路径
+#define TCP_TW_MAXCNT 8192  // 所有tcp连接共享的TIME_WAIT记录数量, 耗尽时连接不经过TIME_WAIT直接关闭
+#define TCP_TW_TMO (60 * 1000)  // TIME_WAIT状态的持续时间(2MSL, ms)
+#define TCP_TW_REUSE_ENABLE 1  // 主动连接时是否复用可安全复用的TIME_WAIT四元组(旧连接需使用时间戳选项)
+#define TCP_TW_REUSE_DELAY 1000  // TIME_WAIT四元组在最近一次接收对端报文段多久之后才能被复用(ms)
+#define TCP_CC_DEFAULT TCP_CC_RENO  // tcp默认的拥塞控制算法(TCP_CONGESTION): TCP_CC_RENO或TCP_CC_BBR
+#define TCP_BBR_BW_RTTS 10  // BBR瓶颈带宽最大值滤波器的窗口长度(轮数, 每轮约一个rtt)
+#define TCP_BBR_MIN_RTT_WIN 10000  // BBR最小rtt的有效时长(ms), 期间未测得更小的值时进入PROBE_RTT阶段重新测量
+#define TCP_BBR_PROBE_RTT_TIME 200  // BBR在PROBE_RTT阶段排空队列后至少保持的时长(ms)
+#define TCP_BBR_MIN_CWND 4  // BBR的最小拥塞窗口(mss个数)
+#define TCP_PACING_BURST_MS 1  // 按发送速率发送时可累积的发送额度(按速率折算的时长, ms), 不少于两个mss
 
 
 #endif  // NET_CFG_H
\ No newline at end of file
@@ -39,6 +39,9 @@ typedef enum _netif_type_t {
   NETIF_TYPE_CNT,  // 特殊：记录网络接口类型数量
 } netif_type_t;
 
+// 网络接口(驱动)支持的卸载特性
+#define NETIF_F_TSO (1 << 0)  // tcp分段卸载: 驱动可直接发送超过mtu的tcp超级数据段, 由其负责分段及计算校验和
+
 struct _netif_t;
 
 /**
@@ -80,6 +83,7 @@ typedef struct _netif_t {
   ipaddr_t gateway;            // 网关地址
   netif_type_t type;           // 接口类型
   int mtu;                     // 最大传输单元
+  uint32_t features;           // 支持的卸载特性(NETIF_F_*)
 
   const link_layer_t *link_layer;  // 链路层回调接口
 
@@ -95,6 +99,7 @@ typedef struct _netif_t {
 
   fixq_t recv_fixq;                    // 接收缓冲队列
   void *recv_buf[NETIF_RECV_BUFSIZE];  // 接收缓冲区
+  volatile int recv_notified;  // 已通知工作线程处理接收队列, 工作线程开始取数据包前清除
   fixq_t send_fixq;                    // 发送缓冲队列
   void *send_buf[NETIF_SEND_BUFSIZE];  // 发送缓冲区
 } netif_t;
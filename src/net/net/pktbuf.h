@@ -24,6 +24,15 @@
 #define PKTBUF_ADD_HEADER_UNCONT 0  // 增添数据块时不连续
 #define PKTBUF_ADD_HEADER_CONT 1    // 增添数据块时连续
 
+/**
+ * @brief 定义外部数据区结构
+ * 数据块可以直接引用外部内存(如应用程序零拷贝发送的数据), 而不是将数据拷贝到有效载荷中,
+ * ref_cnt记录引用该外部数据区的数据块数量, 为0时协议栈不再访问该外部内存
+ */
+typedef struct _pktbuf_ext_t {
+  int ref_cnt;  // 引用该外部数据区的数据块数量
+} pktbuf_ext_t;
+
 /**
  * @brief 定义数据块结构
  *
@@ -33,6 +42,7 @@ typedef struct _pktblk_t {
       node;  // 数据块链表结点, 放在第一个元素的位置，方便调试观察在哪个列表中
   int data_size;                     // 数据大小
   uint8_t *data;                     // 数据起始地址
+  pktbuf_ext_t *ext;  // 数据引用的外部数据区, 为空表示数据在有效载荷中
   uint8_t payload[PKTBUF_BLK_SIZE];  // 数据块的有效载荷大小
 
 } pktblk_t;
@@ -61,6 +71,9 @@ typedef struct _pktbuf_t {
   uint8_t *curr_pos;   // 当前待读取字节的地址
 
   int ref_cnt;  // 引用计数
+
+  int gso_size;  // 分段卸载(GSO)时每个分段携带的最大数据量, 0表示不需要分段
+  int ecn;  // ip头部的显式拥塞通知(ECN)码点, 发送时由传输层设置, 接收时由ipv4模块记录
 } pktbuf_t;
 
 #define pktbuf_check_buf(buf)                             \
@@ -133,6 +146,7 @@ static inline int pktbuf_remain_size(const pktbuf_t *buf) {
 }
 
 net_err_t pktbuf_module_init(void);
+int pktbuf_pool_low(int div);
 pktbuf_t *pktbuf_alloc(int size);
 void pktbuf_free(pktbuf_t *buf);
 net_err_t pktbuf_resize(pktbuf_t *buf, int to_size);
@@ -151,6 +165,11 @@ net_err_t pktbuf_copy(pktbuf_t *dest, pktbuf_t *src, int size);
 net_err_t pktbuf_fill(pktbuf_t *buf, uint8_t data, int size);
 pktbuf_t *pktbuf_inc_ref(pktbuf_t *buf);
 
+void pktbuf_ext_init(pktbuf_ext_t *ext);
+net_err_t pktbuf_ext_add(pktbuf_t *buf, const uint8_t *data, int size,
+                         pktbuf_ext_t *ext);
+int pktbuf_ext_busy(pktbuf_ext_t *ext);
+
 
 uint16_t pktbuf_checksum16(pktbuf_t *buf, uint16_t size, uint32_t pre_sum,
                            int is_take_back);
@@ -21,6 +21,8 @@
 struct _sock_req_t;
 struct net_sockaddr;
 struct _sock_t;
+struct _sock_hash_t;
+struct _pktbuf_t;
 
 // socket等待事件
 #define SOCK_WAIT_NONE 0          // 无等待事件
@@ -57,10 +59,18 @@ typedef struct _sock_ops_t {
                         int flags, struct net_sockaddr *src,
                         net_socklen_t *src_len, ssize_t *ret_recv_len);
 
+  // 接收一个数据报, 通过msg返回源地址及合并的数据报大小
+  net_err_t (*recvmsg)(struct _sock_t *sock, struct net_msghdr *msg, int flags,
+                       ssize_t *ret_recv_len);
+
   // 设置socket选项
   net_err_t (*setopt)(struct _sock_t *sock, int level, int optname,
                       const char *optval, int optlen);
 
+  // 获取socket选项, optlen传入缓冲区大小, 返回选项值的实际长度
+  net_err_t (*getopt)(struct _sock_t *sock, int level, int optname,
+                      char *optval, int *optlen);
+
   // 连接目标socket地址
   net_err_t (*connect)(struct _sock_t *sock, const struct net_sockaddr *addr,
                        net_socklen_t addrlen);
@@ -73,10 +83,21 @@ typedef struct _sock_ops_t {
   net_err_t (*recv)(struct _sock_t *sock, void *buf, size_t buf_len, int flags,
                     ssize_t *ret_recv_len);
 
+  // 零拷贝接收信息, 通过buf返回缓存接收数据的数据包, 且socket已连接到远端地址
+  net_err_t (*recv_zc)(struct _sock_t *sock, struct _pktbuf_t **buf, int flags,
+                       ssize_t *ret_recv_len);
+
   // 绑定socket到本地地址
   net_err_t (*bind)(struct _sock_t *sock, const struct net_sockaddr *addr,
                     net_socklen_t addrlen);
 
+  // 将socket设置为监听状态, 以被动接受连接
+  net_err_t (*listen)(struct _sock_t *sock, int backlog);
+
+  // 从监听socket的连接队列中取出一个已建立的连接, 并通过client返回
+  net_err_t (*accept)(struct _sock_t *sock, struct net_sockaddr *addr,
+                      net_socklen_t *addrlen, struct _sock_t **client);
+
   // 销毁socket对象
   void (*destroy)(struct _sock_t *sock);
 
@@ -86,6 +107,8 @@ typedef struct _sock_ops_t {
 
 net_err_t sock_setopt(struct _sock_t *sock, int level, int optname,
                       const char *optval, int optlen);
+net_err_t sock_getopt(struct _sock_t *sock, int level, int optname,
+                      char *optval, int *optlen);
 net_err_t sock_send(struct _sock_t *sock, const void *buf, size_t buf_len,
                     int flags, ssize_t *ret_send_len);
 net_err_t sock_recv(struct _sock_t *sock, void *buf, size_t buf_len, int flags,
@@ -95,6 +118,10 @@ net_err_t sock_recv(struct _sock_t *sock, void *buf, size_t buf_len, int flags,
 typedef struct _sock_t {
   nlist_node_t node;  // 用于挂载到socket对象链表的节点
 
+  nlist_node_t hash_node;         // 用于挂载到地址哈希表的节点
+  struct _sock_hash_t *hash_tbl;  // 所在的地址哈希表, 为空表示未挂载
+  nlist_t *hash_list;             // 所在的哈希桶
+
   uint16_t local_port;   // 本地端口
   ipaddr_t local_ip;     // 本地IP地址
   uint16_t remote_port;  // 远端端口
@@ -156,6 +183,18 @@ net_err_t sock_req_connect(msg_func_t *msg);
 net_err_t sock_req_bind(msg_func_t *msg);
 net_err_t sock_req_send(msg_func_t *msg);
 net_err_t sock_req_recv(msg_func_t *msg);
+net_err_t sock_req_recv_zc(msg_func_t *msg);
+net_err_t sock_req_recvmsg(msg_func_t *msg);
+
+// socket批量收发数据报请求(sendmmsg和recvmmsg)的参数结构
+typedef struct _sock_mmsg_t {
+  struct net_mmsghdr *msgvec;
+  int vlen;
+  int flags;
+  int ret_cnt;  // 已完成收发的消息数量
+} sock_mmsg_t;
+net_err_t sock_req_sendmmsg(msg_func_t *msg);
+net_err_t sock_req_recvmmsg(msg_func_t *msg);
 
 // socket选项设置请求(setsockopt)的参数结构
 typedef struct _sock_opt_t {
@@ -166,6 +205,29 @@ typedef struct _sock_opt_t {
 } sock_opt_t;
 net_err_t sock_req_setopt(msg_func_t *msg);
 
+// socket选项获取请求(getsockopt)的参数结构
+typedef struct _sock_getopt_t {
+  int level;
+  int optname;
+  char *optval;
+  int *optlen;  // 传入缓冲区大小, 返回选项值的实际长度
+} sock_getopt_t;
+net_err_t sock_req_getopt(msg_func_t *msg);
+
+// socket监听请求(listen)的参数结构
+typedef struct _sock_listen_t {
+  int backlog;
+} sock_listen_t;
+net_err_t sock_req_listen(msg_func_t *msg);
+
+// socket接受连接请求(accept)的参数结构
+typedef struct _sock_accept_t {
+  struct net_sockaddr *addr;
+  net_socklen_t *addrlen;
+  int client_fd;  // 返回新连接的socket文件描述符
+} sock_accept_t;
+net_err_t sock_req_accept(msg_func_t *msg);
+
 // 用于封装外部线程请求工作线程执行socket相关操作时传递的参数
 typedef struct _sock_req_t {
   int sock_fd;        // socket文件描述符
@@ -174,7 +236,11 @@ typedef struct _sock_req_t {
   union {
     sock_create_t create;  // 创建socket请求的参数
     sock_io_t io;
+    sock_mmsg_t mmsg;
     sock_opt_t opt;
+    sock_getopt_t getopt;
+    sock_listen_t listen;
+    sock_accept_t accept;
   };
 
 } sock_req_t;
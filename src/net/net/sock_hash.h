@@ -0,0 +1,59 @@
+/**
+ * @file sock_hash.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief socket地址哈希表, 用于根据数据包的地址信息快速查找sock对象
+ * @version 0.1
+ * @date 2024-11-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef SOCK_HASH_H
+#define SOCK_HASH_H
+
+#include <stdint.h>
+
+#include "ipaddr.h"
+#include "nlist.h"
+#include "sock.h"
+
+// 哈希表的键类型
+typedef enum _sock_hash_key_t {
+  SOCK_HASH_CONN = 0,  // 以四元组为键, 挂载已连接的sock对象
+  SOCK_HASH_LOCAL,     // 以本地端口为键, 挂载已绑定或监听的sock对象
+} sock_hash_key_t;
+
+// 查找时对候选sock对象的过滤函数, 返回非0表示该对象可以作为查找结果
+typedef int (*sock_hash_match_t)(sock_t *sock);
+
+// 定义socket地址哈希表结构
+typedef struct _sock_hash_t {
+  sock_hash_key_t key;  // 键类型
+  nlist_t *bucket_tbl;  // 哈希桶数组, 由使用者提供
+  int bucket_cnt;       // 哈希桶数量, 必须为2的幂
+  uint32_t seed;        // 哈希扰动值, 避免对端构造大量冲突的地址
+  sock_t *last_hit;     // 最近一次查找命中的sock对象(只用于四元组键)
+} sock_hash_t;
+
+void sock_hash_init(sock_hash_t *hash, sock_hash_key_t key,
+                    nlist_t *bucket_tbl, int bucket_cnt, uint32_t seed);
+void sock_hash_insert(sock_hash_t *hash, sock_t *sock);
+void sock_hash_remove(sock_t *sock);
+nlist_t *sock_hash_local_bucket(sock_hash_t *hash, uint16_t local_port);
+sock_t *sock_hash_find(sock_hash_t *hash, const ipaddr_t *local_ip,
+                       uint16_t local_port, const ipaddr_t *remote_ip,
+                       uint16_t remote_port, sock_hash_match_t match);
+
+/**
+ * @brief 判断sock对象是否挂载在指定的哈希表中
+ *
+ * @param hash
+ * @param sock
+ * @return int
+ */
+static inline int sock_hash_is_in(sock_hash_t *hash, sock_t *sock) {
+  return sock->hash_tbl == hash;
+}
+
+#endif  // SOCK_HASH_H
@@ -46,6 +46,8 @@
 #define SOL_SOCKET 0  // 通用socket选项(socket层)
 #undef SOL_TCP
 #define SOL_TCP 1  // TCP层
+#undef SOL_UDP
+#define SOL_UDP 2  // UDP层
 // 选项设置的类型(optname)：
 #undef SO_RCVTIMEO
 #define SO_RCVTIMEO 1  // 接收超时
@@ -53,12 +55,48 @@
 #define SO_SNDTIMEO 2  // 发送超时
 #undef SO_KEEPALIVE
 #define SO_KEEPALIVE 3  // 保活
+#undef SO_ZEROCOPY
+#define SO_ZEROCOPY 4  // 允许使用MSG_ZEROCOPY进行零拷贝发送
+#undef SO_RCVBUF
+#define SO_RCVBUF 5  // 接收缓冲区自动扩大的上限
+#undef SO_MAX_PACING_RATE
+#define SO_MAX_PACING_RATE 6  // 发送速率上限(字节/s)
+#undef SO_REUSEPORT
+#define SO_REUSEPORT 7  // udp: 允许多个socket绑定同一地址及端口, 按流分担接收的数据报
+#undef TCP_NODELAY
+#define TCP_NODELAY 1  // TCP关闭Nagle算法
+#undef TCP_CORK
+#define TCP_CORK 3  // TCP塞住发送, 累积满mss的数据后再发送
 #undef TCP_KEEPIDLE
 #define TCP_KEEPIDLE 4  // TCP保活时长
 #undef TCP_KEEPINTVL
 #define TCP_KEEPINTVL 5  // TCP保活间隔
 #undef TCP_KEEPCNT
 #define TCP_KEEPCNT 6  // TCP保活次数
+#undef TCP_TIMESTAMPS
+#define TCP_TIMESTAMPS 7  // TCP时间戳选项(RFC 7323)
+#undef TCP_QUICKACK
+#define TCP_QUICKACK 8  // TCP立即确认(关闭延迟确认)
+#undef TCP_CONGESTION
+#define TCP_CONGESTION 9  // TCP拥塞控制算法("reno"或"bbr")
+#undef TCP_ECN
+#define TCP_ECN 10  // TCP显式拥塞通知(RFC 3168)
+#undef TCP_FASTOPEN
+#define TCP_FASTOPEN 11  // TCP监听对象允许快速打开(RFC 7413)
+#undef TCP_INFO
+#define TCP_INFO 12  // TCP连接的状态及统计信息(struct net_tcp_info), 只能获取
+#undef UDP_SEGMENT
+#define UDP_SEGMENT 1  // UDP分段发送: 每次发送的数据按该大小切分为多个数据报, 0表示关闭
+#undef UDP_GRO
+#define UDP_GRO 2  // UDP接收合并: 同一个流连续到达的等长数据报合并后一次读取
+
+// 定义数据收发标志(flags)
+#undef MSG_ERRQUEUE
+#define MSG_ERRQUEUE 0x2000  // 读取零拷贝发送的完成通知(struct net_zc_notify), 没有通知时返回0
+#undef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000  // 零拷贝发送, 需先设置SO_ZEROCOPY选项, 否则仍拷贝数据
+#undef MSG_FASTOPEN
+#define MSG_FASTOPEN 0x20000000  // 对未连接的tcp socket使用sendto, 以快速打开方式建立连接并在SYN中携带数据
 
 // 定义socket地址长度类型
 typedef int net_socklen_t;
@@ -102,18 +140,90 @@ struct net_sockaddr_in {  // 结构内存大小与net_sockaddr相同
   char sin_zero[8];
 };
 
+// 零拷贝发送完成通知
+// 每次零拷贝发送调用按顺序分配一个从0开始的序号, 序号在[lo, hi]范围内的调用已完成,
+// 应用程序可以重新使用(修改或释放)这些调用传入的数据区
+struct net_zc_notify {
+  uint32_t lo;
+  uint32_t hi;
+};
+
+// 批量收发数据报(net_sendmmsg/net_recvmmsg)时描述单个数据报的消息结构
+struct net_mmsghdr {
+  void *msg_buf;                  // 数据缓冲区
+  size_t msg_buflen;              // 发送: 数据量, 接收: 缓冲区大小
+  struct net_sockaddr *msg_name;  // 发送: 目的地址, 接收: 返回源地址(可为空)
+  net_socklen_t msg_namelen;      // socket地址大小, 接收时返回源地址的实际大小
+  ssize_t msg_len;                // 返回实际发送或接收的数据量
+};
+
+// 接收数据报(net_recvmsg)的消息结构
+struct net_msghdr {
+  void *msg_buf;                  // 数据缓冲区
+  size_t msg_buflen;              // 缓冲区大小
+  struct net_sockaddr *msg_name;  // 返回源地址(可为空)
+  net_socklen_t msg_namelen;      // 返回源地址的实际大小
+  int msg_segsize;  // 返回: 数据由多个数据报合并(UDP_GRO)而成时为每个数据报的大小,
+                    // 只有最后一个数据报可能较短, 否则为0
+};
+
+// tcp连接协商使用的选项(net_tcp_info.options)
+#define NET_TCPI_OPT_TIMESTAMPS 0x1  // 时间戳选项
+#define NET_TCPI_OPT_ECN 0x2         // 显式拥塞通知
+#define NET_TCPI_OPT_FASTOPEN 0x4    // 以快速打开方式建立连接
+
+// tcp连接的状态及统计信息(TCP_INFO), 时间单位为ms, 数据量单位为字节
+struct net_tcp_info {
+  uint8_t state;       // tcp状态(tcp_state_t)
+  uint8_t options;     // 协商使用的选项(NET_TCPI_OPT_*)
+  uint16_t mss;        // 发送数据段可携带的最大数据量
+  uint32_t rtt;        // 平滑往返时间, 为0表示还未采样
+  uint32_t rttvar;     // 往返时间的平均偏差
+  uint32_t rto;        // 重传超时时间
+  uint32_t min_rtt;    // 采样到的最小往返时间, 为0表示还未采样
+  uint32_t snd_cwnd;   // 拥塞窗口
+  uint32_t snd_ssthresh;  // 慢启动阈值
+  uint32_t snd_wnd;    // 对端通告的接收窗口
+  uint32_t rcv_wnd;    // 本端通告的接收窗口(接收队列剩余容量)
+  uint32_t unacked;    // 已发送未确认的数据量(在途数据量)
+  uint32_t notsent;    // 发送缓冲区中还未发送的数据量
+  uint32_t rcv_queued; // 接收队列中还未被应用程序读取的数据量
+  uint32_t pacing_rate;   // 发送速率(字节/s), 为0表示不限制
+  uint32_t retransmits;   // 当前连续超时重传的次数
+  uint32_t total_retrans; // 重传的数据段总数
+  uint32_t rto_cnt;       // 超时重传的总次数
+  uint32_t tlp_probes;    // 发送的尾部丢失探测数
+  uint32_t rack_lost;     // 按发送时间判定丢失并快速重传的次数
+  uint32_t zwnd_probes;   // 发送的零窗口探测数
+  uint32_t segs_out;      // 发送的数据段数(包括重传及纯ack)
+  uint32_t segs_in;       // 接收的数据段数
+  uint64_t bytes_acked;   // 被对端确认的数据量
+  uint64_t bytes_received;  // 按序接收的数据量
+};
+
 int net_socket(int family, int type, int protocol);
 ssize_t net_sendto(int socket, const void *buf, size_t buf_len, int flags,
                    const struct net_sockaddr *dest, net_socklen_t dest_len);
 ssize_t net_recvfrom(int socket, void *buf, size_t buf_len, int flags,
                      struct net_sockaddr *src, net_socklen_t *src_len);
+int net_sendmmsg(int socket, struct net_mmsghdr *msgvec, unsigned int vlen,
+                 int flags);
+int net_recvmmsg(int socket, struct net_mmsghdr *msgvec, unsigned int vlen,
+                 int flags);
+ssize_t net_recvmsg(int socket, struct net_msghdr *msg, int flags);
 int net_close(int socket);
 int net_connect(int socket, const struct net_sockaddr *addr,
                 net_socklen_t addrlen);
 int net_setsockopt(int socket, int level, int optname, const char *optval,
                    int optlen);
+int net_getsockopt(int socket, int level, int optname, char *optval,
+                   int *optlen);
 ssize_t net_send(int socket, const void *buf, size_t buf_len, int flags);
 ssize_t net_recv(int socket, void *buf, size_t buf_len, int flags);
+ssize_t net_recv_zc(int socket, pktbuf_t **buf, int flags);
+void net_recv_zc_free(pktbuf_t *buf);
 int net_bind(int socket, const struct net_sockaddr *addr,
              net_socklen_t addrlen);
+int net_listen(int socket, int backlog);
+int net_accept(int socket, struct net_sockaddr *addr, net_socklen_t *addrlen);
 #endif  // SOCKET_H
\ No newline at end of file
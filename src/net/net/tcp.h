@@ -15,6 +15,8 @@
 #include "net_cfg.h"
 #include "sock.h"
 #include "tcp_buf.h"
+#include "tcp_ooo.h"
+#include "tcp_rcvq.h"
 #include "tools.h"
 #include "timer.h"
 
@@ -32,8 +34,11 @@ typedef enum _tcp_opt_t {  // TODO: 本协议栈只支持了部分选项
   TCP_OPT_SACK_PERM = 4,   // SACK允许
   TCP_OPT_SACK = 5,        // SACK
   TCP_OPT_TS = 8,          // 时间戳
+  TCP_OPT_FASTOPEN = 34,   // 快速打开cookie(RFC 7413)
 } tcp_opt_t;
 
+#define TCP_FASTOPEN_COOKIE_SIZE 8  // 快速打开cookie的长度
+
 #pragma pack(1)
 
 // 定义tcp选项结构
@@ -43,6 +48,13 @@ typedef struct _tcp_opt_mss_t {  // 获取对端mss
   uint16_t mss;
 } tcp_opt_mss_t;
 
+typedef struct _tcp_opt_ts_t {  // 时间戳选项(RFC 7323)
+  uint8_t kind;
+  uint8_t len;
+  uint32_t ts_val;  // 发送方的时间戳
+  uint32_t ts_ecr;  // 回显对端的时间戳
+} tcp_opt_ts_t;
+
 // 定义tcp 头部结构
 typedef struct _tcp_hdr_t {
   uint16_t src_port;   // 源端口
@@ -116,6 +128,13 @@ typedef struct _tcp_info_t {
   uint32_t data_len;   // 数据长度
   uint32_t seq;        // 序号
   uint32_t seq_len;    // 序号长度
+  int ts_valid;        // 数据包是否携带时间戳选项
+  uint32_t ts_val;     // 对端的时间戳
+  uint32_t ts_ecr;     // 对端回显的本地时间戳
+  uint16_t mss;        // SYN报文段携带的mss选项值, 为0表示未携带
+  int ecn_ce;          // ip头部是否被标记了拥塞(CE)
+  int tfo_len;         // 快速打开选项中cookie的长度, 为-1表示未携带, 为0表示请求cookie
+  uint8_t *tfo_cookie; // 快速打开选项中的cookie
 } tcp_info_t;
 void tcp_info_init(tcp_info_t *tcp_info, pktbuf_t *tcp_buf, ipaddr_t *dest_ip,
                    ipaddr_t *src_ip);
@@ -137,6 +156,27 @@ typedef enum _tcp_state_t {
 
 } tcp_state_t;
 
+// 定义tcp拥塞控制算法
+typedef enum _tcp_cc_t {
+  TCP_CC_RENO = 0,  // 基于丢包的慢启动及拥塞避免(RFC 5681)
+  TCP_CC_BBR,       // 基于瓶颈带宽及最小rtt模型的拥塞控制(BBR)
+} tcp_cc_t;
+
+// 定义BBR拥塞控制的阶段
+typedef enum _tcp_bbr_mode_t {
+  TCP_BBR_STARTUP = 0,  // 每轮将发送速率翻倍, 探测瓶颈带宽
+  TCP_BBR_DRAIN,        // 排空STARTUP阶段在瓶颈处形成的队列
+  TCP_BBR_PROBE_BW,     // 以瓶颈带宽发送, 并周期性地探测更高的带宽
+  TCP_BBR_PROBE_RTT,    // 缩小拥塞窗口排空队列, 重新测量最小rtt
+} tcp_bbr_mode_t;
+
+// 定义RACK-TLP丢包检测统计信息
+typedef struct _tcp_rack_stats_t {
+  uint32_t tlp_probes;      // 发送的尾部丢失探测数
+  uint32_t tlp_recoveries;  // 探测修复了尾部丢包(而不是原数据段的ack晚到)的次数
+  uint32_t rack_lost;       // 按发送时间判定最早的未确认数据段丢失并快速重传的次数
+} tcp_rack_stats_t;
+
 // 定义tcp socket结构, 派生自基础socket结构
 typedef struct _tcp_t {
   sock_t sock_base;  // 基础socket结构(父类，必须在第一个位置)
@@ -158,8 +198,76 @@ typedef struct _tcp_t {
     uint32_t syn_recved : 1;     // 已接收对端的SYN
     uint32_t recv_win_valid : 1;  // 接收窗口的是否有效
     uint32_t keep_alive_enable : 1;      // 是否启用保活机制
+    uint32_t ts_enable : 1;       // 是否允许使用时间戳选项
+    uint32_t ts_ok : 1;           // 双方是否已协商使用时间戳选项
+    uint32_t rtt_timing : 1;      // 是否正在对某个数据段计时(无时间戳时采样rtt)
+    uint32_t quick_ack : 1;       // 是否关闭延迟确认，对每个数据段立即发送ack
+    uint32_t nodelay : 1;         // 是否关闭Nagle算法，小数据段立即发送
+    uint32_t cork : 1;            // 是否塞住发送，只发送满mss的数据段
+    uint32_t zerocopy : 1;        // 是否允许零拷贝发送(SO_ZEROCOPY)
+    uint32_t recovery : 1;        // 是否处于超时重传后的恢复阶段, 确认到send.recover后结束
+    uint32_t ecn_enable : 1;      // 是否允许使用显式拥塞通知(ECN)
+    uint32_t ecn_ok : 1;          // 双方是否已协商使用ECN
+    uint32_t ecn_ece : 1;         // 是否需要在ack中回显对端数据段的拥塞标记(ECE)
+    uint32_t ecn_cwr : 1;         // 是否需要在下一个新数据段中通知对端已降低拥塞窗口(CWR)
+    uint32_t ecn_reduced : 1;     // 是否已因ECE降低拥塞窗口, 确认越过send.cwr_high前不再降低
+    uint32_t tfo_enable : 1;      // 监听对象是否允许快速打开(TCP_FASTOPEN)
+    uint32_t tfo : 1;             // 是否以快速打开方式建立连接, 握手完成前即可收发数据
   } flags;
 
+  // 时间戳选项相关信息(RFC 7323)
+  struct {
+    uint32_t recent;         // 最近一次从对端接收的有效时间戳，用于回显及PAWS检查
+    uint32_t recent_time;    // 记录recent时的本地时间(ms)
+    uint32_t last_ack_sent;  // 最近一次发送的ack号
+  } ts;
+
+  // 快速打开相关信息(RFC 7413)
+  // 客户端: SYN中携带的cookie及其对应的对端mss; 服务端子连接: 需要在SYN+ACK中通告的cookie
+  struct {
+    uint8_t cookie[TCP_FASTOPEN_COOKIE_SIZE];
+    int cookie_len;  // cookie长度, 为0表示不携带(客户端SYN中为请求cookie)
+    uint16_t mss;    // 缓存cookie时记录的对端mss
+    int syn_data;    // 客户端SYN携带的数据量
+  } tfo;
+
+  // 往返时间及重传超时相关信息(RFC 6298)
+  struct {
+    int srtt;            // 平滑往返时间(ms), 为0表示还未采样
+    int rttvar;          // 往返时间的平均偏差(ms)
+    int rto;             // 重传超时时间(ms)
+    int retry;           // 当前连续超时重传的次数
+    uint32_t seq;        // 无时间戳时，正在计时的数据段序号
+    uint32_t time;       // 该数据段的发送时间(ms)
+    net_timer_t timer;   // 重传定时器
+  } rtt;
+
+  // 零拷贝发送相关信息
+  struct {
+    uint32_t next_id;  // 下一次零拷贝发送调用的通知序号
+    uint32_t done_lo;  // 已完成但还未被应用程序读取的调用序号范围[done_lo, done_hi]
+    uint32_t done_hi;
+    int done_valid;    // done_lo及done_hi是否有效
+  } zc;
+
+  // 延迟确认相关信息(RFC 1122)
+  struct {
+    int bytes;           // 自上次发送ack以来接收的未确认数据量
+    net_timer_t timer;   // 延迟确认定时器
+  } delack;
+
+  // 被动打开相关信息
+  // 监听对象: 维护半连接(SYN_RCVD)队列和已完成三次握手、等待accept的全连接队列
+  // 子连接: 在被accept之前记录所属的监听对象及所在的队列
+  struct {
+    struct _tcp_t *parent;  // 所属的监听tcp对象, 被accept后清空
+    nlist_t *queue;         // 子连接当前所在的监听队列
+    nlist_node_t node;      // 用于挂载到监听队列的结点
+    nlist_t syn_list;       // 半连接队列
+    nlist_t accept_list;    // 全连接队列
+    int backlog;            // 全连接队列的最大长度
+  } listen;
+
   struct {             // 用于处理tcp连接的结构
     sock_wait_t wait;  // 用于处理tcp 连接的等待结构
     int keep_idle;     // 保持连接的空闲时间
@@ -175,21 +283,122 @@ typedef struct _tcp_t {
     uint32_t isn;      // 初始序号
     uint32_t una;      // 未确认的数据的数据段序号
     uint32_t nxt;      // 下一个将要发送的数据段序号
+    uint32_t win;      // 对端通告的接收窗口大小
+    uint32_t wl1;      // 最近一次更新窗口的报文段序号
+    uint32_t wl2;      // 最近一次更新窗口的报文段确认号
+    uint32_t cwnd;     // 拥塞窗口大小(RFC 5681)
+    uint32_t ssthresh; // 慢启动阈值
+    uint32_t recover;  // 超时重传时的nxt, 恢复阶段中确认未越过该序号的ack表明还有数据丢失
+    uint32_t cwr_high; // 因ECE降低拥塞窗口时的nxt
     sock_wait_t wait;  // 用于处理tcp发送的等待事件
-    tcp_buf_t buf;     // tcp发送缓冲区
-    // TODO:为了简化实现以及可移植到某些嵌入式设备上，这里直接使用一个固定大小的缓冲区，以后可以使用动态分配的缓冲区
-    uint8_t buf_data[TCP_SBUF_SIZE];  // tcp发送缓冲区数据的数据区
+    tcp_buf_t buf;     // tcp发送缓冲区, 数据区按需从缓冲区页面池分配
+    nlist_node_t page_node;  // 等待缓冲区页面时挂载到等待链表的结点
   } send;
 
+  tcp_cc_t cc;  // 拥塞控制算法(TCP_CONGESTION)
+
+  // 发送节奏控制(pacing)相关信息
+  // 按发送速率随时间累积发送额度, 额度用完后由定时器稍后继续发送, 避免突发发送填满瓶颈处的队列
+  struct {
+    uint32_t rate;      // 拥塞控制算法给出的发送速率(字节/s), 为0表示不限制
+    uint32_t max_rate;  // 发送速率上限(SO_MAX_PACING_RATE, 字节/s), 为0表示不限制
+    int credit;         // 当前的发送额度(字节), 发送超出额度的数据段后为负值
+    uint32_t stamp;     // 上次累积发送额度的时间(ms)
+    net_timer_t timer;  // 发送节奏定时器
+  } pacing;
+
+  // BBR拥塞控制相关信息
+  // 以每轮的交付速率估计瓶颈带宽, 并记录最小rtt, 按两者的乘积(带宽时延积)控制发送速率及在途数据量
+  struct {
+    tcp_bbr_mode_t mode;      // 当前所处的阶段
+    uint32_t delivered;       // 累计被确认的数据量
+    uint32_t delivered_time;  // 最近一次确认新数据的时间(ms)
+    int rs_valid;             // 是否正在进行交付速率采样
+    uint32_t rs_seq;          // 采样数据段的结束序号, 被确认后完成本次采样(一轮)
+    uint32_t rs_delivered;    // 采样开始时的delivered
+    uint32_t rs_time;         // 采样开始时的delivered_time(ms)
+    int rs_app_limited;       // 采样期间发送是否受限于应用程序提供的数据量
+    uint32_t round;           // 已完成的采样轮数
+    uint32_t bw[TCP_BBR_BW_RTTS];  // 最近若干轮中每轮的交付速率(字节/s), 最大值即瓶颈带宽
+    uint32_t full_bw;         // STARTUP阶段带宽增长的基准值
+    int full_bw_cnt;          // 带宽未明显增长的轮数
+    int full_bw_reached;      // 是否已填满瓶颈带宽
+    int min_rtt;              // 最小rtt(ms), 为0表示还未采样
+    uint32_t min_rtt_stamp;   // 测得最小rtt的时间(ms)
+    int pacing_gain;          // 发送速率增益(以256为1)
+    int cwnd_gain;            // 拥塞窗口增益(以256为1)
+    int cycle_idx;            // PROBE_BW阶段增益循环的当前位置
+    uint32_t cycle_stamp;     // 进入当前增益的时间(ms)
+    uint32_t probe_rtt_done;  // PROBE_RTT阶段的结束时间(ms), 为0表示还未排空队列
+    int probe_rtt_round_done; // PROBE_RTT阶段排空队列后是否已经过一轮
+    uint32_t prior_cwnd;      // 进入PROBE_RTT阶段或超时重传前的拥塞窗口
+    int loss_recovery;        // 是否在超时重传后缩小了拥塞窗口, 恢复阶段结束后恢复
+  } bbr;
+
+  // RACK-TLP丢包检测相关信息(RFC 8985)
+  // 记录在途数据段的发送时间, 收到重复ack(之后发送的数据段已到达)且最早的未确认数据段
+  // 发出已超过rtt加重排序窗口时即判定其丢失; 尾部的数据段丢失时没有之后的数据段触发重复ack,
+  // 约两个rtt未收到ack时重传最后一个数据段作为探测, 使尾部丢包不必等待重传超时
+  struct {
+    struct {
+      uint32_t end;   // 数据段的结束序号
+      uint32_t time;  // 数据段最近一次(重)发送的时间(ms)
+    } seg[TCP_RACK_SEG_CNT];  // 按发送顺序记录的在途数据段, 用尽后合并到最后一个记录
+    int head;                 // 最早的在途数据段记录
+    int cnt;                  // 记录数量
+    int rtt;                  // 最近一次采样的rtt(ms), 为-1表示还未采样
+    int min_rtt;              // 最小rtt(ms), 重排序窗口为其1/4
+    int dupack;               // 是否收到了重复ack, 此时定时器用于等待重排序窗口
+    int tlp_valid;            // 是否有未结束的尾部丢失探测
+    uint32_t tlp_high;        // 发送探测时的nxt, 确认越过该序号时探测结束
+    uint32_t tlp_time;        // 发送探测的时间(ms)
+    tcp_rack_stats_t stats;   // 本连接的统计信息
+    net_timer_t timer;        // 重排序及尾部丢失探测定时器
+  } rack;
+
+  // 坚持定时器相关信息(RFC 1122 4.2.2.17)
+  // 对端通告零窗口且没有未确认的数据时, 若对端打开窗口的ack丢失, 双方将一直互相等待,
+  // 因此定时发送携带一个字节的窗口探测, 对端回复的ack将告知当前窗口, 探测间隔按指数退避
+  struct {
+    int backoff;        // 已连续发送的探测数, 探测间隔为rto * 2^backoff
+    int probes;         // 对端未响应的连续探测数, 超过TCP_RETRY_MAX时认为连接已断开
+    int probe_sent;     // 探测的字节已计入nxt, 对端打开窗口时若未被确认则回退nxt重新发送
+    net_timer_t timer;  // 坚持定时器
+  } persist;
+
+  // 连接统计信息, 在收发路径中顺带累加, 由getsockopt(TCP_INFO)读取
+  struct {
+    uint32_t segs_out;        // 发送的数据段数(包括重传及纯ack)
+    uint32_t segs_in;         // 接收的数据段数
+    uint32_t retrans;         // 重传的数据段数
+    uint32_t rto_cnt;         // 超时重传的次数
+    uint32_t zwnd_probes;     // 发送的零窗口探测数
+    uint64_t bytes_acked;     // 被对端确认的数据量
+    uint64_t bytes_received;  // 按序接收的数据量
+  } stats;
+
   // 接收窗口
   // [isn ~ nxt) 已接收的数据, [nxt ~ end) 等待接收的数据
   struct {
     uint32_t isn;                     // 初始序号
     uint32_t unr;                     // 未读取的数据的数据段序号
     uint32_t nxt;                     // 下一个将要接收的数据段序号
+    uint32_t wnd_edge;                // 最近一次通告的接收窗口右边界
     sock_wait_t wait;                 // 用于处理tcp接收的等待事件
-    tcp_buf_t buf;                    // tcp接收缓冲区
-    uint8_t buf_data[TCP_RBUF_SIZE];  // tcp接收缓冲区数据的数据区
+    tcp_rcvq_t queue;                 // tcp接收队列, 直接缓存按序到达的数据包
+    tcp_ooo_t ooo;                    // 乱序报文段重组队列
+
+    // 接收缓冲区自动调整相关信息, 按每个rtt内交付给应用程序的数据量估计对端的发送速率
+    struct {
+      int cap;            // 接收队列可自动扩大到的上限(SO_RCVBUF)
+      int space;          // 此前单个rtt内交付给应用程序的最大数据量
+      uint32_t seq;       // 本次测量开始时的unr
+      uint32_t time;      // 本次测量开始的时间(ms)
+      int rtt;            // 接收方估计的往返时间(ms), 为0表示还未采样
+      int rtt_valid;      // 是否正在通过接收一个窗口的数据采样rtt(无时间戳时)
+      uint32_t rtt_seq;   // 收到该序号之前的所有数据即完成本次采样
+      uint32_t rtt_time;  // 本次采样开始的时间(ms)
+    } tune;
   } recv;
 
 } tcp_t;
@@ -200,6 +409,18 @@ net_err_t tcp_abort_connect(tcp_t *tcp, net_err_t err);
 void tcp_read_options(tcp_t *tcp, tcp_hdr_t *tcp_hdr);
 net_err_t tcp_write_options(tcp_t *tcp, pktbuf_t *buf);
 int tcp_seq_is_ok(tcp_t *tcp, tcp_info_t *info);
+uint32_t tcp_time_now(void);
+void tcp_rtt_update(tcp_t *tcp, int rtt);
+int tcp_paws_reject(tcp_t *tcp, tcp_info_t *info);
+void tcp_ts_update(tcp_t *tcp, tcp_info_t *info);
+tcp_t *tcp_child_alloc(tcp_t *parent, tcp_info_t *info);
+void tcp_child_queue(tcp_t *child, nlist_t *queue);
+uint32_t tcp_syncookie_make(tcp_info_t *info, uint16_t *mss);
+int tcp_syncookie_check(tcp_info_t *info, uint16_t *mss);
+void tcp_zc_collect(tcp_t *tcp);
+void tcp_pmtu_reduced(const ipaddr_t *local_ip, const ipaddr_t *remote_ip,
+                      uint16_t local_port, uint16_t remote_port, uint32_t seq,
+                      int mtu);
 
 static inline int tcp_get_hdr_size(const tcp_hdr_t *tcp_hdr) {
   return (tcp_hdr->hdr_len * 4);
@@ -230,6 +451,29 @@ static inline int tcp_wait_send_data(tcp_t *tcp) {
   return tcp_buf_cnt(&tcp->send.buf) - tcp_wait_ack_data(tcp);
 }
 
+/**
+ * @brief 获取每个数据段可携带的最大数据量,
+ *        协商使用时间戳选项后，每个数据段都需携带时间戳选项(含2字节填充)
+ *
+ * @param tcp
+ * @return int
+ */
+static inline int tcp_send_mss(tcp_t *tcp) {
+  return tcp->mss - (tcp->flags.ts_ok ? 2 + sizeof(tcp_opt_ts_t) : 0);
+}
+
+/**
+ * @brief 获取发送窗口中还可以发送的序号长度,
+ *        即对端接收窗口与拥塞窗口中的较小值减去已发送未确认的序号长度
+ *
+ * @param tcp
+ * @return int 可能小于等于0
+ */
+static inline int tcp_send_window(tcp_t *tcp) {
+  uint32_t win = MIN(tcp->send.win, tcp->send.cwnd);
+  return (int)win - (int)(tcp->send.nxt - tcp->send.una);
+}
+
 /**
  * @brief 获取tcp接收缓冲区中待接收的数据量
  * 
@@ -241,13 +485,24 @@ static inline int tcp_wait_send_data(tcp_t *tcp) {
 // }
 
 /**
- * @brief 获取tcp接收窗口大小(接收缓冲区剩余空间大小)
+ * @brief 获取tcp接收窗口大小(接收队列剩余容量)
  * 
  * @param tcp 
  * @return int 
  */
 static inline int tcp_recv_window(tcp_t *tcp) {
-  return tcp_buf_free_cnt(&tcp->recv.buf);
+  return tcp_rcvq_free_cnt(&tcp->recv.queue);
+}
+
+/**
+ * @brief 获取接收方避免糊涂窗口综合症(SWS)的阈值(RFC 1122 4.2.3.3):
+ *        接收窗口右边界相比上次通告推进了至少一个mss或接收缓冲区的一半时才通告新的窗口
+ *
+ * @param tcp
+ * @return int
+ */
+static inline int tcp_recv_wnd_thresh(tcp_t *tcp) {
+  return MIN(tcp_send_mss(tcp), tcp->recv.queue.size / 2);
 }
 
 /**
@@ -0,0 +1,23 @@
+/**
+ * @file tcp_bbr.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp BBR拥塞控制模块
+ * @version 0.1
+ * @date 2024-12-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TCP_BBR_H
+#define TCP_BBR_H
+
+#include "net_cfg.h"
+#include "tcp.h"
+
+void tcp_bbr_init(tcp_t *tcp);
+void tcp_bbr_on_send(tcp_t *tcp, int len);
+void tcp_bbr_on_ack(tcp_t *tcp, int acked, int rtt);
+void tcp_bbr_on_rto(tcp_t *tcp);
+
+#endif  // TCP_BBR_H
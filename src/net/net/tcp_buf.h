@@ -15,28 +15,50 @@
 #include <stdint.h>
 #include "pktbuf.h"
 
-// 定义tcp数据buf结构
+// 定义零拷贝发送时引用的应用程序数据区结构
+// 数据被确认且不再被任何数据包引用后，才通知应用程序可以重新使用该数据区
+typedef struct _tcp_buf_ext_t {
+  nlist_node_t node;    // 用于挂载到发送缓冲区外部数据区链表的结点
+  const uint8_t *data;  // 未确认数据的起始地址
+  int len;              // 未确认的数据长度
+  uint32_t id;          // 所属的零拷贝发送调用的通知序号
+  int notify;           // 是否为该次发送调用的最后一个数据区, 完成时需要通知应用程序
+  pktbuf_ext_t ref;     // 数据包对该数据区的引用
+} tcp_buf_ext_t;
+
+// 定义tcp数据buf结构, 用作发送缓冲区(接收的数据直接以数据包的形式缓存在接收队列中)
+// 数据区按需从共享的页面池中分配，缓冲区中没有数据时归还，使空闲连接不占用缓冲区内存
+// 还可以在环形数据区之后挂载零拷贝发送的应用程序数据区，数据按挂载顺序发送
 typedef struct _tcp_buf_t {
-  uint8_t *data;  // 数据缓冲区
+  uint8_t *data;  // 数据缓冲区, 为空表示当前未持有页面
   int count;      // 数据缓冲区当前数据量
   int size;       // 数据缓冲区的容量
   int in, out;    // 数据缓冲区的读写索引
 
+  nlist_t ext_list;       // 未确认的零拷贝数据区链表
+  nlist_t ext_done_list;  // 已确认但可能仍被数据包引用的零拷贝数据区链表
+  int ext_count;          // 零拷贝数据区中未确认的数据量
 } tcp_buf_t;
 
-void tcp_buf_init(tcp_buf_t *tcp_buf, uint8_t *data, int size);
+// 缓冲区页面或零拷贝数据区描述结构归还时的通知函数, 用于唤醒等待资源的发送任务
+typedef void (*tcp_buf_page_notify_t)(void);
 
-static inline int tcp_buf_size(tcp_buf_t *tcp_buf) { return tcp_buf->size; }
+net_err_t tcp_buf_module_init(tcp_buf_page_notify_t notify);
+void tcp_buf_init(tcp_buf_t *tcp_buf, int size);
+void tcp_buf_release(tcp_buf_t *tcp_buf);
 
-static inline int tcp_buf_cnt(tcp_buf_t *tcp_buf) { return tcp_buf->count; }
+static inline int tcp_buf_size(tcp_buf_t *tcp_buf) { return tcp_buf->size; }
 
-static inline int tcp_buf_free_cnt(tcp_buf_t *tcp_buf) {
-  return tcp_buf->size - tcp_buf->count;
+static inline int tcp_buf_cnt(tcp_buf_t *tcp_buf) {
+  return tcp_buf->count + tcp_buf->ext_count;
 }
+
+int tcp_buf_free_cnt(tcp_buf_t *tcp_buf);
 int tcp_buf_write(tcp_buf_t *tcp_buf, const uint8_t *data_buf, int len);
+int tcp_buf_write_ext(tcp_buf_t *tcp_buf, const uint8_t *data_buf, int len,
+                      uint32_t id);
+int tcp_buf_ext_done(tcp_buf_t *tcp_buf, uint32_t *id);
 int tcp_buf_read_to_pktbuf(tcp_buf_t *tcp_buf, pktbuf_t *buf, int offset, int len);
-int tcp_buf_write_from_pktbuf(tcp_buf_t *tcp_buf, pktbuf_t *buf, int offset, int len);
-int tcp_buf_read(tcp_buf_t *tcp_buf, uint8_t *data_buf, int len);
 
 int tcp_buf_remove(tcp_buf_t *tcp_buf, int cnt);
 
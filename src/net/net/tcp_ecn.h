@@ -0,0 +1,33 @@
+/**
+ * @file tcp_ecn.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp显式拥塞通知(ECN)模块
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TCP_ECN_H
+#define TCP_ECN_H
+
+#include "net_cfg.h"
+#include "tcp.h"
+
+// 定义tcp显式拥塞通知统计信息
+typedef struct _tcp_ecn_stats_t {
+  uint32_t ce_recv;   // 接收到的被标记了拥塞(CE)的数据段数
+  uint32_t ece_recv;  // 因对端回显的拥塞通知(ECE)而降低拥塞窗口的次数
+  uint32_t cwr_recv;  // 接收到的拥塞窗口已降低(CWR)通知数
+} tcp_ecn_stats_t;
+
+void tcp_ecn_init(tcp_t *tcp);
+void tcp_ecn_syn_in(tcp_t *tcp, tcp_hdr_t *tcp_hdr);
+void tcp_ecn_hdr_out(tcp_t *tcp, tcp_hdr_t *tcp_hdr);
+void tcp_ecn_data_out(tcp_t *tcp, tcp_hdr_t *tcp_hdr, pktbuf_t *buf);
+int tcp_ecn_data_in(tcp_t *tcp, tcp_info_t *info);
+void tcp_ecn_ack_in(tcp_t *tcp, tcp_info_t *info);
+void tcp_ecn_stats_get(tcp_ecn_stats_t *stats);
+
+#endif  // TCP_ECN_H
@@ -0,0 +1,36 @@
+/**
+ * @file tcp_fastopen.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp快速打开(TFO)模块
+ * @version 0.1
+ * @date 2024-12-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TCP_FASTOPEN_H
+#define TCP_FASTOPEN_H
+
+#include "net_cfg.h"
+#include "tcp.h"
+
+// 定义tcp快速打开统计信息
+typedef struct _tcp_fastopen_stats_t {
+  uint32_t cookie_req;     // 客户端: 没有缓存的cookie, 在SYN中请求cookie的次数
+  uint32_t syn_data_sent;  // 客户端: SYN携带了数据的连接数
+  uint32_t syn_data_acked; // 客户端: SYN携带的数据被对端接受的连接数
+  uint32_t cookie_sent;    // 服务端: 在SYN+ACK中通告cookie的次数
+  uint32_t cookie_invalid; // 服务端: SYN携带的cookie校验失败的次数
+  uint32_t syn_data_recv;  // 服务端: 接受了SYN携带的数据的连接数
+} tcp_fastopen_stats_t;
+
+void tcp_fastopen_init(uint32_t seed);
+void tcp_fastopen_connect(tcp_t *tcp);
+int tcp_fastopen_syn_data(tcp_t *tcp, int wait_data_len);
+int tcp_fastopen_write_option(tcp_t *tcp, tcp_hdr_t *tcp_hdr, uint8_t *opt);
+int tcp_fastopen_syn_in(tcp_t *child, tcp_t *parent, tcp_info_t *info);
+void tcp_fastopen_synack_in(tcp_t *tcp, tcp_info_t *info);
+void tcp_fastopen_stats_get(tcp_fastopen_stats_t *stats);
+
+#endif  // TCP_FASTOPEN_H
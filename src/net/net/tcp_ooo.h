@@ -0,0 +1,68 @@
+/**
+ * @file tcp_ooo.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp乱序报文段重组队列模块
+ * @version 0.1
+ * @date 2024-11-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TCP_OOO_H
+#define TCP_OOO_H
+
+#include <stdint.h>
+
+#include "net_cfg.h"
+#include "nlist.h"
+#include "pktbuf.h"
+#include "tcp_rcvq.h"
+
+// 定义乱序报文段结构, 描述一段连续的已接收但未按序到达的数据
+typedef struct _tcp_seg_t {
+  nlist_node_t node;  // 乱序队列链表结点
+  uint32_t seq;       // 数据段的起始序号
+  int len;            // 数据段的数据长度
+  int fin;            // 数据段之后是否紧跟fin请求
+  pktbuf_t *buf;      // 只包含有效数据的数据包(已移除tcp头部)
+} tcp_seg_t;
+
+// 定义乱序队列结构, 队列中的数据段按序号升序排列，且互不重叠、互不相邻
+typedef struct _tcp_ooo_t {
+  nlist_t seg_list;  // 乱序数据段链表
+  int size;          // 队列中缓存的数据总量
+  tcp_seg_t *last;   // 最近一次插入或合并的数据段, 作为第一个SACK块
+} tcp_ooo_t;
+
+// 定义SACK块结构, 描述一段已接收的序号范围[start, end)
+typedef struct _tcp_sack_block_t {
+  uint32_t start;
+  uint32_t end;
+} tcp_sack_block_t;
+
+net_err_t tcp_ooo_module_init(void);
+void tcp_ooo_init(tcp_ooo_t *ooo);
+void tcp_ooo_clear(tcp_ooo_t *ooo);
+net_err_t tcp_ooo_insert(tcp_ooo_t *ooo, pktbuf_t *buf, uint32_t seq, int len,
+                         int fin, int max_size);
+int tcp_ooo_drain(tcp_ooo_t *ooo, tcp_rcvq_t *rcvq, uint32_t *nxt, int *fin);
+int tcp_ooo_sack_blocks(tcp_ooo_t *ooo, tcp_sack_block_t *blocks, int max);
+
+static inline int tcp_ooo_is_empty(tcp_ooo_t *ooo) {
+  return nlist_is_empty(&ooo->seg_list);
+}
+
+/**
+ * @brief 乱序队列可缓存的最大数据量: 整个接收缓冲区, 随接收缓冲区的自动扩大而增长, 不小于TCP_OOO_MAXSIZE
+ *        插入前数据已被截断到接收窗口内, 通告的窗口内的数据都能被缓存,
+ *        否则对端在恢复阶段按拥塞窗口发送的新数据被丢弃, 每轮只能由部分确认触发的重传补上一个空缺
+ *
+ * @param rcvbuf_size 当前接收缓冲区的大小
+ * @return int
+ */
+static inline int tcp_ooo_max_size(int rcvbuf_size) {
+  return rcvbuf_size > TCP_OOO_MAXSIZE ? rcvbuf_size : TCP_OOO_MAXSIZE;
+}
+
+#endif  // TCP_OOO_H
@@ -0,0 +1,27 @@
+/**
+ * @file tcp_rack.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp RACK-TLP丢包检测模块
+ * @version 0.1
+ * @date 2024-12-11
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TCP_RACK_H
+#define TCP_RACK_H
+
+#include "net_cfg.h"
+#include "tcp.h"
+
+void tcp_rack_init(tcp_t *tcp);
+void tcp_rack_stop(tcp_t *tcp);
+void tcp_rack_on_send(tcp_t *tcp);
+void tcp_rack_on_retransmit(tcp_t *tcp, uint32_t seq, uint32_t end);
+void tcp_rack_on_ack(tcp_t *tcp, tcp_info_t *info, int rtt);
+void tcp_rack_on_dupack(tcp_t *tcp);
+void tcp_rack_on_rto(tcp_t *tcp);
+void tcp_rack_stats_get(tcp_rack_stats_t *stats);
+
+#endif  // TCP_RACK_H
@@ -0,0 +1,25 @@
+/**
+ * @file tcp_rcvbuf.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp接收缓冲区自动调整模块
+ * @version 0.1
+ * @date 2024-12-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TCP_RCVBUF_H
+#define TCP_RCVBUF_H
+
+#include "net_cfg.h"
+#include "tcp.h"
+
+void tcp_rcvbuf_init(tcp_t *tcp);
+void tcp_rcvbuf_release(tcp_t *tcp);
+void tcp_rcvbuf_set_cap(tcp_t *tcp, int cap);
+void tcp_rcvbuf_data_in(tcp_t *tcp, tcp_info_t *info);
+void tcp_rcvbuf_adjust(tcp_t *tcp);
+int tcp_rcvbuf_mem_used(void);
+
+#endif  // TCP_RCVBUF_H
@@ -0,0 +1,42 @@
+/**
+ * @file tcp_rcvq.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp接收队列模块
+ * @version 0.1
+ * @date 2024-12-05
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TCP_RCVQ_H
+#define TCP_RCVQ_H
+
+#include <stdint.h>
+
+#include "net_cfg.h"
+#include "nlist.h"
+#include "pktbuf.h"
+
+// 定义tcp接收队列结构, 按序号顺序缓存已按序到达的数据包, 不将数据拷贝到缓冲区中
+// 每个数据包的有效数据为[pos, total_size), pos之前为tcp头部或已读取的数据,
+// 在读取时才移除, 使正在处理的数据包的tcp头部在入队后仍然有效
+typedef struct _tcp_rcvq_t {
+  nlist_t buf_list;  // 数据包链表
+  int count;         // 队列中未读取的数据量
+  int size;          // 队列的容量, 即接收窗口的上限
+} tcp_rcvq_t;
+
+void tcp_rcvq_init(tcp_rcvq_t *rcvq, int size);
+void tcp_rcvq_clear(tcp_rcvq_t *rcvq);
+int tcp_rcvq_put(tcp_rcvq_t *rcvq, pktbuf_t *buf, int offset, int len);
+int tcp_rcvq_read(tcp_rcvq_t *rcvq, uint8_t *data_buf, int len);
+pktbuf_t *tcp_rcvq_get(tcp_rcvq_t *rcvq);
+
+static inline int tcp_rcvq_cnt(tcp_rcvq_t *rcvq) { return rcvq->count; }
+
+static inline int tcp_rcvq_free_cnt(tcp_rcvq_t *rcvq) {
+  return rcvq->size - rcvq->count;
+}
+
+#endif  // TCP_RCVQ_H
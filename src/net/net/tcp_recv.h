@@ -15,8 +15,17 @@
 
 #include "tcp.h"
 
+// 定义tcp首部预测统计信息
+typedef struct _tcp_pred_stats_t {
+  uint32_t total;     // 已建立连接上接收到的报文段数
+  uint32_t ack_hit;   // 由快速路径处理的纯ack报文段数
+  uint32_t data_hit;  // 由快速路径处理的按序纯数据报文段数
+} tcp_pred_stats_t;
+
 net_err_t tcp_recv(pktbuf_t *tcp_buf, ipaddr_t *src_ip, ipaddr_t *dest_ip);
 net_err_t tcp_recv_data(tcp_t *tcp, tcp_info_t *info);
+int tcp_recv_syn_data(tcp_t *tcp, tcp_info_t *info);
+void tcp_pred_stats_get(tcp_pred_stats_t *stats);
 
 
 #endif  // TCP_RECV_H
\ No newline at end of file
@@ -13,11 +13,24 @@
 #define TCP_SEND_H
 
 #include "tcp.h"
+#include "tcp_tw.h"
 
 
 
 net_err_t tcp_transmit(tcp_t *tcp);
+net_err_t tcp_retransmit(tcp_t *tcp);
+net_err_t tcp_retransmit_tail(tcp_t *tcp);
+int tcp_rto_get(tcp_t *tcp);
+void tcp_rto_start(tcp_t *tcp);
+void tcp_rto_stop(tcp_t *tcp);
+void tcp_delack_schedule(tcp_t *tcp, int len);
+void tcp_delack_stop(tcp_t *tcp);
+void tcp_pacing_stop(tcp_t *tcp);
+void tcp_persist_stop(tcp_t *tcp);
 net_err_t tcp_send_reset(tcp_info_t *info);
+net_err_t tcp_send_syncookie(tcp_info_t *info, uint32_t isn, uint16_t mss);
+net_err_t tcp_send_tw_ack(tcp_tw_t *tw);
+net_err_t tcp_send_abort(tcp_t *tcp);
 net_err_t tcp_send_syn(tcp_t *tcp);
 net_err_t tcp_send_ack(tcp_t *tcp, tcp_info_t *info);
 net_err_t tcp_send_fin(tcp_t *tcp);
@@ -22,6 +22,7 @@ net_err_t tcp_state_handler_recv(tcp_t *tcp, tcp_info_t *info);
 
 const char *tcp_state_name(tcp_state_t state);
 void tcp_state_set(tcp_t *tcp, tcp_state_t state);
+void tcp_ack_advance(tcp_t *tcp, tcp_info_t *info);
 net_err_t tcp_ack_process(tcp_t *tcp, tcp_info_t *info);
 
 #endif  // TCP_STATE_H
\ No newline at end of file
@@ -0,0 +1,55 @@
+/**
+ * @file tcp_tw.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp TIME_WAIT记录模块
+ * @version 0.1
+ * @date 2024-12-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TCP_TW_H
+#define TCP_TW_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "net_cfg.h"
+#include "nlist.h"
+#include "sock_hash.h"
+#include "tcp.h"
+
+// 定义TIME_WAIT记录结构, 连接进入TIME_WAIT状态后代替tcp对象挂载在连接哈希表中,
+// 只保留应答对端重传的报文段及判断四元组能否复用所需的信息, tcp对象及其缓冲区随即释放
+// 前两个成员与tcp_t相同, 查找结果可以通过state区分(tcp对象不会以TIME_WAIT状态留在哈希表中)
+typedef struct _tcp_tw_t {
+  sock_t sock_base;   // 地址信息及哈希表结点
+  tcp_state_t state;  // 固定为TCP_STATE_TIME_WAIT
+
+  nlist_node_t node;        // 按超时时间顺序挂载到TIME_WAIT链表的结点
+  uint32_t expire;          // 2MSL超时的tcp时钟时间(ms)
+  uint32_t snd_nxt;         // 本地下一个发送序号(已越过本地的fin)
+  uint32_t rcv_nxt;         // 期望接收的下一个序号(已越过对端的fin)
+  uint16_t rcv_wnd;         // 应答时通告的接收窗口
+  uint8_t ts_ok;            // 连接是否协商使用了时间戳选项
+  uint32_t ts_recent;       // 最近一次从对端接收的有效时间戳
+  uint32_t ts_recent_time;  // 记录ts_recent时的本地时间(ms)
+} tcp_tw_t;
+
+// 查找结果按tcp_t读取state后再区分是否为TIME_WAIT记录, 编译期检查两者的前两个成员位置相同,
+// 不满足时数组大小为负, 编译失败
+typedef char tcp_tw_layout_check[(offsetof(tcp_tw_t, sock_base) ==
+                                      offsetof(tcp_t, sock_base) &&
+                                  offsetof(tcp_tw_t, state) ==
+                                      offsetof(tcp_t, state))
+                                     ? 1
+                                     : -1];
+
+net_err_t tcp_tw_module_init(sock_hash_t *conn_hash);
+net_err_t tcp_tw_enter(tcp_t *tcp);
+int tcp_tw_recv(tcp_tw_t *tw, tcp_info_t *info);
+int tcp_tw_can_reuse(tcp_tw_t *tw);
+uint32_t tcp_tw_reuse(tcp_tw_t *tw);
+
+#endif  // TCP_TW_H
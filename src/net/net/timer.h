@@ -23,6 +23,7 @@
 // 定时器属性标志位宏
 #define NET_TIMER_RELOAD (1 << 0)  // 重复定时器
 #define NET_TIMER_ACTIVE (1 << 1)  // 定时器激活
+#define NET_TIMER_OVERTIME (1 << 2)  // 定时器已超时, 在超时链表中等待调用回调函数
 
 struct _net_timer_t;
 
@@ -47,6 +47,9 @@ typedef struct _udp_t {
 
   nlist_t recv_buf_list;  // 接收的数据包缓存链表
   sock_wait_t recv_wait;  // 用于处理udp socket的接收等待事件
+  int reuseport;          // 是否允许与其他socket共享本地地址及端口(SO_REUSEPORT)
+  int gso_size;           // 分段发送时每个数据报的大小(UDP_SEGMENT), 0表示不分段
+  int gro;                // 是否合并同一个流连续到达的数据报(UDP_GRO)
 } udp_t;
 
 net_err_t udp_module_init(void);
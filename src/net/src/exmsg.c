@@ -169,6 +169,9 @@ static void exmsg_handle_netif_recv(exmsg_t *msg) {
   // 获取网络接口
   netif_t *netif = msg->msg_netif.netif;
 
+  // 先清除通知标志再取数据包, 之后放入的数据包会发送新的通知, 不会遗留在接收队列中
+  netif->recv_notified = 0;
+
   // 以非阻塞的方式从网络接口接收数据包
   pktbuf_t *buf = (pktbuf_t *)0;
   while ((buf = netif_recvq_get(netif, -1))) {  //!!! 取数据包
@@ -228,6 +231,11 @@ static void exmsg_work_thread(void *arg) {
   while (1) {
     // 以阻塞方式从消息队列中接收消息, 并设置超时时间为当前最先到期的定时器时间
     exmsg_t *msg = (exmsg_t *)fixq_get(&msg_queue, net_timer_first_tmo());
+
+    // 先按等待消息的时间扫描定时器, 处理消息时新添加的定时器不应计入这段时间,
+    // 否则空闲一段时间后添加的定时器会立即超时
+    net_timer_check_tmo(sys_time_goes(&sys_time));
+
     if (msg) {                  // 有消息
       switch (msg->type) {      // 根据消息类型处理消息
         case EXMSG_NETIF_RECV:  // 网络接口接收到数据包
@@ -0,0 +1,202 @@
+/**
+ * @file gso.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 分段卸载(GSO)模块
+ *        tcp层一次下交一个超过mtu的超级数据段(只构造一次ip及tcp头部),
+ *        由网络接口在发送前按gso_size切分为多个数据帧，
+ *        每个数据帧的头部由超级数据段的头部作为模板拷贝后修改序号、长度及校验和;
+ *        udp层设置UDP_SEGMENT后同样下交超级数据报, 切分为多个等长的数据报(最后一个可能较短)
+ * @version 0.1
+ * @date 2024-11-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "gso.h"
+
+#include "dbg.h"
+#include "ipv4.h"
+#include "protocol.h"
+#include "tcp.h"
+#include "tools.h"
+#include "udp.h"
+
+/**
+ * @brief 判断超级数据段能否由网络接口直接发送, 不能时需由gso_segment切分
+ *        驱动只支持tcp分段卸载(NETIF_F_TSO), udp超级数据报总是在发送前切分
+ *
+ * @param netif
+ * @param buf 超级数据段(包含ip头部)
+ * @return int
+ */
+int gso_offload(netif_t *netif, pktbuf_t *buf) {
+  if (!(netif->features & NETIF_F_TSO) ||
+      pktbuf_set_cont(buf, sizeof(ipv4_hdr_t)) != NET_ERR_OK) {
+    return 0;
+  }
+
+  ipv4_pkt_t *ip_pkt = (ipv4_pkt_t *)pktbuf_data_ptr(buf);
+  return ip_pkt->hdr.tran_proto == NET_PROTOCOL_TCP;
+}
+
+/**
+ * @brief 从超级数据段中切分出一个分段, 并以超级数据段的传输层头部为模板填充头部
+ *
+ * @param buf 超级数据段
+ * @param hdr 超级数据段的ip及传输层头部(模板)
+ * @param ip_hdr_size ip头部大小
+ * @param tran_hdr_size 传输层头部大小
+ * @param offset 分段数据在超级数据段有效数据中的偏移
+ * @param size 分段携带的数据量
+ * @return pktbuf_t* 包含传输层头部的分段
+ */
+static pktbuf_t *gso_seg_alloc(pktbuf_t *buf, const uint8_t *hdr,
+                               int ip_hdr_size, int tran_hdr_size, int offset,
+                               int size) {
+  pktbuf_t *seg = pktbuf_alloc(size);  //!!! 分配数据包
+  if (!seg) {
+    dbg_warning(DBG_NETIF, "no free pktbuf for gso seg.");
+    return (pktbuf_t *)0;
+  }
+
+  // 拷贝分段的有效数据
+  pktbuf_seek(buf, ip_hdr_size + tran_hdr_size + offset);
+  if (pktbuf_copy(seg, buf, size) != NET_ERR_OK) {
+    goto gso_seg_alloc_failed;
+  }
+
+  // 添加并拷贝传输层头部模板
+  if (pktbuf_header_add(seg, tran_hdr_size, PKTBUF_ADD_HEADER_CONT) !=
+      NET_ERR_OK) {
+    goto gso_seg_alloc_failed;
+  }
+  plat_memcpy(pktbuf_data_ptr(seg), hdr + ip_hdr_size, tran_hdr_size);
+
+  return seg;
+
+gso_seg_alloc_failed:
+  dbg_error(DBG_NETIF, "gso seg alloc failed.");
+  pktbuf_free(seg);  //!!! 释放数据包
+  return (pktbuf_t *)0;
+}
+
+/**
+ * @brief 将超级数据段按gso_size切分为多个不超过mtu的数据帧并逐个发送
+ *        ip标识从超级数据段的标识开始依次递增;
+ *        tcp: fin及psh标志只保留在最后一个分段, 每个分段的序号依次递增,
+ *        udp: 每个分段为一个独立的数据报, 修改其长度,
+ *        每个分段的传输层校验和在此处计算(超级数据段的校验和未计算)
+ *        至少发出一个分段后即释放超级数据段并返回成功, 之后的分段发送失败(如发送队列已满)时
+ *        丢弃剩余的数据, 与链路上的丢包相同(tcp重传, udp不保证送达);
+ *        第一个分段就发送失败时由调用者负责释放
+ *
+ * @param netif 网络接口
+ * @param ipaddr 下一跳ip地址
+ * @param buf tcp或udp超级数据段(包含ip头部)
+ * @return net_err_t
+ */
+net_err_t gso_segment(netif_t *netif, const ipaddr_t *ipaddr, pktbuf_t *buf) {
+  // 将ip头部及传输层头部(含选项)设置为内存连续，作为每个分段头部的模板
+  net_err_t err = pktbuf_set_cont(buf, sizeof(ipv4_hdr_t));
+  if (err != NET_ERR_OK) {
+    return err;
+  }
+  ipv4_pkt_t *ip_pkt = (ipv4_pkt_t *)pktbuf_data_ptr(buf);
+  int ip_hdr_size = ipv4_get_hdr_size(ip_pkt);
+  uint8_t protocol = ip_pkt->hdr.tran_proto;
+  int tran_hdr_size;
+  if (protocol == NET_PROTOCOL_TCP) {
+    err = pktbuf_set_cont(buf, ip_hdr_size + sizeof(tcp_hdr_t));
+    if (err != NET_ERR_OK) {
+      return err;
+    }
+    tcp_hdr_t *tcp_hdr =
+        (tcp_hdr_t *)((uint8_t *)pktbuf_data_ptr(buf) + ip_hdr_size);
+    tran_hdr_size = tcp_get_hdr_size(tcp_hdr);
+  } else if (protocol == NET_PROTOCOL_UDP) {
+    tran_hdr_size = sizeof(udp_hdr_t);
+  } else {
+    dbg_error(DBG_NETIF, "gso only support tcp and udp.");
+    return NET_ERR_PARAM;
+  }
+
+  err = pktbuf_set_cont(buf, ip_hdr_size + tran_hdr_size);
+  if (err != NET_ERR_OK) {
+    return err;
+  }
+
+  // 获取头部模板及其中需要在每个分段中修改的字段
+  uint8_t *hdr = (uint8_t *)pktbuf_data_ptr(buf);
+  ip_pkt = (ipv4_pkt_t *)hdr;
+  ipaddr_t src_ip, dest_ip;
+  ipaddr_from_bytes(&src_ip, ip_pkt->hdr.src_ip);
+  ipaddr_from_bytes(&dest_ip, ip_pkt->hdr.dest_ip);
+  uint16_t id = net_ntohs(ip_pkt->hdr.id);
+  uint32_t seq = protocol == NET_PROTOCOL_TCP
+                     ? net_ntohl(((tcp_hdr_t *)(hdr + ip_hdr_size))->seq)
+                     : 0;
+
+  int data_size = pktbuf_total_size(buf) - ip_hdr_size - tran_hdr_size;
+  int offset = 0;
+  for (; offset < data_size; offset += buf->gso_size, id++) {
+    int size = MIN(buf->gso_size, data_size - offset);
+    pktbuf_t *seg =
+        gso_seg_alloc(buf, hdr, ip_hdr_size, tran_hdr_size, offset, size);
+    if (!seg) {
+      err = NET_ERR_MEM;
+      break;
+    }
+
+    if (protocol == NET_PROTOCOL_TCP) {
+      // 修改tcp头部的序号及标志位，并计算tcp校验和
+      tcp_hdr_t *seg_tcp = (tcp_hdr_t *)pktbuf_data_ptr(seg);
+      seg_tcp->seq = net_htonl(seq + offset);
+      if (offset + size < data_size) {
+        seg_tcp->f_fin = seg_tcp->f_psh = 0;
+      }
+      seg_tcp->checksum = 0;
+      seg_tcp->checksum = tools_checksum16_pseudo_head(
+          seg, &dest_ip, &src_ip, NET_PROTOCOL_TCP);
+    } else {
+      // 修改udp头部的长度，并计算udp校验和
+      udp_hdr_t *seg_udp = (udp_hdr_t *)pktbuf_data_ptr(seg);
+      seg_udp->total_len = net_htons(pktbuf_total_size(seg));
+      seg_udp->checksum = 0;
+      seg_udp->checksum = tools_checksum16_pseudo_head(
+          seg, &dest_ip, &src_ip, NET_PROTOCOL_UDP);
+    }
+
+    // 添加ip头部模板，修改总长度及标识，并计算头部校验和
+    err = pktbuf_header_add(seg, ip_hdr_size, PKTBUF_ADD_HEADER_CONT);
+    if (err != NET_ERR_OK) {
+      dbg_error(DBG_NETIF, "gso seg add ip header failed.");
+      pktbuf_free(seg);  //!!! 释放数据包
+      break;
+    }
+    plat_memcpy(pktbuf_data_ptr(seg), hdr, ip_hdr_size);
+    ipv4_pkt_t *seg_ip = (ipv4_pkt_t *)pktbuf_data_ptr(seg);
+    seg_ip->hdr.total_len = net_htons(pktbuf_total_size(seg));
+    seg_ip->hdr.id = net_htons(id);
+    seg_ip->hdr.hdr_chksum = 0;
+    seg_ip->hdr.hdr_chksum = tools_checksum16(seg_ip, ip_hdr_size, 0, 0, 1);
+
+    err = netif_send(netif, ipaddr, seg);  //!!! 数据包传递
+    if (err != NET_ERR_OK) {
+      dbg_error(DBG_NETIF, "netif send gso seg failed.");
+      pktbuf_free(seg);  //!!! 释放数据包
+      break;
+    }
+  }
+
+  // 第一个分段就失败时由调用者处理错误, 否则已发出的分段有效, 丢弃剩余的数据
+  if (err != NET_ERR_OK && offset == 0) {
+    return err;
+  }
+  if (err != NET_ERR_OK) {
+    dbg_warning(DBG_NETIF, "gso drop %d bytes after send failed.",
+                data_size - offset);
+  }
+  pktbuf_free(buf);  //!!! 释放数据包
+  return NET_ERR_OK;
+}
@@ -17,6 +17,12 @@
 #include "net_err.h"
 #include "protocol.h"
 #include "sock_raw.h"
+#include "tcp.h"
+#include "tools.h"
+
+// 路由器未填写下一跳mtu时用于估计路径mtu的常用mtu表(RFC 1191)
+static const uint16_t icmpv4_mtu_plateau[] = {32000, 17914, 8166, 4352, 2002,
+                                              1492,  1006,  508,  296,  68};
 
 #if DBG_DISP_ENABLED(DBG_ICMPV4)
 
@@ -143,6 +149,61 @@ static net_err_t icmpv4_make_echo_reply(const ipaddr_t *dest_ipaddr,
   return icmpv4_send(dest_ipaddr, src_ipaddr, icmpv4_pktbuf);
 }
 
+/**
+ * @brief 处理icmpv4"需要分片"报文(RFC 1191): 更新原始数据包目的主机的路径mtu,
+ *        原始数据包为tcp报文段时通知对应的tcp连接减小mss
+ *        路由器未填写下一跳mtu时(RFC 1191之前的实现), 按原始数据包的大小从常用mtu表中估计
+ *
+ * @param buf 封装了icmpv4数据包的ipv4数据包
+ * @param ip_hdr_size ipv4头部大小
+ */
+static void icmpv4_frag_needed(pktbuf_t *buf, int ip_hdr_size) {
+  // 报文负载为原始数据包的ipv4头部及传输层头部的前8个字节(包含端口号及tcp序号)
+  int size = ip_hdr_size + sizeof(icmpv4_hdr_t) + sizeof(ipv4_hdr_t);
+  if (pktbuf_total_size(buf) < size + 8 ||
+      pktbuf_set_cont(buf, size) != NET_ERR_OK) {
+    return;
+  }
+  ipv4_pkt_t *orig = (ipv4_pkt_t *)((uint8_t *)pktbuf_data_ptr(buf) + size -
+                                    sizeof(ipv4_hdr_t));
+  size += ipv4_get_hdr_size(orig) - sizeof(ipv4_hdr_t) + 8;
+  if (orig->hdr.version != IPV4_VERSION || pktbuf_total_size(buf) < size ||
+      pktbuf_set_cont(buf, size) != NET_ERR_OK) {
+    return;
+  }
+
+  // 设置连续性后数据可能被移动, 重新获取各头部
+  icmpv4_hdr_t *icmp_hdr =
+      (icmpv4_hdr_t *)((uint8_t *)pktbuf_data_ptr(buf) + ip_hdr_size);
+  orig = (ipv4_pkt_t *)(icmp_hdr + 1);
+  uint8_t *tran_hdr = (uint8_t *)orig + ipv4_get_hdr_size(orig);
+
+  int total_len = net_ntohs(orig->hdr.total_len);
+  int mtu = net_ntohs(icmp_hdr->frag.next_mtu);
+  if (mtu == 0 || mtu >= total_len) {
+    mtu = 0;
+    for (int i = 0; i < sizeof(icmpv4_mtu_plateau) / sizeof(uint16_t); i++) {
+      if (icmpv4_mtu_plateau[i] < total_len) {
+        mtu = icmpv4_mtu_plateau[i];
+        break;
+      }
+    }
+  }
+  mtu = MAX(mtu, IPV4_PMTU_MIN);
+
+  ipaddr_t src_ip, dest_ip;
+  ipaddr_from_bytes(&src_ip, orig->hdr.src_ip);
+  ipaddr_from_bytes(&dest_ip, orig->hdr.dest_ip);
+  ipv4_pmtu_update(&dest_ip, mtu);
+
+  if (orig->hdr.tran_proto == NET_PROTOCOL_TCP) {
+    tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)tran_hdr;
+    tcp_pmtu_reduced(&src_ip, &dest_ip, net_ntohs(tcp_hdr->src_port),
+                     net_ntohs(tcp_hdr->dest_port), net_ntohl(tcp_hdr->seq),
+                     mtu);
+  }
+}
+
 /**
  * @brief 接收一个icmpv4数据包
  *7
@@ -192,6 +253,18 @@ net_err_t icmpv4_recv(pktbuf_t *buf, const ipaddr_t *dest_ipaddr,
       return icmpv4_make_echo_reply(src_ipaddr, dest_ipaddr,
                                     buf);  //!!! 数据包传递
     } break;
+    case ICMPv4_TYPE_UNREACH: {
+      if (icmpv4_pkt->hdr.code == ICMPv4_CODE_UNREACH_FRAG) {
+        icmpv4_frag_needed(buf, ip_hdr_size);
+      }
+
+      // 不可达报文(包含ipv4头部)同样递交给原始socket模块处理
+      err = sockraw_recv_pktbuf(buf);  //!!! 数据包传递
+      if (err != NET_ERR_OK) {
+        dbg_error(DBG_ICMPV4, "sockraw recv pktbuf failed.");
+        return err;
+      }
+    } break;
     default: {
       dbg_warning(DBG_ICMPV4, "unknown icmpv4 pkt type.");
       // 其余类型的icmpv4数据包(包含ipv4头部)直接递交给原始socket模块处理
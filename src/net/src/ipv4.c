@@ -30,6 +30,10 @@ static ipv4_frag_t ipv4_frag_arr[IPV4_FRAG_MAXCNT];  // ipv4分片数组(分片
 static mblock_t ipv4_frag_mblock;  // ipv4分片内存池管理对象
 static nlist_t ipv4_frag_list;  // ipv4分片链表，记录已分配的分片
 static net_timer_t ipv4_frag_timer;  // ipv4分片超时定时器
+static ipv4_pmtu_t ipv4_pmtu_arr[IPV4_PMTU_MAXCNT];  // 路径mtu缓存数组(缓存表项内存池)
+static mblock_t ipv4_pmtu_mblock;  // 路径mtu缓存表项内存池管理对象
+static nlist_t ipv4_pmtu_list;  // 路径mtu缓存链表，记录已分配的表项
+static net_timer_t ipv4_pmtu_timer;  // 路径mtu缓存表项超时定时器
 
 /**
  * @brief 获取分片数据包的有效数据大小
@@ -149,9 +153,17 @@ static void ipv4_frags_show(void) {
 #define ipv4_frags_show()
 #endif
 
-static inline int ipv4_get_id(void) {
+/**
+ * @brief 分配cnt个连续的ipv4数据包标识
+ *
+ * @param cnt
+ * @return int 第一个标识
+ */
+static inline int ipv4_get_id(int cnt) {
   static int id = 0;
-  return id++;
+  int first = id;
+  id += cnt;
+  return first;
 }
 
 /**
@@ -254,6 +266,119 @@ static net_err_t ipv4_frag_init(void) {
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 路径mtu缓存表项超时处理函数, 释放超时的表项, 使到达其目的主机的数据包重新使用网络接口的mtu,
+ *        以发现路径mtu是否已增大
+ *
+ * @param timer
+ * @param arg
+ */
+static void ipv4_pmtu_tmo(net_timer_t *timer, void *arg) {
+  nlist_node_t *curr_node = 0, *next_node = 0;
+
+  nlist_for_each_safe(curr_node, next_node, &ipv4_pmtu_list) {
+    ipv4_pmtu_t *pmtu = nlist_entry(curr_node, ipv4_pmtu_t, node);
+    if (--pmtu->tmo <= 0) {
+      nlist_remove(&ipv4_pmtu_list, &pmtu->node);
+      mblock_free(&ipv4_pmtu_mblock, pmtu);
+    }
+  }
+}
+
+/**
+ * @brief 初始化路径mtu缓存表
+ *
+ * @return net_err_t
+ */
+static net_err_t ipv4_pmtu_init(void) {
+  // 路径mtu缓存表只由工作线程访问，无需加锁
+  net_err_t err =
+      mblock_init(&ipv4_pmtu_mblock, ipv4_pmtu_arr, sizeof(ipv4_pmtu_t),
+                  IPV4_PMTU_MAXCNT, NLOCKER_NONE);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_IPV4, "init ipv4 pmtu mblock failed.");
+    return err;
+  }
+
+  nlist_init(&ipv4_pmtu_list);
+
+  err = net_timer_add(&ipv4_pmtu_timer, "ipv4 pmtu timer", ipv4_pmtu_tmo,
+                      &ipv4_pmtu_timer, IPV4_PMTU_SCAN_PERIOD * 1000,
+                      NET_TIMER_ACTIVE | NET_TIMER_RELOAD);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_IPV4, "init ipv4 pmtu timer failed.");
+    return err;
+  }
+
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 查找目的主机的路径mtu缓存表项
+ *
+ * @param dest_ip
+ * @return ipv4_pmtu_t*
+ */
+static ipv4_pmtu_t *ipv4_pmtu_find(const ipaddr_t *dest_ip) {
+  nlist_node_t *node = 0;
+  nlist_for_each(node, &ipv4_pmtu_list) {
+    ipv4_pmtu_t *pmtu = nlist_entry(node, ipv4_pmtu_t, node);
+    if (ipaddr_is_equal(&pmtu->dest_ip, dest_ip)) {
+      return pmtu;
+    }
+  }
+
+  return (ipv4_pmtu_t *)0;
+}
+
+/**
+ * @brief 获取到达目的主机的路径mtu
+ *
+ * @param dest_ip
+ * @param mtu 发送数据包的网络接口的mtu
+ * @return int 缓存的路径mtu与网络接口mtu中的较小值
+ */
+int ipv4_pmtu_get(const ipaddr_t *dest_ip, int mtu) {
+  if (nlist_is_empty(&ipv4_pmtu_list)) {
+    return mtu;
+  }
+
+  ipv4_pmtu_t *pmtu = ipv4_pmtu_find(dest_ip);
+  return (pmtu && pmtu->mtu < mtu) ? pmtu->mtu : mtu;
+}
+
+/**
+ * @brief 根据icmp"需要分片"报文更新到达目的主机的路径mtu,
+ *        只接受比当前缓存值更小的路径mtu(RFC 1191), 缓存表已满时复用最久未更新的表项
+ *
+ * @param dest_ip
+ * @param mtu
+ */
+void ipv4_pmtu_update(const ipaddr_t *dest_ip, int mtu) {
+  mtu = MAX(mtu, IPV4_PMTU_MIN);
+
+  ipv4_pmtu_t *pmtu = ipv4_pmtu_find(dest_ip);
+  if (pmtu) {
+    if (mtu >= pmtu->mtu) {
+      return;
+    }
+    nlist_remove(&ipv4_pmtu_list, &pmtu->node);
+  } else {
+    pmtu = (ipv4_pmtu_t *)mblock_alloc(&ipv4_pmtu_mblock, -1);
+    if (!pmtu) {
+      pmtu = nlist_entry(nlist_remove_last(&ipv4_pmtu_list), ipv4_pmtu_t,
+                         node);
+    }
+    nlist_node_init(&pmtu->node);
+    ipaddr_copy(&pmtu->dest_ip, dest_ip);
+  }
+
+  pmtu->mtu = mtu;
+  pmtu->tmo = IPV4_PMTU_TMO / IPV4_PMTU_SCAN_PERIOD;
+  nlist_insert_first(&ipv4_pmtu_list, &pmtu->node);
+  dbg_info(DBG_IPV4, "ipv4 pmtu update to %d.", mtu);
+}
+
 /**
  * @brief 初始化ipv4协议模块
  *
@@ -269,6 +394,13 @@ net_err_t ipv4_module_init(void) {
     return err;
   }
 
+  // 初始化路径mtu缓存表
+  err = ipv4_pmtu_init();
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_IPV4, "init ipv4 pmtu failed.");
+    return err;
+  }
+
   // 初始化路由表
   err = route_init();
   if (err != NET_ERR_OK) {
@@ -361,6 +493,9 @@ static net_err_t ipv4_handle_normal(const netif_t *netif, pktbuf_t *buf) {
   ipaddr_from_bytes(&src_ip, pkt->hdr.src_ip);
   ipaddr_from_bytes(&dest_ip, pkt->hdr.dest_ip);
 
+  // 记录ecn码点, 上层协议移除ipv4头部后仍可得知数据包是否被标记了拥塞
+  buf->ecn = pkt->hdr.ecn;
+
   // 根据数据包的协议字段将其提供给上一层协议处理，ip包有可能会触发上层协议的不可达错误
   // 当触发不可达错误时，需要尽可能返回该ip包的数据，所以ip包头在上层协议接收该包时再移除
   switch (pkt->hdr.tran_proto) {
@@ -468,12 +603,14 @@ static int ipv4_frag_buf_is_all(ipv4_frag_t *frag) {
  */
 static pktbuf_t *ipv4_frag_buf_collect(ipv4_frag_t *frag) {
   pktbuf_t *target_buf = 0;  // 重组后的数据包
+  int ce = 0;                // 是否有分片被标记了拥塞
 
   // 遍历分片数据包链表，将数据包重组
   nlist_node_t *node = 0;
   while ((node = nlist_remove_first(&frag->buf_list))) {
     pktbuf_t *curr_buf = nlist_entry(node, pktbuf_t, node);  //!!! 获取数据包
     ipv4_pkt_t *curr_pkt = pktbuf_data_ptr(curr_buf);
+    ce |= curr_pkt->hdr.ecn == IPV4_ECN_CE;
     if (!target_buf) {
       target_buf = curr_buf;
       continue;
@@ -498,6 +635,11 @@ static pktbuf_t *ipv4_frag_buf_collect(ipv4_frag_t *frag) {
     }
   }
 
+  // 任一分片被标记了拥塞时, 重组后的数据包同样视为被标记(RFC 3168)
+  if (target_buf && ce) {
+    ((ipv4_pkt_t *)pktbuf_data_ptr(target_buf))->hdr.ecn = IPV4_ECN_CE;
+  }
+
   return target_buf;
 }
 
@@ -697,6 +839,29 @@ net_err_t ipv4_recv(const netif_t *netif, pktbuf_t *buf) {
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 获取待发送数据包的ecn码点
+ *        配置了IPV4_ECN_MARK_QLEN时, 支持ECN的数据包在网络接口的发送队列积压到该数量时标记为CE,
+ *        在队列填满而丢弃数据包之前就向发送方通告拥塞(RFC 3168);
+ *        默认不标记: 本机的发送队列积压时由本机的拥塞控制处理, 标记自己的报文只会无故降低发送速率
+ *
+ * @param netif 发送数据包的网络接口
+ * @param buf 上层数据包
+ * @return uint8_t
+ */
+static uint8_t ipv4_ecn_out(netif_t *netif, pktbuf_t *buf) {
+  if (buf->ecn == IPV4_ECN_NOT_ECT) {
+    return IPV4_ECN_NOT_ECT;
+  }
+
+#if IPV4_ECN_MARK_QLEN > 0
+  if (fixq_count(&netif->send_fixq) >= IPV4_ECN_MARK_QLEN) {
+    return IPV4_ECN_CE;
+  }
+#endif
+  return (uint8_t)buf->ecn;
+}
+
 /**
  * @brief 对上层数据包进行分片处理，并包装成ipv4数据包发送
  *
@@ -706,26 +871,29 @@ net_err_t ipv4_recv(const netif_t *netif, pktbuf_t *buf) {
  * @param buf 上层数据包(不包含ipv4头部)
  * @param netif 发送数据包的网络接口
  * @param next_hop 下一跳地址
+ * @param mtu 分片的最大大小(不超过网络接口的mtu及路径mtu)
  * @return net_err_t
  */
 net_err_t ipv4_frag_send(uint8_t tran_protocol, const ipaddr_t *dest_ipaddr,
                          const ipaddr_t *src_ipaddr, pktbuf_t *buf,
-                         netif_t *netif, const ipaddr_t *next_hop) {
+                         netif_t *netif, const ipaddr_t *next_hop, int mtu) {
   // TODO:
   // 后续优化思路：在进行分片处理时，不进行内存的再分配与拷贝，而是直接在原数据包上进行分片处理
   dbg_info(DBG_IPV4, "send an ipv4 frag packet....");
   net_err_t err = NET_ERR_OK;
 
-  // 获取当前要发送的ipv4所有分片
-  int ipv4_id = ipv4_get_id();
+  // 获取当前要发送的ipv4所有分片, 所有分片使用相同的ecn码点
+  int ipv4_id = ipv4_get_id(1);
+  uint8_t ecn = ipv4_ecn_out(netif, buf);
 
   // 对数据包进行分片处理
   int offset = 0, total_size = pktbuf_total_size(buf);
   pktbuf_acc_reset(buf);  // 重置待发送数据的访问位置
   while (total_size > 0) {
     // 计算当前分片的有效数据长度
-    int curr_size = total_size > netif->mtu ? (netif->mtu - sizeof(ipv4_hdr_t))
-                                            : total_size;
+    int curr_size =
+        total_size > mtu - sizeof(ipv4_hdr_t) ? (mtu - sizeof(ipv4_hdr_t)) & ~7
+                                              : total_size;
     // 为当前分片数据包分配内存, 大小 = 有效数据长度(curr_size) + ipv4头部大小
     pktbuf_t *frag_buf =
         pktbuf_alloc(curr_size + sizeof(ipv4_hdr_t));  //!!! 分配数据包
@@ -758,7 +926,7 @@ net_err_t ipv4_frag_send(uint8_t tran_protocol, const ipaddr_t *dest_ipaddr,
     ipv4_pkt_t *pkt = pktbuf_data_ptr(frag_buf);
     pkt->hdr.version = IPV4_VERSION;
     ipv4_set_hdr_size(pkt, sizeof(ipv4_hdr_t));
-    pkt->hdr.ecn = 0;
+    pkt->hdr.ecn = ecn;
     pkt->hdr.diff_service = 0;
     pkt->hdr.total_len = pktbuf_total_size(frag_buf);
     pkt->hdr.id = ipv4_id;
@@ -843,13 +1011,20 @@ net_err_t ipv4_send(uint8_t tran_protocol, const ipaddr_t *dest_ipaddr,
     next_hop = &rt_entry->next_hop;
   }
 
-  // 判断数据包是否需要进行分片处理
+  // 判断数据包是否需要进行分片处理,
+  // tcp或udp超级数据段由网络接口按mtu进行分段(GSO)，不需要分片
+  // 进行路径mtu发现时tcp报文段设置禁止分片标志, 由tcp按路径mtu调整mss, 其余数据包按路径mtu分片
   int ipv4_total_size = pktbuf_total_size(buf) + sizeof(ipv4_hdr_t);
-  if (netif->mtu && ipv4_total_size > netif->mtu) {
-    // 数据包大小超过了网络接口链路层的最大传输单元
+  int df = IPV4_PMTU_DISC_ENABLE && tran_protocol == NET_PROTOCOL_TCP;
+  int mtu = netif->mtu;
+  if (mtu && !df && ipv4_total_size > IPV4_PMTU_MIN) {
+    mtu = ipv4_pmtu_get(dest_ipaddr, mtu);
+  }
+  if (mtu && ipv4_total_size > mtu && !buf->gso_size) {
+    // 数据包大小超过了网络接口链路层或路径的最大传输单元
     // 需要对数据包进行分片处理
     err = ipv4_frag_send(tran_protocol, dest_ipaddr, src_ipaddr, buf, netif,
-                         next_hop);  //!!! 数据包传递
+                         next_hop, mtu);  //!!! 数据包传递
     if (err != NET_ERR_OK) {
       dbg_error(DBG_IPV4, "frag send failed.");
       return err;
@@ -869,11 +1044,16 @@ net_err_t ipv4_send(uint8_t tran_protocol, const ipaddr_t *dest_ipaddr,
   ipv4_pkt_t *pkt = pktbuf_data_ptr(buf);
   pkt->hdr.version = IPV4_VERSION;
   ipv4_set_hdr_size(pkt, sizeof(ipv4_hdr_t));
-  pkt->hdr.ecn = 0;
+  pkt->hdr.ecn = ipv4_ecn_out(netif, buf);
   pkt->hdr.diff_service = 0;
   pkt->hdr.total_len = ipv4_total_size;
-  pkt->hdr.id = ipv4_get_id();
+  // 超级数据段的每个分段都需要一个标识，以超级数据段的标识为起始依次递增
+  pkt->hdr.id = ipv4_get_id(
+      buf->gso_size ? (ipv4_total_size - sizeof(ipv4_hdr_t) + buf->gso_size - 1) /
+                          buf->gso_size
+                    : 1);
   pkt->hdr.flags_frag_offset = 0;
+  pkt->hdr.frag_disable = df;
   pkt->hdr.ttl = IPV4_DEFAULT_TTL;
   pkt->hdr.tran_proto = tran_protocol;
   pkt->hdr.hdr_chksum = 0;
@@ -25,6 +25,10 @@
 static net_err_t loop_open(netif_t *netif, void *data) {
     // 设置网络接口类型为环回接口
     netif->type = NETIF_TYPE_LOOP;
+    netif->mtu = NETIF_LOOP_MTU;
+#if NETIF_LOOP_TSO
+    netif->features |= NETIF_F_TSO;  // 数据不离开本机，超级数据段无需分段
+#endif
 
     return NET_ERR_OK;
 }
@@ -54,7 +58,8 @@ static net_err_t loop_send(netif_t *netif) {
         return NET_ERR_OK;
     }
 
-    // 将数据包放入接收队列
+    // 将数据包放入接收队列, 超级数据段作为一个完整的数据包被接收
+    buf->gso_size = 0;
     net_err_t err = netif_recvq_put(netif, buf, -1);    //!!! 数据包传递
     if (err != NET_ERR_OK) {    //  如果放入失败,则释放数据包
         pktbuf_free(buf); //!!! 释放数据包
@@ -15,6 +15,7 @@
 #include "ether.h"
 #include "exmsg.h"
 #include "fixq.h"
+#include "gso.h"
 #include "ipaddr.h"
 #include "mblock.h"
 #include "nlist.h"
@@ -151,6 +152,8 @@ netif_t *netif_open(const char *dev_name, const netif_ops_t *ops,
   plat_memset(&(netif->hwaddr), 0, sizeof(netif_hwaddr_t));  // 清空硬件地址
   netif->type = NETIF_TYPE_NONE;  // 接口在打开时不知道类型, 先设置为无类型
   netif->mtu = 0;                 // 最大传输单元，暂时设置为0
+  netif->features = 0;            // 卸载特性由驱动在打开时设置
+  netif->recv_notified = 0;       // 接收队列为空, 尚未通知工作线程
 
   // 初始化节点, 用于挂载到已使用网络接口的链表(netif_list)中
   nlist_node_init(&(netif->node));
@@ -409,13 +412,19 @@ net_err_t netif_recvq_put(netif_t *netif, pktbuf_t *buf, int tmo) {
     return NET_ERR_FULL;
   }
 
-  // 测试用, 通知工作线程有数据到达
+  // 工作线程处理通知时会取完接收队列中的所有数据包,
+  // 所以已有未处理的通知时不再发送, 避免大量数据包到达时耗尽消息结构
+  if (netif->recv_notified) {
+    return NET_ERR_OK;
+  }
+
   // 发送到消息队列(网卡管理线程与数据包处理线程)中
+  // 数据包已转交给接收队列, 通知失败时不能返回错误(调用者会释放该数据包),
+  // 保持未通知的状态, 由下一个到达的数据包重新发送通知
+  netif->recv_notified = 1;
   err = exmsg_netif_recv(netif);
   if (err != NET_ERR_OK) {
-    // TODO:
-    // 数据包已转交，但消息通知失败，该数据包可能一直在接收队列中，导致内存泄漏，需要进一步处理
-    //  且不能直接返回错误，否则会导致上层调用者释放一个在接收队列中的数据包
+    netif->recv_notified = 0;
     dbg_warning(DBG_NETIF, "exmsg netif recv failed.");
   }
 
@@ -491,6 +500,12 @@ net_err_t netif_send(netif_t *netif, const ipaddr_t *ipaddr, pktbuf_t *buf) {
 
   net_err_t err = NET_ERR_OK;
 
+  // 超级数据段在此处(尽可能晚)按mtu切分为多个数据帧,
+  // 驱动支持tcp分段卸载时tcp超级数据段直接交给驱动处理
+  if (buf->gso_size && !gso_offload(netif, buf)) {
+    return gso_segment(netif, ipaddr, buf);  //!!! 数据包传递
+  }
+
   if (netif->link_layer) {                              // 进行链路层处理
     err = netif->link_layer->send(netif, ipaddr, buf);  //!!! 数据包传递
     if (err != NET_ERR_OK) {
@@ -69,9 +69,27 @@ static inline int pktbuf_currblk_remain_size(const pktbuf_t *buf) {
  * @return int
  */
 static inline int pktblk_tail_free_size(pktblk_t *blk) {
+  // 引用外部数据区的数据块不能扩展
+  if (blk->ext) {
+    return 0;
+  }
   return (int)((blk->payload + PKTBUF_BLK_SIZE) - (blk->data + blk->data_size));
 }
 
+/**
+ * @brief 获取数据块的头部剩余空闲空间大小
+ *
+ * @param blk
+ * @return int
+ */
+static inline int pktblk_head_free_size(pktblk_t *blk) {
+  // 引用外部数据区的数据块不能扩展
+  if (blk->ext) {
+    return 0;
+  }
+  return (int)(blk->data - blk->payload);
+}
+
 #if DBG_DISP_ENABLED(DBG_PKTBUF)
 static void display_check_buf(pktbuf_t *pktbuf) {
   if (pktbuf == (pktbuf_t *)0) {
@@ -86,6 +104,13 @@ static void display_check_buf(pktbuf_t *pktbuf) {
   for (curr = pktbuf_blk_first(pktbuf); curr; curr = pktbuf_blk_next(curr)) {
     plat_printf("[%d]:\t", index++);
 
+    // 引用外部数据区的数据块不使用有效载荷区域
+    if (curr->ext) {
+      plat_printf("ext: %d B\n", curr->data_size);
+      buf_total_size += curr->data_size;
+      continue;
+    }
+
     // 检测已使用的载荷区域是否在有效载荷区域内
     if (curr->data < curr->payload ||
         curr->data >= curr->payload + PKTBUF_BLK_SIZE) {
@@ -146,6 +171,21 @@ net_err_t pktbuf_module_init(void) {
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 判断数据包池或数据块池的空闲数量是否已低于总量的1/div, 用于判断内存是否紧张
+ *
+ * @param div
+ * @return int
+ */
+int pktbuf_pool_low(int div) {
+  nlocker_lock(&pkt_locker);
+  int low = nlist_count(&pktblk_list.free_list) < PKTBUF_BLK_CNT / div ||
+            nlist_count(&pktbuf_list.free_list) < PKTBUF_BUF_CNT / div;
+  nlocker_unlock(&pkt_locker);
+
+  return low;
+}
+
 /**
  * @brief 从数据块池中分配一个数据块
  *
@@ -163,6 +203,7 @@ static pktblk_t *pktblock_alloc(void) {
 
   pktblk->data_size = 0;
   pktblk->data = (uint8_t *)0;
+  pktblk->ext = (pktbuf_ext_t *)0;
   nlist_node_init(&pktblk->node);
 
   return pktblk;
@@ -175,6 +216,10 @@ static pktblk_t *pktblock_alloc(void) {
  */
 static void pktblock_free(pktblk_t *pktblk) {
   nlocker_lock(&pkt_locker);  // 加锁
+  // 释放对外部数据区的引用
+  if (pktblk->ext) {
+    pktblk->ext->ref_cnt--;
+  }
   mblock_free(&pktblk_list, pktblk);
   nlocker_unlock(&pkt_locker);  // 解锁
 }
@@ -275,6 +320,8 @@ pktbuf_t *pktbuf_alloc(int size) {
   // 初始化数据包
   pktbuf->total_size = 0;
   pktbuf->ref_cnt = 1;
+  pktbuf->gso_size = 0;
+  pktbuf->ecn = 0;
   nlist_init(&pktbuf->blk_list);
   nlist_node_init(&pktbuf->node);
 
@@ -346,7 +393,7 @@ net_err_t pktbuf_header_add(pktbuf_t *buf, int size, int is_cont) {
   // 将当前数据包的第一个数据块剩余空闲空间利用起来
   pktblk_t *block = pktbuf_blk_first(buf);
   // 计算当前数据块头部的剩余空闲空间
-  int resv_size = (int)(block->data - block->payload);
+  int resv_size = pktblk_head_free_size(block);
   if (size <= resv_size) {  // 头部剩余空间足够拓展
     block->data -= size;
     block->data_size += size;
@@ -366,7 +413,7 @@ net_err_t pktbuf_header_add(pktbuf_t *buf, int size, int is_cont) {
       return NET_ERR_SIZE;
     }
 
-  } else {  // 不保证数据在内存上的连续
+  } else if (resv_size > 0) {  // 不保证数据在内存上的连续
 
     // 将当前头部数据块的剩余空间利用起来
     block->data = block->payload;
@@ -428,9 +475,10 @@ net_err_t pktbuf_header_remove(pktbuf_t *buf, int size) {
     block = next_blk;
   }
 
-  // 判断数据包访问位置是否需要更新，若当前访问位置在移除的数据块中，则更新访问位置
+  // 判断数据包访问位置是否需要更新，若当前访问位置在移除的数据块中，则更新访问位置,
+  // 访问位置恰好在移除的末尾时，其所在的数据块可能已被释放，同样需要重置
   buf->pos -= remove_size;
-  if (buf->pos < 0) {
+  if (buf->pos <= 0) {
     pktbuf_acc_reset(buf);
   }
 
@@ -598,6 +646,12 @@ net_err_t pktbuf_set_cont(pktbuf_t *buf, int size) {
     return NET_ERR_OK;
   }
 
+  // 外部数据区不能被修改，无法将后续数据调整到其中
+  if (first_blk->ext) {
+    dbg_error(DBG_PKTBUF, "pktbuf set cont failed, first block is external.");
+    return NET_ERR_SIZE;
+  }
+
   // 将第一个数据块的数据调整到数据块有效载荷的起始位置
   uint8_t *dest = first_blk->payload;
   if (first_blk->data != first_blk->payload) {
@@ -640,6 +694,11 @@ net_err_t pktbuf_set_cont(pktbuf_t *buf, int size) {
     }
   }
 
+  // 数据在数据块间发生了移动，按原偏移量重新定位访问位置
+  int pos = buf->pos;
+  pktbuf_acc_reset(buf);
+  pktbuf_pos_move_forward(buf, pos);
+
   display_check_buf(buf);
   return NET_ERR_OK;
 }
@@ -902,6 +961,72 @@ pktbuf_t *pktbuf_inc_ref(pktbuf_t *buf) {
   return buf;
 }
 
+/**
+ * @brief 初始化外部数据区结构
+ *
+ * @param ext
+ */
+void pktbuf_ext_init(pktbuf_ext_t *ext) { ext->ref_cnt = 0; }
+
+/**
+ * @brief 在数据包尾部添加一个直接引用外部内存的数据块, 数据不进行拷贝,
+ *        在该数据块被释放之前，外部内存必须保持有效且不被修改
+ *
+ * @param buf
+ * @param data 外部内存的起始地址
+ * @param size 外部内存的大小
+ * @param ext 外部内存所属的外部数据区
+ * @return net_err_t
+ */
+net_err_t pktbuf_ext_add(pktbuf_t *buf, const uint8_t *data, int size,
+                         pktbuf_ext_t *ext) {
+  pktbuf_check_buf(buf);
+
+  if (data == (uint8_t *)0 || size <= 0 || !ext) {
+    dbg_error(DBG_PKTBUF, "pktbuf ext add failed, invalid param.");
+    return NET_ERR_PARAM;
+  }
+
+  pktblk_t *blk = pktblock_alloc();
+  if (!blk) {
+    dbg_error(DBG_PKTBUF, "pktbuf ext add failed, no buffer.");
+    return NET_ERR_MEM;
+  }
+  blk->data = (uint8_t *)data;
+  blk->data_size = size;
+  blk->ext = ext;
+
+  // 数据块可能在其它线程中被释放，引用计数需要加锁保护
+  nlocker_lock(&pkt_locker);
+  ext->ref_cnt++;
+  nlocker_unlock(&pkt_locker);
+
+  nlist_insert_last(&buf->blk_list, &blk->node);
+  buf->total_size += size;
+
+  // 访问位置原本在数据包末尾时，需要重新定位
+  if (!buf->curr_blk) {
+    buf->curr_pos = (uint8_t *)0;
+    pktbuf_update_pos(buf);
+  }
+
+  display_check_buf(buf);
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 判断外部数据区是否仍被数据块引用
+ *
+ * @param ext
+ * @return int 1: 仍被引用, 0: 未被引用
+ */
+int pktbuf_ext_busy(pktbuf_ext_t *ext) {
+  nlocker_lock(&pkt_locker);
+  int busy = ext->ref_cnt > 0;
+  nlocker_unlock(&pkt_locker);
+
+  return busy;
+}
 
 /**
  * @brief 计算数据包从当前访问位置buf.pos开始的size个字节的校验和
@@ -28,6 +28,7 @@ static nlist_t socket_list;     // 挂载已分配的socket对象链表
 
 /**
  * @brief 初始化socket等待事件对象
+ *        信号量在第一次有线程需要等待时才创建, 使从未阻塞过的socket(如大量空闲连接)不占用信号量
  *
  * @param wait 等待事件对象
  * @return net_err_t
@@ -35,9 +36,9 @@ static nlist_t socket_list;     // 挂载已分配的socket对象链表
 net_err_t sock_wait_init(sock_wait_t *wait) {
   wait->wait_event_cnt = 0;
   wait->error = NET_ERR_OK;
-  wait->sem = sys_sem_create(0);
+  wait->sem = SYS_SEM_INVALID;
 
-  return wait->sem == SYS_SEM_INVALID ? NET_ERR_SOCKET : NET_ERR_OK;
+  return NET_ERR_OK;
 }
 
 /**
@@ -63,6 +64,14 @@ void sock_wait_destroy(sock_wait_t *wait) {
  * @return net_err_t
  */
 net_err_t sock_wait_add(sock_wait_t *wait, int tmo, struct _sock_req_t *req) {
+  // 第一次等待时创建信号量, 在工作线程中创建, 外部线程进入等待前已与工作线程同步
+  if (wait->sem == SYS_SEM_INVALID) {
+    wait->sem = sys_sem_create(0);
+    if (wait->sem == SYS_SEM_INVALID) {
+      dbg_error(DBG_SOCKET, "create wait sem failed.");
+    }
+  }
+
   // 增加等待事件数
   wait->wait_event_cnt++;
   // 方法请求对象记录wait对象和对应的超时时间
@@ -80,7 +89,7 @@ net_err_t sock_wait_add(sock_wait_t *wait, int tmo, struct _sock_req_t *req) {
  * @return net_err_t
  */
 net_err_t sock_wait_enter(sock_wait_t *wait, int tmo) {
-  if (!wait) {
+  if (!wait || wait->sem == SYS_SEM_INVALID) {
     dbg_error(DBG_SOCKET, "wait object is null.");
     return NET_ERR_SOCKET;
   }
@@ -421,6 +430,186 @@ net_err_t sock_req_recv(msg_func_t *msg) {
   return err;
 }
 
+/**
+ * @brief 外部应用请求零拷贝接收数据, 通过io.buf返回数据包
+ *
+ * @param msg
+ * @return net_err_t
+ */
+net_err_t sock_req_recv_zc(msg_func_t *msg) {
+  // 获取socket接收请求参数
+  sock_req_t *sock_req = (sock_req_t *)msg->arg;
+  sock_io_t *io = &sock_req->io;
+
+  // 获取封装socket对象, 并获取其基类对象
+  net_socket_t *socket = socket_by_index(sock_req->sock_fd);
+  if (!socket) {
+    dbg_error(DBG_SOCKET, "invalid socket fd.");
+    return NET_ERR_SOCKET;
+  }
+  sock_t *sock = socket->sock;
+
+  // 只有面向连接的socket对象支持零拷贝接收
+  if (!sock->ops->recv_zc) {
+    dbg_error(DBG_SOCKET, "socket recv zerocopy not supported.");
+    return NET_ERR_SOCKET;
+  }
+  net_err_t err = sock->ops->recv_zc(sock, (struct _pktbuf_t **)io->buf,
+                                     io->flags, &io->ret_len);
+  if (err == NET_ERR_NEEDWAIT) {  // 通知外部线程等待执行结果
+    if (sock->recv_wait) {
+      sock_wait_add(sock->recv_wait, sock->recv_tmo, sock_req);
+    } else {
+      dbg_error(DBG_SOCKET, "socket don't have recv wait obj.");
+      return NET_ERR_SOCKET;
+    }
+  }
+
+  return err;
+}
+
+/**
+ * @brief 外部应用请求接收一个数据报, 并返回其源地址及合并的数据报大小
+ *
+ * @param msg
+ * @return net_err_t
+ */
+net_err_t sock_req_recvmsg(msg_func_t *msg) {
+  // 获取socket接收请求参数, io.buf记录应用程序的消息结构
+  sock_req_t *sock_req = (sock_req_t *)msg->arg;
+  sock_io_t *io = &sock_req->io;
+
+  // 获取封装socket对象, 并获取其基类对象
+  net_socket_t *socket = socket_by_index(sock_req->sock_fd);
+  if (!socket) {
+    dbg_error(DBG_SOCKET, "invalid socket fd.");
+    return NET_ERR_SOCKET;
+  }
+  sock_t *sock = socket->sock;
+
+  if (!sock->ops->recvmsg) {
+    dbg_error(DBG_SOCKET, "socket recvmsg not supported.");
+    return NET_ERR_SOCKET;
+  }
+  net_err_t err = sock->ops->recvmsg(sock, (struct net_msghdr *)io->buf,
+                                     io->flags, &io->ret_len);
+  if (err == NET_ERR_NEEDWAIT) {  // 通知外部线程等待执行结果
+    if (sock->recv_wait) {
+      sock_wait_add(sock->recv_wait, sock->recv_tmo, sock_req);
+    } else {
+      dbg_error(DBG_SOCKET, "socket don't have recv wait obj.");
+      return NET_ERR_SOCKET;
+    }
+  }
+
+  return err;
+}
+
+/**
+ * @brief 外部应用请求批量发送数据报, 在一次工作线程调用中依次发送所有消息,
+ *        避免每个数据报都经过一次消息队列及线程切换
+ *        某个消息发送失败时停止发送, 已有消息发送成功时返回成功, 由调用者返回已发送的消息数量
+ *
+ * @param msg
+ * @return net_err_t
+ */
+net_err_t sock_req_sendmmsg(msg_func_t *msg) {
+  // 获取socket批量发送请求参数
+  sock_req_t *sock_req = (sock_req_t *)msg->arg;
+  sock_mmsg_t *mmsg = &sock_req->mmsg;
+
+  // 获取封装socket对象, 并获取其基类对象
+  net_socket_t *socket = socket_by_index(sock_req->sock_fd);
+  if (!socket) {
+    dbg_error(DBG_SOCKET, "invalid socket fd.");
+    return NET_ERR_SOCKET;
+  }
+  sock_t *sock = socket->sock;
+
+  if (!sock->ops->sendto) {
+    dbg_error(DBG_SOCKET, "socket sendto not supported.");
+    return NET_ERR_SOCKET;
+  }
+
+  net_err_t err = NET_ERR_OK;
+  while (mmsg->ret_cnt < mmsg->vlen) {
+    struct net_mmsghdr *hdr = &mmsg->msgvec[mmsg->ret_cnt];
+    hdr->msg_len = 0;
+    err = sock->ops->sendto(sock, hdr->msg_buf, hdr->msg_buflen, mmsg->flags,
+                            hdr->msg_name, hdr->msg_namelen, &hdr->msg_len);
+    if (err != NET_ERR_OK) {
+      break;
+    }
+    mmsg->ret_cnt++;
+  }
+
+  if (err == NET_ERR_NEEDWAIT) {  // 通知外部线程等待, 之后从未发送的消息继续
+    if (sock->send_wait) {
+      sock_wait_add(sock->send_wait, sock->send_tmo, sock_req);
+    } else {
+      dbg_error(DBG_SOCKET, "socket don't have send wait obj.");
+      return NET_ERR_SOCKET;
+    }
+    return err;
+  }
+
+  return mmsg->ret_cnt > 0 ? NET_ERR_OK : err;
+}
+
+/**
+ * @brief 外部应用请求批量接收数据报, 在一次工作线程调用中从接收队列取出所有已到达的数据报,
+ *        最多取出vlen个; 已取出至少一个数据报时不再等待后续的数据报, 直接返回
+ *
+ * @param msg
+ * @return net_err_t
+ */
+net_err_t sock_req_recvmmsg(msg_func_t *msg) {
+  // 获取socket批量接收请求参数
+  sock_req_t *sock_req = (sock_req_t *)msg->arg;
+  sock_mmsg_t *mmsg = &sock_req->mmsg;
+
+  // 获取封装socket对象, 并获取其基类对象
+  net_socket_t *socket = socket_by_index(sock_req->sock_fd);
+  if (!socket) {
+    dbg_error(DBG_SOCKET, "invalid socket fd.");
+    return NET_ERR_SOCKET;
+  }
+  sock_t *sock = socket->sock;
+
+  if (!sock->ops->recvfrom) {
+    dbg_error(DBG_SOCKET, "socket recvfrom not supported.");
+    return NET_ERR_SOCKET;
+  }
+
+  net_err_t err = NET_ERR_OK;
+  while (mmsg->ret_cnt < mmsg->vlen) {
+    struct net_mmsghdr *hdr = &mmsg->msgvec[mmsg->ret_cnt];
+    hdr->msg_len = 0;
+    err = sock->ops->recvfrom(sock, hdr->msg_buf, hdr->msg_buflen,
+                              mmsg->flags, hdr->msg_name, &hdr->msg_namelen,
+                              &hdr->msg_len);
+    if (err != NET_ERR_OK) {
+      break;
+    }
+    mmsg->ret_cnt++;
+  }
+
+  if (mmsg->ret_cnt > 0) {  // 接收队列已取空或消息已用完
+    return NET_ERR_OK;
+  }
+
+  if (err == NET_ERR_NEEDWAIT) {  // 通知外部线程等待执行结果
+    if (sock->recv_wait) {
+      sock_wait_add(sock->recv_wait, sock->recv_tmo, sock_req);
+    } else {
+      dbg_error(DBG_SOCKET, "socket don't have recv wait obj.");
+      return NET_ERR_SOCKET;
+    }
+  }
+
+  return err;
+}
+
 /**
  * @brief 外部应用请求设置socket选项
  *
@@ -451,6 +640,36 @@ net_err_t sock_req_setopt(msg_func_t *msg) {
                            opt->optlen);
 }
 
+/**
+ * @brief 外部应用请求获取socket选项
+ *
+ * @param msg
+ * @return net_err_t
+ */
+net_err_t sock_req_getopt(msg_func_t *msg) {
+  // 获取socket选项获取请求参数
+  sock_req_t *sock_req = (sock_req_t *)msg->arg;
+  sock_getopt_t *opt = &sock_req->getopt;
+
+  // 获取封装的socket对象
+  net_socket_t *socket = socket_by_index(sock_req->sock_fd);
+  if (!socket) {
+    dbg_error(DBG_SOCKET, "invalid socket fd.");
+    return NET_ERR_SOCKET;
+  }
+
+  // 获取socket基类对象
+  sock_t *sock = socket->sock;
+
+  // 调用socket对象的getsockopt方法，完成静态多态调用
+  if (!sock->ops->getopt) {
+    dbg_error(DBG_SOCKET, "socket getsockopt not supported.");
+    return NET_ERR_SOCKET;
+  }
+  return sock->ops->getopt(sock, opt->level, opt->optname, opt->optval,
+                           opt->optlen);
+}
+
 /**
  * @brief 内部接口，连接指定socket对象，只与connect连接的远端地址通信
  *
@@ -527,6 +746,94 @@ net_err_t sock_req_bind(msg_func_t *msg) {
   return sock->ops->bind(sock, addr, addr_len);
 }
 
+/**
+ * @brief 内部接口，将socket设置为监听状态
+ *
+ * @param msg
+ * @return net_err_t
+ */
+net_err_t sock_req_listen(msg_func_t *msg) {
+  // 获取socket监听请求参数
+  sock_req_t *sock_req = (sock_req_t *)msg->arg;
+  sock_listen_t *listen = &sock_req->listen;
+
+  // 获取封装的socket对象
+  net_socket_t *socket = socket_by_index(sock_req->sock_fd);
+  if (!socket) {
+    dbg_error(DBG_SOCKET, "invalid socket fd.");
+    return NET_ERR_SOCKET;
+  }
+
+  // 获取socket基类对象, 并完成静态多态调用
+  sock_t *sock = socket->sock;
+  if (!sock->ops->listen) {
+    dbg_error(DBG_SOCKET, "socket listen not supported.");
+    return NET_ERR_SOCKET;
+  }
+
+  return sock->ops->listen(sock, listen->backlog);
+}
+
+/**
+ * @brief 内部接口，从监听socket中取出一个已建立的连接,
+ * 并为其分配一个新的socket对象
+ *
+ * @param msg
+ * @return net_err_t
+ */
+net_err_t sock_req_accept(msg_func_t *msg) {
+  // 获取socket接受连接请求参数
+  sock_req_t *sock_req = (sock_req_t *)msg->arg;
+  sock_accept_t *accept = &sock_req->accept;
+
+  // 获取封装的socket对象
+  net_socket_t *socket = socket_by_index(sock_req->sock_fd);
+  if (!socket) {
+    dbg_error(DBG_SOCKET, "invalid socket fd.");
+    return NET_ERR_SOCKET;
+  }
+
+  // 获取socket基类对象
+  sock_t *sock = socket->sock;
+  if (!sock->ops->accept) {
+    dbg_error(DBG_SOCKET, "socket accept not supported.");
+    return NET_ERR_SOCKET;
+  }
+
+  // 先为新连接分配socket对象, 避免连接取出后因无法分配socket对象而丢失
+  net_socket_t *client_socket = socket_alloc();
+  if (!client_socket) {
+    dbg_error(DBG_SOCKET, "no free socket object.");
+    return NET_ERR_SOCKET;
+  }
+
+  // 完成静态多态调用, 取出一个已建立的连接
+  sock_t *client = (sock_t *)0;
+  net_err_t err =
+      sock->ops->accept(sock, accept->addr, accept->addrlen, &client);
+  if (err != NET_ERR_OK) {
+    socket_free(client_socket);
+
+    if (err == NET_ERR_NEEDWAIT) {  // 没有已建立的连接, 通知外部线程等待
+      if (sock->conn_wait) {
+        // 为方法请求对象添加一个wait对象, 使用该wait对象阻塞外部线程
+        sock_wait_add(sock->conn_wait, sock->recv_tmo, sock_req);
+      } else {
+        dbg_error(DBG_SOCKET, "socket don't have accept wait obj.");
+        return NET_ERR_SOCKET;
+      }
+    }
+    return err;
+  }
+
+  // 记录新连接的sock对象, 并挂载到socket对象链表
+  client_socket->sock = client;
+  nlist_insert_last(&socket_list, &client_socket->node);
+  accept->client_fd = socket_get_index(client_socket);
+
+  return NET_ERR_OK;
+}
+
 /**
  * @brief 初始化基础socket对象(sock)
  *
@@ -562,6 +869,9 @@ net_err_t sock_init(sock_t *sock, int family, int protocol,
 
   // 初始化socket对象的挂载节点
   nlist_node_init(&sock->node);
+  nlist_node_init(&sock->hash_node);
+  sock->hash_tbl = (struct _sock_hash_t *)0;
+  sock->hash_list = (nlist_t *)0;
 
   return NET_ERR_OK;
 }
@@ -734,6 +1044,46 @@ net_err_t sock_setopt(sock_t *sock, int level, int optname, const char *optval,
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 基类sock的getsockopt方法实现，后续派生类可直接继承该方法
+ *
+ * @param sock
+ * @param level
+ * @param optname
+ * @param optval
+ * @param optlen 传入缓冲区大小, 返回选项值的实际长度
+ * @return net_err_t
+ */
+net_err_t sock_getopt(sock_t *sock, int level, int optname, char *optval,
+                      int *optlen) {
+  if (level != SOL_SOCKET) {  // TODO: 暂时只支持获取socket层选项
+    dbg_error(DBG_SOCKET, "invalid socket option level.");
+    return NET_ERR_SOCKET;
+  }
+
+  switch (optname) {
+    case SO_RCVTIMEO:                               // 获取接收超时时间
+    case SO_SNDTIMEO: {                             // 获取发送超时时间
+      if (*optlen < (int)sizeof(struct net_timeval)) {  // 缓冲区不足
+        dbg_error(DBG_SOCKET, "invalid socket option len.");
+        return NET_ERR_SOCKET;
+      }
+      int tmo = optname == SO_RCVTIMEO ? sock->recv_tmo : sock->send_tmo;
+      struct net_timeval *tv = (struct net_timeval *)optval;
+      tv->tv_sec = tmo / 1000;
+      tv->tv_usec = (tmo % 1000) * 1000;
+      *optlen = sizeof(struct net_timeval);
+    } break;
+
+    default: {
+      dbg_error(DBG_SOCKET, "invalid socket option name.");
+      return NET_ERR_SOCKET;
+    } break;
+  }
+
+  return NET_ERR_OK;
+}
+
 /**
  * @brief 基类的send方法实现，后续派生类可直接继承该方法
  *
@@ -0,0 +1,205 @@
+/**
+ * @file sock_hash.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief socket地址哈希表, 用于根据数据包的地址信息快速查找sock对象
+ * @version 0.1
+ * @date 2024-11-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "sock_hash.h"
+
+#include "dbg.h"
+#include "net_cfg.h"
+#include "tools.h"
+
+/**
+ * @brief 初始化socket地址哈希表
+ *
+ * @param hash
+ * @param key 键类型
+ * @param bucket_tbl 哈希桶数组
+ * @param bucket_cnt 哈希桶数量, 必须为2的幂
+ * @param seed 哈希扰动值
+ */
+void sock_hash_init(sock_hash_t *hash, sock_hash_key_t key,
+                    nlist_t *bucket_tbl, int bucket_cnt, uint32_t seed) {
+  dbg_assert(bucket_cnt > 0 && (bucket_cnt & (bucket_cnt - 1)) == 0,
+             "sock hash bucket cnt must be power of 2.");
+
+  hash->key = key;
+  hash->bucket_tbl = bucket_tbl;
+  hash->bucket_cnt = bucket_cnt;
+  hash->seed = seed;
+  hash->last_hit = (sock_t *)0;
+
+  for (int i = 0; i < bucket_cnt; i++) {
+    nlist_init(&bucket_tbl[i]);
+  }
+}
+
+/**
+ * @brief 根据地址信息获取对应的哈希桶
+ *        以本地端口为键时只使用端口号, 使绑定了具体ip与通配ip的对象位于同一个桶
+ *
+ * @param hash
+ * @param local_ip
+ * @param local_port
+ * @param remote_ip
+ * @param remote_port
+ * @return nlist_t*
+ */
+static nlist_t *sock_hash_bucket(sock_hash_t *hash, const ipaddr_t *local_ip,
+                                 uint16_t local_port, const ipaddr_t *remote_ip,
+                                 uint16_t remote_port) {
+  uint32_t val;
+  if (hash->key == SOCK_HASH_CONN) {
+    uint8_t data[IP_ADDR_SIZE * 2 + 4];
+    plat_memcpy(data, local_ip->addr_bytes, IP_ADDR_SIZE);
+    plat_memcpy(data + IP_ADDR_SIZE, remote_ip->addr_bytes, IP_ADDR_SIZE);
+    data[IP_ADDR_SIZE * 2] = (uint8_t)(local_port >> 8);
+    data[IP_ADDR_SIZE * 2 + 1] = (uint8_t)local_port;
+    data[IP_ADDR_SIZE * 2 + 2] = (uint8_t)(remote_port >> 8);
+    data[IP_ADDR_SIZE * 2 + 3] = (uint8_t)remote_port;
+    val = tools_hash32(data, sizeof(data), hash->seed);
+  } else {
+    val = tools_hash32(&local_port, sizeof(local_port), hash->seed);
+  }
+
+  return &hash->bucket_tbl[val & (hash->bucket_cnt - 1)];
+}
+
+/**
+ * @brief 将sock对象按其当前的地址信息挂载到哈希表中,
+ *        挂载期间不能修改作为键的地址信息, 需先移除再重新挂载
+ *
+ * @param hash
+ * @param sock
+ */
+void sock_hash_insert(sock_hash_t *hash, sock_t *sock) {
+  dbg_assert(!sock->hash_tbl, "sock already in hash table.");
+
+  nlist_t *bucket =
+      sock_hash_bucket(hash, &sock->local_ip, sock->local_port,
+                       &sock->remote_ip, sock->remote_port);
+  nlist_insert_first(bucket, &sock->hash_node);
+  sock->hash_tbl = hash;
+  sock->hash_list = bucket;
+}
+
+/**
+ * @brief 将sock对象从其所在的哈希表中移除, 未挂载时不做处理
+ *
+ * @param sock
+ */
+void sock_hash_remove(sock_t *sock) {
+  sock_hash_t *hash = sock->hash_tbl;
+  if (!hash) {
+    return;
+  }
+
+  if (hash->last_hit == sock) {
+    hash->last_hit = (sock_t *)0;
+  }
+  nlist_remove(sock->hash_list, &sock->hash_node);
+  sock->hash_tbl = (sock_hash_t *)0;
+  sock->hash_list = (nlist_t *)0;
+}
+
+/**
+ * @brief 获取以本地端口为键的哈希表中, 绑定了指定端口的sock对象所在的哈希桶,
+ *        供需要自定义匹配规则的使用者遍历, 桶中可能还有其他端口的对象
+ *
+ * @param hash
+ * @param local_port
+ * @return nlist_t*
+ */
+nlist_t *sock_hash_local_bucket(sock_hash_t *hash, uint16_t local_port) {
+  dbg_assert(hash->key == SOCK_HASH_LOCAL, "sock hash key must be local.");
+  return sock_hash_bucket(hash, (const ipaddr_t *)0, local_port,
+                          (const ipaddr_t *)0, 0);
+}
+
+/**
+ * @brief 判断sock对象的四元组是否与给定的地址信息完全匹配
+ *
+ * @param sock
+ * @param local_ip
+ * @param local_port
+ * @param remote_ip
+ * @param remote_port
+ * @return int
+ */
+static inline int sock_hash_conn_match(sock_t *sock, const ipaddr_t *local_ip,
+                                       uint16_t local_port,
+                                       const ipaddr_t *remote_ip,
+                                       uint16_t remote_port) {
+  return sock->local_port == local_port && sock->remote_port == remote_port &&
+         ipaddr_is_equal(&sock->remote_ip, remote_ip) &&
+         ipaddr_is_equal(&sock->local_ip, local_ip);
+}
+
+/**
+ * @brief 在哈希表中查找与地址信息匹配的sock对象
+ *        四元组键: 要求四元组完全匹配, 优先检查最近一次命中的对象
+ *        本地端口键: 忽略远端地址, 优先返回绑定了该本地ip的对象, 其次返回绑定了通配ip的对象,
+ *        local_ip为空时返回任意一个绑定了该端口的对象
+ *
+ * @param hash
+ * @param local_ip
+ * @param local_port
+ * @param remote_ip
+ * @param remote_port
+ * @param match 过滤函数, 为空则不过滤
+ * @return sock_t*
+ */
+sock_t *sock_hash_find(sock_hash_t *hash, const ipaddr_t *local_ip,
+                       uint16_t local_port, const ipaddr_t *remote_ip,
+                       uint16_t remote_port, sock_hash_match_t match) {
+  nlist_node_t *node = (nlist_node_t *)0;
+
+  if (hash->key == SOCK_HASH_CONN) {
+    // 同一连接的数据包通常连续到达, 先检查最近一次命中的对象
+    sock_t *sock = hash->last_hit;
+    if (sock &&
+        sock_hash_conn_match(sock, local_ip, local_port, remote_ip,
+                             remote_port) &&
+        (!match || match(sock))) {
+      return sock;
+    }
+
+    nlist_t *bucket =
+        sock_hash_bucket(hash, local_ip, local_port, remote_ip, remote_port);
+    nlist_for_each(node, bucket) {
+      sock = nlist_entry(node, sock_t, hash_node);
+      if (sock_hash_conn_match(sock, local_ip, local_port, remote_ip,
+                               remote_port) &&
+          (!match || match(sock))) {
+        hash->last_hit = sock;
+        return sock;
+      }
+    }
+
+    return (sock_t *)0;
+  }
+
+  sock_t *wildcard = (sock_t *)0;  // 绑定了通配ip的候选对象
+  nlist_t *bucket = sock_hash_bucket(hash, local_ip, local_port, remote_ip,
+                                     remote_port);
+  nlist_for_each(node, bucket) {
+    sock_t *sock = nlist_entry(node, sock_t, hash_node);
+    if (sock->local_port != local_port || (match && !match(sock))) {
+      continue;
+    }
+
+    if (!local_ip || ipaddr_is_equal(&sock->local_ip, local_ip)) {
+      return sock;
+    } else if (!wildcard && ipaddr_is_any(&sock->local_ip)) {
+      wildcard = sock;
+    }
+  }
+
+  return wildcard;
+}
@@ -284,6 +284,7 @@ sock_t *sockraw_create(int family, int protocol) {
       .sendto = sockraw_sendto,      // 独立实现接口
       .recvfrom = sockraw_recvfrom,  // 独立实现接口
       .setopt = sock_setopt,         // 继承基类的实现
+      .getopt = sock_getopt,         // 继承基类的实现
       .close = sockraw_close,        // 独立实现接口
       .send = sock_send,             // 继承基类的实现
       .recv = sock_recv,             // 继承基类的实现
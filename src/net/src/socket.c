@@ -160,6 +160,167 @@ ssize_t net_recvfrom(int socket, void *buf, size_t buf_len, int flags,
   }
 }
 
+/**
+ * @brief 外部接口，接收一个数据报, 并通过msg返回源地址;
+ *        socket设置了UDP_GRO时, 返回的数据可能由多个数据报合并而成,
+ *        msg_segsize记录每个数据报的大小, 应用程序据此还原数据报的边界
+ *
+ * @param socket
+ * @param msg
+ * @param flags
+ * @return ssize_t 接收的数据量, -1表示接收失败
+ */
+ssize_t net_recvmsg(int socket, struct net_msghdr *msg, int flags) {
+  // 进行参数检查
+  if (socket < 0 || !msg || !msg->msg_buf || !msg->msg_buflen) {
+    dbg_error(DBG_SOCKET, "recvmsg param error.\n");
+    return -1;
+  }
+
+  while (1) {
+    // 封装socket接收请求参数
+    sock_req_t sock_req;
+    sock_req.wait = (sock_wait_t *)0;
+    sock_req.wait_tmo = 0;
+    sock_req.sock_fd = socket;
+    sock_req.io.buf = msg;
+    sock_req.io.buf_len = 0;
+    sock_req.io.flags = flags;
+    sock_req.io.ret_len = 0;
+
+    // 调用消息队列工作线程执行socket接收请求
+    net_err_t err = exmsg_func_exec(sock_req_recvmsg, &sock_req);
+    switch (err) {
+      case NET_ERR_OK: {
+        return sock_req.io.ret_len > 0 ? sock_req.io.ret_len : -1;
+      } break;
+      case NET_ERR_NEEDWAIT: {  // 需要等待内部工作线程执行完毕
+        if (sock_wait_enter(sock_req.wait, sock_req.wait_tmo) != NET_ERR_OK) {
+          dbg_error(DBG_SOCKET, "socket wait error.");
+          return -1;
+        }
+      } break;
+      default: {  // 发生其他错误
+        dbg_error(DBG_SOCKET, "recvmsg failed.\n");
+        return -1;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 外部接口，批量发送数据报, 每个消息指定各自的数据及目的地址,
+ *        所有消息在一次工作线程调用中发送, 减少消息队列往返及线程切换的开销
+ *
+ * @param socket
+ * @param msgvec 消息数组, 返回时msg_len记录各消息实际发送的数据量
+ * @param vlen 消息数量
+ * @param flags
+ * @return int 成功发送的消息数量, -1表示发送失败
+ */
+int net_sendmmsg(int socket, struct net_mmsghdr *msgvec, unsigned int vlen,
+                 int flags) {
+  // 进行参数检查
+  if (socket < 0 || !msgvec || !vlen) {
+    dbg_error(DBG_SOCKET, "sendmmsg param error.\n");
+    return -1;
+  }
+  for (unsigned int i = 0; i < vlen; i++) {
+    struct net_mmsghdr *hdr = &msgvec[i];
+    if (!hdr->msg_buf || !hdr->msg_buflen || !hdr->msg_name ||
+        hdr->msg_namelen != sizeof(struct net_sockaddr) ||
+        hdr->msg_name->sa_family != AF_INET) {
+      dbg_error(DBG_SOCKET, "sendmmsg msg param error.\n");
+      return -1;
+    }
+  }
+
+  // 封装socket批量发送请求参数
+  sock_req_t sock_req;
+  sock_req.wait = (sock_wait_t *)0;
+  sock_req.wait_tmo = 0;
+  sock_req.sock_fd = socket;
+  sock_req.mmsg.msgvec = msgvec;
+  sock_req.mmsg.vlen = (int)vlen;
+  sock_req.mmsg.flags = flags;
+  sock_req.mmsg.ret_cnt = 0;
+
+  while (1) {
+    // 调用消息队列工作线程执行socket批量发送请求
+    net_err_t err = exmsg_func_exec(sock_req_sendmmsg, &sock_req);
+    switch (err) {
+      case NET_ERR_OK: {  // 全部发送, 或部分消息发送失败
+        return sock_req.mmsg.ret_cnt;
+      } break;
+      case NET_ERR_NEEDWAIT: {  // 需要等待内部工作线程执行完毕
+        if (sock_wait_enter(sock_req.wait, sock_req.wait_tmo) != NET_ERR_OK) {
+          dbg_error(DBG_SOCKET, "socket send wait time out.");
+          return sock_req.mmsg.ret_cnt > 0 ? sock_req.mmsg.ret_cnt : -1;
+        }
+      } break;
+      default: {  // 发生其他错误
+        dbg_error(DBG_SOCKET, "sendmmsg failed.\n");
+        return -1;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 外部接口，批量接收数据报, 没有数据报时阻塞等待,
+ *        之后在一次工作线程调用中取出接收队列中所有已到达的数据报(最多vlen个)
+ *
+ * @param socket
+ * @param msgvec 消息数组, 返回时msg_len记录各消息接收的数据量, msg_name记录源地址
+ * @param vlen 消息数量
+ * @param flags
+ * @return int 接收的消息数量, -1表示接收失败
+ */
+int net_recvmmsg(int socket, struct net_mmsghdr *msgvec, unsigned int vlen,
+                 int flags) {
+  // 进行参数检查
+  if (socket < 0 || !msgvec || !vlen) {
+    dbg_error(DBG_SOCKET, "recvmmsg param error.\n");
+    return -1;
+  }
+  for (unsigned int i = 0; i < vlen; i++) {
+    if (!msgvec[i].msg_buf || !msgvec[i].msg_buflen) {
+      dbg_error(DBG_SOCKET, "recvmmsg msg param error.\n");
+      return -1;
+    }
+  }
+
+  while (1) {
+    // 封装socket批量接收请求参数
+    sock_req_t sock_req;
+    sock_req.wait = (sock_wait_t *)0;
+    sock_req.wait_tmo = 0;
+    sock_req.sock_fd = socket;
+    sock_req.mmsg.msgvec = msgvec;
+    sock_req.mmsg.vlen = (int)vlen;
+    sock_req.mmsg.flags = flags;
+    sock_req.mmsg.ret_cnt = 0;
+
+    // 调用消息队列工作线程执行socket批量接收请求
+    net_err_t err = exmsg_func_exec(sock_req_recvmmsg, &sock_req);
+    switch (err) {
+      case NET_ERR_OK: {
+        return sock_req.mmsg.ret_cnt;
+      } break;
+      case NET_ERR_NEEDWAIT: {  // 没有已到达的数据报, 等待后重新请求
+        if (sock_wait_enter(sock_req.wait, sock_req.wait_tmo) != NET_ERR_OK) {
+          dbg_error(DBG_SOCKET, "socket wait error.");
+          return -1;
+        }
+      } break;
+      default: {  // 发生其他错误
+        dbg_error(DBG_SOCKET, "recvmmsg failed.\n");
+        return -1;
+      }
+    }
+  }
+}
+
 int net_close(int socket) {
   // 封装socket关闭请求参数
   sock_req_t sock_req;
@@ -231,6 +392,44 @@ int net_setsockopt(int socket, int level, int optname, const char *optval,
   return 0;
 }
 
+/**
+ * @brief 外部接口, 根据选项级别(level)和对应的选项类型(optname)来获取socket选项
+ *
+ * @param socket
+ * @param level
+ * @param optname
+ * @param optval
+ * @param optlen 传入缓冲区大小, 返回选项值的实际长度
+ * @return int
+ */
+int net_getsockopt(int socket, int level, int optname, char *optval,
+                   int *optlen) {
+  // 进行参数检查
+  if (socket < 0 || !optval || !optlen || *optlen <= 0) {
+    dbg_error(DBG_SOCKET, "getsockopt param error.\n");
+    return -1;
+  }
+
+  // 封装socket选项获取请求参数
+  sock_req_t sock_req;
+  sock_req.wait = (sock_wait_t *)0;
+  sock_req.wait_tmo = 0;
+  sock_req.sock_fd = socket;
+  sock_req.getopt.level = level;
+  sock_req.getopt.optname = optname;
+  sock_req.getopt.optval = optval;
+  sock_req.getopt.optlen = optlen;
+
+  // 由工作线程读取socket对象的状态, 避免与协议处理并发访问
+  net_err_t err = exmsg_func_exec(sock_req_getopt, &sock_req);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_SOCKET, "getsockopt failed.\n");
+    return -1;
+  }
+
+  return 0;
+}
+
 /**
  * @brief 外部接口， socket连接指定地址, 只与该远端地址通信
  *
@@ -327,6 +526,88 @@ int net_bind(int socket, const struct net_sockaddr *addr,
   return 0;
 }
 
+/**
+ * @brief 外部接口，将socket设置为监听状态, 以被动接受远端的连接请求
+ *
+ * @param socket
+ * @param backlog 已建立连接队列的最大长度
+ * @return int
+ */
+int net_listen(int socket, int backlog) {
+  // 进行参数检查
+  if (socket < 0 || backlog < 0) {
+    dbg_error(DBG_SOCKET, "listen param error.\n");
+    return -1;
+  }
+
+  // 封装socket监听请求参数
+  sock_req_t sock_req;
+  sock_req.wait = (sock_wait_t *)0;
+  sock_req.wait_tmo = 0;
+  sock_req.sock_fd = socket;
+  sock_req.listen.backlog = backlog;
+
+  // 调用消息队列工作线程执行socket监听请求
+  net_err_t err = exmsg_func_exec(sock_req_listen, &sock_req);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_SOCKET, "listen failed.\n");
+    return -1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 外部接口，从监听socket中取出一个已建立的连接,
+ * 若没有已建立的连接则阻塞等待
+ *
+ * @param socket
+ * @param addr 返回远端的地址信息, 可为空
+ * @param addrlen 返回远端地址信息的大小, 可为空
+ * @return int 新连接的socket文件描述符, -1表示失败
+ */
+int net_accept(int socket, struct net_sockaddr *addr,
+               net_socklen_t *addrlen) {
+  // 进行参数检查
+  if (socket < 0) {
+    dbg_error(DBG_SOCKET, "accept param error.\n");
+    return -1;
+  }
+  if (addr && addrlen && *addrlen < sizeof(struct net_sockaddr)) {
+    dbg_error(DBG_SOCKET, "accept addrlen error.\n");
+    return -1;
+  }
+
+  while (1) {
+    // 封装socket接受连接请求参数
+    sock_req_t sock_req;
+    sock_req.wait = (sock_wait_t *)0;
+    sock_req.wait_tmo = 0;
+    sock_req.sock_fd = socket;
+    sock_req.accept.addr = addr;
+    sock_req.accept.addrlen = addrlen;
+    sock_req.accept.client_fd = -1;
+
+    // 调用消息队列工作线程执行socket接受连接请求
+    net_err_t err = exmsg_func_exec(sock_req_accept, &sock_req);
+    switch (err) {
+      case NET_ERR_OK: {  // 成功取出一个已建立的连接
+        return sock_req.accept.client_fd;
+      } break;
+      case NET_ERR_NEEDWAIT: {  // 需要等待新的连接完成三次握手
+        if (sock_wait_enter(sock_req.wait, sock_req.wait_tmo) != NET_ERR_OK) {
+          dbg_error(DBG_SOCKET, "socket accept wait error.");
+          return -1;
+        }
+      } break;
+      default: {  // 发生其他错误
+        dbg_error(DBG_SOCKET, "accept failed.\n");
+        return -1;
+      }
+    }
+  }
+}
+
 /**
  * @brief 通过socket发送数据，socket已经调用connect()函数连接到远端地址
  *
@@ -432,3 +713,68 @@ ssize_t net_recv(int socket, void *buf, size_t buf_len, int flags) {
     }
   }
 }
+
+/**
+ * @brief 外部接口，零拷贝接收数据，socket已经调用connect()函数连接到远端地址
+ *        取走接收队列中所有已按序到达的数据, 数据不进行拷贝，
+ *        通过buf返回只包含有效数据的数据包, 应用程序只能通过pktbuf接口读取其中的数据,
+ *        使用完后需调用net_recv_zc_free()释放
+ *
+ * @param socket
+ * @param buf 返回缓存接收数据的数据包
+ * @param flags
+ * @return ssize_t 接收的数据量, 0表示对端已关闭连接, -1表示接收失败
+ */
+ssize_t net_recv_zc(int socket, pktbuf_t **buf, int flags) {
+  // 进行参数检查
+  if (socket < 0 || !buf) {
+    dbg_error(DBG_SOCKET, "recv zc param error.\n");
+    return -1;
+  }
+  *buf = (pktbuf_t *)0;
+
+  while (1) {
+    // 封装socket接收请求参数
+    sock_req_t sock_req;
+    sock_req.wait = (sock_wait_t *)0;
+    sock_req.wait_tmo = 0;
+    sock_req.sock_fd = socket;
+    sock_req.io.buf = buf;
+    sock_req.io.buf_len = 0;
+    sock_req.io.flags = flags;
+    sock_req.io.ret_len = 0;
+
+    // 调用消息队列工作线程执行socket零拷贝接收请求
+    net_err_t err = exmsg_func_exec(sock_req_recv_zc, &sock_req);
+    switch (err) {
+      case NET_ERR_OK: {
+        return sock_req.io.ret_len >= 0 ? sock_req.io.ret_len : -1;
+      } break;
+      case NET_ERR_NEEDWAIT: {  // 需要等待内部工作线程执行完毕
+        net_err_t err = sock_wait_enter(sock_req.wait, sock_req.wait_tmo);
+        if (err == NET_ERR_TCP_CLOSE) {  // 对端已关闭连接
+          dbg_info(DBG_SOCKET, "remote close.\n");
+          return 0;
+        } else if (err != NET_ERR_OK) {
+          dbg_error(DBG_SOCKET, "socket wait error.");
+          return -1;
+        }
+      } break;
+      default: {  // 发生其他错误
+        dbg_error(DBG_SOCKET, "recv zc failed.\n");
+        return -1;
+      }
+    }
+  }
+}
+
+/**
+ * @brief 外部接口，释放零拷贝接收返回的数据包
+ *
+ * @param buf
+ */
+void net_recv_zc_free(pktbuf_t *buf) {
+  if (buf) {
+    pktbuf_free(buf);  //!!! 释放数据包
+  }
+}
@@ -10,12 +10,21 @@
  */
 #include "tcp.h"
 
+#include "ipv4.h"
 #include "mblock.h"
+#include "net_sys.h"
 #include "protocol.h"
 #include "route.h"
+#include "sock_hash.h"
+#include "tcp_bbr.h"
 #include "tcp_buf.h"
+#include "tcp_ecn.h"
+#include "tcp_fastopen.h"
+#include "tcp_rack.h"
+#include "tcp_rcvbuf.h"
 #include "tcp_send.h"
 #include "tcp_state.h"
+#include "tcp_tw.h"
 
 #define TCP_CREATE_WAIT 1    // 创建tcp socket时进行等待
 #define TCP_CREATE_NOWAIT 0  // 创建tcp socket时不进行等待
@@ -23,6 +32,19 @@
 static tcp_t tcp_tbl[TCP_MAXCNT];  // tcp socket对象表
 static mblock_t tcp_mblock;        // tcp socket对象内存块管理对象
 static nlist_t tcp_list;           // 挂载已分配的tcp socket对象链表
+static nlist_t tcp_conn_bucket[TCP_CONN_HASH_SIZE];  // 已连接对象哈希表的哈希桶
+static nlist_t tcp_bind_bucket[TCP_BIND_HASH_SIZE];  // 绑定及监听对象哈希表的哈希桶
+static sock_hash_t tcp_conn_hash;  // 已连接的tcp对象, 以四元组为键
+static sock_hash_t tcp_bind_hash;  // 已绑定或监听但未连接的tcp对象, 以本地端口为键
+static nlist_t tcp_page_wait_list;  // 因缓冲区页面或零拷贝数据区耗尽而等待发送的tcp对象链表
+static net_time_t tcp_time;        // 上次更新tcp时钟的系统时间
+static uint32_t tcp_time_ms;       // tcp时钟(ms)，用于时间戳选项及rtt采样
+static uint32_t tcp_syncookie_secret;  // 生成SYN cookie的密钥
+
+// SYN cookie中只用3位记录mss, 所以只能从以下几个常用值中选择
+static const uint16_t tcp_syncookie_mss_tbl[] = {TCP_MSS_DEFAULT, 1220, 1440,
+                                                 1460};
+#define TCP_SYNCOOKIE_TIME_SHIFT 16  // SYN cookie计数器的周期为2^16ms(约65s)
 
 #if DBG_DISP_ENABLED(DBG_TCP)
 void tcp_disp(char *msg, tcp_t *tcp) {
@@ -85,6 +107,19 @@ void tcp_disp_list(void) {
 
 #endif
 
+/**
+ * @brief 缓冲区页面或零拷贝数据区归还时的通知函数: 唤醒一个因资源耗尽而等待发送的任务,
+ *        被唤醒的任务重新尝试写入发送缓冲区
+ *
+ */
+static void tcp_buf_page_notify(void) {
+  nlist_node_t *node = nlist_remove_first(&tcp_page_wait_list);
+  if (node) {
+    tcp_t *tcp = nlist_entry(node, tcp_t, send.page_node);
+    sock_wakeup(&tcp->sock_base, SOCK_WAIT_WRITE, NET_ERR_OK);
+  }
+}
+
 net_err_t tcp_module_init(void) {
   dbg_info(DBG_TCP, "init tcp module ......");
 
@@ -95,10 +130,104 @@ net_err_t tcp_module_init(void) {
   // 初始化tcp socket对象挂载链表
   nlist_init(&tcp_list);
 
+  // 初始化乱序队列模块
+  net_err_t err = tcp_ooo_module_init();
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp ooo module init failed.");
+    return err;
+  }
+
+  // 初始化收发缓冲区共享的页面池
+  nlist_init(&tcp_page_wait_list);
+  err = tcp_buf_module_init(tcp_buf_page_notify);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp buf module init failed.");
+    return err;
+  }
+
+  // 初始化tcp时钟，从1开始计时，避免与回显时间戳的无效值0混淆
+  sys_time_curr(&tcp_time);
+  tcp_time_ms = 1;
+
+  // 使用启动时间生成SYN cookie的密钥, 使每次启动生成的cookie都不相同
+  tcp_syncookie_secret = tools_hash32(&tcp_time, sizeof(tcp_time),
+                                      (uint32_t)(uintptr_t)tcp_tbl);
+
+  // 初始化连接查找使用的哈希表, 使用随机的扰动值避免对端构造冲突的四元组
+  sock_hash_init(&tcp_conn_hash, SOCK_HASH_CONN, tcp_conn_bucket,
+                 TCP_CONN_HASH_SIZE, tcp_syncookie_secret ^ 0x5bd1e995U);
+  sock_hash_init(&tcp_bind_hash, SOCK_HASH_LOCAL, tcp_bind_bucket,
+                 TCP_BIND_HASH_SIZE, tcp_syncookie_secret);
+  tcp_fastopen_init(tcp_syncookie_secret);
+
+  // 初始化TIME_WAIT记录模块, 记录与已连接的tcp对象挂载在同一个哈希表中
+  err = tcp_tw_module_init(&tcp_conn_hash);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp time wait module init failed.");
+    return err;
+  }
+
   dbg_info(DBG_TCP, "init tcp module ok.");
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 获取tcp时钟的当前值(ms)
+ * 只由工作线程访问，不需要加锁
+ *
+ * @return uint32_t
+ */
+uint32_t tcp_time_now(void) {
+  tcp_time_ms += sys_time_goes(&tcp_time);
+  return tcp_time_ms;
+}
+
+/**
+ * @brief 解析tcp数据包中与具体连接无关的选项(时间戳及mss选项)，
+ * 并记录到数据包信息结构中, 调用前需保证tcp头部(包括选项)在内存上连续
+ *
+ * @param tcp_info
+ */
+static void tcp_info_read_options(tcp_info_t *tcp_info) {
+  tcp_hdr_t *tcp_hdr = tcp_info->tcp_hdr;
+  uint8_t *opt_start = (uint8_t *)(tcp_hdr + 1);  // 跳过tcp头部
+  uint8_t *opt_end =
+      opt_start + (tcp_get_hdr_size(tcp_hdr) - sizeof(tcp_hdr_t));
+
+  tcp_info->ts_valid = 0;
+  tcp_info->mss = 0;
+  tcp_info->tfo_len = -1;
+  while (opt_start < opt_end) {
+    if (opt_start[0] == TCP_OPT_END) {
+      break;
+    } else if (opt_start[0] == TCP_OPT_NOP) {
+      opt_start++;
+      continue;
+    }
+
+    // 其余选项都有长度字段，长度不合法则停止解析
+    if (opt_start + 1 >= opt_end || opt_start[1] < 2 ||
+        opt_start + opt_start[1] > opt_end) {
+      break;
+    }
+
+    if (opt_start[0] == TCP_OPT_TS && opt_start[1] == sizeof(tcp_opt_ts_t)) {
+      tcp_opt_ts_t *opt_ts = (tcp_opt_ts_t *)opt_start;
+      tcp_info->ts_valid = 1;
+      tcp_info->ts_val = net_ntohl(opt_ts->ts_val);
+      tcp_info->ts_ecr = net_ntohl(opt_ts->ts_ecr);
+    } else if (opt_start[0] == TCP_OPT_MSS &&
+               opt_start[1] == sizeof(tcp_opt_mss_t)) {
+      tcp_info->mss = net_ntohs(((tcp_opt_mss_t *)opt_start)->mss);
+    } else if (opt_start[0] == TCP_OPT_FASTOPEN &&
+               opt_start[1] - 2 <= TCP_FASTOPEN_COOKIE_SIZE) {
+      tcp_info->tfo_len = opt_start[1] - 2;
+      tcp_info->tfo_cookie = opt_start + 2;
+    }
+    opt_start += opt_start[1];  // 移动到下一个选项
+  }
+}
+
 /**
  * @brief 初始化一个tcp数据包信息结构
  *
@@ -132,6 +261,12 @@ void tcp_info_init(tcp_info_t *tcp_info, pktbuf_t *tcp_buf, ipaddr_t *local_ip,
    */
   tcp_info->seq_len =
       tcp_info->data_len + tcp_info->tcp_hdr->f_syn + tcp_info->tcp_hdr->f_fin;
+
+  // 记录ip头部的拥塞标记
+  tcp_info->ecn_ce = tcp_buf->ecn == IPV4_ECN_CE;
+
+  // 解析时间戳选项
+  tcp_info_read_options(tcp_info);
 }
 
 /**
@@ -160,6 +295,40 @@ static tcp_t *tcp_get_free(int wait) {
  * @return void*
  */
 static void *tcp_free(tcp_t *tcp) {
+  // 停止重传、延迟确认、发送节奏、RACK-TLP及坚持定时器, 并释放乱序队列、发送缓冲区及接收队列中缓存的数据
+  tcp_rto_stop(tcp);
+  tcp_delack_stop(tcp);
+  tcp_pacing_stop(tcp);
+  tcp_rack_stop(tcp);
+  tcp_persist_stop(tcp);
+  tcp_ooo_clear(&tcp->recv.ooo);
+  if (nlist_is_mount(&tcp->send.page_node)) {
+    nlist_remove(&tcp_page_wait_list, &tcp->send.page_node);
+  }
+  tcp_buf_release(&tcp->send.buf);
+  tcp_rcvq_clear(&tcp->recv.queue);
+  tcp_rcvbuf_release(tcp);
+
+  // 未被accept的子连接，将其从所属监听对象的队列中移除
+  if (tcp->listen.parent) {
+    nlist_remove(tcp->listen.queue, &tcp->listen.node);
+    tcp->listen.parent = (tcp_t *)0;
+  }
+
+  // 监听对象，复位并释放所有还未被accept的子连接
+  if (tcp->state == TCP_STATE_LISTEN) {
+    nlist_node_t *node = (nlist_node_t *)0;
+    while ((node = nlist_first(&tcp->listen.syn_list)) ||
+           (node = nlist_first(&tcp->listen.accept_list))) {
+      tcp_t *child = nlist_entry(node, tcp_t, listen.node);
+      tcp_send_abort(child);
+      tcp_free(child);
+    }
+  }
+
+  // 将tcp对象从连接查找使用的哈希表中移除
+  sock_hash_remove(&tcp->sock_base);
+
   // 销毨tcp对象的基础sock对象所持有的资源(主要是wait对象)
   sock_uninit(&tcp->sock_base);
 
@@ -170,28 +339,96 @@ static void *tcp_free(tcp_t *tcp) {
 
   // 将tcp对象内存块释放
   mblock_free(&tcp_mblock, tcp);
+}
+
+/**
+ * @brief 哈希表查找过滤函数: 只匹配未关闭的tcp对象
+ *        已关闭的连接只等待持有者调用close释放，不再处理任何报文,
+ *        避免其四元组被新连接复用时，新连接的SYN被当作旧连接的报文处理
+ *
+ * @param sock
+ * @return int
+ */
+static int tcp_is_alive(sock_t *sock) {
+  return ((tcp_t *)sock)->state != TCP_STATE_CLOSED;
+}
 
-  tcp_disp_list();
+/**
+ * @brief 哈希表查找过滤函数: 只匹配处于监听状态的tcp对象
+ *
+ * @param sock
+ * @return int
+ */
+static int tcp_is_listen(sock_t *sock) {
+  return ((tcp_t *)sock)->state == TCP_STATE_LISTEN;
+}
+
+/**
+ * @brief 判断主动发起连接的tcp对象能否复用与其四元组相同的已有连接
+ *        只能复用可以安全复用的TIME_WAIT记录, 且新连接需使用时间戳选项
+ *
+ * @param tcp 发起连接的tcp对象
+ * @param old 四元组相同的已有连接
+ * @return int
+ */
+static int tcp_tw_reusable(tcp_t *tcp, tcp_t *old) {
+  return old->state == TCP_STATE_TIME_WAIT && tcp->flags.ts_enable &&
+         tcp_tw_can_reuse((tcp_tw_t *)old);
 }
 
 /**
- * @brief 检查tcp端口号是否已被使用
+ * @brief 检查是否有未关闭的连接(不含TIME_WAIT记录)正在使用本地端口port,
+ *        绑定或连接后从绑定哈希表移到连接哈希表的对象只能在此找到
+ *        连接哈希表以四元组为键, 需遍历所有哈希桶, 只在绑定及为监听对象分配端口时使用
  *
+ * @param local_ip 为通配ip时匹配任意本地ip
  * @param port
  * @return int
  */
-static int tcp_port_is_used(uint16_t port) {
-  nlist_node_t *node = (nlist_node_t *)0;
-  nlist_for_each(node, &tcp_list) {
-    sock_t *sock = nlist_entry(node, sock_t, node);
-    if (sock->local_port == port) {
-      return 1;
+static int tcp_conn_port_is_used(const ipaddr_t *local_ip, uint16_t port) {
+  for (int i = 0; i < TCP_CONN_HASH_SIZE; i++) {
+    nlist_node_t *node = (nlist_node_t *)0;
+    nlist_for_each(node, &tcp_conn_bucket[i]) {
+      sock_t *sock = nlist_entry(node, sock_t, hash_node);
+      int state = ((tcp_t *)sock)->state;
+      if (sock->local_port != port || state == TCP_STATE_CLOSED ||
+          state == TCP_STATE_TIME_WAIT) {
+        continue;
+      }
+      if (ipaddr_is_any(local_ip) ||
+          ipaddr_is_equal(&sock->local_ip, local_ip)) {
+        return 1;
+      }
     }
   }
-
   return 0;
 }
 
+/**
+ * @brief 检查tcp端口号是否可以分配给sock对象
+ *        端口号不能已被其他对象绑定或监听,
+ *        若sock对象已确定远端地址, 则使用该端口号后四元组也不能与已有连接重复(可复用的TIME_WAIT记录除外),
+ *        否则(监听)端口号也不能被已有的连接使用
+ *
+ * @param sock
+ * @param port
+ * @return int
+ */
+static int tcp_port_is_used(sock_t *sock, uint16_t port) {
+  if (sock_hash_find(&tcp_bind_hash, (const ipaddr_t *)0, port,
+                     (const ipaddr_t *)0, 0, (sock_hash_match_t)0)) {
+    return 1;
+  }
+
+  if (!sock->remote_port) {
+    return tcp_conn_port_is_used(&sock->local_ip, port);
+  }
+  tcp_t *old = (tcp_t *)sock_hash_find(&tcp_conn_hash, &sock->local_ip, port,
+                                       &sock->remote_ip, sock->remote_port,
+                                       tcp_is_alive);
+  return old && !tcp_tw_reusable((tcp_t *)sock, old);
+}
+
 /**
  * @brief 分配一个本地端口号
  *
@@ -208,12 +445,14 @@ static net_err_t tcp_alloc_port(sock_t *sock) {
 #endif
 
   for (int i = NET_PORT_START; i < NET_PORT_END; i++) {
-    last_alloc_port = (last_alloc_port + 1 % NET_PORT_END);
-    last_alloc_port = last_alloc_port ? last_alloc_port : NET_PORT_START;
-    if (!tcp_port_is_used(last_alloc_port)) {
+    // 在[NET_PORT_START, NET_PORT_END)范围内循环分配
+    last_alloc_port++;
+    if (last_alloc_port < NET_PORT_START || last_alloc_port >= NET_PORT_END) {
+      last_alloc_port = NET_PORT_START;
+    }
+    if (!tcp_port_is_used(sock, last_alloc_port)) {
       // 本地端口号未被使用，分配该端口号
       sock->local_port = last_alloc_port;
-      tcp_disp_list();
       return NET_ERR_OK;
     }
   }
@@ -232,6 +471,76 @@ static uint32_t tcp_get_isn(void) {
   return isn++;
 }
 
+/**
+ * @brief 根据到达对端的路由所使用的网络接口mtu获取mss
+ *
+ * @param remote_ip
+ * @return uint16_t
+ */
+static uint16_t tcp_route_mss(const ipaddr_t *remote_ip) {
+  // 查找路由表，获取发送所使用的网络接口
+  route_entry_t *rt_entry = route_find(remote_ip);
+  if (!rt_entry || rt_entry->netif->mtu <= TCP_MSS_DEFAULT +
+                                               sizeof(ipv4_hdr_t) +
+                                               sizeof(tcp_hdr_t)) {
+    // 本地网络接口mtu未知或过小，使用默认mss
+    return TCP_MSS_DEFAULT;
+  }
+
+  // 计算mss = MTU - IP头部 - TCP头部, 作为本地在SYN中通告的mss
+  return rt_entry->netif->mtu - sizeof(ipv4_hdr_t) - sizeof(tcp_hdr_t);
+}
+
+/**
+ * @brief 获取到达对端的路径所允许的mss,
+ *        经过网关的路径mtu可能小于本地网络接口的mtu, 通过路径mtu发现得知后使用其中的较小值
+ *
+ * @param remote_ip
+ * @return uint16_t
+ */
+static uint16_t tcp_path_mss(const ipaddr_t *remote_ip) {
+  int mss = tcp_route_mss(remote_ip);
+  int pmtu_mss = ipv4_pmtu_get(remote_ip, mss + sizeof(ipv4_hdr_t) +
+                                              sizeof(tcp_hdr_t)) -
+                 sizeof(ipv4_hdr_t) - sizeof(tcp_hdr_t);
+  return (uint16_t)MIN(mss, pmtu_mss);
+}
+
+/**
+ * @brief 处理icmp"需要分片"报文: 连接发出的报文段超过了路径mtu而被路由器丢弃,
+ *        减小连接的mss并立即以新的mss重传最早的未确认数据, 不视为拥塞
+ *        只处理序号位于已发送未确认范围内的报文, 避免伪造的icmp报文干扰连接(RFC 5927)
+ *
+ * @param local_ip 被丢弃的报文段的源ip地址
+ * @param remote_ip 被丢弃的报文段的目的ip地址
+ * @param local_port
+ * @param remote_port
+ * @param seq 被丢弃的报文段的序号
+ * @param mtu 路径mtu
+ */
+void tcp_pmtu_reduced(const ipaddr_t *local_ip, const ipaddr_t *remote_ip,
+                      uint16_t local_port, uint16_t remote_port, uint32_t seq,
+                      int mtu) {
+  tcp_t *tcp = (tcp_t *)sock_hash_find(&tcp_conn_hash, local_ip, local_port,
+                                       remote_ip, remote_port, tcp_is_alive);
+  if (!tcp || tcp->state == TCP_STATE_TIME_WAIT ||
+      tcp_seq_before(seq, tcp->send.una) ||
+      !tcp_seq_before(seq, tcp->send.nxt)) {
+    return;
+  }
+
+  int mss = mtu - sizeof(ipv4_hdr_t) - sizeof(tcp_hdr_t);
+  if (mss >= tcp->mss) {
+    return;
+  }
+
+  dbg_info(DBG_TCP, "tcp pmtu reduced, mss %d -> %d.", tcp->mss, mss);
+  tcp->mss = mss;
+  tcp->flags.rtt_timing = 0;  // 放弃对被丢弃的报文段的rtt计时
+  tcp_retransmit(tcp);
+  tcp_rto_start(tcp);
+}
+
 /**
  * @brief 初始化tcp连接结构
  *
@@ -248,32 +557,61 @@ static net_err_t tcp_connect_init(tcp_t *tcp) {
   tcp->recv.isn = 0;  // 设置接收窗口的初始序号位
   tcp->recv.nxt = 0;  // 设置接收窗口的待接收位
 
-  // 初始化发送缓冲区和接收缓冲区
-  tcp_buf_init(&tcp->send.buf, tcp->send.buf_data, TCP_SBUF_SIZE);
-  tcp_buf_init(&tcp->recv.buf, tcp->recv.buf_data, TCP_RBUF_SIZE);
-
-  // 查找路由表，判断是否在本地网段，以初始化mss
-  route_entry_t *rt_entry = route_find(&tcp->sock_base.remote_ip);
-  if (rt_entry->netif->mtu == 0 || !ipaddr_is_any(&rt_entry->next_hop)) {
-    // 本地网络接口mtu未知或者下一跳地址不为空(即下一跳地址为网关地址，即对端不在本地链路上)，使用默认mss
-    tcp->mss = TCP_MSS_DEFAULT;
-  } else {  // 对端在本地链路上，计算mss = MTU - IP头部 - TCP头部
-    tcp->mss = rt_entry->netif->mtu - sizeof(ipv4_hdr_t) - sizeof(tcp_hdr_t);
+  // 初始化发送缓冲区和接收队列
+  tcp_buf_init(&tcp->send.buf, TCP_SBUF_SIZE);
+  tcp_rcvbuf_init(tcp);
+  tcp_ooo_init(&tcp->recv.ooo);
+
+  // 初始化重传超时估计值及时间戳信息
+  tcp->rtt.srtt = 0;
+  tcp->rtt.rttvar = 0;
+  tcp->rtt.rto = TCP_RTO_INIT;
+  tcp->rtt.retry = 0;
+  tcp->flags.rtt_timing = 0;
+  tcp->flags.recovery = 0;
+  tcp_ecn_init(tcp);
+  tcp_rack_init(tcp);
+  plat_memset(&tcp->stats, 0, sizeof(tcp->stats));
+  tcp->flags.tfo = 0;
+  tcp->tfo.cookie_len = 0;
+  tcp->tfo.syn_data = 0;
+  tcp->flags.ts_ok = 0;
+  tcp->ts.recent = 0;
+  tcp->ts.recent_time = 0;
+  tcp->ts.last_ack_sent = 0;
+
+  // 根据路由的网络接口mtu及路径mtu初始化mss
+  tcp->mss = tcp_path_mss(&tcp->sock_base.remote_ip);
+
+  // 对端的接收窗口在收到其SYN后才能确定, 拥塞窗口从初始窗口开始慢启动
+  tcp->send.win = 0;
+  tcp->send.wl1 = 0;
+  tcp->send.wl2 = tcp->send.isn;
+  tcp->send.cwnd = TCP_INIT_CWND * tcp->mss;
+  tcp->send.ssthresh = 0x7fffffff;
+
+  // 初始的发送额度在首次发送时被限制为可累积的上限, 使用BBR时由其模型给出发送速率
+  tcp->pacing.rate = 0;
+  tcp->pacing.credit = 0x7fffffff;
+  tcp->pacing.stamp = tcp_time_now();
+  if (tcp->cc == TCP_CC_BBR) {
+    tcp_bbr_init(tcp);
   }
 
   return NET_ERR_OK;
 }
 
 /**
- * @brief 建立tcp连接
+ * @brief 确定连接的四元组并初始化连接状态, 之后即可发送SYN
  *
  * @param sock
  * @param addr
  * @param addrlen
  * @return net_err_t
  */
-static net_err_t tcp_connect(sock_t *sock, const struct net_sockaddr *addr,
-                             net_socklen_t addrlen) {
+static net_err_t tcp_connect_prepare(sock_t *sock,
+                                     const struct net_sockaddr *addr,
+                                     net_socklen_t addrlen) {
   // 检查tcp对象状态是否为CLOSED
   if (((tcp_t *)sock)->state != TCP_STATE_CLOSED) {
     dbg_error(DBG_TCP, "tcp state error.");
@@ -285,14 +623,6 @@ static net_err_t tcp_connect(sock_t *sock, const struct net_sockaddr *addr,
   ipaddr_from_bytes(&sock->remote_ip, addr_in->sin_addr.s_addr_bytes);
   sock->remote_port = net_ntohs(addr_in->sin_port);
 
-  // 若未绑定本地端口，则分配一个本地端口
-  if (sock->local_port == NET_PORT_EMPTY) {
-    if (tcp_alloc_port(sock) != NET_ERR_OK) {
-      dbg_error(DBG_TCP, "alloc local port failed.");
-      return NET_ERR_TCP;
-    }
-  }
-
   // 若未绑定本地ip地址，则查找路由表，获取本地ip地址
   if (ipaddr_is_any(&sock->local_ip)) {
     route_entry_t *rt_entry = route_find(&sock->remote_ip);
@@ -303,12 +633,62 @@ static net_err_t tcp_connect(sock_t *sock, const struct net_sockaddr *addr,
     ipaddr_copy(&sock->local_ip, &rt_entry->netif->ipaddr);
   }
 
+  // 若未绑定本地端口，则分配一个本地端口
+  if (sock->local_port == NET_PORT_EMPTY &&
+      tcp_alloc_port(sock) != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "alloc local port failed.");
+    return NET_ERR_TCP;
+  }
+
+  // 检查四元组是否与已有连接重复, 可以安全复用的TIME_WAIT记录直接释放
+  int tw_reuse = 0;
+  uint32_t tw_isn = 0;
+  tcp_t *old = (tcp_t *)sock_hash_find(&tcp_conn_hash, &sock->local_ip,
+                                       sock->local_port, &sock->remote_ip,
+                                       sock->remote_port, tcp_is_alive);
+  if (old) {
+    if (!tcp_tw_reusable((tcp_t *)sock, old)) {
+      dbg_error(DBG_TCP, "tcp connection already exists.");
+      return NET_ERR_TCP;
+    }
+    tw_isn = tcp_tw_reuse((tcp_tw_t *)old);
+    tw_reuse = 1;
+  }
+
+  // 四元组已确定，从绑定哈希表移动到连接哈希表，以便接收对端的SYN+ACK
+  sock_hash_remove(sock);
+  sock_hash_insert(&tcp_conn_hash, sock);
+
   // 初始化tcp对象连接状态，包括发送窗口和接收窗口的边界信息
   if (tcp_connect_init((tcp_t *)sock) != NET_ERR_OK) {
     dbg_error(DBG_TCP, "init connect failed.");
     return NET_ERR_TCP;
   }
 
+  // 复用TIME_WAIT四元组时, 初始序号需越过旧连接使用过的序号
+  if (tw_reuse) {
+    tcp_t *tcp = (tcp_t *)sock;
+    tcp->send.isn = tcp->send.una = tcp->send.nxt = tcp->send.wl2 = tw_isn;
+  }
+
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 建立tcp连接
+ *
+ * @param sock
+ * @param addr
+ * @param addrlen
+ * @return net_err_t
+ */
+static net_err_t tcp_connect(sock_t *sock, const struct net_sockaddr *addr,
+                             net_socklen_t addrlen) {
+  net_err_t err = tcp_connect_prepare(sock, addr, addrlen);
+  if (err != NET_ERR_OK) {
+    return err;
+  }
+
   // 发送连接请求(SYN)
   if (tcp_send_syn((tcp_t *)sock) != NET_ERR_OK) {
     dbg_error(DBG_TCP, "send syn failed.");
@@ -338,8 +718,22 @@ static net_err_t tcp_close(sock_t *sock) {
       tcp_free(tcp);
     } break;
 
-    case TCP_STATE_SYN_SENT:
-    case TCP_STATE_SYN_RCVD: {  // tcp正在等待连接建立，放弃该连接并释放tcp对象
+    case TCP_STATE_SYN_RCVD: {
+      // 以快速打开方式被动建立的连接可能已在握手完成前收发了数据, 与已建立的连接相同,
+      // 发送剩余的数据及关闭请求, 并在FIN_WAIT_1状态下等待对端对SYN+ACK及FIN的确认
+      if (tcp->flags.tfo) {
+        if (tcp_send_fin(tcp) != NET_ERR_OK) {
+          dbg_error(DBG_TCP, "send fin failed.");
+          return NET_ERR_TCP;
+        }
+        tcp_state_set(tcp, TCP_STATE_FIN_WAIT_1);
+        return NET_ERR_NEEDWAIT;
+      }
+      tcp_abort_connect(tcp, NET_ERR_TCP_CLOSE);
+      tcp_free(tcp);
+    } break;
+
+    case TCP_STATE_SYN_SENT: {  // tcp正在等待连接建立，放弃该连接并释放tcp对象
       tcp_abort_connect(tcp, NET_ERR_TCP_CLOSE);
       tcp_free(tcp);
     } break;
@@ -363,7 +757,8 @@ static net_err_t tcp_close(sock_t *sock) {
       return NET_ERR_NEEDWAIT;  // 通知调用者等待对端对FIN的确认
     } break;
 
-    case TCP_STATE_TIME_WAIT: {  // TODO: 暂时处：释放tcp对象
+    case TCP_STATE_LISTEN:         // 监听对象，连同未被accept的子连接一起释放
+    case TCP_STATE_TIME_WAIT: {  // 已由TIME_WAIT记录代替，释放tcp对象
       tcp_free(tcp);
     } break;
     default:
@@ -394,9 +789,18 @@ static net_err_t tcp_send(sock_t *sock, const void *buf, size_t buf_len,
       return NET_ERR_TCP_CLOSE;
     } break;
 
-    case TCP_STATE_LISTEN:
     case TCP_STATE_SYN_RCVD:
     case TCP_STATE_SYN_SENT: {
+      // 以快速打开方式建立的连接在握手完成前即可发送数据,
+      // 数据先写入发送缓冲区, 客户端在握手完成后发送, 服务端不等待对端的确认
+      if (tcp->flags.tfo) {
+        break;
+      }
+      dbg_warning(DBG_TCP, "tcp is waiting for connectino, refuse send data.");
+      return NET_ERR_TCP;
+    } break;
+
+    case TCP_STATE_LISTEN: {
       dbg_warning(DBG_TCP, "tcp is waiting for connectino, refuse send data.");
       return NET_ERR_TCP;
     } break;
@@ -426,8 +830,27 @@ static net_err_t tcp_send(sock_t *sock, const void *buf, size_t buf_len,
   }
 
   // 将数据写入到tcp发送缓冲区, 并返回累积实际发送数据长度到ret_send_len中
-  int size = tcp_buf_write(&tcp->send.buf, (const uint8_t *)buf, (int)buf_len);
+  // 零拷贝发送时只挂载应用程序的数据区, 数据在被确认之前由发送缓冲区及数据包直接引用
+  int size;
+  if ((flags & MSG_ZEROCOPY) && tcp->flags.zerocopy) {
+    // 一次发送调用可能分多次挂载, 第一次挂载成功时才分配新的通知序号
+    uint32_t id = *ret_send_len ? tcp->zc.next_id - 1 : tcp->zc.next_id;
+    size = tcp_buf_write_ext(&tcp->send.buf, (const uint8_t *)buf,
+                             (int)buf_len, id);
+    if (size > 0 && *ret_send_len == 0) {
+      tcp->zc.next_id++;
+    }
+  } else {
+    size = tcp_buf_write(&tcp->send.buf, (const uint8_t *)buf, (int)buf_len);
+  }
   if (size <= 0) {  // 写入失败
+    // 缓冲区为空却写入失败，说明缓冲区页面池或零拷贝数据区已耗尽,
+    // 没有可等待的确认事件, 挂载到页面等待链表, 有资源归还时被唤醒
+    if (tcp_buf_cnt(&tcp->send.buf) == 0 &&
+        !nlist_is_mount(&tcp->send.page_node)) {
+      dbg_warning(DBG_TCP, "no free tcp buf page.");
+      nlist_insert_last(&tcp_page_wait_list, &tcp->send.page_node);
+    }
     dbg_warning(DBG_TCP, "send buf write 0 byte.");
     return NET_ERR_NEEDWAIT;
   } else {  // 写入成功，调用tcp_transmit发送数据
@@ -437,22 +860,106 @@ static net_err_t tcp_send(sock_t *sock, const void *buf, size_t buf_len,
 }
 
 /**
- * @brief 内部接口，接收tcp数据
+ * @brief tcp提供给上层的指定目的地址的数据发送接口
+ *        未连接的tcp对象使用MSG_FASTOPEN时以快速打开方式发起连接, 数据在发送SYN之前写入发送缓冲区,
+ *        缓存了对端的cookie时由SYN携带, 不等待握手完成即返回; 其余情况忽略目的地址, 与send相同
  *
  * @param sock
  * @param buf
  * @param buf_len
  * @param flags
- * @param ret_recv_len
+ * @param dest
+ * @param dest_len
+ * @param ret_send_len
  * @return net_err_t
  */
-static net_err_t tcp_recv(sock_t *sock, void *buf, size_t buf_len, int flags,
-                          ssize_t *ret_recv_len) {
-  // 转为对应tcp对象
+static net_err_t tcp_sendto(sock_t *sock, const void *buf, size_t buf_len,
+                            int flags, const struct net_sockaddr *dest,
+                            net_socklen_t dest_len, ssize_t *ret_send_len) {
   tcp_t *tcp = (tcp_t *)sock;
+  if (!TCP_FASTOPEN_ENABLE || !(flags & MSG_FASTOPEN) ||
+      tcp->state != TCP_STATE_CLOSED) {
+    return tcp_send(sock, buf, buf_len, flags, ret_send_len);
+  }
+
+  net_err_t err = tcp_connect_prepare(sock, dest, dest_len);
+  if (err != NET_ERR_OK) {
+    return err;
+  }
+
+  tcp_fastopen_connect(tcp);
+  int size = tcp_buf_write(&tcp->send.buf, (const uint8_t *)buf, (int)buf_len);
+  if (size > 0) {
+    *ret_send_len += size;
+  }
+
+  // 发送携带数据(或cookie请求)的连接请求(SYN)，并切换到SYN_SENT状态
+  if (tcp_send_syn(tcp) != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "send syn failed.");
+    return NET_ERR_TCP;
+  }
+  tcp_state_set(tcp, TCP_STATE_SYN_SENT);
+
+  // 没有写入数据(缓冲区页面已耗尽)时, 由send的处理等待缓冲区空间
+  return size > 0 ? NET_ERR_OK
+                  : tcp_send(sock, buf, buf_len, flags, ret_send_len);
+}
+
+/**
+ * @brief 收集已完成的零拷贝发送调用, 合并到待应用程序读取的完成通知中,
+ *        并释放其占用的零拷贝数据区描述结构
+ *
+ * @param tcp
+ */
+void tcp_zc_collect(tcp_t *tcp) {
+  uint32_t id;
+  while (tcp_buf_ext_done(&tcp->send.buf, &id)) {
+    // 调用按序号顺序完成，只需扩展范围的上界
+    if (!tcp->zc.done_valid) {
+      tcp->zc.done_lo = id;
+      tcp->zc.done_valid = 1;
+    }
+    tcp->zc.done_hi = id;
+  }
+}
+
+/**
+ * @brief 读取零拷贝发送的完成通知
+ *
+ * @param tcp
+ * @param buf 存放struct net_zc_notify的缓冲区
+ * @param buf_len
+ * @param ret_recv_len 有通知时返回通知结构的大小, 否则为0
+ * @return net_err_t
+ */
+static net_err_t tcp_zc_read(tcp_t *tcp, void *buf, size_t buf_len,
+                             ssize_t *ret_recv_len) {
+  if (buf_len < sizeof(struct net_zc_notify)) {
+    dbg_error(DBG_TCP, "zerocopy notify buf too small.");
+    return NET_ERR_PARAM;
+  }
+
+  tcp_zc_collect(tcp);
+  if (tcp->zc.done_valid) {
+    struct net_zc_notify *notify = (struct net_zc_notify *)buf;
+    notify->lo = tcp->zc.done_lo;
+    notify->hi = tcp->zc.done_hi;
+    tcp->zc.done_valid = 0;
+    *ret_recv_len += sizeof(struct net_zc_notify);
+  }
 
-  net_err_t need_wait = NET_ERR_NEEDWAIT;  // 默认调用者需要等待
+  return NET_ERR_OK;
+}
 
+/**
+ * @brief 检查tcp对象当前的状态是否允许接收数据
+ *
+ * @param tcp
+ * @return net_err_t NET_ERR_NEEDWAIT: 允许接收, 没有数据时调用者需要等待
+ *                   NET_ERR_OK: 允许接收, 但不会再有新的数据, 不需要等待
+ *                   其他: 不允许接收
+ */
+static net_err_t tcp_recv_state_check(tcp_t *tcp) {
   // 根据tcp对象的状态进行不同的处理
   switch (tcp->state) {
     case TCP_STATE_CLOSED: {
@@ -460,9 +967,17 @@ static net_err_t tcp_recv(sock_t *sock, void *buf, size_t buf_len, int flags,
       return NET_ERR_TCP_CLOSE;
     } break;
 
-    case TCP_STATE_LISTEN:
     case TCP_STATE_SYN_RCVD:
     case TCP_STATE_SYN_SENT: {
+      // 以快速打开方式建立的连接在握手完成前即可接收数据
+      if (tcp->flags.tfo) {
+        return NET_ERR_NEEDWAIT;
+      }
+      dbg_error(DBG_TCP, "tcp is waiting for connectino, refuse recv data.");
+      return NET_ERR_TCP_STATE;
+    } break;
+
+    case TCP_STATE_LISTEN: {
       dbg_error(DBG_TCP, "tcp is waiting for connectino, refuse recv data.");
       return NET_ERR_TCP_STATE;
     } break;
@@ -478,14 +993,14 @@ static net_err_t tcp_recv(sock_t *sock, void *buf, size_t buf_len, int flags,
     // 半关闭状态，缓冲区中可能还有数据未接收，所以可以继续接收数据
     case TCP_STATE_FIN_WAIT_1:
     case TCP_STATE_FIN_WAIT_2:
-      break;
+      return NET_ERR_NEEDWAIT;
 
     case TCP_STATE_CLOSING:
     case TCP_STATE_CLOSE_WAIT: {
       // 此两个半关闭状态下，本地已接收到对端的fin请求并完成了接收和发送了确认
-      // 即此两个状态下本地不再接收有效数据，缓冲区不会再更新数据,
-      // 所以若缓冲区中有数据则可以继续接收 但若缓冲区中无数据，则不需要等待
-      need_wait = NET_ERR_OK;
+      // 即此两个状态下本地不再接收有效数据，接收队列不会再更新数据,
+      // 所以若队列中有数据则可以继续接收 但若队列中无数据，则不需要等待
+      return NET_ERR_OK;
     } break;
 
     default: {
@@ -493,12 +1008,58 @@ static net_err_t tcp_recv(sock_t *sock, void *buf, size_t buf_len, int flags,
       return NET_ERR_TCP_STATE;
     } break;
   }
+}
+
+/**
+ * @brief 应用程序从接收队列中取走size个字节的数据后, 更新未读取数据的序号并调整接收队列的容量,
+ *        窗口右边界相比上次通告推进了至少一个mss(或缓冲区的一半)时,
+ *        对端可能正因窗口不足而停止发送, 立即发送窗口更新
+ *
+ * @param tcp
+ * @param size
+ */
+static void tcp_recv_consumed(tcp_t *tcp, int size) {
+  tcp->recv.unr += size;  // 更新未读取的数据的数据段序号
+  tcp_rcvbuf_adjust(tcp);  // 根据对端的发送速率调整接收队列的容量
+
+  uint32_t edge = tcp->recv.nxt + tcp_recv_window(tcp);
+  if (tcp->flags.recv_win_valid && !tcp->flags.fin_recved &&
+      tcp_seq_after_eq(edge, tcp->recv.wnd_edge + tcp_recv_wnd_thresh(tcp))) {
+    tcp_send_ack(tcp, (tcp_info_t *)0);
+  }
+}
+
+/**
+ * @brief 内部接口，接收tcp数据
+ *
+ * @param sock
+ * @param buf
+ * @param buf_len
+ * @param flags
+ * @param ret_recv_len
+ * @return net_err_t
+ */
+static net_err_t tcp_recv(sock_t *sock, void *buf, size_t buf_len, int flags,
+                          ssize_t *ret_recv_len) {
+  // 转为对应tcp对象
+  tcp_t *tcp = (tcp_t *)sock;
+
+  // 读取零拷贝发送的完成通知, 与连接状态无关且不需要等待
+  if (flags & MSG_ERRQUEUE) {
+    return tcp_zc_read(tcp, buf, buf_len, ret_recv_len);
+  }
+
+  // 检查连接状态, 并获取没有数据时调用者是否需要等待
+  net_err_t need_wait = tcp_recv_state_check(tcp);
+  if (need_wait != NET_ERR_NEEDWAIT && need_wait != NET_ERR_OK) {
+    return need_wait;
+  }
 
-  // 从tcp接收缓冲区中读取数据到buf中
-  int size = tcp_buf_read(&tcp->recv.buf, (uint8_t *)buf, (int)buf_len);
+  // 从tcp接收队列中读取数据到buf中, 这是接收数据的唯一一次拷贝
+  int size = tcp_rcvq_read(&tcp->recv.queue, (uint8_t *)buf, (int)buf_len);
   if (size > 0) {
     *ret_recv_len += size;
-    tcp->recv.unr += size;  // 更新未读取的数据的数据段序号
+    tcp_recv_consumed(tcp, size);
     return NET_ERR_OK;
   }
 
@@ -506,11 +1067,41 @@ static net_err_t tcp_recv(sock_t *sock, void *buf, size_t buf_len, int flags,
 }
 
 /**
- * @brief 设置TCP socket选项
+ * @brief 内部接口，零拷贝接收tcp数据: 取走接收队列中的所有数据包, 不进行拷贝
  *
  * @param sock
- * @param level
- * @param optname
+ * @param buf 返回只包含有效数据的数据包, 由应用程序只读访问并负责释放
+ * @param flags
+ * @param ret_recv_len
+ * @return net_err_t
+ */
+static net_err_t tcp_recv_zc(sock_t *sock, pktbuf_t **buf, int flags,
+                             ssize_t *ret_recv_len) {
+  tcp_t *tcp = (tcp_t *)sock;
+
+  net_err_t need_wait = tcp_recv_state_check(tcp);
+  if (need_wait != NET_ERR_NEEDWAIT && need_wait != NET_ERR_OK) {
+    return need_wait;
+  }
+
+  pktbuf_t *data = tcp_rcvq_get(&tcp->recv.queue);
+  if (data) {
+    int size = pktbuf_total_size(data);
+    *buf = data;
+    *ret_recv_len += size;
+    tcp_recv_consumed(tcp, size);
+    return NET_ERR_OK;
+  }
+
+  return need_wait;
+}
+
+/**
+ * @brief 设置TCP socket选项
+ *
+ * @param sock
+ * @param level
+ * @param optname
  * @param optval
  * @param optlen
  * @return net_err_t
@@ -528,6 +1119,31 @@ static net_err_t tcp_setopt(struct _sock_t *sock, int level, int optname,
       }
       tcp->flags.keep_alive_enable = *((int *)optval);
       return NET_ERR_OK;
+    } else if (optname == SO_ZEROCOPY) {  // 设置是否允许零拷贝发送
+      if (optlen != sizeof(int)) {
+        dbg_error(DBG_TCP,
+                  "invalid TCP option value: optlen < sizeof(optval).");
+        return NET_ERR_TCP;
+      }
+      tcp->flags.zerocopy = *((int *)optval) ? 1 : 0;
+      return NET_ERR_OK;
+    } else if (optname == SO_RCVBUF) {  // 设置接收缓冲区自动扩大的上限
+      if (optlen != sizeof(int)) {
+        dbg_error(DBG_TCP,
+                  "invalid TCP option value: optlen < sizeof(optval).");
+        return NET_ERR_TCP;
+      }
+      tcp_rcvbuf_set_cap(tcp, *((int *)optval));
+      return NET_ERR_OK;
+    } else if (optname == SO_MAX_PACING_RATE) {  // 设置发送速率上限(字节/s)
+      if (optlen != sizeof(int)) {
+        dbg_error(DBG_TCP,
+                  "invalid TCP option value: optlen < sizeof(optval).");
+        return NET_ERR_TCP;
+      }
+      int rate = *((int *)optval);
+      tcp->pacing.max_rate = rate > 0 ? (uint32_t)rate : 0;
+      return NET_ERR_OK;
     } else {  // 其余选项交由基类sock处理
       if (sock_setopt(sock, level, optname, optval, optlen) != NET_ERR_OK) {
         dbg_error(DBG_TCP, "set TCP option failed.");
@@ -563,6 +1179,120 @@ static net_err_t tcp_setopt(struct _sock_t *sock, int level, int optname,
         tcp->conn.keep_cnt = *((int *)optval);
       } break;
 
+      case TCP_TIMESTAMPS: {  // 设置是否启用时间戳选项, 只能在建立连接前设置
+        if (optlen != sizeof(int)) {
+          dbg_error(DBG_TCP,
+                    "invalid TCP option value: optlen < sizeof(optval).");
+          return NET_ERR_TCP;
+        }
+        if (tcp->state != TCP_STATE_CLOSED) {
+          dbg_error(DBG_TCP, "can't set TCP_TIMESTAMPS after connect.");
+          return NET_ERR_TCP_STATE;
+        }
+        tcp->flags.ts_enable = *((int *)optval) ? 1 : 0;
+      } break;
+
+      case TCP_ECN: {  // 设置是否启用显式拥塞通知, 只能在建立连接前设置
+        if (optlen != sizeof(int)) {
+          dbg_error(DBG_TCP,
+                    "invalid TCP option value: optlen < sizeof(optval).");
+          return NET_ERR_TCP;
+        }
+        if (tcp->state != TCP_STATE_CLOSED) {
+          dbg_error(DBG_TCP, "can't set TCP_ECN after connect.");
+          return NET_ERR_TCP_STATE;
+        }
+        tcp->flags.ecn_enable = *((int *)optval) ? 1 : 0;
+      } break;
+
+      case TCP_FASTOPEN: {  // 设置监听对象是否允许快速打开, 需在listen之前设置
+        if (optlen != sizeof(int)) {
+          dbg_error(DBG_TCP,
+                    "invalid TCP option value: optlen < sizeof(optval).");
+          return NET_ERR_TCP;
+        }
+        if (tcp->state != TCP_STATE_CLOSED) {
+          dbg_error(DBG_TCP, "can't set TCP_FASTOPEN after listen.");
+          return NET_ERR_TCP_STATE;
+        }
+        tcp->flags.tfo_enable = *((int *)optval) ? 1 : 0;
+      } break;
+
+      case TCP_QUICKACK: {  // 设置是否关闭延迟确认
+        if (optlen != sizeof(int)) {
+          dbg_error(DBG_TCP,
+                    "invalid TCP option value: optlen < sizeof(optval).");
+          return NET_ERR_TCP;
+        }
+        tcp->flags.quick_ack = *((int *)optval) ? 1 : 0;
+
+        // 开启立即确认时，若有延迟的ack则立即发送
+        if (tcp->flags.quick_ack &&
+            (tcp->delack.timer.flags & NET_TIMER_ACTIVE)) {
+          tcp_send_ack(tcp, (tcp_info_t *)0);
+        }
+      } break;
+
+      case TCP_NODELAY: {  // 设置是否关闭Nagle算法
+        if (optlen != sizeof(int)) {
+          dbg_error(DBG_TCP,
+                    "invalid TCP option value: optlen < sizeof(optval).");
+          return NET_ERR_TCP;
+        }
+        tcp->flags.nodelay = *((int *)optval) ? 1 : 0;
+
+        // 关闭Nagle算法时，立即发送被推迟的小数据段
+        if (tcp->flags.nodelay) {
+          tcp_transmit(tcp);
+        }
+      } break;
+
+      case TCP_CORK: {  // 设置是否塞住发送
+        if (optlen != sizeof(int)) {
+          dbg_error(DBG_TCP,
+                    "invalid TCP option value: optlen < sizeof(optval).");
+          return NET_ERR_TCP;
+        }
+        tcp->flags.cork = *((int *)optval) ? 1 : 0;
+
+        // 取消塞住时，立即发送累积的不足mss的数据
+        if (!tcp->flags.cork) {
+          tcp_transmit(tcp);
+        }
+      } break;
+
+      case TCP_CONGESTION: {  // 设置拥塞控制算法
+        char name[8];
+        if (optlen <= 0 || optlen >= (int)sizeof(name)) {
+          dbg_error(DBG_TCP, "invalid TCP congestion control name.");
+          return NET_ERR_TCP;
+        }
+        plat_memcpy(name, optval, optlen);
+        name[optlen] = '\0';
+
+        tcp_cc_t cc;
+        if (plat_strcmp(name, "reno") == 0) {
+          cc = TCP_CC_RENO;
+        } else if (plat_strcmp(name, "bbr") == 0) {
+          cc = TCP_CC_BBR;
+        } else {
+          dbg_error(DBG_TCP, "unknown TCP congestion control: %s.", name);
+          return NET_ERR_TCP;
+        }
+
+        // 连接建立后切换时, 从当前的拥塞窗口开始重新初始化拥塞控制算法的状态
+        if (cc != tcp->cc) {
+          tcp->cc = cc;
+          if (tcp->state != TCP_STATE_CLOSED &&
+              tcp->state != TCP_STATE_LISTEN) {
+            tcp->pacing.rate = 0;
+            if (cc == TCP_CC_BBR) {
+              tcp_bbr_init(tcp);
+            }
+          }
+        }
+      } break;
+
       default: {
         dbg_error(DBG_TCP, "invalid TCP option name.");
         return NET_ERR_TCP;
@@ -573,6 +1303,213 @@ static net_err_t tcp_setopt(struct _sock_t *sock, int level, int optname,
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 填充tcp连接的状态及统计信息(TCP_INFO), 在工作线程中调用, 读取的是一致的快照
+ *
+ * @param tcp
+ * @param info
+ */
+static void tcp_info_fill(tcp_t *tcp, struct net_tcp_info *info) {
+  plat_memset(info, 0, sizeof(struct net_tcp_info));
+  info->state = (uint8_t)tcp->state;
+  if (tcp->state == TCP_STATE_CLOSED || tcp->state == TCP_STATE_LISTEN) {
+    return;
+  }
+
+  info->options = (tcp->flags.ts_ok ? NET_TCPI_OPT_TIMESTAMPS : 0) |
+                  (tcp->flags.ecn_ok ? NET_TCPI_OPT_ECN : 0) |
+                  (tcp->flags.tfo ? NET_TCPI_OPT_FASTOPEN : 0);
+  info->mss = (uint16_t)tcp_send_mss(tcp);
+
+  info->rtt = tcp->rtt.srtt;
+  info->rttvar = tcp->rtt.rttvar;
+  info->rto = tcp->rtt.rto;
+  info->min_rtt = tcp->rack.rtt >= 0 ? tcp->rack.min_rtt : 0;
+
+  info->snd_cwnd = tcp->send.cwnd;
+  info->snd_ssthresh = tcp->send.ssthresh;
+  info->snd_wnd = tcp->send.win;
+  info->rcv_wnd = tcp_recv_window(tcp);
+  info->unacked = tcp->send.nxt - tcp->send.una;
+  info->notsent = tcp_wait_send_data(tcp);
+  info->rcv_queued = tcp_rcvq_cnt(&tcp->recv.queue);
+
+  // 实际的发送速率受SO_MAX_PACING_RATE限制
+  uint32_t rate = tcp->pacing.rate;
+  if (tcp->pacing.max_rate && (!rate || rate > tcp->pacing.max_rate)) {
+    rate = tcp->pacing.max_rate;
+  }
+  info->pacing_rate = rate;
+
+  info->retransmits = tcp->rtt.retry;
+  info->total_retrans = tcp->stats.retrans;
+  info->rto_cnt = tcp->stats.rto_cnt;
+  info->tlp_probes = tcp->rack.stats.tlp_probes;
+  info->rack_lost = tcp->rack.stats.rack_lost;
+  info->zwnd_probes = tcp->stats.zwnd_probes;
+  info->segs_out = tcp->stats.segs_out;
+  info->segs_in = tcp->stats.segs_in;
+  info->bytes_acked = tcp->stats.bytes_acked;
+  info->bytes_received = tcp->stats.bytes_received;
+}
+
+/**
+ * @brief 获取TCP socket选项
+ *
+ * @param sock
+ * @param level
+ * @param optname
+ * @param optval
+ * @param optlen 传入缓冲区大小, 返回选项值的实际长度
+ * @return net_err_t
+ */
+static net_err_t tcp_getopt(struct _sock_t *sock, int level, int optname,
+                            char *optval, int *optlen) {
+  tcp_t *tcp = (tcp_t *)sock;
+
+  if (level == SOL_TCP && optname == TCP_INFO) {
+    // 缓冲区较小时只返回前面的部分, 兼容使用旧版本结构的应用程序
+    struct net_tcp_info info;
+    tcp_info_fill(tcp, &info);
+    int len = MIN(*optlen, (int)sizeof(info));
+    plat_memcpy(optval, &info, len);
+    *optlen = len;
+    return NET_ERR_OK;
+  }
+
+  // 其余选项交由基类sock处理
+  if (sock_getopt(sock, level, optname, optval, optlen) != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "get TCP option failed.");
+    return NET_ERR_TCP;
+  }
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 绑定tcp对象的本地ip地址与端口
+ *
+ * @param sock
+ * @param addr
+ * @param addrlen
+ * @return net_err_t
+ */
+static net_err_t tcp_bind(sock_t *sock, const struct net_sockaddr *addr,
+                          net_socklen_t addrlen) {
+  // 只能在建立连接前绑定, 且不能重复绑定
+  if (((tcp_t *)sock)->state != TCP_STATE_CLOSED) {
+    dbg_error(DBG_TCP, "tcp state error, can't bind.");
+    return NET_ERR_TCP_STATE;
+  }
+  if (sock->local_port != NET_PORT_EMPTY) {
+    dbg_error(DBG_TCP, "socket has bind.");
+    return NET_ERR_TCP;
+  }
+
+  // 获取端口号, 并判断端口号是否已被绑定, 或正被已建立的连接使用
+  const struct net_sockaddr_in *addr_in = (const struct net_sockaddr_in *)addr;
+  ipaddr_t local_ip;
+  ipaddr_from_bytes(&local_ip, addr_in->sin_addr.s_addr_bytes);
+  uint16_t local_port = net_ntohs(addr_in->sin_port);
+  sock_t *bind_sock =
+      sock_hash_find(&tcp_bind_hash, &local_ip, local_port,
+                     (const ipaddr_t *)0, 0, (sock_hash_match_t)0);
+  if ((bind_sock && ipaddr_is_equal(&bind_sock->local_ip, &local_ip)) ||
+      tcp_conn_port_is_used(&local_ip, local_port)) {
+    dbg_error(DBG_TCP, "port has bind.");
+    return NET_ERR_TCP;
+  }
+
+  // socket未进行绑定，且端口号未被使用，绑定本地ip和端口号
+  net_err_t err = sock_bind(sock, &local_ip, local_port);
+  if (err != NET_ERR_OK) {
+    return err;
+  }
+
+  sock_hash_insert(&tcp_bind_hash, sock);
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 将tcp对象设置为监听状态，以被动接受连接请求
+ *
+ * @param sock
+ * @param backlog 全连接队列的最大长度
+ * @return net_err_t
+ */
+static net_err_t tcp_listen(sock_t *sock, int backlog) {
+  tcp_t *tcp = (tcp_t *)sock;
+
+  // 只有未建立连接的tcp对象才能监听, 已监听的tcp对象可以重新设置backlog
+  if (tcp->state != TCP_STATE_CLOSED && tcp->state != TCP_STATE_LISTEN) {
+    dbg_error(DBG_TCP, "tcp state error, can't listen.");
+    return NET_ERR_TCP_STATE;
+  }
+
+  // 若未绑定本地端口，则分配一个本地端口
+  if (sock->local_port == NET_PORT_EMPTY) {
+    if (tcp_alloc_port(sock) != NET_ERR_OK) {
+      dbg_error(DBG_TCP, "alloc local port failed.");
+      return NET_ERR_TCP;
+    }
+    sock_hash_insert(&tcp_bind_hash, sock);
+  }
+
+  // 限制全连接队列的长度
+  tcp->listen.backlog = backlog <= 0 ? 1 : MIN(backlog, TCP_ACCEPT_BACKLOG);
+
+  if (tcp->state == TCP_STATE_CLOSED) {
+    nlist_init(&tcp->listen.syn_list);
+    nlist_init(&tcp->listen.accept_list);
+    tcp_state_set(tcp, TCP_STATE_LISTEN);
+  }
+
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 从监听tcp对象的全连接队列中取出一个已完成三次握手的子连接
+ *
+ * @param sock
+ * @param addr 返回子连接的远端地址, 可为空
+ * @param addrlen
+ * @param client 返回子连接
+ * @return net_err_t
+ */
+static net_err_t tcp_accept(sock_t *sock, struct net_sockaddr *addr,
+                            net_socklen_t *addrlen, sock_t **client) {
+  tcp_t *tcp = (tcp_t *)sock;
+
+  if (tcp->state != TCP_STATE_LISTEN) {
+    dbg_error(DBG_TCP, "tcp is not listening, can't accept.");
+    return NET_ERR_TCP_STATE;
+  }
+
+  // 全连接队列为空，通知调用者等待新的连接
+  nlist_node_t *node = nlist_remove_first(&tcp->listen.accept_list);
+  if (!node) {
+    return NET_ERR_NEEDWAIT;
+  }
+
+  // 子连接交由调用者持有，不再属于监听对象
+  tcp_t *child = nlist_entry(node, tcp_t, listen.node);
+  child->listen.parent = (tcp_t *)0;
+  child->listen.queue = (nlist_t *)0;
+
+  // 记录子连接的远端地址
+  if (addr && addrlen) {
+    struct net_sockaddr_in *addr_in = (struct net_sockaddr_in *)addr;
+    plat_memset(addr_in, 0, sizeof(struct net_sockaddr_in));
+    addr_in->sin_family = AF_INET;
+    addr_in->sin_port = net_htons(child->sock_base.remote_port);
+    plat_memcpy(addr_in->sin_addr.s_addr_bytes,
+                child->sock_base.remote_ip.addr_bytes, IP_ADDR_SIZE);
+    *addrlen = sizeof(struct net_sockaddr_in);
+  }
+
+  *client = &child->sock_base;
+  return NET_ERR_OK;
+}
+
 /**
  * @brief 分配一个tcp socket对象
  *
@@ -583,11 +1520,15 @@ static tcp_t *tcp_alloc(int family, int protocol, int wait) {
       .connect = tcp_connect,  // 独立实现接口
       .close = tcp_close,      // 独立实现接口
       .send = tcp_send,        // 独立实现接口
+      .sendto = tcp_sendto,    // 独立实现接口
       .recv = tcp_recv,        // 独立实现接口
+      .recv_zc = tcp_recv_zc,  // 独立实现接口
       .setopt = tcp_setopt,    // 独立实现接口
-      //   .sendto = tcp_sendto,      // 独立实现接口
+      .getopt = tcp_getopt,    // 独立实现接口
+      .bind = tcp_bind,        // 独立实现接口
+      .listen = tcp_listen,    // 独立实现接口
+      .accept = tcp_accept,    // 独立实现接口
       //   .recvfrom = tcp_recvfrom,  // 独立实现接口
-      //   .bind = tcp_bind,
   };
 
   // 获取一个空闲的tcp对象
@@ -614,6 +1555,19 @@ static tcp_t *tcp_alloc(int family, int protocol, int wait) {
   tcp->conn.keep_intvl = TCP_KEEPALIVE_INTVL;
   tcp->conn.keep_cnt = TCP_KEEPALIVE_CNT;
 
+  // 初始化时间戳选项
+  tcp->flags.ts_enable = TCP_TS_ENABLE;
+  tcp->flags.ecn_enable = TCP_ECN_ENABLE;
+
+  // 初始化接收缓冲区自动扩大的上限
+  tcp->recv.tune.cap = TCP_RBUF_MAX;
+
+  // 初始化拥塞控制算法
+  tcp->cc = TCP_CC_DEFAULT;
+
+  // 初始化乱序队列
+  tcp_ooo_init(&tcp->recv.ooo);
+
   // 初始化tcp对象的连接wait对象, 并用基类sock记录该wait对象
   if (sock_wait_init(&tcp->conn.wait) != NET_ERR_OK) {
     dbg_error(DBG_TCP, "conn wait init failed.");
@@ -699,29 +1653,25 @@ sock_t *tcp_create(int family, int protocol) {
  * @return tcp_t*
  */
 tcp_t *tcp_find(tcp_info_t *info) {
-  nlist_node_t *node = (nlist_node_t *)0;
-  nlist_for_each(node, &tcp_list) {
-    sock_t *tcp_sock = nlist_entry(node, sock_t, node);
-    // 若tcp对象绑定了本地ip地址，则比较本地ip地址
-    if (!ipaddr_is_any(&tcp_sock->local_ip) &&
-        !ipaddr_is_equal(&tcp_sock->local_ip, &info->local_ip)) {
-      continue;
-    }
-
-    // 比较四元组其余信息
-    if (tcp_sock->local_port == info->tcp_hdr->dest_port &&
-        tcp_sock->remote_port == info->tcp_hdr->src_port &&
-        ipaddr_is_equal(&tcp_sock->remote_ip, &info->remote_ip)) {
-      return (tcp_t *)tcp_sock;
-    }
+  // 优先按四元组查找已建立的连接
+  sock_t *sock = sock_hash_find(&tcp_conn_hash, &info->local_ip,
+                                info->tcp_hdr->dest_port, &info->remote_ip,
+                                info->tcp_hdr->src_port, tcp_is_alive);
+  if (sock) {
+    return (tcp_t *)sock;
   }
 
-  return (tcp_t *)0;
+  // 没有完全匹配的连接时，由监听该端口的tcp对象处理,
+  // 绑定了本地ip的监听对象优先于绑定了通配ip的监听对象
+  return (tcp_t *)sock_hash_find(&tcp_bind_hash, &info->local_ip,
+                                 info->tcp_hdr->dest_port, (const ipaddr_t *)0,
+                                 0, tcp_is_listen);
 }
 
 /**
  * @brief 舍弃当前tcp连接，唤醒等待在该tcp对象上的所有任务,
  *        并将tcp对象状态设置为CLOSED以等待本地持有者调用close关闭并释放该对象
+ *        未被accept的子连接没有持有者，直接释放
  *
  *
  * @param tcp
@@ -729,6 +1679,20 @@ tcp_t *tcp_find(tcp_info_t *info) {
  * @return net_err_t
  */
 net_err_t tcp_abort_connect(tcp_t *tcp, net_err_t err) {
+  // 连接已舍弃，不再需要重传及确认，也不会再接收数据
+  tcp_rto_stop(tcp);
+  tcp_delack_stop(tcp);
+  tcp_pacing_stop(tcp);
+  tcp_rack_stop(tcp);
+  tcp_persist_stop(tcp);
+  tcp_ooo_clear(&tcp->recv.ooo);
+
+  // 未被accept的子连接没有持有者会调用close()，直接释放
+  if (tcp->listen.parent) {
+    tcp_free(tcp);
+    return NET_ERR_OK;
+  }
+
   // 设置tcp状态为CLOSED
   tcp_state_set(tcp, TCP_STATE_CLOSED);
 
@@ -739,8 +1703,9 @@ net_err_t tcp_abort_connect(tcp_t *tcp, net_err_t err) {
 }
 
 /**
- * @brief 解析tcp选项数据
- * TODO: 选项数据和tcp头部数据可能不是连续存储的，需要特殊处理
+ * @brief 解析SYN报文段中的tcp选项数据, 以协商mss及时间戳选项
+ * 调用前需保证tcp头部(包括选项)在内存上连续
+ *
  * @param tcp
  * @param tcp_hdr
  */
@@ -750,6 +1715,8 @@ void tcp_read_options(tcp_t *tcp, tcp_hdr_t *tcp_hdr) {
   uint8_t *opt_end =
       opt_start + (tcp_get_hdr_size(tcp_hdr) - sizeof(tcp_hdr_t));
 
+  tcp->flags.ts_ok = 0;
+
   // 遍历tcp选项数据
   while (opt_start < opt_end) {
     switch (opt_start[0]) {
@@ -759,49 +1726,95 @@ void tcp_read_options(tcp_t *tcp, tcp_hdr_t *tcp_hdr) {
           uint16_t mss = net_ntohs(opt_mss->mss);
           tcp->mss = MIN(tcp->mss, mss);  // 选择最小的MSS
         }
-        opt_start += opt_mss->len;  // 移动到下一个选项
+      } break;
+
+      case TCP_OPT_TS: {  // 对端支持时间戳选项, 若本地也允许则启用
+        tcp_opt_ts_t *opt_ts = (tcp_opt_ts_t *)opt_start;
+        if (opt_ts->len == sizeof(tcp_opt_ts_t) && tcp->flags.ts_enable) {
+          tcp->flags.ts_ok = 1;
+          tcp->ts.recent = net_ntohl(opt_ts->ts_val);
+          tcp->ts.recent_time = tcp_time_now();
+        }
       } break;
 
       case TCP_OPT_NOP: {  // 填充字节，直接跳过
         opt_start++;
+        continue;
       } break;
 
       case TCP_OPT_END: {  // 结束选项
         return;
       } break;
 
-      default: {  // TODO: 其他选项暂时跳过，后续再扩展
-        opt_start++;
-      } break;
+      default:  // 其他选项暂时跳过，后续再扩展
+        break;
     }
+
+    // 其余选项都有长度字段，长度不合法则停止解析
+    if (opt_start + 1 >= opt_end || opt_start[1] < 2) {
+      return;
+    }
+    opt_start += opt_start[1];  // 移动到下一个选项
   }
 }
 
 /**
- * @brief 设置tcp数据包的同步选项
- * TODO: 暂时只设置MSS选项
+ * @brief 根据tcp数据包头部的标志位，为数据包填充tcp选项
+ *        SYN报文段: MSS选项，若允许则再附加时间戳选项以发起协商, 快速打开时附加cookie选项
+ *        其余报文段: 若已协商时间戳选项，则附加时间戳选项
+ * 调用前需已填充好tcp头部的标志位，且数据包中只有tcp头部
  *
  * @param tcp
  * @param buf
  * @return net_err_t
  */
 net_err_t tcp_write_options(tcp_t *tcp, pktbuf_t *buf) {
-  // 对数据包进行拓容以容纳MSS选项
-  int opt_len = sizeof(tcp_opt_mss_t);
+  tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(buf);
+  uint8_t opt_buf[sizeof(tcp_opt_mss_t) + 2 + sizeof(tcp_opt_ts_t) + 4 +
+                  TCP_FASTOPEN_COOKIE_SIZE];
+  int opt_len = 0;
+
+  // 构造MSS选项
+  if (tcp_hdr->f_syn) {
+    tcp_opt_mss_t *opt_mss = (tcp_opt_mss_t *)(opt_buf + opt_len);
+    opt_mss->kind = TCP_OPT_MSS;
+    opt_mss->len = sizeof(tcp_opt_mss_t);
+    // 通告本地网络接口所能接收的mss, tcp->mss在SYN+ACK中已是双方协商后的值
+    opt_mss->mss = net_htons(tcp_route_mss(&tcp->sock_base.remote_ip));
+    opt_len += sizeof(tcp_opt_mss_t);
+  }
+
+  // 构造时间戳选项, 主动发起的SYN根据本地配置决定是否携带，
+  // SYN+ACK及其余报文段则根据协商结果决定
+  int ts = (tcp_hdr->f_syn && !tcp_hdr->f_ack) ? tcp->flags.ts_enable
+                                                : tcp->flags.ts_ok;
+  if (ts) {
+    // 使用两个NOP选项填充，使时间戳字段4字节对齐
+    opt_buf[opt_len++] = TCP_OPT_NOP;
+    opt_buf[opt_len++] = TCP_OPT_NOP;
+    tcp_opt_ts_t *opt_ts = (tcp_opt_ts_t *)(opt_buf + opt_len);
+    opt_ts->kind = TCP_OPT_TS;
+    opt_ts->len = sizeof(tcp_opt_ts_t);
+    opt_ts->ts_val = net_htonl(tcp_time_now());
+    opt_ts->ts_ecr = net_htonl(tcp_hdr->f_ack ? tcp->ts.recent : 0);
+    opt_len += sizeof(tcp_opt_ts_t);
+  }
+
+  // 构造快速打开选项
+  opt_len += tcp_fastopen_write_option(tcp, tcp_hdr, opt_buf + opt_len);
+
+  if (opt_len == 0) {
+    return NET_ERR_OK;
+  }
+
+  // 对数据包进行拓容以容纳选项，并将选项填充到数据包中
   net_err_t err = pktbuf_resize(buf, pktbuf_total_size(buf) + opt_len);
   if (err != NET_ERR_OK) {
     dbg_error(DBG_TCP, "pktbuf resize error.");
     return err;
   }
-
-  // 构造MSS选项，填充到数据包中
-  tcp_opt_mss_t opt_mss = {
-      .kind = TCP_OPT_MSS,
-      .len = sizeof(tcp_opt_mss_t),
-      .mss = net_htons(tcp->mss),
-  };
   pktbuf_seek(buf, pktbuf_total_size(buf) - opt_len);
-  err = pktbuf_write(buf, (uint8_t *)&opt_mss, sizeof(tcp_opt_mss_t));
+  err = pktbuf_write(buf, opt_buf, opt_len);
   if (err != NET_ERR_OK) {
     dbg_error(DBG_TCP, "pktbuf write error.");
     return err;
@@ -810,6 +1823,82 @@ net_err_t tcp_write_options(tcp_t *tcp, pktbuf_t *buf) {
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 使用一次往返时间采样值更新重传超时时间(RFC 6298)
+ *
+ * @param tcp
+ * @param rtt 往返时间采样值(ms)
+ */
+void tcp_rtt_update(tcp_t *tcp, int rtt) {
+  if (rtt < 0) {
+    return;
+  }
+
+  if (tcp->rtt.srtt == 0) {  // 第一次采样
+    tcp->rtt.srtt = rtt ? rtt : 1;
+    tcp->rtt.rttvar = rtt / 2;
+  } else {
+    // rttvar = 3/4 * rttvar + 1/4 * |srtt - rtt|
+    // srtt = 7/8 * srtt + 1/8 * rtt
+    int delta = tcp->rtt.srtt - rtt;
+    delta = delta < 0 ? -delta : delta;
+    tcp->rtt.rttvar = (3 * tcp->rtt.rttvar + delta) / 4;
+    tcp->rtt.srtt = (7 * tcp->rtt.srtt + rtt) / 8;
+    tcp->rtt.srtt = tcp->rtt.srtt ? tcp->rtt.srtt : 1;
+  }
+
+  // rto = srtt + 4 * rttvar, 并限制在[TCP_RTO_MIN, TCP_RTO_MAX]范围内
+  int rto = tcp->rtt.srtt + 4 * tcp->rtt.rttvar;
+  rto = MAX(rto, TCP_RTO_MIN);
+  tcp->rtt.rto = MIN(rto, TCP_RTO_MAX);
+}
+
+/**
+ * @brief 防止序号回绕检查(PAWS, RFC 7323)
+ * 若报文段携带的时间戳早于最近记录的时间戳，则说明该报文段是一个
+ * 过时的重复报文段(其序号可能已经回绕)，应丢弃
+ *
+ * @param tcp
+ * @param info
+ * @return int 1: 需要丢弃, 0: 通过检查
+ */
+int tcp_paws_reject(tcp_t *tcp, tcp_info_t *info) {
+  if (!tcp->flags.ts_ok || !info->ts_valid || info->tcp_hdr->f_rst) {
+    return 0;
+  }
+
+  if (!tcp_seq_before(info->ts_val, tcp->ts.recent)) {
+    return 0;
+  }
+
+  // 长时间空闲的连接，recent可能已经失效(对端时钟回绕)，不再进行检查
+  if (tcp_time_now() - tcp->ts.recent_time > TCP_PAWS_IDLE) {
+    return 0;
+  }
+
+  return 1;
+}
+
+/**
+ * @brief 根据已通过检查的报文段更新需要回显的时间戳
+ * 只有当报文段覆盖了上次发送的ack号时才更新(RFC 7323 4.3)，
+ * 以保证回显的时间戳来自于推进了接收窗口的报文段
+ *
+ * @param tcp
+ * @param info
+ */
+void tcp_ts_update(tcp_t *tcp, tcp_info_t *info) {
+  if (!tcp->flags.ts_ok || !info->ts_valid) {
+    return;
+  }
+
+  if (tcp_seq_before_eq(info->seq, tcp->ts.last_ack_sent) &&
+      tcp_seq_after_eq(info->ts_val, tcp->ts.recent)) {
+    tcp->ts.recent = info->ts_val;
+    tcp->ts.recent_time = tcp_time_now();
+  }
+}
+
 /**
  * @brief 判断tcp数据包的序列号是否有效，有效则处理数据包，否则不处理(RFC793)
  *        有效：
@@ -838,8 +1927,10 @@ int tcp_seq_is_ok(tcp_t *tcp, tcp_info_t *info) {
               tcp_seq_before(info->seq, tcp->recv.nxt + win_size));
     }
   } else {
-    if (win_size == 0) {  // 情况3: 有数据，无窗口，直接返回0
-      return 0;
+    if (win_size == 0) {
+      // 情况3: 有数据，无窗口, 只接受不携带数据且序号等于nxt的fin请求,
+      // fin不占用接收缓冲区，对端在发完填满窗口的数据后即可发送fin
+      return info->data_len == 0 && info->seq == tcp->recv.nxt;
     } else {  // 情况4: 有数据，有窗口，有数据落在窗口内即可
       // 起始seq在窗口内，则肯定有部分数据有效[seq, next + win_size)
       int v = (tcp_seq_after_eq(info->seq, tcp->recv.nxt) &&
@@ -853,4 +1944,151 @@ int tcp_seq_is_ok(tcp_t *tcp, tcp_info_t *info) {
       return v;
     }
   }
-}
\ No newline at end of file
+}
+/**
+ * @brief 为监听tcp对象收到的连接请求分配一个子连接, 并挂载到tcp对象链表
+ *        子连接继承监听对象的选项, 接收窗口由调用者根据连接请求进行设置
+ *
+ * @param parent 监听tcp对象
+ * @param info 连接请求数据包的信息
+ * @return tcp_t*
+ */
+tcp_t *tcp_child_alloc(tcp_t *parent, tcp_info_t *info) {
+  // 在工作线程中分配，不能阻塞等待
+  tcp_t *child = tcp_alloc(parent->sock_base.family,
+                           parent->sock_base.protocol, TCP_CREATE_NOWAIT);
+  if (!child) {
+    return (tcp_t *)0;
+  }
+
+  // 继承监听对象的socket选项
+  child->sock_base.recv_tmo = parent->sock_base.recv_tmo;
+  child->sock_base.send_tmo = parent->sock_base.send_tmo;
+  child->flags.ts_enable = parent->flags.ts_enable;
+  child->flags.ecn_enable = parent->flags.ecn_enable;
+  child->flags.quick_ack = parent->flags.quick_ack;
+  child->flags.nodelay = parent->flags.nodelay;
+  child->flags.cork = parent->flags.cork;
+  child->flags.zerocopy = parent->flags.zerocopy;
+  child->recv.tune.cap = parent->recv.tune.cap;
+  child->cc = parent->cc;
+  child->pacing.max_rate = parent->pacing.max_rate;
+  child->flags.keep_alive_enable = parent->flags.keep_alive_enable;
+  child->conn.keep_idle = parent->conn.keep_idle;
+  child->conn.keep_intvl = parent->conn.keep_intvl;
+  child->conn.keep_cnt = parent->conn.keep_cnt;
+
+  // 记录连接的四元组
+  ipaddr_copy(&child->sock_base.local_ip, &info->local_ip);
+  child->sock_base.local_port = info->tcp_hdr->dest_port;
+  ipaddr_copy(&child->sock_base.remote_ip, &info->remote_ip);
+  child->sock_base.remote_port = info->tcp_hdr->src_port;
+
+  // 初始化发送窗口、缓冲区及mss等连接信息
+  tcp_connect_init(child);
+
+  child->listen.parent = parent;
+  tcp_insert(child);
+  sock_hash_insert(&tcp_conn_hash, &child->sock_base);
+
+  return child;
+}
+
+/**
+ * @brief 将未被accept的子连接移动到所属监听对象的指定队列中
+ *
+ * @param child
+ * @param queue 监听对象的半连接队列或全连接队列
+ */
+void tcp_child_queue(tcp_t *child, nlist_t *queue) {
+  if (child->listen.queue) {
+    nlist_remove(child->listen.queue, &child->listen.node);
+  }
+
+  nlist_insert_last(queue, &child->listen.node);
+  child->listen.queue = queue;
+}
+
+/**
+ * @brief 计算SYN cookie中的校验部分
+ *
+ * @param info
+ * @param peer_isn 对端的初始序号
+ * @param count cookie计数器
+ * @param mss_idx mss在编码表中的索引
+ * @return uint32_t
+ */
+static uint32_t tcp_syncookie_hash(tcp_info_t *info, uint32_t peer_isn,
+                                   uint32_t count, uint32_t mss_idx) {
+  uint32_t data[] = {
+      info->local_ip.addr,
+      info->remote_ip.addr,
+      ((uint32_t)info->tcp_hdr->src_port << 16) | info->tcp_hdr->dest_port,
+      peer_isn,
+      count,
+      mss_idx,
+  };
+
+  return tools_hash32(data, sizeof(data), tcp_syncookie_secret);
+}
+
+/**
+ * @brief 半连接队列已满时，根据连接请求生成SYN cookie作为SYN+ACK的初始序号,
+ *        使本地不需要保存任何连接状态
+ *        cookie格式: | 计数器低5位 | mss索引(3位) | 校验值(24位) |
+ *
+ * @param info SYN数据包的信息
+ * @param mss 返回cookie中编码的mss
+ * @return uint32_t
+ */
+uint32_t tcp_syncookie_make(tcp_info_t *info, uint16_t *mss) {
+  // 选择不超过双方mss的最大编码值
+  uint16_t mss_limit = tcp_path_mss(&info->remote_ip);
+  if (info->mss) {
+    mss_limit = MIN(mss_limit, info->mss);
+  }
+  uint32_t mss_idx = 0;
+  for (int i = 1; i < sizeof(tcp_syncookie_mss_tbl) / sizeof(uint16_t); i++) {
+    if (tcp_syncookie_mss_tbl[i] <= mss_limit) {
+      mss_idx = i;
+    }
+  }
+  *mss = tcp_syncookie_mss_tbl[mss_idx];
+
+  uint32_t count = tcp_time_now() >> TCP_SYNCOOKIE_TIME_SHIFT;
+  uint32_t hash = tcp_syncookie_hash(info, info->seq, count, mss_idx);
+  return ((count & 0x1f) << 27) | (mss_idx << 24) | (hash & 0xffffff);
+}
+
+/**
+ * @brief 检查第三次握手的ack确认号是否为本地生成的有效SYN cookie,
+ *        只接受当前及上一个计数周期内生成的cookie
+ *
+ * @param info ack数据包的信息
+ * @param mss 返回cookie中编码的mss
+ * @return int 1: 有效, 0: 无效
+ */
+int tcp_syncookie_check(tcp_info_t *info, uint16_t *mss) {
+  uint32_t cookie = info->tcp_hdr->ack - 1;
+  uint32_t peer_isn = info->seq - 1;
+
+  // 根据计数器低5位恢复生成cookie时的计数值
+  uint32_t now = tcp_time_now() >> TCP_SYNCOOKIE_TIME_SHIFT;
+  uint32_t diff = (now - (cookie >> 27)) & 0x1f;
+  if (diff > 1) {
+    return 0;
+  }
+
+  uint32_t mss_idx = (cookie >> 24) & 0x7;
+  if (mss_idx >= sizeof(tcp_syncookie_mss_tbl) / sizeof(uint16_t)) {
+    return 0;
+  }
+
+  uint32_t hash = tcp_syncookie_hash(info, peer_isn, now - diff, mss_idx);
+  if ((hash & 0xffffff) != (cookie & 0xffffff)) {
+    return 0;
+  }
+
+  *mss = tcp_syncookie_mss_tbl[mss_idx];
+  return 1;
+}
@@ -0,0 +1,431 @@
+/**
+ * @file tcp_bbr.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp BBR拥塞控制模块
+ *        基于丢包的拥塞控制在瓶颈处的队列填满并丢包后才降低发送量, 队列始终处于满的状态, 增大了时延;
+ *        BBR以每轮(约一个rtt)的交付速率的最大值估计瓶颈带宽, 以一段时间内的最小rtt估计传播时延,
+ *        按瓶颈带宽控制发送速率, 按两者的乘积(带宽时延积)限制在途数据量, 使瓶颈处基本不形成队列
+ *        阶段: STARTUP指数增长探测带宽 -> DRAIN排空探测时形成的队列 -> PROBE_BW以瓶颈带宽发送,
+ *        周期性地以1.25倍速率探测更高的带宽并以0.75倍速率排空队列, 最小rtt长时间未更新时进入PROBE_RTT重新测量
+ * @version 0.1
+ * @date 2024-12-09
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "tcp_bbr.h"
+
+#include "dbg.h"
+#include "tools.h"
+
+#define BBR_UNIT 256  // 增益的单位1
+#define BBR_HIGH_GAIN (BBR_UNIT * 2885 / 1000 + 1)  // 2/ln2, STARTUP阶段每轮发送速率翻倍所需的增益
+#define BBR_DRAIN_GAIN (BBR_UNIT * 1000 / 2885)  // 1/BBR_HIGH_GAIN, 一轮内排空STARTUP阶段形成的队列
+#define BBR_CWND_GAIN (BBR_UNIT * 2)  // PROBE_BW阶段的拥塞窗口增益, 容纳延迟确认等造成的ack聚合
+#define BBR_FULL_BW_THRESH (BBR_UNIT * 5 / 4)  // 带宽增长不足25%视为未增长
+#define BBR_FULL_BW_CNT 3  // 带宽连续3轮未增长即认为已填满瓶颈带宽
+#define BBR_CYCLE_LEN 8    // PROBE_BW阶段增益循环的长度
+
+// PROBE_BW阶段的发送速率增益循环: 探测更高的带宽, 排空探测形成的队列, 之后以瓶颈带宽发送
+static const int bbr_pacing_gain[BBR_CYCLE_LEN] = {
+    BBR_UNIT * 5 / 4, BBR_UNIT * 3 / 4, BBR_UNIT, BBR_UNIT,
+    BBR_UNIT,         BBR_UNIT,         BBR_UNIT, BBR_UNIT,
+};
+
+/**
+ * @brief 获取在途(已发送未确认)的数据量
+ *
+ * @param tcp
+ * @return uint32_t
+ */
+static uint32_t bbr_inflight(tcp_t *tcp) {
+  return tcp->send.nxt - tcp->send.una;
+}
+
+/**
+ * @brief 获取估计的瓶颈带宽: 最近TCP_BBR_BW_RTTS轮中交付速率的最大值
+ *
+ * @param tcp
+ * @return uint32_t 字节/s
+ */
+static uint32_t bbr_max_bw(tcp_t *tcp) {
+  uint32_t bw = 0;
+  for (int i = 0; i < TCP_BBR_BW_RTTS; i++) {
+    bw = MAX(bw, tcp->bbr.bw[i]);
+  }
+  return bw;
+}
+
+/**
+ * @brief 计算带宽时延积与增益的乘积, 还未测得带宽及最小rtt时使用初始拥塞窗口
+ *
+ * @param tcp
+ * @param gain
+ * @return uint32_t
+ */
+static uint32_t bbr_bdp(tcp_t *tcp, int gain) {
+  uint32_t bw = bbr_max_bw(tcp);
+  if (!bw || !tcp->bbr.min_rtt) {
+    return TCP_INIT_CWND * tcp->mss;
+  }
+
+  uint64_t bdp = (uint64_t)bw * tcp->bbr.min_rtt / 1000;
+  return (uint32_t)MIN(bdp * gain / BBR_UNIT, 0x7fffffffU);
+}
+
+/**
+ * @brief 进入PROBE_BW阶段的增益循环的下一个位置
+ *
+ * @param tcp
+ * @param now
+ */
+static void bbr_advance_cycle_phase(tcp_t *tcp, uint32_t now) {
+  tcp->bbr.cycle_idx = (tcp->bbr.cycle_idx + 1) % BBR_CYCLE_LEN;
+  tcp->bbr.cycle_stamp = now;
+  tcp->bbr.pacing_gain = bbr_pacing_gain[tcp->bbr.cycle_idx];
+}
+
+/**
+ * @brief 进入PROBE_BW阶段, 从除排空位置外的随机位置开始增益循环, 避免共享瓶颈的连接同时探测带宽
+ *
+ * @param tcp
+ * @param now
+ */
+static void bbr_enter_probe_bw(tcp_t *tcp, uint32_t now) {
+  tcp->bbr.mode = TCP_BBR_PROBE_BW;
+  tcp->bbr.cwnd_gain = BBR_CWND_GAIN;
+  tcp->bbr.cycle_idx = BBR_CYCLE_LEN - 1 - (int)(now % (BBR_CYCLE_LEN - 1));
+  bbr_advance_cycle_phase(tcp, now);
+}
+
+/**
+ * @brief 进入STARTUP阶段
+ *
+ * @param tcp
+ */
+static void bbr_enter_startup(tcp_t *tcp) {
+  tcp->bbr.mode = TCP_BBR_STARTUP;
+  tcp->bbr.pacing_gain = BBR_HIGH_GAIN;
+  tcp->bbr.cwnd_gain = BBR_HIGH_GAIN;
+}
+
+/**
+ * @brief 初始化连接的BBR状态并给出初始的发送速率
+ *
+ * @param tcp
+ */
+void tcp_bbr_init(tcp_t *tcp) {
+  plat_memset(&tcp->bbr, 0, sizeof(tcp->bbr));
+  tcp->bbr.min_rtt_stamp = tcp_time_now();
+  bbr_enter_startup(tcp);
+
+  tcp->pacing.rate = 0;
+  tcp_bbr_on_ack(tcp, 0, -1);
+}
+
+/**
+ * @brief 发送新数据时选择一个数据段采样交付速率: 记录此时已交付的数据量及时间,
+ *        该数据段被确认时, 期间交付的数据量除以经过的时间即为交付速率, 每次采样约经过一个rtt(一轮)
+ *
+ * @param tcp
+ * @param len 即将从send.nxt处发送的数据量
+ */
+void tcp_bbr_on_send(tcp_t *tcp, int len) {
+  if (tcp->cc != TCP_CC_BBR || tcp->bbr.rs_valid) {
+    return;
+  }
+
+  // 没有在途数据(空闲后重新开始发送)时, 从当前时间开始计算交付速率
+  if (tcp->send.una == tcp->send.nxt) {
+    tcp->bbr.delivered_time = tcp_time_now();
+  }
+
+  tcp->bbr.rs_valid = 1;
+  tcp->bbr.rs_seq = tcp->send.nxt + len;
+  tcp->bbr.rs_delivered = tcp->bbr.delivered;
+  tcp->bbr.rs_time = tcp->bbr.delivered_time;
+
+  // 发送该数据段后既没有待发送的数据, 拥塞窗口也未用完, 交付速率受限于应用程序而不是网络
+  tcp->bbr.rs_app_limited = tcp_wait_send_data(tcp) - len <= 0 &&
+                            bbr_inflight(tcp) + len < tcp->send.cwnd;
+}
+
+/**
+ * @brief 采样数据段被确认, 计算交付速率并更新瓶颈带宽滤波器
+ *        间隔小于最小rtt的采样受ack压缩影响偏高, 丢弃;
+ *        受限于应用程序的采样偏低, 只在不小于当前估计值时使用
+ *
+ * @param tcp
+ * @param now
+ */
+static void bbr_update_bw(tcp_t *tcp, uint32_t now) {
+  int idx = tcp->bbr.round % TCP_BBR_BW_RTTS;
+  tcp->bbr.bw[idx] = 0;  // 新的一轮, 滤波器窗口滑动, 丢弃最旧的一轮
+
+  int interval = (int)(now - tcp->bbr.rs_time);
+  if (interval <= 0 || interval < tcp->bbr.min_rtt) {
+    return;
+  }
+
+  uint32_t delivered = tcp->bbr.delivered - tcp->bbr.rs_delivered;
+  uint64_t bw = (uint64_t)delivered * 1000 / interval;
+  bw = MIN(bw, 0xffffffffU);
+  if (!tcp->bbr.rs_app_limited || bw >= bbr_max_bw(tcp)) {
+    tcp->bbr.bw[idx] = (uint32_t)bw;
+  }
+}
+
+/**
+ * @brief PROBE_BW阶段推进增益循环
+ *        每个增益至少持续一个最小rtt; 探测时(增益>1)需在途数据达到对应的带宽时延积,
+ *        排空时(增益<1)在途数据降到带宽时延积以下即可提前结束
+ *
+ * @param tcp
+ * @param now
+ */
+static void bbr_update_cycle_phase(tcp_t *tcp, uint32_t now) {
+  if (tcp->bbr.mode != TCP_BBR_PROBE_BW) {
+    return;
+  }
+
+  int full_length = (int)(now - tcp->bbr.cycle_stamp) > tcp->bbr.min_rtt;
+  uint32_t inflight = bbr_inflight(tcp);
+  int advance = full_length;
+  if (tcp->bbr.pacing_gain > BBR_UNIT) {
+    advance = full_length && inflight >= bbr_bdp(tcp, tcp->bbr.pacing_gain);
+  } else if (tcp->bbr.pacing_gain < BBR_UNIT) {
+    advance = full_length || inflight <= bbr_bdp(tcp, BBR_UNIT);
+  }
+
+  if (advance) {
+    bbr_advance_cycle_phase(tcp, now);
+  }
+}
+
+/**
+ * @brief STARTUP阶段每轮检查带宽是否仍在增长, 连续BBR_FULL_BW_CNT轮增长不足25%即认为已填满瓶颈带宽
+ *
+ * @param tcp
+ */
+static void bbr_check_full_bw_reached(tcp_t *tcp) {
+  if (tcp->bbr.full_bw_reached || tcp->bbr.rs_app_limited) {
+    return;
+  }
+
+  uint32_t bw = bbr_max_bw(tcp);
+  if ((uint64_t)bw * BBR_UNIT >=
+      (uint64_t)tcp->bbr.full_bw * BBR_FULL_BW_THRESH) {
+    tcp->bbr.full_bw = bw;
+    tcp->bbr.full_bw_cnt = 0;
+    return;
+  }
+
+  if (++tcp->bbr.full_bw_cnt >= BBR_FULL_BW_CNT) {
+    tcp->bbr.full_bw_reached = 1;
+    dbg_info(DBG_TCP, "tcp bbr full bw reached: %u bytes/s.", bw);
+  }
+}
+
+/**
+ * @brief 填满瓶颈带宽后进入DRAIN阶段, 在途数据降到带宽时延积以下后进入PROBE_BW阶段
+ *
+ * @param tcp
+ * @param now
+ */
+static void bbr_check_drain(tcp_t *tcp, uint32_t now) {
+  if (tcp->bbr.mode == TCP_BBR_STARTUP && tcp->bbr.full_bw_reached) {
+    tcp->bbr.mode = TCP_BBR_DRAIN;
+    tcp->bbr.pacing_gain = BBR_DRAIN_GAIN;
+    tcp->bbr.cwnd_gain = BBR_HIGH_GAIN;
+  }
+
+  if (tcp->bbr.mode == TCP_BBR_DRAIN &&
+      bbr_inflight(tcp) <= bbr_bdp(tcp, BBR_UNIT)) {
+    bbr_enter_probe_bw(tcp, now);
+  }
+}
+
+/**
+ * @brief 在进入PROBE_RTT阶段或超时重传缩小拥塞窗口前记录当前的拥塞窗口, 结束后据此恢复,
+ *        已处于其中一个阶段时拥塞窗口已被缩小, 保留之前记录的较大值
+ *
+ * @param tcp
+ */
+static void bbr_save_cwnd(tcp_t *tcp) {
+  if (tcp->bbr.mode != TCP_BBR_PROBE_RTT && !tcp->flags.recovery) {
+    tcp->bbr.prior_cwnd = tcp->send.cwnd;
+  } else {
+    tcp->bbr.prior_cwnd = MAX(tcp->bbr.prior_cwnd, tcp->send.cwnd);
+  }
+}
+
+/**
+ * @brief 更新最小rtt, 超过TCP_BBR_MIN_RTT_WIN未测得更小的值时进入PROBE_RTT阶段:
+ *        将拥塞窗口缩小到TCP_BBR_MIN_CWND个mss以排空队列,
+ *        保持TCP_BBR_PROBE_RTT_TIME及至少一轮后恢复拥塞窗口并返回之前的阶段
+ *
+ * @param tcp
+ * @param rtt 本次ack的rtt采样值(ms), 小于0表示没有采样
+ * @param round_start 本次ack是否完成了一轮
+ * @param now
+ */
+static void bbr_update_min_rtt(tcp_t *tcp, int rtt, int round_start,
+                               uint32_t now) {
+  int expired = (int)(now - tcp->bbr.min_rtt_stamp) > TCP_BBR_MIN_RTT_WIN;
+  if (rtt >= 0 && (!tcp->bbr.min_rtt || rtt < tcp->bbr.min_rtt || expired)) {
+    tcp->bbr.min_rtt = MAX(rtt, 1);
+    tcp->bbr.min_rtt_stamp = now;
+  }
+
+  if (expired && tcp->bbr.mode != TCP_BBR_PROBE_RTT) {
+    bbr_save_cwnd(tcp);
+    tcp->bbr.mode = TCP_BBR_PROBE_RTT;
+    tcp->bbr.pacing_gain = BBR_UNIT;
+    tcp->bbr.cwnd_gain = BBR_UNIT;
+    tcp->bbr.probe_rtt_done = 0;
+  }
+
+  if (tcp->bbr.mode != TCP_BBR_PROBE_RTT) {
+    return;
+  }
+
+  if (!tcp->bbr.probe_rtt_done) {
+    if (bbr_inflight(tcp) <= TCP_BBR_MIN_CWND * (uint32_t)tcp->mss) {
+      tcp->bbr.probe_rtt_done = MAX(now + TCP_BBR_PROBE_RTT_TIME, 1U);
+      tcp->bbr.probe_rtt_round_done = 0;
+    }
+    return;
+  }
+
+  if (round_start) {
+    tcp->bbr.probe_rtt_round_done = 1;
+  }
+  if (tcp->bbr.probe_rtt_round_done &&
+      (int)(now - tcp->bbr.probe_rtt_done) >= 0) {
+    tcp->bbr.min_rtt_stamp = now;
+    tcp->send.cwnd = MAX(tcp->send.cwnd, tcp->bbr.prior_cwnd);
+    if (tcp->bbr.full_bw_reached) {
+      bbr_enter_probe_bw(tcp, now);
+    } else {
+      bbr_enter_startup(tcp);
+    }
+  }
+}
+
+/**
+ * @brief 按瓶颈带宽与发送速率增益设置发送速率
+ *        还未测得带宽时按拥塞窗口及平滑rtt估计(还未采样rtt时按1ms计),
+ *        之后在填满瓶颈带宽之前只提高发送速率, 避免偏低的早期采样拖慢STARTUP阶段
+ *
+ * @param tcp
+ */
+static void bbr_set_pacing_rate(tcp_t *tcp) {
+  uint32_t bw = bbr_max_bw(tcp);
+  if (!bw) {
+    int rtt = tcp->rtt.srtt ? tcp->rtt.srtt : 1;
+    uint64_t rate = (uint64_t)tcp->send.cwnd * 1000 / rtt;
+    tcp->pacing.rate =
+        (uint32_t)MIN(rate * BBR_HIGH_GAIN / BBR_UNIT, 0xffffffffU);
+    return;
+  }
+
+  uint64_t rate = (uint64_t)bw * tcp->bbr.pacing_gain / BBR_UNIT;
+  rate = MIN(rate, 0xffffffffU);
+  if (tcp->bbr.full_bw_reached || rate > tcp->pacing.rate) {
+    tcp->pacing.rate = (uint32_t)rate;
+  }
+}
+
+/**
+ * @brief 设置拥塞窗口: 目标为带宽时延积与拥塞窗口增益的乘积, 并为按额度成批发送留出余量
+ *        填满瓶颈带宽后按确认的数据量增长且不超过目标值, 之前只要低于目标值即按确认的数据量增长
+ *
+ * @param tcp
+ * @param acked 本次ack确认的数据量
+ */
+static void bbr_set_cwnd(tcp_t *tcp, int acked) {
+  uint32_t min_cwnd = TCP_BBR_MIN_CWND * (uint32_t)tcp->mss;
+  uint32_t target = bbr_bdp(tcp, tcp->bbr.cwnd_gain) + 3U * tcp->mss;
+  uint32_t cwnd = tcp->send.cwnd;
+
+  // 恢复阶段中部分确认可能一次确认大量对端已乱序缓存的数据,
+  // 每个ack最多增长一个mss, 避免新数据突发地涌入瓶颈队列造成新的丢包
+  if (tcp->flags.recovery) {
+    acked = MIN(acked, tcp->mss);
+  }
+
+  if (tcp->bbr.full_bw_reached) {
+    cwnd = MIN(cwnd + acked, target);
+  } else if (cwnd < target ||
+             tcp->bbr.delivered < TCP_INIT_CWND * (uint32_t)tcp->mss) {
+    cwnd += acked;
+  }
+
+  cwnd = MAX(cwnd, min_cwnd);
+  if (tcp->bbr.mode == TCP_BBR_PROBE_RTT) {
+    cwnd = MIN(cwnd, min_cwnd);
+  }
+  tcp->send.cwnd = cwnd;
+}
+
+/**
+ * @brief 处理确认了新数据的ack: 完成交付速率采样、推进阶段, 并更新发送速率及拥塞窗口
+ *        调用前send.una已越过本次确认的数据
+ *
+ * @param tcp
+ * @param acked 本次ack确认的数据量
+ * @param rtt 本次ack的rtt采样值(ms), 小于0表示没有采样
+ */
+void tcp_bbr_on_ack(tcp_t *tcp, int acked, int rtt) {
+  uint32_t now = tcp_time_now();
+  int round_start = 0;
+
+  tcp->bbr.delivered += acked;
+  tcp->bbr.delivered_time = now;
+
+  // 超时重传后的恢复阶段已结束, 恢复超时前的拥塞窗口
+  if (tcp->bbr.loss_recovery && !tcp->flags.recovery) {
+    tcp->bbr.loss_recovery = 0;
+    tcp->send.cwnd = MAX(tcp->send.cwnd, tcp->bbr.prior_cwnd);
+  }
+
+  // 采样数据段被确认, 完成一轮
+  if (tcp->bbr.rs_valid && tcp_seq_after_eq(tcp->send.una, tcp->bbr.rs_seq)) {
+    tcp->bbr.rs_valid = 0;
+    tcp->bbr.round++;
+    round_start = 1;
+    bbr_update_bw(tcp, now);
+  }
+
+  bbr_update_cycle_phase(tcp, now);
+  if (round_start) {
+    bbr_check_full_bw_reached(tcp);
+  }
+  bbr_check_drain(tcp, now);
+  bbr_update_min_rtt(tcp, rtt, round_start, now);
+
+  bbr_set_pacing_rate(tcp);
+  bbr_set_cwnd(tcp, acked);
+}
+
+/**
+ * @brief 重传超时: 带宽及最小rtt模型保持不变, 恢复阶段中拥塞窗口从一个mss开始按确认的数据量增长,
+ *        恢复阶段结束后恢复超时前的拥塞窗口; 采样数据段可能已丢失, 放弃本次采样
+ *        浅缓冲的瓶颈链路在带宽增长停止前就已丢包, STARTUP阶段发生超时即认为已填满瓶颈带宽
+ *
+ * @param tcp
+ */
+void tcp_bbr_on_rto(tcp_t *tcp) {
+  if (tcp->bbr.mode == TCP_BBR_STARTUP && bbr_max_bw(tcp) &&
+      !tcp->bbr.full_bw_reached) {
+    tcp->bbr.full_bw_reached = 1;
+    dbg_info(DBG_TCP, "tcp bbr startup loss, full bw: %u bytes/s.",
+             bbr_max_bw(tcp));
+  }
+
+  bbr_save_cwnd(tcp);
+  tcp->bbr.loss_recovery = 1;
+  tcp->send.cwnd = tcp->mss;
+  tcp->bbr.rs_valid = 0;
+}
@@ -12,20 +12,148 @@
 
 #include "tcp_buf.h"
 
+#include "mblock.h"
 #include "sys_plat.h"
 #include "tools.h"
+
+static uint8_t tcp_buf_page_tbl[TCP_BUF_PAGE_CNT][TCP_BUF_PAGE_SIZE];  // 缓冲区页面表
+static mblock_t tcp_buf_page_mblock;  // 缓冲区页面内存块管理对象
+static tcp_buf_page_notify_t tcp_buf_page_notify;  // 资源归还时的通知函数
+
+static tcp_buf_ext_t tcp_buf_ext_tbl[TCP_ZC_EXT_CNT];  // 零拷贝数据区描述结构表
+static mblock_t tcp_buf_ext_mblock;  // 零拷贝数据区描述结构内存块管理对象
+static nlist_t tcp_buf_ext_orphan_list;  // 所属连接已释放但仍被数据包引用的零拷贝数据区
+
+/**
+ * @brief 初始化tcp缓冲区模块(共享的缓冲区页面池)
+ *
+ * @param notify 页面或零拷贝数据区描述结构归还时的通知函数
+ * @return net_err_t
+ */
+net_err_t tcp_buf_module_init(tcp_buf_page_notify_t notify) {
+  tcp_buf_page_notify = notify;
+  nlist_init(&tcp_buf_ext_orphan_list);
+
+  // 只由工作线程访问，不需要加锁
+  net_err_t err =
+      mblock_init(&tcp_buf_page_mblock, tcp_buf_page_tbl, TCP_BUF_PAGE_SIZE,
+                  TCP_BUF_PAGE_CNT, NLOCKER_NONE);
+  if (err != NET_ERR_OK) {
+    return err;
+  }
+
+  return mblock_init(&tcp_buf_ext_mblock, tcp_buf_ext_tbl,
+                     sizeof(tcp_buf_ext_t), TCP_ZC_EXT_CNT, NLOCKER_NONE);
+}
+
 /**
- * @brief 初始化tcp_buf对象
+ * @brief 初始化tcp_buf对象, 数据区在第一次写入时才分配
  *
  * @param tcp_buf
- * @param data buf的首地址
- * @param size buf的大小
+ * @param size buf的大小, 不能超过缓冲区页面大小
  */
-void tcp_buf_init(tcp_buf_t *tcp_buf, uint8_t *data, int size) {
-  tcp_buf->data = data;
+void tcp_buf_init(tcp_buf_t *tcp_buf, int size) {
+  dbg_assert(size <= TCP_BUF_PAGE_SIZE, "tcp buf size > page size.");
+
+  tcp_buf->data = (uint8_t *)0;
   tcp_buf->count = 0;
   tcp_buf->size = size;
   tcp_buf->in = tcp_buf->out = 0;
+
+  nlist_init(&tcp_buf->ext_list);
+  nlist_init(&tcp_buf->ext_done_list);
+  tcp_buf->ext_count = 0;
+}
+
+/**
+ * @brief 确保tcp_buf持有数据区页面, 没有时从页面池中分配
+ *
+ * @param tcp_buf
+ * @return int 1: 持有页面, 0: 页面池已耗尽
+ */
+static int tcp_buf_page_get(tcp_buf_t *tcp_buf) {
+  if (!tcp_buf->data) {
+    tcp_buf->data = (uint8_t *)mblock_alloc(&tcp_buf_page_mblock, -1);
+  }
+
+  return tcp_buf->data != (uint8_t *)0;
+}
+
+/**
+ * @brief 缓冲区中的数据已全部取出时，将数据区页面归还页面池
+ *
+ * @param tcp_buf
+ */
+static void tcp_buf_page_put(tcp_buf_t *tcp_buf) {
+  if (tcp_buf->data && tcp_buf->count == 0) {
+    mblock_free(&tcp_buf_page_mblock, tcp_buf->data);
+    tcp_buf->data = (uint8_t *)0;
+    tcp_buf->in = tcp_buf->out = 0;
+
+    if (tcp_buf_page_notify) {
+      tcp_buf_page_notify();
+    }
+  }
+}
+
+/**
+ * @brief 释放零拷贝数据区描述结构
+ *
+ * @param ext
+ */
+static void tcp_buf_ext_free(tcp_buf_ext_t *ext) {
+  mblock_free(&tcp_buf_ext_mblock, ext);
+
+  if (tcp_buf_page_notify) {
+    tcp_buf_page_notify();
+  }
+}
+
+/**
+ * @brief 释放不再被数据包引用的孤立零拷贝数据区
+ *
+ */
+static void tcp_buf_ext_reap(void) {
+  nlist_node_t *node = (nlist_node_t *)0;
+  nlist_node_t *next = (nlist_node_t *)0;
+  nlist_for_each_safe(node, next, &tcp_buf_ext_orphan_list) {
+    tcp_buf_ext_t *ext = nlist_entry(node, tcp_buf_ext_t, node);
+    if (!pktbuf_ext_busy(&ext->ref)) {
+      nlist_remove(&tcp_buf_ext_orphan_list, node);
+      tcp_buf_ext_free(ext);
+    }
+  }
+}
+
+/**
+ * @brief 丢弃缓冲区中的所有数据并归还数据区页面,
+ *        零拷贝数据区可能仍被数据包引用，转移到孤立链表中延迟释放
+ *
+ * @param tcp_buf
+ */
+void tcp_buf_release(tcp_buf_t *tcp_buf) {
+  tcp_buf->count = 0;
+  tcp_buf_page_put(tcp_buf);
+
+  nlist_join(&tcp_buf_ext_orphan_list, &tcp_buf->ext_list);
+  nlist_join(&tcp_buf_ext_orphan_list, &tcp_buf->ext_done_list);
+  tcp_buf->ext_count = 0;
+  tcp_buf_ext_reap();
+}
+
+/**
+ * @brief 获取缓冲区的空闲容量,
+ *        未持有页面且页面池已耗尽时无法写入数据，空闲容量为0
+ *
+ * @param tcp_buf
+ * @return int
+ */
+int tcp_buf_free_cnt(tcp_buf_t *tcp_buf) {
+  if (!tcp_buf->data && mblock_free_cnt(&tcp_buf_page_mblock) == 0) {
+    return 0;
+  }
+
+  return tcp_buf->size - tcp_buf->count;
 }
 
 /**
@@ -48,7 +176,7 @@ static void _tcp_buf_write(tcp_buf_t *tcp_buf, const uint8_t *data_buf,
 }
 
 /**
- * @brief 向tcp_buf中写入数据
+ * @brief 向tcp_buf(tcp发送缓冲区)中写入数据
  *
  * @param tcp_buf
  * @param data_buf 待写入的数据首地址
@@ -56,9 +184,11 @@ static void _tcp_buf_write(tcp_buf_t *tcp_buf, const uint8_t *data_buf,
  * @return int 成功写入的数据长度
  */
 int tcp_buf_write(tcp_buf_t *tcp_buf, const uint8_t *data_buf, int len) {
+  // 还有未确认的零拷贝数据时不能写入环形数据区, 否则会先于零拷贝数据发送
   int free_cnt = tcp_buf_free_cnt(tcp_buf);
-  if (free_cnt <= 0) {
-    return free_cnt;
+  if (free_cnt <= 0 || tcp_buf->ext_count > 0 ||
+      !tcp_buf_page_get(tcp_buf)) {
+    return 0;
   }
 
   // 根据剩余空间大小，写入数据到缓冲区
@@ -71,37 +201,70 @@ int tcp_buf_write(tcp_buf_t *tcp_buf, const uint8_t *data_buf, int len) {
   return write_len;
 }
 
-static void _tcp_buf_read(tcp_buf_t *tcp_buf, uint8_t *data_buf, int len) {
-  // 计算剩可读数据并拷贝，情况1：可读数据未形成回绕，cpy_len = len,
-  // 只进行第一次拷贝 情况2：可读数据形成回绕，cpy_len = tcp_buf->size -
-  // tcp_buf->out, 还需要进行第二次拷贝(len - cpy_len)
-  int cpy_len = MIN(len, tcp_buf->size - tcp_buf->out);
-  plat_memcpy(data_buf, &tcp_buf->data[tcp_buf->out], cpy_len);
-  plat_memcpy(data_buf + cpy_len, tcp_buf->data, len - cpy_len);
+/**
+ * @brief 向tcp_buf(tcp发送缓冲区)中挂载零拷贝发送的应用程序数据区, 数据不进行拷贝,
+ *        直到数据被确认且不再被数据包引用前，应用程序不能修改该数据区
+ *
+ * @param tcp_buf
+ * @param data_buf 应用程序数据区的首地址
+ * @param len 数据区长度
+ * @param id 所属的零拷贝发送调用的通知序号
+ * @return int 成功挂载的数据长度
+ */
+int tcp_buf_write_ext(tcp_buf_t *tcp_buf, const uint8_t *data_buf, int len,
+                      uint32_t id) {
+  // 限制每个连接引用的未确认数据量
+  int free_cnt = TCP_ZC_MAX_SIZE - tcp_buf->ext_count;
+  if (free_cnt <= 0) {
+    return 0;
+  }
+
+  tcp_buf_ext_reap();
+  tcp_buf_ext_t *ext = (tcp_buf_ext_t *)mblock_alloc(&tcp_buf_ext_mblock, -1);
+  if (!ext) {
+    return 0;
+  }
+
+  ext->data = data_buf;
+  ext->len = MIN(len, free_cnt);
+  ext->id = id;
+  ext->notify = ext->len == len;  // 剩余数据全部挂载时为该次调用的最后一个数据区
+  pktbuf_ext_init(&ext->ref);
+  nlist_node_init(&ext->node);
+  nlist_insert_last(&tcp_buf->ext_list, &ext->node);
+  tcp_buf->ext_count += ext->len;
+
+  return ext->len;
 }
 
 /**
- * @brief 从tcp_buf中读取数据到data_buf中
+ * @brief 获取一个已完成的零拷贝发送调用: 数据已被确认且不再被任何数据包引用
+ *        数据区按发送顺序完成, 前面的数据区仍被引用时后面的数据区也不会完成
  *
  * @param tcp_buf
- * @param data_buf
- * @param len
- * @return int
+ * @param id 返回已完成的零拷贝发送调用的通知序号
+ * @return int 1: 有已完成的调用, 0: 没有
  */
-int tcp_buf_read(tcp_buf_t *tcp_buf, uint8_t *data_buf, int len) {
-  if (tcp_buf->count <= 0) {
-    return tcp_buf->count;
-  }
+int tcp_buf_ext_done(tcp_buf_t *tcp_buf, uint32_t *id) {
+  nlist_node_t *node;
+  while ((node = nlist_first(&tcp_buf->ext_done_list))) {
+    tcp_buf_ext_t *ext = nlist_entry(node, tcp_buf_ext_t, node);
+    if (pktbuf_ext_busy(&ext->ref)) {
+      return 0;
+    }
 
-  // 根据可读数据量，读取数据到buf中
-  int read_len = MIN(len, tcp_buf->count);
-  _tcp_buf_read(tcp_buf, data_buf, read_len);
+    nlist_remove(&tcp_buf->ext_done_list, node);
+    int notify = ext->notify;
+    *id = ext->id;
+    tcp_buf_ext_free(ext);
 
-  // 更新缓冲区的数据量和读写索引
-  tcp_buf->count -= read_len;
-  tcp_buf->out = (tcp_buf->out + read_len) % tcp_buf->size;
+    // 一次发送调用被分为多个数据区时，只在最后一个数据区完成时通知
+    if (notify) {
+      return 1;
+    }
+  }
 
-  return read_len;
+  return 0;
 }
 
 static net_err_t _tcp_buf_read_to_pktbuf(tcp_buf_t *tcp_buf, pktbuf_t *buf, int offset,
@@ -123,105 +286,104 @@ static net_err_t _tcp_buf_read_to_pktbuf(tcp_buf_t *tcp_buf, pktbuf_t *buf, int
 }
 
 /**
- * @brief 从tcp_buf(tcp发送缓冲区)中读取数据到pktbuf(tcp数据包)中
+ * @brief 从tcp_buf(tcp发送缓冲区)中读取数据追加到pktbuf(tcp数据包)的尾部
  *      从缓冲区out指针偏移offset字节处开始读取数据，且不移除读取的数据
+ *      环形数据区中的数据拷贝到数据包中, 零拷贝数据区中的数据由数据包直接引用
  *
  * @param tcp_buf
  * @param buf
  * @param offset 待读取数据相对于缓冲区out指针的偏移量
- * @param len 需要确保len <= tcp_buf->count， 内部不做检查
+ * @param len 需要确保offset + len <= tcp_buf_cnt(tcp_buf)， 内部不做检查
  * @return int 读取的数据长度
  */
 int tcp_buf_read_to_pktbuf(tcp_buf_t *tcp_buf, pktbuf_t *buf, int offset,
                            int len) {
-  net_err_t err = NET_ERR_OK;
   // 判断是否有数据可读
-  if (tcp_buf->count <= 0) {
-    return tcp_buf->count;
+  int total = tcp_buf_cnt(tcp_buf);
+  if (total <= 0) {
+    return total;
   }
+  int read_len = MIN(len, total);
 
-  // 根据可读数据量，读取数据到buf中
-  int read_len = MIN(len, tcp_buf->count);
-  err = _tcp_buf_read_to_pktbuf(tcp_buf, buf, offset, read_len);
-  if (err != NET_ERR_OK) {
-    dbg_error(DBG_TCP, "tcp buf read to pktbuf failed.");
-    return -1;
-  }
-
-  return read_len;
-}
-
-/**
- * @brief 从pktbuf中读取数据到tcp_buf中
- *
- * @param tcp_buf
- * @param buf
- * @param offset
- * @param len 需要确保len <= tcp_buf->size - tcp_buf->count， 内部不做检查
- * @return int
- */
-static net_err_t _tcp_buf_write_from_pktbuf(tcp_buf_t *tcp_buf, pktbuf_t *buf,
-                                            int offset, int len) {
-  net_err_t err = NET_ERR_OK;
-  // 计算待写入数据的起始索引
-  int start_idx = (tcp_buf->in + offset) % tcp_buf->size;
-  // 计算可写入的数据长度，情况1：预写入空闲区未形成回绕，cpy_len = len,
-  // 只进行第一次拷贝 情况2：可写数据形成回绕，cpy_len = tcp_buf->size -
-  // start_idx, 还需要进行第二次拷贝(len - cpy_len)
-  int cpy_len = MIN(len, tcp_buf->size - start_idx);
-  err = pktbuf_read(buf, &tcp_buf->data[start_idx], cpy_len);
-  err = pktbuf_read(buf, tcp_buf->data, len - cpy_len);
-  if (err != NET_ERR_OK) {
-    dbg_error(DBG_TCP, "pktbuf read error.");
+  // 拷贝环形数据区中的数据
+  int copy_len = MIN(read_len, MAX(tcp_buf->count - offset, 0));
+  if (copy_len > 0) {
+    int pos = pktbuf_total_size(buf);
+    if (pktbuf_resize(buf, pos + copy_len) != NET_ERR_OK) {
+      dbg_error(DBG_TCP, "pktbuf resize failed.");
+      return -1;
+    }
+    pktbuf_seek(buf, pos);
+    if (_tcp_buf_read_to_pktbuf(tcp_buf, buf, offset, copy_len) !=
+        NET_ERR_OK) {
+      dbg_error(DBG_TCP, "tcp buf read to pktbuf failed.");
+      return -1;
+    }
   }
 
-  return err;
-}
-
-/**
- * @brief 将pktbuf中的数据写入到tcp_buf中
- *
- * @param tcp_buf
- * @param buf
- * @param offset 相对于缓冲区in指针的偏移量
- * @param len
- * @return int
- */
-int tcp_buf_write_from_pktbuf(tcp_buf_t *tcp_buf, pktbuf_t *buf, int offset,
-                              int len) {
-  net_err_t err = NET_ERR_OK;
+  // 引用零拷贝数据区中的数据
+  int ext_len = read_len - copy_len;
+  int ext_offset = MAX(offset - tcp_buf->count, 0);
+  nlist_node_t *node = (nlist_node_t *)0;
+  nlist_for_each(node, &tcp_buf->ext_list) {
+    if (ext_len <= 0) {
+      break;
+    }
 
-  // 判断是否有空间可写
-  int free_cnt = tcp_buf_free_cnt(tcp_buf) - offset;
-  if (free_cnt <= 0) {
-    return free_cnt;
-  }
+    tcp_buf_ext_t *ext = nlist_entry(node, tcp_buf_ext_t, node);
+    if (ext_offset >= ext->len) {
+      ext_offset -= ext->len;
+      continue;
+    }
 
-  // 根据剩余空间大小，写入数据到缓冲区
-  int write_len = MIN(len, free_cnt);
-  err = _tcp_buf_write_from_pktbuf(tcp_buf, buf, offset, write_len);
-  if (err != NET_ERR_OK) {
-    dbg_error(DBG_TCP, "pktbuf read error.");
-    return -1;
+    int size = MIN(ext->len - ext_offset, ext_len);
+    if (pktbuf_ext_add(buf, ext->data + ext_offset, size, &ext->ref) !=
+        NET_ERR_OK) {
+      dbg_error(DBG_TCP, "tcp buf ref ext data failed.");
+      return -1;
+    }
+    ext_offset = 0;
+    ext_len -= size;
   }
 
-  // 更新缓冲区的数据量和读写索引
-  tcp_buf->count += write_len;
-  tcp_buf->in = (tcp_buf->in + write_len) % tcp_buf->size;
-  return write_len;
+  return read_len;
 }
 
 /**
  * @brief 从tcp_buf队列中移除cnt个数据
+ *        先移除环形数据区中的数据，再移除零拷贝数据区中的数据,
+ *        数据已全部移除的零拷贝数据区转移到完成链表，等待不再被数据包引用
  *
  * @param tcp_buf
  * @param cnt
  * @return int 成功移除的数据长度
  */
 int tcp_buf_remove(tcp_buf_t *tcp_buf, int cnt) {
-  cnt = MIN(cnt, tcp_buf->count);
-  tcp_buf->out = (tcp_buf->out + cnt) % tcp_buf->size;
-  tcp_buf->count -= cnt;
+  int remove_cnt = MIN(cnt, tcp_buf->count);
+  if (remove_cnt > 0) {
+    tcp_buf->out = (tcp_buf->out + remove_cnt) % tcp_buf->size;
+    tcp_buf->count -= remove_cnt;
+    tcp_buf_page_put(tcp_buf);
+    cnt -= remove_cnt;
+  } else {
+    remove_cnt = 0;
+  }
+
+  nlist_node_t *node;
+  while (cnt > 0 && (node = nlist_first(&tcp_buf->ext_list))) {
+    tcp_buf_ext_t *ext = nlist_entry(node, tcp_buf_ext_t, node);
+    int size = MIN(cnt, ext->len);
+    ext->data += size;
+    ext->len -= size;
+    tcp_buf->ext_count -= size;
+    remove_cnt += size;
+    cnt -= size;
+
+    if (ext->len == 0) {
+      nlist_remove(&tcp_buf->ext_list, node);
+      nlist_insert_last(&tcp_buf->ext_done_list, node);
+    }
+  }
 
-  return cnt;
+  return remove_cnt;
 }
\ No newline at end of file
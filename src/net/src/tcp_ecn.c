@@ -0,0 +1,157 @@
+/**
+ * @file tcp_ecn.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp显式拥塞通知(ECN)模块(RFC 3168)
+ *        建立连接时通过SYN中的ECE及CWR标志位协商, 协商成功后新数据段的ip头部设置ECT码点,
+ *        途经的路由器发生拥塞时将其标记为CE而不是丢弃, 接收方在之后的ack中设置ECE回显拥塞通知,
+ *        发送方按一次丢包降低拥塞窗口并在下一个新数据段中设置CWR, 接收方收到CWR后停止回显,
+ *        从而在不丢包的情况下得知网络拥塞
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "tcp_ecn.h"
+
+#include "dbg.h"
+#include "ipv4.h"
+#include "tools.h"
+
+static tcp_ecn_stats_t ecn_stats;  // 显式拥塞通知统计信息
+
+/**
+ * @brief 初始化连接的显式拥塞通知状态, 在建立连接前调用
+ *
+ * @param tcp
+ */
+void tcp_ecn_init(tcp_t *tcp) {
+  tcp->flags.ecn_ok = 0;
+  tcp->flags.ecn_ece = 0;
+  tcp->flags.ecn_cwr = 0;
+  tcp->flags.ecn_reduced = 0;
+}
+
+/**
+ * @brief 根据对端的SYN报文段协商是否使用ECN
+ *        连接请求(SYN)需同时设置ECE及CWR, 连接应答(SYN+ACK)只设置ECE,
+ *        以区分不理解这两个标志位而将其原样反射回来的对端
+ *
+ * @param tcp
+ * @param tcp_hdr 对端的SYN或SYN+ACK报文段
+ */
+void tcp_ecn_syn_in(tcp_t *tcp, tcp_hdr_t *tcp_hdr) {
+  if (tcp_hdr->f_ack) {
+    tcp->flags.ecn_ok =
+        tcp->flags.ecn_enable && tcp_hdr->f_ece && !tcp_hdr->f_cwr;
+  } else {
+    tcp->flags.ecn_ok =
+        tcp->flags.ecn_enable && tcp_hdr->f_ece && tcp_hdr->f_cwr;
+  }
+}
+
+/**
+ * @brief 设置待发送报文段头部的ECN标志位, 调用前需已设置好SYN及ACK标志位
+ *        SYN: 允许ECN时同时设置ECE及CWR以发起协商
+ *        SYN+ACK: 已协商使用ECN时设置ECE以表示同意
+ *        其余报文段: 需要回显拥塞通知时设置ECE
+ *
+ * @param tcp
+ * @param tcp_hdr
+ */
+void tcp_ecn_hdr_out(tcp_t *tcp, tcp_hdr_t *tcp_hdr) {
+  if (tcp_hdr->f_syn) {
+    if (!tcp_hdr->f_ack) {
+      tcp_hdr->f_ece = tcp_hdr->f_cwr = tcp->flags.ecn_enable;
+    } else {
+      tcp_hdr->f_ece = tcp->flags.ecn_ok;
+    }
+    return;
+  }
+
+  tcp_hdr->f_ece = tcp->flags.ecn_ok && tcp->flags.ecn_ece;
+}
+
+/**
+ * @brief 发送携带新数据的报文段: 设置ip头部的ECT码点, 并在降低拥塞窗口后的第一个新数据段中设置CWR
+ *        纯ack、窗口探测及重传的数据段不设置ECT, 这些报文段被丢弃时无法通过降低拥塞窗口响应(RFC 3168)
+ *
+ * @param tcp
+ * @param tcp_hdr
+ * @param buf
+ */
+void tcp_ecn_data_out(tcp_t *tcp, tcp_hdr_t *tcp_hdr, pktbuf_t *buf) {
+  if (!tcp->flags.ecn_ok) {
+    return;
+  }
+
+  buf->ecn = IPV4_ECN_ECT0;
+  if (tcp->flags.ecn_cwr) {
+    tcp_hdr->f_cwr = 1;
+    tcp->flags.ecn_cwr = 0;
+  }
+}
+
+/**
+ * @brief 接收到对端的报文段: CWR表示对端已降低拥塞窗口, 停止回显拥塞通知,
+ *        之后被标记了CE的数据段需要在每个ack中设置ECE回显, 直到对端再次发送CWR
+ *
+ * @param tcp
+ * @param info
+ * @return int 1: 开始回显新的拥塞通知, 需立即发送ack, 0: 其他
+ */
+int tcp_ecn_data_in(tcp_t *tcp, tcp_info_t *info) {
+  if (!tcp->flags.ecn_ok) {
+    return 0;
+  }
+
+  if (info->tcp_hdr->f_cwr) {
+    ecn_stats.cwr_recv++;
+    tcp->flags.ecn_ece = 0;
+  }
+
+  if (info->ecn_ce && info->seq_len) {
+    ecn_stats.ce_recv++;
+    if (!tcp->flags.ecn_ece) {
+      tcp->flags.ecn_ece = 1;
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 接收到对端的ack: 设置了ECE时按一次丢包降低拥塞窗口(不重传数据), 并在下一个新数据段中通知对端,
+ *        降低时已发送的数据被确认之前, 对端回显的仍是同一次拥塞, 不再重复降低
+ *
+ * @param tcp
+ * @param info
+ */
+void tcp_ecn_ack_in(tcp_t *tcp, tcp_info_t *info) {
+  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
+  if (!tcp->flags.ecn_ok || !tcp_hdr->f_ece || tcp_hdr->f_syn ||
+      (tcp->flags.ecn_reduced &&
+       tcp_seq_before_eq(tcp_hdr->ack, tcp->send.cwr_high))) {
+    return;
+  }
+
+  // 与快速重传相同, 慢启动阈值减为在途数据量的一半, 拥塞窗口从慢启动阈值开始拥塞避免(RFC 5681)
+  uint32_t flight = tcp->send.nxt - tcp->send.una;
+  tcp->send.ssthresh = MAX(flight / 2, 2U * tcp->mss);
+  tcp->send.cwnd = MIN(tcp->send.cwnd, tcp->send.ssthresh);
+
+  tcp->flags.ecn_cwr = 1;
+  tcp->flags.ecn_reduced = 1;
+  tcp->send.cwr_high = tcp->send.nxt;
+  ecn_stats.ece_recv++;
+  dbg_info(DBG_TCP, "tcp ecn congestion, cwnd reduce to %u.", tcp->send.cwnd);
+}
+
+/**
+ * @brief 获取显式拥塞通知的统计信息
+ *
+ * @param stats
+ */
+void tcp_ecn_stats_get(tcp_ecn_stats_t *stats) { *stats = ecn_stats; }
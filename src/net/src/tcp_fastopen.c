@@ -0,0 +1,263 @@
+/**
+ * @file tcp_fastopen.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp快速打开(TFO)模块(RFC 7413)
+ *        普通连接需等待三次握手完成(一个rtt)后才能发送数据, 对于短连接的请求/响应, 这个rtt是时延的主要部分;
+ *        服务端根据客户端的ip地址生成cookie并在SYN+ACK中通告, 客户端按目的ip地址缓存cookie,
+ *        之后的连接在SYN中携带cookie及请求数据, 服务端校验cookie通过后立即将数据交给应用程序,
+ *        响应在握手完成前即可发出; cookie校验失败或对端不支持时退化为普通的三次握手,
+ *        SYN携带的数据在握手完成后重新发送
+ * @version 0.1
+ * @date 2024-12-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "tcp_fastopen.h"
+
+#include "dbg.h"
+#include "tcp_rack.h"
+#include "tcp_send.h"
+#include "tools.h"
+
+// 定义客户端的cookie缓存表项
+typedef struct _tcp_fastopen_cache_t {
+  ipaddr_t ip;                                 // 服务端ip地址
+  uint8_t cookie[TCP_FASTOPEN_COOKIE_SIZE];    // 服务端通告的cookie
+  uint16_t mss;                                // 服务端通告的mss, 限制SYN携带的数据量
+  uint32_t time;                               // 最近一次使用的时间(ms), 用于淘汰表项
+  int valid;                                   // 表项是否有效
+} tcp_fastopen_cache_t;
+
+static tcp_fastopen_cache_t fastopen_cache[TCP_FASTOPEN_CACHE_SIZE];
+static uint32_t fastopen_secret;          // 服务端生成cookie的密钥
+static tcp_fastopen_stats_t fastopen_stats;  // 快速打开统计信息
+
+/**
+ * @brief 初始化tcp快速打开模块
+ *
+ * @param seed 用于生成cookie密钥的随机值
+ */
+void tcp_fastopen_init(uint32_t seed) {
+  fastopen_secret = tools_hash32(&seed, sizeof(seed), 0x7f4a7c15U);
+  plat_memset(fastopen_cache, 0, sizeof(fastopen_cache));
+  plat_memset(&fastopen_stats, 0, sizeof(fastopen_stats));
+}
+
+/**
+ * @brief 服务端根据客户端的ip地址生成cookie, 只有知道密钥才能为某个ip地址构造有效的cookie,
+ *        伪造源地址的SYN无法携带数据占用服务端的资源
+ *
+ * @param ip 客户端ip地址
+ * @param cookie
+ */
+static void fastopen_cookie_make(const ipaddr_t *ip, uint8_t *cookie) {
+  uint32_t val[2];
+  val[0] = tools_hash32(&ip->addr, sizeof(ip->addr), fastopen_secret);
+  val[1] = tools_hash32(&ip->addr, sizeof(ip->addr), val[0] ^ fastopen_secret);
+  plat_memcpy(cookie, val, TCP_FASTOPEN_COOKIE_SIZE);
+}
+
+/**
+ * @brief 查找目的ip地址对应的cookie缓存表项
+ *
+ * @param ip
+ * @return tcp_fastopen_cache_t* 未找到时返回0
+ */
+static tcp_fastopen_cache_t *fastopen_cache_find(const ipaddr_t *ip) {
+  for (int i = 0; i < TCP_FASTOPEN_CACHE_SIZE; i++) {
+    tcp_fastopen_cache_t *entry = &fastopen_cache[i];
+    if (entry->valid && ipaddr_is_equal(&entry->ip, ip)) {
+      return entry;
+    }
+  }
+  return (tcp_fastopen_cache_t *)0;
+}
+
+/**
+ * @brief 缓存服务端通告的cookie, 表已满时淘汰最久未使用的表项
+ *
+ * @param ip
+ * @param cookie
+ * @param mss
+ */
+static void fastopen_cache_update(const ipaddr_t *ip, const uint8_t *cookie,
+                                  uint16_t mss) {
+  tcp_fastopen_cache_t *entry = fastopen_cache_find(ip);
+  if (!entry) {
+    entry = &fastopen_cache[0];
+    for (int i = 0; i < TCP_FASTOPEN_CACHE_SIZE && entry->valid; i++) {
+      tcp_fastopen_cache_t *curr = &fastopen_cache[i];
+      if (!curr->valid || (int)(curr->time - entry->time) < 0) {
+        entry = curr;
+      }
+    }
+    ipaddr_copy(&entry->ip, ip);
+    entry->valid = 1;
+  }
+
+  plat_memcpy(entry->cookie, cookie, TCP_FASTOPEN_COOKIE_SIZE);
+  entry->mss = mss;
+  entry->time = tcp_time_now();
+}
+
+/**
+ * @brief 客户端以快速打开方式发起连接, 在发送SYN之前调用:
+ *        缓存了对端的cookie时SYN携带cookie及数据, 否则SYN携带空的快速打开选项以请求cookie
+ *
+ * @param tcp
+ */
+void tcp_fastopen_connect(tcp_t *tcp) {
+  tcp->flags.tfo = 1;
+  tcp->tfo.cookie_len = 0;
+  tcp->tfo.syn_data = 0;
+
+  tcp_fastopen_cache_t *entry = fastopen_cache_find(&tcp->sock_base.remote_ip);
+  if (!entry) {
+    fastopen_stats.cookie_req++;
+    return;
+  }
+
+  plat_memcpy(tcp->tfo.cookie, entry->cookie, TCP_FASTOPEN_COOKIE_SIZE);
+  tcp->tfo.cookie_len = TCP_FASTOPEN_COOKIE_SIZE;
+  tcp->tfo.mss = entry->mss;
+  entry->time = tcp_time_now();
+}
+
+/**
+ * @brief 获取客户端的SYN可携带的数据量
+ *        对端的mss在收到SYN+ACK之前未知, 使用缓存cookie时记录的mss, 并扣除SYN中的选项长度
+ *
+ * @param tcp
+ * @param wait_data_len 发送缓冲区中待发送的数据量
+ * @return int
+ */
+int tcp_fastopen_syn_data(tcp_t *tcp, int wait_data_len) {
+  if (!TCP_FASTOPEN_ENABLE || !tcp->flags.tfo || !tcp->tfo.cookie_len ||
+      tcp->flags.recv_win_valid) {
+    return 0;
+  }
+
+  int opt_len = sizeof(tcp_opt_mss_t) + 4 + TCP_FASTOPEN_COOKIE_SIZE +
+                (tcp->flags.ts_enable ? 2 + sizeof(tcp_opt_ts_t) : 0);
+  int max = (int)MIN(tcp->mss, tcp->tfo.mss) - opt_len;
+  tcp->tfo.syn_data = MIN(wait_data_len, MAX(max, 0));
+  return tcp->tfo.syn_data;
+}
+
+/**
+ * @brief 在SYN或SYN+ACK的选项区中填充快速打开选项, 使用两个NOP选项填充使选项区4字节对齐
+ *        SYN: 以快速打开方式发起的连接携带缓存的cookie, 没有缓存时携带空的选项请求cookie
+ *        SYN+ACK: 需要向对端通告cookie时携带
+ *
+ * @param tcp
+ * @param tcp_hdr 已设置好SYN及ACK标志位的tcp头部
+ * @param opt 选项的填充位置, 至少有TCP_FASTOPEN_COOKIE_SIZE + 4字节空间
+ * @return int 填充的长度, 不需要携带时返回0
+ */
+int tcp_fastopen_write_option(tcp_t *tcp, tcp_hdr_t *tcp_hdr, uint8_t *opt) {
+  if (!TCP_FASTOPEN_ENABLE || !tcp_hdr->f_syn) {
+    return 0;
+  }
+  if (tcp_hdr->f_ack ? !tcp->tfo.cookie_len : !tcp->flags.tfo) {
+    return 0;
+  }
+
+  opt[0] = opt[1] = TCP_OPT_NOP;
+  opt[2] = TCP_OPT_FASTOPEN;
+  opt[3] = 2 + tcp->tfo.cookie_len;
+  plat_memcpy(opt + 4, tcp->tfo.cookie, tcp->tfo.cookie_len);
+  return 4 + tcp->tfo.cookie_len;
+}
+
+/**
+ * @brief 服务端处理携带快速打开选项的SYN, 在为其分配子连接后调用
+ *        cookie有效时子连接以快速打开方式建立, SYN携带的数据可立即交给应用程序;
+ *        请求cookie或cookie无效时在SYN+ACK中通告新的cookie, SYN携带的数据不被确认,
+ *        由对端在握手完成后重新发送
+ *
+ * @param child 子连接
+ * @param parent 监听tcp对象
+ * @param info SYN数据包的信息
+ * @return int 1: 接受SYN携带的数据, 0: 按普通的三次握手处理
+ */
+int tcp_fastopen_syn_in(tcp_t *child, tcp_t *parent, tcp_info_t *info) {
+  if (!TCP_FASTOPEN_ENABLE || !parent->flags.tfo_enable || info->tfo_len < 0) {
+    return 0;
+  }
+
+  uint8_t cookie[TCP_FASTOPEN_COOKIE_SIZE];
+  fastopen_cookie_make(&info->remote_ip, cookie);
+  if (info->tfo_len == TCP_FASTOPEN_COOKIE_SIZE &&
+      plat_memcmp(info->tfo_cookie, cookie, TCP_FASTOPEN_COOKIE_SIZE) == 0) {
+    child->flags.tfo = 1;
+    if (info->data_len) {
+      fastopen_stats.syn_data_recv++;
+    }
+    return 1;
+  }
+
+  if (info->tfo_len > 0) {
+    fastopen_stats.cookie_invalid++;
+    dbg_warning(DBG_TCP, "tcp fastopen cookie invalid.");
+  }
+  plat_memcpy(child->tfo.cookie, cookie, TCP_FASTOPEN_COOKIE_SIZE);
+  child->tfo.cookie_len = TCP_FASTOPEN_COOKIE_SIZE;
+  fastopen_stats.cookie_sent++;
+  return 0;
+}
+
+/**
+ * @brief 客户端接收到SYN+ACK, 在处理其ack之后调用: 缓存对端通告的cookie,
+ *        SYN携带的数据未被确认时(对端不支持或cookie无效), 将其重新作为待发送的数据,
+ *        握手完成后立即发送, 而不必等待重传超时
+ *
+ * @param tcp
+ * @param info SYN+ACK数据包的信息
+ */
+void tcp_fastopen_synack_in(tcp_t *tcp, tcp_info_t *info) {
+  if (!tcp->flags.tfo) {
+    return;
+  }
+
+  if (info->tfo_len == TCP_FASTOPEN_COOKIE_SIZE) {
+    fastopen_cache_update(&tcp->sock_base.remote_ip, info->tfo_cookie,
+                          info->mss ? info->mss : TCP_MSS_DEFAULT);
+  }
+
+  if (!tcp->tfo.syn_data) {
+    return;
+  }
+
+  fastopen_stats.syn_data_sent++;
+  if (tcp->send.una == tcp->send.nxt) {
+    fastopen_stats.syn_data_acked++;
+    return;
+  }
+
+  // 对端没有接受数据, 也没有通告新的cookie, 缓存的cookie已不可用
+  if (info->tfo_len != TCP_FASTOPEN_COOKIE_SIZE) {
+    tcp_fastopen_cache_t *entry =
+        fastopen_cache_find(&tcp->sock_base.remote_ip);
+    if (entry) {
+      entry->valid = 0;
+    }
+  }
+
+  // 未被确认的数据还在发送缓冲区中, 回退nxt使其重新作为待发送的数据
+  dbg_info(DBG_TCP, "tcp fastopen syn data not acked, resend.");
+  tcp->send.nxt = tcp->send.una;
+  tcp->tfo.syn_data = 0;
+  tcp_rto_stop(tcp);
+  tcp_rack_init(tcp);
+}
+
+/**
+ * @brief 获取tcp快速打开的统计信息
+ *
+ * @param stats
+ */
+void tcp_fastopen_stats_get(tcp_fastopen_stats_t *stats) {
+  *stats = fastopen_stats;
+}
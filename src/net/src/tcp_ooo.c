@@ -0,0 +1,273 @@
+/**
+ * @file tcp_ooo.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp乱序报文段重组队列模块
+ *        缓存序号在接收窗口nxt之后到达的报文段数据，并按序号范围进行合并，
+ *        当空缺被填补后，再将连续的数据转移到接收队列中
+ * @version 0.1
+ * @date 2024-11-20
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "tcp_ooo.h"
+
+#include "mblock.h"
+#include "tcp.h"
+#include "tools.h"
+
+static tcp_seg_t tcp_seg_tbl[TCP_OOO_SEG_MAXCNT];  // 乱序数据段描述结构表
+static mblock_t tcp_seg_mblock;  // 乱序数据段描述结构内存块管理对象
+
+/**
+ * @brief 初始化乱序队列模块
+ *
+ * @return net_err_t
+ */
+net_err_t tcp_ooo_module_init(void) {
+  // 只由工作线程访问，不需要加锁
+  return mblock_init(&tcp_seg_mblock, tcp_seg_tbl, sizeof(tcp_seg_t),
+                     TCP_OOO_SEG_MAXCNT, NLOCKER_NONE);
+}
+
+/**
+ * @brief 初始化一个乱序队列
+ *
+ * @param ooo
+ */
+void tcp_ooo_init(tcp_ooo_t *ooo) {
+  nlist_init(&ooo->seg_list);
+  ooo->size = 0;
+  ooo->last = (tcp_seg_t *)0;
+}
+
+/**
+ * @brief 将数据段从乱序队列中移除，并释放其数据包及描述结构
+ *
+ * @param ooo
+ * @param seg
+ */
+static void tcp_seg_free(tcp_ooo_t *ooo, tcp_seg_t *seg) {
+  nlist_remove(&ooo->seg_list, &seg->node);
+  ooo->size -= seg->len;
+  if (ooo->last == seg) {
+    ooo->last = (tcp_seg_t *)0;
+  }
+
+  pktbuf_free(seg->buf);  //!!! 释放数据包
+  mblock_free(&tcp_seg_mblock, seg);
+}
+
+/**
+ * @brief 移除数据段头部cnt个字节的数据
+ *
+ * @param ooo
+ * @param seg
+ * @param cnt
+ */
+static void tcp_seg_trim_head(tcp_ooo_t *ooo, tcp_seg_t *seg, int cnt) {
+  pktbuf_header_remove(seg->buf, cnt);
+  seg->seq += cnt;
+  seg->len -= cnt;
+  ooo->size -= cnt;
+}
+
+/**
+ * @brief 将数据段next合并到数据段seg尾部, next的起始序号需不晚于seg的结束序号,
+ *        合并后释放next
+ *
+ * @param ooo
+ * @param seg
+ * @param next
+ */
+static void tcp_seg_merge(tcp_ooo_t *ooo, tcp_seg_t *seg, tcp_seg_t *next) {
+  uint32_t seg_end = seg->seq + seg->len;
+  uint32_t next_end = next->seq + next->len;
+
+  if (tcp_seq_after(next_end, seg_end)) {
+    // 移除next中与seg重叠的部分，再将剩余数据拼接到seg尾部
+    tcp_seg_trim_head(ooo, next, (int)(seg_end - next->seq));
+    pktbuf_join(seg->buf, next->buf);  //!!! 数据包合并, next->buf已被释放
+    seg->len += next->len;
+    seg->fin = next->fin;
+
+    nlist_remove(&ooo->seg_list, &next->node);
+    if (ooo->last == next) {
+      ooo->last = seg;
+    }
+    mblock_free(&tcp_seg_mblock, next);
+  } else {
+    // next完全被seg覆盖，直接释放
+    if (next_end == seg_end) {
+      seg->fin |= next->fin;
+    }
+    tcp_seg_free(ooo, next);
+  }
+}
+
+/**
+ * @brief 清空乱序队列，释放所有缓存的数据段
+ *
+ * @param ooo
+ */
+void tcp_ooo_clear(tcp_ooo_t *ooo) {
+  nlist_node_t *node = (nlist_node_t *)0;
+  while ((node = nlist_first(&ooo->seg_list)) != (nlist_node_t *)0) {
+    tcp_seg_free(ooo, nlist_entry(node, tcp_seg_t, node));
+  }
+}
+
+/**
+ * @brief 将一个乱序到达的数据段插入乱序队列，并与重叠或相邻的数据段合并
+ *        插入成功后由乱序队列负责释放buf, 失败则由调用者负责释放
+ *
+ * @param ooo
+ * @param buf 只包含有效数据的数据包
+ * @param seq 数据段的起始序号
+ * @param len 数据段的数据长度
+ * @param fin 数据段之后是否紧跟fin请求
+ * @param max_size 队列可缓存的最大数据量
+ * @return net_err_t
+ */
+net_err_t tcp_ooo_insert(tcp_ooo_t *ooo, pktbuf_t *buf, uint32_t seq, int len,
+                         int fin, int max_size) {
+  // 缓存的数据量超过上限，丢弃该数据段，由对端重传
+  if (ooo->size + len > max_size) {
+    dbg_warning(DBG_TCP, "tcp ooo queue full, drop seg(seq:%u, len:%d).", seq,
+                len);
+    return NET_ERR_FULL;
+  }
+
+  tcp_seg_t *seg = (tcp_seg_t *)mblock_alloc(&tcp_seg_mblock, -1);
+  if (!seg) {
+    dbg_warning(DBG_TCP, "no free tcp seg for ooo queue.");
+    return NET_ERR_MEM;
+  }
+  nlist_node_init(&seg->node);
+  seg->seq = seq;
+  seg->len = len;
+  seg->fin = fin;
+  seg->buf = buf;
+  ooo->size += len;
+
+  // 找到第一个结束序号不早于seg起始序号的数据段, 即可能与seg重叠或相邻的数据段
+  tcp_seg_t *curr = (tcp_seg_t *)0;
+  nlist_node_t *node = (nlist_node_t *)0;
+  nlist_for_each(node, &ooo->seg_list) {
+    tcp_seg_t *s = nlist_entry(node, tcp_seg_t, node);
+    uint32_t s_end = s->seq + s->len;
+    if (tcp_seq_after_eq(s_end, seq)) {
+      curr = s;
+      break;
+    }
+  }
+
+  if (!curr) {  // seg在所有数据段之后，直接插入队尾
+    nlist_insert_last(&ooo->seg_list, &seg->node);
+  } else if (tcp_seq_before_eq(curr->seq, seq)) {
+    // curr起始于seg之前，将seg合并到curr中
+    nlist_insert_after(&ooo->seg_list, &curr->node, &seg->node);
+    tcp_seg_merge(ooo, curr, seg);
+    seg = curr;
+  } else {  // seg起始于curr之前，插入到curr之前
+    nlist_insert_before(&ooo->seg_list, &curr->node, &seg->node);
+  }
+
+  // 合并seg之后与其重叠或相邻的数据段
+  while ((node = nlist_next(&ooo->seg_list, &seg->node)) != (nlist_node_t *)0) {
+    tcp_seg_t *next = nlist_entry(node, tcp_seg_t, node);
+    uint32_t seg_end = seg->seq + seg->len;
+    if (tcp_seq_after(next->seq, seg_end)) {
+      break;
+    }
+    tcp_seg_merge(ooo, seg, next);
+  }
+
+  ooo->last = seg;
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 将乱序队列中与接收窗口nxt连续的数据转移到接收队列中,
+ *        并更新nxt
+ *
+ * @param ooo
+ * @param rcvq 接收队列
+ * @param nxt 接收窗口的下一个待接收序号
+ * @param fin 返回转移的数据之后是否紧跟fin请求
+ * @return int 转移到接收队列的数据长度
+ */
+int tcp_ooo_drain(tcp_ooo_t *ooo, tcp_rcvq_t *rcvq, uint32_t *nxt, int *fin) {
+  int total = 0;
+  nlist_node_t *node = (nlist_node_t *)0;
+
+  *fin = 0;
+  while ((node = nlist_first(&ooo->seg_list)) != (nlist_node_t *)0) {
+    tcp_seg_t *seg = nlist_entry(node, tcp_seg_t, node);
+    if (tcp_seq_after(seg->seq, *nxt)) {  // 仍有空缺
+      break;
+    }
+
+    // 跳过已接收的部分，将剩余数据放入接收队列
+    uint32_t seg_end = seg->seq + seg->len;
+    if (tcp_seq_after(seg_end, *nxt)) {
+      int skip = (int)(*nxt - seg->seq);
+      int len = seg->len - skip;
+      int cnt = tcp_rcvq_put(rcvq, seg->buf, skip, len);  //!!! 数据包引用
+      if (cnt <= 0) {
+        break;
+      }
+      *nxt += cnt;
+      total += cnt;
+
+      if (cnt < len) {  // 接收队列已满，保留剩余数据(已拷贝的部分)
+        tcp_seg_trim_head(ooo, seg, skip + cnt);
+        break;
+      }
+    }
+
+    if (seg->fin && *nxt == seg_end) {
+      *fin = 1;
+    }
+    tcp_seg_free(ooo, seg);
+  }
+
+  return total;
+}
+
+/**
+ * @brief 获取乱序队列中缓存的序号范围, 以供SACK选项使用(RFC 2018)
+ *        第一个块为最近一次接收的数据所在的范围，其余按序号升序排列
+ *
+ * @param ooo
+ * @param blocks 返回的序号范围数组
+ * @param max 数组的最大容量
+ * @return int 返回的序号范围数量
+ */
+int tcp_ooo_sack_blocks(tcp_ooo_t *ooo, tcp_sack_block_t *blocks, int max) {
+  int cnt = 0;
+
+  if (ooo->last && cnt < max) {
+    blocks[cnt].start = ooo->last->seq;
+    blocks[cnt].end = ooo->last->seq + ooo->last->len;
+    cnt++;
+  }
+
+  nlist_node_t *node = (nlist_node_t *)0;
+  nlist_for_each(node, &ooo->seg_list) {
+    if (cnt >= max) {
+      break;
+    }
+
+    tcp_seg_t *seg = nlist_entry(node, tcp_seg_t, node);
+    if (seg == ooo->last) {
+      continue;
+    }
+    blocks[cnt].start = seg->seq;
+    blocks[cnt].end = seg->seq + seg->len;
+    cnt++;
+  }
+
+  return cnt;
+}
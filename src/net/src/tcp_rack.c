@@ -0,0 +1,289 @@
+/**
+ * @file tcp_rack.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp RACK-TLP丢包检测模块(RFC 8985)
+ *        RACK: 按发送时间而不是重复ack的个数判断丢包, 收到重复ack表明之后发送的数据段已到达,
+ *        此时最早的未确认数据段若发出已超过rtt加重排序窗口(最小rtt的1/4)则判定丢失并快速重传,
+ *        未超过则等待到期后再判断, 以容忍少量的乱序;
+ *        TLP: 尾部的数据段丢失时没有之后的数据段触发重复ack, 发送数据后约两个rtt(探测超时)未收到ack,
+ *        就重传最后一个数据段作为探测, 其ack或重复ack使丢失在约一个rtt内被修复或由RACK检测到,
+ *        而不必等待重传超时
+ *        对端不支持SACK, 只能通过累积确认及重复ack得知数据段的到达情况, 因此只检测最早的未确认数据段
+ * @version 0.1
+ * @date 2024-12-11
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "tcp_rack.h"
+
+#include "dbg.h"
+#include "tcp_send.h"
+#include "tools.h"
+
+static tcp_rack_stats_t rack_stats;  // 所有连接的RACK-TLP统计信息
+
+static void rack_tmo(net_timer_t *timer, void *arg);
+
+/**
+ * @brief 以ms为超时时间(重新)启动RACK-TLP定时器
+ *
+ * @param tcp
+ * @param ms
+ */
+static void rack_timer_start(tcp_t *tcp, int ms) {
+  tcp_rack_stop(tcp);
+  net_timer_add(&tcp->rack.timer, "tcp rack", rack_tmo, tcp, ms,
+                NET_TIMER_ACTIVE);
+}
+
+/**
+ * @brief 检测到丢包后降低拥塞窗口, 与快速重传相同, 慢启动阈值减为在途数据量的一半(RFC 5681)
+ *        BBR不因丢包减小带宽模型, 不降低拥塞窗口
+ *
+ * @param tcp
+ * @param flight 发生丢包时的在途数据量
+ */
+static void rack_cwnd_reduce(tcp_t *tcp, uint32_t flight) {
+  if (tcp->cc == TCP_CC_BBR) {
+    return;
+  }
+
+  tcp->send.ssthresh = MAX(flight / 2, 2U * tcp->mss);
+  tcp->send.cwnd = MIN(tcp->send.cwnd, tcp->send.ssthresh);
+}
+
+/**
+ * @brief 启动尾部丢失探测定时器
+ *        探测超时为两个srtt, 且不小于TCP_TLP_MIN_PTO; 在途数据只有一个数据段时对端可能正在延迟确认,
+ *        无论是否使用时间戳选项都再加上最大延迟确认时间(RFC 8985 7.2), 时间戳只能在多余的探测被确认后
+ *        避免降低拥塞窗口, 不能避免多余的探测及其触发的立即确认; 重传超时先于探测超时到期时由超时重传处理
+ *
+ * @param tcp
+ */
+static void rack_tlp_schedule(tcp_t *tcp) {
+  uint32_t flight = tcp->send.nxt - tcp->send.una;
+  if (!TCP_RACK_ENABLE || !flight || tcp->flags.syn_need_ack ||
+      tcp->flags.recovery || tcp->rack.tlp_valid || !tcp->rtt.srtt) {
+    tcp_rack_stop(tcp);
+    return;
+  }
+
+  int pto = MAX(2 * tcp->rtt.srtt, TCP_TLP_MIN_PTO);
+  if (flight <= (uint32_t)tcp_send_mss(tcp)) {
+    pto += TCP_DELACK_TMO;
+  }
+  if (pto >= tcp_rto_get(tcp)) {
+    tcp_rack_stop(tcp);
+    return;
+  }
+  rack_timer_start(tcp, pto);
+}
+
+/**
+ * @brief 判断最早的未确认数据段是否已丢失: 之后发送的数据段已到达(收到了重复ack),
+ *        且其发出已超过rtt加重排序窗口, 丢失时进入恢复阶段并立即重传, 否则等待到期后再判断
+ *
+ * @param tcp
+ */
+static void rack_detect(tcp_t *tcp) {
+  if (!tcp->rack.cnt) {
+    return;
+  }
+
+  int rtt = tcp->rack.rtt >= 0 ? tcp->rack.rtt : tcp->rtt.srtt;
+  int reo_wnd = MIN(tcp->rack.min_rtt / 4, tcp->rtt.srtt);
+  uint32_t time = tcp->rack.seg[tcp->rack.head].time;
+  int wait = (int)(time + rtt + reo_wnd - tcp_time_now());
+  if (wait > 0) {
+    rack_timer_start(tcp, wait);
+    return;
+  }
+
+  tcp->rack.dupack = 0;
+  tcp->rack.tlp_valid = 0;
+  tcp_rack_stop(tcp);
+  tcp->rack.stats.rack_lost++;
+  rack_stats.rack_lost++;
+  dbg_info(DBG_TCP, "tcp rack lost, seq: %u.", tcp->send.una);
+
+  // 进入恢复阶段, 之后每个部分确认都立即重传下一个未确认的数据段
+  rack_cwnd_reduce(tcp, tcp->send.nxt - tcp->send.una);
+  tcp->flags.recovery = 1;
+  tcp->send.recover = tcp->send.nxt;
+  tcp_retransmit(tcp);
+  tcp_rto_start(tcp);
+}
+
+/**
+ * @brief RACK-TLP定时器超时处理函数: 收到重复ack后为重排序窗口到期, 重新判断是否丢包;
+ *        否则为探测超时, 重传最后一个数据段作为尾部丢失探测, 每个探测结束前不再发送新的探测
+ *
+ * @param timer
+ * @param arg
+ */
+static void rack_tmo(net_timer_t *timer, void *arg) {
+  tcp_t *tcp = (tcp_t *)arg;
+  if (tcp->rack.dupack) {
+    rack_detect(tcp);
+    return;
+  }
+
+  if (tcp->send.una == tcp->send.nxt || tcp->flags.recovery ||
+      tcp_retransmit_tail(tcp) != NET_ERR_OK) {
+    return;
+  }
+
+  tcp->rack.tlp_valid = 1;
+  tcp->rack.tlp_high = tcp->send.nxt;
+  tcp->rack.tlp_time = tcp_time_now();
+  tcp->rack.stats.tlp_probes++;
+  rack_stats.tlp_probes++;
+  dbg_info(DBG_TCP, "tcp tail loss probe, nxt: %u.", tcp->send.nxt);
+
+  // 探测本身也可能丢失, 重新开始计算重传超时
+  tcp_rto_start(tcp);
+}
+
+/**
+ * @brief 初始化连接的RACK-TLP状态, 在建立连接前调用
+ *
+ * @param tcp
+ */
+void tcp_rack_init(tcp_t *tcp) {
+  tcp->rack.head = 0;
+  tcp->rack.cnt = 0;
+  tcp->rack.rtt = -1;
+  tcp->rack.min_rtt = TCP_RTO_MAX;
+  tcp->rack.dupack = 0;
+  tcp->rack.tlp_valid = 0;
+  plat_memset(&tcp->rack.stats, 0, sizeof(tcp_rack_stats_t));
+}
+
+/**
+ * @brief 停止RACK-TLP定时器
+ *
+ * @param tcp
+ */
+void tcp_rack_stop(tcp_t *tcp) {
+  if (tcp->rack.timer.flags & NET_TIMER_ACTIVE) {
+    net_timer_remove(&tcp->rack.timer);
+  }
+}
+
+/**
+ * @brief 发送了新的数据段(send.nxt已更新): 记录其发送时间, 并重新启动探测定时器
+ *
+ * @param tcp
+ */
+void tcp_rack_on_send(tcp_t *tcp) {
+  uint32_t now = tcp_time_now();
+  if (tcp->rack.cnt < TCP_RACK_SEG_CNT) {
+    int idx = (tcp->rack.head + tcp->rack.cnt++) % TCP_RACK_SEG_CNT;
+    tcp->rack.seg[idx].end = tcp->send.nxt;
+    tcp->rack.seg[idx].time = now;
+  } else {
+    // 记录已用尽, 合并到最后一个记录, 使用较晚的发送时间, 只会推迟而不会提前判定丢失
+    int idx = (tcp->rack.head + tcp->rack.cnt - 1) % TCP_RACK_SEG_CNT;
+    tcp->rack.seg[idx].end = tcp->send.nxt;
+    tcp->rack.seg[idx].time = now;
+  }
+
+  if (!tcp->rack.dupack) {
+    rack_tlp_schedule(tcp);
+  }
+}
+
+/**
+ * @brief 重传了[seq, end)范围内的数据: 更新与其重叠的数据段记录的发送时间
+ *
+ * @param tcp
+ * @param seq
+ * @param end
+ */
+void tcp_rack_on_retransmit(tcp_t *tcp, uint32_t seq, uint32_t end) {
+  uint32_t now = tcp_time_now();
+  uint32_t start = tcp->send.una;
+  for (int i = 0; i < tcp->rack.cnt; i++) {
+    int idx = (tcp->rack.head + i) % TCP_RACK_SEG_CNT;
+    if (!tcp_seq_before(start, end)) {
+      break;
+    }
+    if (tcp_seq_after(tcp->rack.seg[idx].end, seq)) {
+      tcp->rack.seg[idx].time = now;
+    }
+    start = tcp->rack.seg[idx].end;
+  }
+}
+
+/**
+ * @brief 接收到确认了新数据的ack(send.una已更新): 移除已确认的数据段记录, 更新rtt,
+ *        结束已被确认的尾部丢失探测, 并重新启动探测定时器
+ *        探测结束时若对端回显的时间戳早于探测的发送时间, 说明ack确认的是原数据段, 探测是多余的;
+ *        否则(或未使用时间戳选项无法区分时)视为探测修复了一次丢包, 需要降低拥塞窗口
+ *
+ * @param tcp
+ * @param info
+ * @param rtt 本次ack采样的rtt(ms), 为-1表示未采样
+ */
+void tcp_rack_on_ack(tcp_t *tcp, tcp_info_t *info, int rtt) {
+  while (tcp->rack.cnt &&
+         !tcp_seq_after(tcp->rack.seg[tcp->rack.head].end, tcp->send.una)) {
+    tcp->rack.head = (tcp->rack.head + 1) % TCP_RACK_SEG_CNT;
+    tcp->rack.cnt--;
+  }
+
+  if (rtt >= 0) {
+    tcp->rack.rtt = rtt;
+    tcp->rack.min_rtt = MIN(tcp->rack.min_rtt, rtt);
+  }
+
+  if (tcp->rack.tlp_valid &&
+      !tcp_seq_before(tcp->send.una, tcp->rack.tlp_high)) {
+    tcp->rack.tlp_valid = 0;
+    if (!(tcp->flags.ts_ok && info->ts_valid && info->ts_ecr &&
+          (int)(info->ts_ecr - tcp->rack.tlp_time) < 0)) {
+      tcp->rack.stats.tlp_recoveries++;
+      rack_stats.tlp_recoveries++;
+      rack_cwnd_reduce(tcp, tcp->send.cwnd);
+    }
+  }
+
+  // 确认了新的数据, 重新等待重复ack
+  tcp->rack.dupack = 0;
+  rack_tlp_schedule(tcp);
+}
+
+/**
+ * @brief 接收到重复的ack(未确认新数据, 不携带数据且窗口未变化)
+ *
+ * @param tcp
+ */
+void tcp_rack_on_dupack(tcp_t *tcp) {
+  if (!TCP_RACK_ENABLE || !tcp->rack.cnt || tcp->flags.recovery ||
+      tcp->flags.syn_need_ack) {
+    return;
+  }
+
+  tcp->rack.dupack = 1;
+  rack_detect(tcp);
+}
+
+/**
+ * @brief 发生了超时重传, 由超时重传的恢复阶段处理丢包, 结束探测及重排序等待
+ *
+ * @param tcp
+ */
+void tcp_rack_on_rto(tcp_t *tcp) {
+  tcp_rack_stop(tcp);
+  tcp->rack.dupack = 0;
+  tcp->rack.tlp_valid = 0;
+}
+
+/**
+ * @brief 获取所有连接的RACK-TLP统计信息, 单个连接的统计信息记录在tcp->rack.stats中
+ *
+ * @param stats
+ */
+void tcp_rack_stats_get(tcp_rack_stats_t *stats) { *stats = rack_stats; }
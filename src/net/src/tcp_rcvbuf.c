@@ -0,0 +1,203 @@
+/**
+ * @file tcp_rcvbuf.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp接收缓冲区自动调整模块
+ *        固定大小的接收缓冲区在高带宽时延积的路径上限制了吞吐量, 而读取缓慢的连接又不需要较大的缓冲区,
+ *        因此以每个rtt内交付给应用程序的数据量估计对端的发送速率,
+ *        对端的发送量逼近接收窗口时将接收队列扩大为该数据量的两倍, 使对端的拥塞窗口可以继续增长,
+ *        扩大的部分受每个连接的上限(SO_RCVBUF)及所有连接的总量上限限制, 并在内存紧张时收缩
+ *        接收窗口直接由接收队列的剩余容量得到, 队列的容量变化后通告的窗口随之变化
+ * @version 0.1
+ * @date 2024-12-07
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "tcp_rcvbuf.h"
+
+#include "dbg.h"
+#include "pktbuf.h"
+#include "tools.h"
+
+static int tcp_rmem_used;  // 所有连接接收队列超出TCP_RBUF_SIZE部分的总量
+
+/**
+ * @brief 初始化连接的接收队列及自动调整信息, 接收队列从TCP_RBUF_SIZE开始
+ *        初始的单个rtt数据量取缓冲区的一半, 对端在一个rtt内发送了整个窗口的数据后即开始扩大
+ *
+ * @param tcp
+ */
+void tcp_rcvbuf_init(tcp_t *tcp) {
+  tcp_rcvq_init(&tcp->recv.queue, TCP_RBUF_SIZE);
+
+  tcp->recv.tune.space = TCP_RBUF_SIZE / 2;
+  tcp->recv.tune.seq = 0;
+  tcp->recv.tune.time = 0;
+  tcp->recv.tune.rtt = 0;
+  tcp->recv.tune.rtt_valid = 0;
+}
+
+/**
+ * @brief 释放连接的接收队列扩大的部分, 在释放tcp对象时调用
+ *
+ * @param tcp
+ */
+void tcp_rcvbuf_release(tcp_t *tcp) {
+  if (tcp->recv.queue.size > TCP_RBUF_SIZE) {
+    tcp_rmem_used -= tcp->recv.queue.size - TCP_RBUF_SIZE;
+    tcp->recv.queue.size = TCP_RBUF_SIZE;
+  }
+}
+
+/**
+ * @brief 扩大接收队列的容量, 不超过连接的上限及所有连接剩余的总量
+ *
+ * @param tcp
+ * @param size 期望的容量
+ */
+static void tcp_rcvbuf_grow(tcp_t *tcp, int size) {
+  tcp_rcvq_t *rcvq = &tcp->recv.queue;
+
+  int extra = MIN(size, tcp->recv.tune.cap) - rcvq->size;
+  extra = MIN(extra, TCP_RMEM_LIMIT - tcp_rmem_used);
+  if (extra <= 0) {
+    return;
+  }
+
+  rcvq->size += extra;
+  tcp_rmem_used += extra;
+  dbg_info(DBG_TCP, "tcp rcvbuf grow to %d.", rcvq->size);
+}
+
+/**
+ * @brief 收缩接收队列的容量, 不小于TCP_RBUF_SIZE,
+ *        且不能收回已通告给对端的窗口, 对端可能已按该窗口发送了数据
+ *
+ * @param tcp
+ * @param size 期望的容量
+ */
+static void tcp_rcvbuf_shrink(tcp_t *tcp, int size) {
+  tcp_rcvq_t *rcvq = &tcp->recv.queue;
+
+  int committed = tcp->flags.recv_win_valid
+                      ? (int)(tcp->recv.wnd_edge - tcp->recv.unr)
+                      : rcvq->count;
+  size = MAX(size, TCP_RBUF_SIZE);
+  size = MAX(size, MAX(committed, rcvq->count));
+  if (size >= rcvq->size) {
+    return;
+  }
+
+  tcp_rmem_used -= rcvq->size - size;
+  rcvq->size = size;
+  tcp->recv.tune.space = MIN(tcp->recv.tune.space, size / 2);
+  dbg_info(DBG_TCP, "tcp rcvbuf shrink to %d.", rcvq->size);
+}
+
+/**
+ * @brief 设置连接的接收队列可自动扩大到的上限, 取值范围为[TCP_RBUF_SIZE, TCP_RBUF_MAX],
+ *        当前容量超过新的上限时立即收缩
+ *
+ * @param tcp
+ * @param cap
+ */
+void tcp_rcvbuf_set_cap(tcp_t *tcp, int cap) {
+  cap = MAX(cap, TCP_RBUF_SIZE);
+  tcp->recv.tune.cap = MIN(cap, TCP_RBUF_MAX);
+  tcp_rcvbuf_shrink(tcp, tcp->recv.tune.cap);
+}
+
+/**
+ * @brief 记录接收方估计的rtt
+ *        通过时间戳回显得到的采样值进行平滑, 通过接收一个窗口的数据得到的采样值包含了对端的发送间隔,
+ *        只取最小值
+ *
+ * @param tcp
+ * @param rtt
+ * @param win_dep 采样值是否通过接收一个窗口的数据得到
+ */
+static void tcp_rcvbuf_rtt_sample(tcp_t *tcp, int rtt, int win_dep) {
+  rtt = rtt ? rtt : 1;
+
+  if (tcp->recv.tune.rtt == 0) {  // 第一次采样, 从此开始测量每个rtt内的数据量
+    tcp->recv.tune.rtt = rtt;
+    tcp->recv.tune.seq = tcp->recv.unr;
+    tcp->recv.tune.time = tcp_time_now();
+  } else if (win_dep) {
+    tcp->recv.tune.rtt = MIN(tcp->recv.tune.rtt, rtt);
+  } else {
+    // rtt = 7/8 * rtt + 1/8 * sample
+    tcp->recv.tune.rtt = (7 * tcp->recv.tune.rtt + rtt) / 8;
+    tcp->recv.tune.rtt = tcp->recv.tune.rtt ? tcp->recv.tune.rtt : 1;
+  }
+}
+
+/**
+ * @brief 接收到按序的数据后采样接收方的rtt, 并在内存紧张时收缩已扩大的接收队列
+ *        使用时间戳时, 对端回显的时间戳即为本地发送ack的时间;
+ *        否则记录接收完当前窗口所需的时间(RFC 7323未使用时间戳时接收方的rtt估计方法)
+ *
+ * @param tcp
+ * @param info 携带新数据的报文段, recv.nxt已越过其数据
+ */
+void tcp_rcvbuf_data_in(tcp_t *tcp, tcp_info_t *info) {
+#if TCP_RBUF_AUTOTUNE
+  uint32_t now = tcp_time_now();
+
+  if (tcp->flags.ts_ok) {
+    if (info->ts_valid && info->ts_ecr && (int)(now - info->ts_ecr) >= 0) {
+      tcp_rcvbuf_rtt_sample(tcp, (int)(now - info->ts_ecr), 0);
+    }
+  } else if (!tcp->recv.tune.rtt_valid ||
+             tcp_seq_after_eq(tcp->recv.nxt, tcp->recv.tune.rtt_seq)) {
+    if (tcp->recv.tune.rtt_valid) {
+      tcp_rcvbuf_rtt_sample(tcp, (int)(now - tcp->recv.tune.rtt_time), 1);
+    }
+    tcp->recv.tune.rtt_seq = tcp->recv.nxt + tcp_recv_window(tcp);
+    tcp->recv.tune.rtt_time = now;
+    tcp->recv.tune.rtt_valid = 1;
+  }
+
+  if (tcp->recv.queue.size > TCP_RBUF_SIZE &&
+      pktbuf_pool_low(TCP_RMEM_LOW_DIV)) {
+    tcp_rcvbuf_shrink(tcp, TCP_RBUF_SIZE);
+  }
+#endif
+}
+
+/**
+ * @brief 应用程序取走数据后调整接收队列的容量
+ *        每经过一个rtt统计此期间交付给应用程序的数据量, 超过此前的最大值时,
+ *        对端的发送量受限于接收窗口, 将接收队列扩大为该数据量的两倍;
+ *        读取缓慢的连接交付的数据量较少, 缓冲区不会扩大
+ *
+ * @param tcp
+ */
+void tcp_rcvbuf_adjust(tcp_t *tcp) {
+#if TCP_RBUF_AUTOTUNE
+  uint32_t now = tcp_time_now();
+  if (tcp->recv.tune.rtt == 0 ||
+      (int)(now - tcp->recv.tune.time) < tcp->recv.tune.rtt) {
+    return;
+  }
+
+  int copied = (int)(tcp->recv.unr - tcp->recv.tune.seq);
+  if (pktbuf_pool_low(TCP_RMEM_LOW_DIV)) {
+    tcp_rcvbuf_shrink(tcp, TCP_RBUF_SIZE);
+  } else if (copied > tcp->recv.tune.space) {
+    tcp->recv.tune.space = copied;
+    tcp_rcvbuf_grow(tcp, 2 * copied);
+  }
+
+  tcp->recv.tune.seq = tcp->recv.unr;
+  tcp->recv.tune.time = now;
+#endif
+}
+
+/**
+ * @brief 获取所有连接接收队列超出TCP_RBUF_SIZE部分的总量
+ *
+ * @return int
+ */
+int tcp_rcvbuf_mem_used(void) { return tcp_rmem_used; }
@@ -0,0 +1,169 @@
+/**
+ * @file tcp_rcvq.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp接收队列模块
+ *        按序到达的数据包去除tcp头部后直接挂载到队列中, 只在应用程序读取时拷贝一次,
+ *        应用程序也可以通过零拷贝接收直接取走队列中的数据包
+ * @version 0.1
+ * @date 2024-12-05
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "tcp_rcvq.h"
+
+#include "dbg.h"
+#include "tools.h"
+
+/**
+ * @brief 初始化tcp接收队列
+ *
+ * @param rcvq
+ * @param size 队列的容量
+ */
+void tcp_rcvq_init(tcp_rcvq_t *rcvq, int size) {
+  nlist_init(&rcvq->buf_list);
+  rcvq->count = 0;
+  rcvq->size = size;
+}
+
+/**
+ * @brief 清空接收队列，释放所有缓存的数据包
+ *
+ * @param rcvq
+ */
+void tcp_rcvq_clear(tcp_rcvq_t *rcvq) {
+  nlist_node_t *node = (nlist_node_t *)0;
+  while ((node = nlist_remove_first(&rcvq->buf_list)) != (nlist_node_t *)0) {
+    pktbuf_free(nlist_entry(node, pktbuf_t, node));  //!!! 释放数据包
+  }
+  rcvq->count = 0;
+}
+
+/**
+ * @brief 将数据拷贝到队尾的数据包中, 队列为空时分配一个新的数据包
+ *
+ * @param rcvq
+ * @param buf 访问位置已位于待拷贝数据处的数据包
+ * @param len
+ * @return net_err_t
+ */
+static net_err_t tcp_rcvq_copy(tcp_rcvq_t *rcvq, pktbuf_t *buf, int len) {
+  nlist_node_t *node = nlist_last(&rcvq->buf_list);
+  if (!node) {
+    pktbuf_t *tail = pktbuf_alloc(len);  //!!! 分配数据包
+    if (!tail) {
+      return NET_ERR_MEM;
+    }
+
+    pktbuf_copy(tail, buf, len);
+    pktbuf_acc_reset(tail);
+    nlist_insert_last(&rcvq->buf_list, &tail->node);
+    return NET_ERR_OK;
+  }
+
+  // 追加到队尾数据包的尾部, 并恢复其读取位置
+  pktbuf_t *tail = nlist_entry(node, pktbuf_t, node);
+  int pos = tail->pos;
+  int size = pktbuf_total_size(tail);
+  if (pktbuf_resize(tail, size + len) != NET_ERR_OK) {
+    return NET_ERR_MEM;
+  }
+  pktbuf_seek(tail, size);
+  pktbuf_copy(tail, buf, len);
+  pktbuf_seek(tail, pos);
+
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 将数据包中从offset开始的len个字节数据放入接收队列
+ *        数据包的剩余数据全部入队且不小于TCP_RCVQ_COPYBREAK时, 队列增加其引用计数后直接挂载,
+ *        否则将数据拷贝到队尾的数据包中, 避免大量小数据包占用数据包池
+ *        数据包始终由调用者负责释放
+ *
+ * @param rcvq
+ * @param buf
+ * @param offset 有效数据在数据包中的偏移(tcp头部及已接收的数据)
+ * @param len
+ * @return int 成功放入的数据长度
+ */
+int tcp_rcvq_put(tcp_rcvq_t *rcvq, pktbuf_t *buf, int offset, int len) {
+  len = MIN(len, tcp_rcvq_free_cnt(rcvq));
+  if (len <= 0) {
+    return 0;
+  }
+
+  pktbuf_seek(buf, offset);
+  if (len >= TCP_RCVQ_COPYBREAK && offset + len == pktbuf_total_size(buf)) {
+    nlist_insert_last(&rcvq->buf_list,
+                      &pktbuf_inc_ref(buf)->node);  //!!! 数据包引用
+  } else if (tcp_rcvq_copy(rcvq, buf, len) != NET_ERR_OK) {
+    dbg_warning(DBG_TCP, "no free pktbuf for tcp recv queue.");
+    return 0;
+  }
+
+  rcvq->count += len;
+  return len;
+}
+
+/**
+ * @brief 从接收队列中读取数据，并移除读取的数据
+ *
+ * @param rcvq
+ * @param data_buf
+ * @param len
+ * @return int 读取的数据长度
+ */
+int tcp_rcvq_read(tcp_rcvq_t *rcvq, uint8_t *data_buf, int len) {
+  int total = 0;
+  nlist_node_t *node = (nlist_node_t *)0;
+
+  while (total < len &&
+         (node = nlist_first(&rcvq->buf_list)) != (nlist_node_t *)0) {
+    pktbuf_t *buf = nlist_entry(node, pktbuf_t, node);
+    int size = MIN(pktbuf_remain_size(buf), len - total);
+    pktbuf_read(buf, data_buf + total, size);
+    total += size;
+
+    if (pktbuf_remain_size(buf) == 0) {
+      nlist_remove_first(&rcvq->buf_list);
+      pktbuf_free(buf);  //!!! 释放数据包
+    } else {
+      // 只读取了部分数据，归还已读取的数据块
+      pktbuf_header_remove(buf, buf->pos);
+    }
+  }
+
+  rcvq->count -= total;
+  return total;
+}
+
+/**
+ * @brief 取出接收队列中的所有数据包, 去除头部及已读取的数据后合并为一个数据包返回,
+ *        由调用者负责释放
+ *
+ * @param rcvq
+ * @return pktbuf_t* 队列为空时返回0
+ */
+pktbuf_t *tcp_rcvq_get(tcp_rcvq_t *rcvq) {
+  pktbuf_t *buf = (pktbuf_t *)0;
+  nlist_node_t *node = (nlist_node_t *)0;
+
+  while ((node = nlist_remove_first(&rcvq->buf_list)) != (nlist_node_t *)0) {
+    pktbuf_t *curr = nlist_entry(node, pktbuf_t, node);
+    pktbuf_header_remove(curr, curr->pos);
+    if (!buf) {
+      buf = curr;
+    } else {
+      pktbuf_join(buf, curr);  //!!! 数据包合并, curr已被释放
+    }
+  }
+
+  if (buf) {
+    pktbuf_acc_reset(buf);
+  }
+  rcvq->count = 0;
+  return buf;
+}
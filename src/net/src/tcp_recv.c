@@ -14,8 +14,11 @@
 #include "ipaddr.h"
 #include "pktbuf.h"
 #include "protocol.h"
+#include "tcp_ecn.h"
+#include "tcp_rcvbuf.h"
 #include "tcp_send.h"
 #include "tcp_state.h"
+#include "tcp_tw.h"
 #include "tools.h"
 
 /**
@@ -63,6 +66,107 @@ static net_err_t tcp_check(pktbuf_t *tcp_buf, ipaddr_t *src_ip,
   return NET_ERR_OK;
 }
 
+static tcp_pred_stats_t pred_stats;  // 首部预测统计信息
+
+/**
+ * @brief 获取首部预测的统计信息
+ *
+ * @param stats
+ */
+void tcp_pred_stats_get(tcp_pred_stats_t *stats) { *stats = pred_stats; }
+
+#if TCP_HDR_PRED_ENABLE
+/**
+ * @brief 快速路径中更新对端通告的接收窗口
+ *        报文段的序号等于recv.nxt, 不早于任何已接收的报文段, 确认号也晚于send.una,
+ *        必定满足状态机中窗口更新的条件(RFC 793), 无需再比较wl1及wl2
+ *
+ * @param tcp
+ * @param info
+ */
+static inline void tcp_recv_fast_win(tcp_t *tcp, tcp_info_t *info) {
+  tcp->send.win = info->tcp_hdr->win_size;
+  tcp->send.wl1 = info->seq;
+  tcp->send.wl2 = info->tcp_hdr->ack;
+}
+
+/**
+ * @brief 首部预测(Van Jacobson): 已建立连接上接收到的报文段绝大多数是按序到达的纯数据或纯ack,
+ *        对这两类报文段跳过状态机中通用的序号检查、ack处理及数据接收处理,
+ *        直接推进发送窗口或将数据追加到接收队列, 其余报文段仍交由状态机处理
+ *
+ * @param tcp
+ * @param info
+ * @return int 1: 已由快速路径处理, 0: 需交由状态机处理
+ */
+static int tcp_recv_fast(tcp_t *tcp, tcp_info_t *info) {
+  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
+  if (tcp->state != TCP_STATE_ESTABLISHED) {
+    return 0;
+  }
+  pred_stats.total++;
+
+  // 只有ack标志位(可带psh), 且序号正好为期望接收的序号, 拥塞通知交由慢速路径处理
+  if (!tcp_hdr->f_ack || tcp_hdr->f_syn || tcp_hdr->f_fin ||
+      tcp_hdr->f_rst || tcp_hdr->f_urg || tcp_hdr->f_ece || tcp_hdr->f_cwr ||
+      info->ecn_ce || info->seq != tcp->recv.nxt) {
+    return 0;
+  }
+
+  // 除协商后每个报文段都携带的时间戳选项外不能有其他选项, 且时间戳能通过PAWS检查
+  int opt_size = tcp->flags.ts_ok ? 2 + sizeof(tcp_opt_ts_t) : 0;
+  if (tcp_get_hdr_size(tcp_hdr) != sizeof(tcp_hdr_t) + opt_size ||
+      (tcp->flags.ts_ok && (!info->ts_valid ||
+                            tcp_seq_before(info->ts_val, tcp->ts.recent)))) {
+    return 0;
+  }
+
+  if (info->data_len == 0) {
+    // 纯ack: 只处理确认了新数据的ack, 重复的ack(包括纯窗口更新)交由状态机处理
+    // 接收缓冲区较小时对端每个ack通告的窗口都可能变化, 因此不要求窗口不变,
+    // 处理完ack后总会尝试发送, 与状态机的处理相同
+    if (!tcp_seq_after(tcp_hdr->ack, tcp->send.una) ||
+        tcp_seq_after(tcp_hdr->ack, tcp->send.nxt)) {
+      return 0;
+    }
+
+    tcp_ts_update(tcp, info);
+    tcp_recv_fast_win(tcp, info);
+    tcp_ack_advance(tcp, info);
+
+    // 发送窗口向前滑动, 继续发送缓冲区中剩余的数据
+    tcp_transmit(tcp);
+    pred_stats.ack_hit++;
+    return 1;
+  }
+
+  // 按序纯数据: 没有确认新的数据, 窗口没有变化(无需尝试发送), 乱序队列为空,
+  // 且接收队列能容纳全部数据
+  if (tcp_hdr->ack != tcp->send.una || tcp_hdr->win_size != tcp->send.win ||
+      !tcp_ooo_is_empty(&tcp->recv.ooo) ||
+      (int)info->data_len > tcp_recv_window(tcp)) {
+    return 0;
+  }
+
+  tcp_ts_update(tcp, info);
+  int len = tcp_rcvq_put(&tcp->recv.queue, info->tcp_buf,
+                         tcp_get_hdr_size(tcp_hdr),
+                         info->data_len);  //!!! 数据包引用
+  if (len <= 0) {
+    return 0;
+  }
+  tcp->recv.nxt += len;
+  tcp->stats.bytes_received += len;
+  tcp->send.wl1 = info->seq;
+  tcp_rcvbuf_data_in(tcp, info);
+
+  sock_wakeup(&tcp->sock_base, SOCK_WAIT_READ, NET_ERR_OK);
+  tcp_delack_schedule(tcp, len);
+  pred_stats.data_hit++;
+  return 1;
+}
+#endif
+
 /**
  * @brief 从网络层接收tcp数据包，并进行处理
  *
@@ -87,6 +191,14 @@ net_err_t tcp_recv(pktbuf_t *tcp_buf, ipaddr_t *src_ip, ipaddr_t *dest_ip) {
     return err;
   }
 
+  // 将tcp头部及选项设置为内存连续，以便后续解析选项
+  err = pktbuf_set_cont(tcp_buf,
+                        tcp_get_hdr_size((tcp_hdr_t *)pktbuf_data_ptr(tcp_buf)));
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "pktbuf set cont failed.");
+    return err;
+  }
+
   // 获取tcp数据包头部, 并转换头部字段到主机字节序
   tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(tcp_buf);
   tcp_hdr_ntoh(tcp_hdr);
@@ -99,6 +211,16 @@ net_err_t tcp_recv(pktbuf_t *tcp_buf, ipaddr_t *src_ip, ipaddr_t *dest_ip) {
 
   // 根据tcp数据包信息查找对应的tcp对象
   tcp_t *tcp = tcp_find(&tcp_info);
+
+  // 处于TIME_WAIT状态的连接由TIME_WAIT记录处理, 复用该四元组的新连接请求交由监听对象处理
+  if (tcp && tcp->state == TCP_STATE_TIME_WAIT) {
+    if (!tcp_tw_recv((tcp_tw_t *)tcp, &tcp_info)) {
+      pktbuf_free(tcp_buf);  //!!! 释放数据包
+      return NET_ERR_OK;
+    }
+    tcp = tcp_find(&tcp_info);
+  }
+
   if (!tcp) {
     dbg_warning(DBG_TCP, "tcp find failed.");
     if (!tcp_hdr->f_rst) {  // 若不是复位请求，则给对端发送复位数据包
@@ -108,6 +230,16 @@ net_err_t tcp_recv(pktbuf_t *tcp_buf, ipaddr_t *src_ip, ipaddr_t *dest_ip) {
     return NET_ERR_TCP;
   }
 
+  tcp->stats.segs_in++;
+
+#if TCP_HDR_PRED_ENABLE
+  // 首部预测命中时不再经过状态机
+  if (tcp_recv_fast(tcp, &tcp_info)) {
+    pktbuf_free(tcp_buf);  //!!! 释放数据包
+    return NET_ERR_OK;
+  }
+#endif
+
   // 根据tcp对象的状态处理接收到的tcp数据包
   err = tcp_state_handler_recv(tcp, &tcp_info);
   if (err != NET_ERR_OK) {
@@ -122,38 +254,68 @@ net_err_t tcp_recv(pktbuf_t *tcp_buf, ipaddr_t *src_ip, ipaddr_t *dest_ip) {
 }
 
 /**
- * @brief 将tcp数据包的有效数据部分拷贝到tcp接收缓冲区中
+ * @brief 将tcp数据包的有效数据部分放入tcp接收队列中
+ *        调用前需保证数据包的起始序号不晚于接收窗口的nxt
  *
  * @param tcp
  * @param info
- * @return int 成功拷贝的数据长度
+ * @return int 成功放入的数据长度
  */
-static int copy_recv_data(tcp_t *tcp, tcp_info_t *info) {
-  // 获取接收缓冲区中可写入的空闲容量
-  int free_cnt = tcp_recv_window(tcp);
-  int cpy_len = MIN(free_cnt, info->data_len);  // 拷贝数据长度不能超过空闲容量
-  if (cpy_len <= 0) {
-    return cpy_len;
-  }
-
-  // 移动数据包的访问指针，以略过tcp头部
-  pktbuf_seek(info->tcp_buf,
-              tcp_get_hdr_size((tcp_hdr_t *)pktbuf_data_ptr(info->tcp_buf)));
-
-  // 计算写入偏移量
-  int offset = info->seq - tcp->recv.nxt;
-  if (offset < 0) {
-    return -1;
-  } 
-
-  // 从发送缓冲区中读取数据到tcp数据包中
-  return tcp_buf_write_from_pktbuf(&tcp->recv.buf, info->tcp_buf, offset,
-                                   cpy_len);  //!!! 数据包传递
+static int queue_recv_data(tcp_t *tcp, tcp_info_t *info) {
+  // 跳过已接收过的部分(重传的数据包可能与已接收的数据重叠)
+  int skip = (int)(tcp->recv.nxt - info->seq);
+  int data_len = (int)info->data_len - skip;
+  if (data_len <= 0) {
+    return 0;
+  }
+
+  // 略过tcp头部及已接收的数据, 放入的数据长度不能超过接收窗口
+  return tcp_rcvq_put(&tcp->recv.queue, info->tcp_buf,
+                      tcp_get_hdr_size(info->tcp_hdr) + skip,
+                      data_len);  //!!! 数据包引用
+}
+
+/**
+ * @brief 将乱序到达的数据包的有效数据拷贝到一个新的数据包中，并插入乱序队列
+ *        只缓存落在接收窗口内的数据, 乱序队列的容量由tcp_ooo_max_size根据当前接收缓冲区确定
+ *
+ * @param tcp
+ * @param info
+ */
+static void tcp_recv_ooo(tcp_t *tcp, tcp_info_t *info) {
+  int len = (int)info->data_len;
+  int fin = info->tcp_hdr->f_fin;
+
+  // 截断超出接收窗口的数据, 被截断的数据段不再包含fin
+  uint32_t win_end = tcp->recv.nxt + tcp_recv_window(tcp);
+  int win_len = (int)(win_end - info->seq);
+  if (len > win_len) {
+    len = win_len;
+    fin = 0;
+  }
+  if (len <= 0 && !fin) {
+    return;
+  }
+
+  // 只拷贝有效数据，使乱序队列独立持有数据包，且便于后续合并
+  pktbuf_t *buf = pktbuf_alloc(len);  //!!! 分配数据包
+  if (!buf) {
+    dbg_warning(DBG_TCP, "no free pktbuf for tcp ooo seg.");
+    return;
+  }
+  pktbuf_seek(info->tcp_buf, tcp_get_hdr_size(info->tcp_hdr));
+  if (pktbuf_copy(buf, info->tcp_buf, len) != NET_ERR_OK ||
+      tcp_ooo_insert(&tcp->recv.ooo, buf, info->seq, len, fin,
+                     tcp_ooo_max_size(tcp->recv.queue.size)) !=
+          NET_ERR_OK) {  //!!! 数据包传递
+    pktbuf_free(buf);  //!!! 释放数据包
+  }
 }
 
 /**
  * @brief 接收处理tcp包的有效数据部分(有保证的部分也就是有序号的部分),
- * 同时更新接收窗口信息，并发送ack确认
+ * 同时更新接收窗口信息，并发送ack确认(只接收到新的有序数据时延迟确认)
+ * 乱序到达的数据包将缓存到乱序队列中，并立即发送重复ack, 以通知对端数据空缺的位置
  *
  * @param tcp
  * @param info
@@ -164,20 +326,43 @@ net_err_t tcp_recv_data(tcp_t *tcp, tcp_info_t *info) {
   tcp_hdr_t *tcp_hdr = info->tcp_hdr;
 
   uint8_t wakeup = 0;  // 是否唤醒等待在tcp对象上的任务
+  int drained = 0;     // 是否从乱序队列中转移了数据
+  int ce = tcp_ecn_data_in(tcp, info);  // 是否开始回显新的拥塞通知
 
-  // 将数据包的有效数据部分拷贝到tcp接收缓冲区中, 并更新接收窗口信息
-  int cpy_len = copy_recv_data(tcp, info);
-  if (cpy_len < 0) {
-    dbg_error(DBG_TCP, "copy recv data failed, cpy len < 0.");
-    return NET_ERR_TCP;
-  } else if (cpy_len > 0) {
+  // 数据包的起始序号在nxt之后，即中间有数据空缺，缓存到乱序队列中,
+  // 并立即发送重复ack
+  if (tcp_seq_after(info->seq, tcp->recv.nxt)) {
+    if (info->seq_len) {
+      tcp_recv_ooo(tcp, info);
+      tcp_send_ack(tcp, info);
+    }
+    return NET_ERR_OK;
+  }
+
+  // 将数据包的有效数据部分放入tcp接收队列中, 并更新接收窗口信息
+  int cpy_len = queue_recv_data(tcp, info);
+  if (cpy_len > 0) {
     tcp->recv.nxt += cpy_len;  // 更新接收窗口的nxt
+    tcp->stats.bytes_received += cpy_len;
+    tcp_rcvbuf_data_in(tcp, info);
     wakeup++;
   }
 
   // 若fin有效, 且所有fin之前的数据都已接收完毕则对fin进行确认
-  // fin标志位不会携带数据，所以该fin包的seq号等于接收窗口的nxt即表示所有数据都已接收完毕
-  if (tcp_hdr->f_fin && (tcp->recv.nxt == info->seq)) {
+  // fin位于数据包有效数据之后，其序号等于接收窗口的nxt即表示所有数据都已接收完毕
+  int fin = tcp_hdr->f_fin && (tcp->recv.nxt == info->seq + info->data_len);
+
+  // 新数据填补了空缺，将乱序队列中已连续的数据转移到接收队列
+  if (cpy_len > 0 && !fin && !tcp_ooo_is_empty(&tcp->recv.ooo)) {
+    drained = tcp_ooo_drain(&tcp->recv.ooo, &tcp->recv.queue, &tcp->recv.nxt,
+                            &fin);
+    if (drained > 0) {
+      tcp->stats.bytes_received += drained;
+      wakeup++;
+    }
+  }
+
+  if (fin) {
     tcp->recv.nxt++;
     tcp->flags.fin_recved = 1;
     wakeup++;
@@ -186,16 +371,48 @@ net_err_t tcp_recv_data(tcp_t *tcp, tcp_info_t *info) {
   // 若成功处理完数据包，则唤醒等待在tcp对象上的任务
   if (wakeup) {
     if (tcp->flags.fin_recved) {
-      // 对端请求关闭连接, 唤醒等待在tcp对象上的所有任务
-      sock_wakeup(&tcp->sock_base, SOCK_WAIT_ALL, NET_ERR_TCP_CLOSE);
+      // 对端请求关闭连接, 唤醒等待在tcp对象上的所有任务,
+      // fin可能与数据一同到达，读取任务被唤醒后需继续读取缓冲区中剩余的数据
+      sock_wakeup(&tcp->sock_base, SOCK_WAIT_READ, NET_ERR_OK);
+      sock_wakeup(&tcp->sock_base, SOCK_WAIT_WRITE | SOCK_WAIT_CONN,
+                  NET_ERR_TCP_CLOSE);
     } else {
       // 成功接收数据包, 唤醒等待在tcp对象上的读取任务
       sock_wakeup(&tcp->sock_base, SOCK_WAIT_READ, NET_ERR_OK);
     }
 
-    // 发送ack确认
+    // 只接收到新的有序数据时延迟发送ack确认,
+    // fin请求、填补了空缺的数据及新的拥塞通知需要立即确认，以便对端尽快得知接收状态
+    if (fin || drained || ce || !tcp_ooo_is_empty(&tcp->recv.ooo)) {
+      tcp_send_ack(tcp, info);
+    } else {
+      tcp_delack_schedule(tcp, cpy_len);
+    }
+  } else if (info->seq_len) {
+    // 重复的数据包(之前的ack可能已丢失)，立即发送重复ack
     tcp_send_ack(tcp, info);
   }
 
   return NET_ERR_OK;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 接收以快速打开方式建立连接时SYN携带的数据, 在设置好接收窗口之后、发送SYN+ACK之前调用,
+ *        使SYN+ACK同时确认这部分数据; SYN携带的fin不处理, 由对端重传
+ *
+ * @param tcp
+ * @param info SYN数据包的信息
+ * @return int 放入接收队列的数据长度
+ */
+int tcp_recv_syn_data(tcp_t *tcp, tcp_info_t *info) {
+  // 数据从SYN之后的序号开始
+  tcp_info_t data_info = *info;
+  data_info.seq = info->seq + 1;
+
+  int cpy_len = queue_recv_data(tcp, &data_info);
+  if (cpy_len > 0) {
+    tcp->recv.nxt += cpy_len;
+    tcp->stats.bytes_received += cpy_len;
+  }
+  return cpy_len;
+}
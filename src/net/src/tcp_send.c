@@ -11,10 +11,18 @@
 
 #include "tcp_send.h"
 
+#include "ipv4.h"
 #include "protocol.h"
+#include "tcp_bbr.h"
 #include "tcp_buf.h"
+#include "tcp_ecn.h"
+#include "tcp_fastopen.h"
+#include "tcp_rack.h"
 #include "tools.h"
 
+static void tcp_persist_tmo(net_timer_t *timer, void *arg);
+static void tcp_persist_start(tcp_t *tcp);
+
 /**
  * @brief tcp协议层将tcp数据包下交给网络层处理
  *
@@ -30,10 +38,13 @@ static net_err_t tcp_send(tcp_hdr_t *tcp_hdr, pktbuf_t *tcp_buf,
   // 将tcp头部字段转换为网络字节序
   tcp_hdr_hton(tcp_hdr);
 
-  // 清空校验和字段, 并计算校验和
+  // 清空校验和字段, 并计算校验和,
+  // 超级数据段的校验和由分段卸载时对每个分段分别计算
   tcp_hdr->checksum = 0;
-  tcp_hdr->checksum =
-      tools_checksum16_pseudo_head(tcp_buf, dest_ip, src_ip, NET_PROTOCOL_TCP);
+  if (!tcp_buf->gso_size) {
+    tcp_hdr->checksum = tools_checksum16_pseudo_head(tcp_buf, dest_ip, src_ip,
+                                                     NET_PROTOCOL_TCP);
+  }
 
   // 通过网络层发送tcp数据包
   net_err_t err = ipv4_send(NET_PROTOCOL_TCP, dest_ip, src_ip, tcp_buf);
@@ -98,123 +109,835 @@ net_err_t tcp_send_reset(tcp_info_t *info) {
 }
 
 /**
- * @brief 将tcp发送缓冲区中的数据拷贝到待发送的tcp数据包中
- *        从缓冲区out指针偏移offset字节处开始读取数据
+ * @brief 使用SYN cookie作为初始序号，向发送连接请求的对端回复SYN+ACK
+ *        本地不保存连接状态，只携带cookie中编码的mss选项
  *
- * @param tcp
- * @param buf
- * @return int 拷贝数据的长度
+ * @param info 连接请求数据包的信息
+ * @param isn SYN cookie
+ * @param mss cookie中编码的mss
+ * @return net_err_t
  */
-static int copy_send_data(tcp_t *tcp, pktbuf_t *buf) {
-  // 获取发送缓冲区中待发送数据的长度, 数据长度不能超过mss
-  int valid_len = tcp_wait_send_data(tcp);
-  int cpy_len = MIN(valid_len, tcp->mss);
-  if (cpy_len <= 0) {
-    return cpy_len;
+net_err_t tcp_send_syncookie(tcp_info_t *info, uint32_t isn, uint16_t mss) {
+  // 分配一个数据包用于存放tcp头部及mss选项
+  int size = sizeof(tcp_hdr_t) + sizeof(tcp_opt_mss_t);
+  pktbuf_t *buf = pktbuf_alloc(size);  //!!! 分配数据包
+  if (!buf) {
+    dbg_warning(DBG_TCP, "no free pktbuf for tcp syncookie pkt.");
+    return NET_ERR_TCP;
+  }
+  net_err_t err = pktbuf_set_cont(buf, size);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "pktbuf set cont failed.");
+    pktbuf_free(buf);  //!!! 释放数据包
+    return err;
+  }
+
+  // 获取tcp数据包头部, 并填充头部字段
+  tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(buf);
+  tcp_hdr->src_port = info->tcp_hdr->dest_port;
+  tcp_hdr->dest_port = info->tcp_hdr->src_port;
+  tcp_hdr->seq = isn;
+  tcp_hdr->ack = info->seq + 1;  // 确认对端的syn请求
+  tcp_set_hdr_size(tcp_hdr, size);
+  tcp_hdr->reserved = 0;
+  tcp_hdr->flag = 0;
+  tcp_hdr->f_syn = 1;
+  tcp_hdr->f_ack = 1;
+  tcp_hdr->win_size = TCP_RBUF_SIZE;
+  tcp_hdr->urg_ptr = 0;
+
+  // 填充mss选项
+  tcp_opt_mss_t *opt_mss = (tcp_opt_mss_t *)(tcp_hdr + 1);
+  opt_mss->kind = TCP_OPT_MSS;
+  opt_mss->len = sizeof(tcp_opt_mss_t);
+  opt_mss->mss = net_htons(mss);
+
+  // 发送SYN+ACK数据包
+  err = tcp_send(tcp_hdr, buf, &info->remote_ip, &info->local_ip);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp send syncookie failed.");
+    pktbuf_free(buf);  //!!! 释放数据包
   }
 
-  // 对数据包进行扩容，以容纳新的数据
-  net_err_t err = pktbuf_resize(buf, pktbuf_total_size(buf) + cpy_len);
+  return err;
+}
+
+/**
+ * @brief 由TIME_WAIT记录发送ack, 告知对端本地的接收位置
+ *        连接使用了时间戳选项时同样需要携带, 否则对端可能丢弃该ack
+ *
+ * @param tw
+ * @return net_err_t
+ */
+net_err_t tcp_send_tw_ack(tcp_tw_t *tw) {
+  // 分配一个数据包用于存放tcp头部及时间戳选项
+  int opt_size = tw->ts_ok ? 2 + sizeof(tcp_opt_ts_t) : 0;
+  int size = sizeof(tcp_hdr_t) + opt_size;
+  pktbuf_t *buf = pktbuf_alloc(size);  //!!! 分配数据包
+  if (!buf) {
+    dbg_warning(DBG_TCP, "no free pktbuf for tcp time wait ack.");
+    return NET_ERR_TCP;
+  }
+  net_err_t err = pktbuf_set_cont(buf, size);
   if (err != NET_ERR_OK) {
-    dbg_error(DBG_TCP, "pktbuf resize failed.");
-    return -1;
+    dbg_error(DBG_TCP, "pktbuf set cont failed.");
+    pktbuf_free(buf);  //!!! 释放数据包
+    return err;
   }
 
-  // 移动数据包的访问指针，以略过tcp头部
-  pktbuf_seek(buf, tcp_get_hdr_size((tcp_hdr_t *)pktbuf_data_ptr(buf)));
+  // 获取tcp数据包头部, 并填充头部字段
+  tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(buf);
+  tcp_hdr->src_port = tw->sock_base.local_port;
+  tcp_hdr->dest_port = tw->sock_base.remote_port;
+  tcp_hdr->seq = tw->snd_nxt;
+  tcp_hdr->ack = tw->rcv_nxt;
+  tcp_set_hdr_size(tcp_hdr, size);
+  tcp_hdr->reserved = 0;
+  tcp_hdr->flag = 0;
+  tcp_hdr->f_ack = 1;
+  tcp_hdr->win_size = tw->rcv_wnd;
+  tcp_hdr->urg_ptr = 0;
+
+  // 填充时间戳选项, 使用两个NOP选项填充，使时间戳字段4字节对齐
+  if (tw->ts_ok) {
+    uint8_t *opt = (uint8_t *)(tcp_hdr + 1);
+    opt[0] = opt[1] = TCP_OPT_NOP;
+    tcp_opt_ts_t *opt_ts = (tcp_opt_ts_t *)(opt + 2);
+    opt_ts->kind = TCP_OPT_TS;
+    opt_ts->len = sizeof(tcp_opt_ts_t);
+    opt_ts->ts_val = net_htonl(tcp_time_now());
+    opt_ts->ts_ecr = net_htonl(tw->ts_recent);
+  }
 
-  // 从发送缓冲区中读取数据到tcp数据包中
-  return tcp_buf_read_to_pktbuf(&tcp->send.buf, buf, tcp_wait_ack_data(tcp),
-                                cpy_len);  //!!! 数据包传递
+  err = tcp_send(tcp_hdr, buf, &tw->sock_base.remote_ip,
+                 &tw->sock_base.local_ip);
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp send time wait ack failed.");
+    pktbuf_free(buf);  //!!! 释放数据包
+  }
+
+  return err;
 }
 
 /**
- * @brief 根据tcp对象的状态，创建并发送一个tcp数据包
+ * @brief 将tcp发送缓冲区中的数据添加到待发送的tcp数据包(tcp头部之后)中
+ *        从缓冲区out指针偏移offset字节处开始读取len字节数据,
+ *        零拷贝发送的数据由数据包直接引用，不进行拷贝
  *
  * @param tcp
- * @return net_err_t
+ * @param buf
+ * @param offset
+ * @param len
+ * @return int 添加数据的长度
  */
-net_err_t tcp_transmit(tcp_t *tcp) {
-  net_err_t err = NET_ERR_OK;
+static int copy_send_data(tcp_t *tcp, pktbuf_t *buf, int offset, int len) {
+  if (len <= 0) {
+    return len;
+  }
 
-  // 获取tcp对象的发送缓冲区中待发送数据的长度，并判断是否需要发送一个tcp数据包
-  int wait_data_len = tcp_wait_send_data(tcp);
-  if (wait_data_len < 0) {
-    dbg_error(DBG_TCP, "tcp send buf error, wait_send_data can't < 0.");
-    return NET_ERR_TCP;
+  // 从发送缓冲区中读取数据追加到tcp数据包尾部
+  return tcp_buf_read_to_pktbuf(&tcp->send.buf, buf, offset,
+                                len);  //!!! 数据包传递
+}
+
+/**
+ * @brief 获取需要向对端通告的接收窗口, 接收方避免糊涂窗口综合症(RFC 1122 4.2.3.3):
+ *        应用程序每次只读取少量数据时, 窗口右边界推进不足阈值则继续通告原来的右边界,
+ *        避免对端按逐渐打开的小窗口发送大量小数据段; 已通告的窗口不会收回
+ *
+ * @param tcp
+ * @param syn 是否为SYN数据包, 此时还未通告过窗口
+ * @return uint16_t
+ */
+static uint16_t tcp_recv_wnd_advertise(tcp_t *tcp, int syn) {
+  int win = tcp_recv_window(tcp);
+  if (syn || !tcp->flags.recv_win_valid) {
+    return win;
   }
-  int seq_len =
-      tcp->flags.syn_need_send + tcp->flags.fin_need_send + wait_data_len;
-  if (seq_len == 0) {  // 没有数据或请求需要发送，直接返回
-    return NET_ERR_OK;
+
+  // 接收了越过通告窗口的零窗口探测时, 原来的右边界已在nxt之前
+  int old = (int)(tcp->recv.wnd_edge - tcp->recv.nxt);
+  if (win > old && win - old < tcp_recv_wnd_thresh(tcp)) {
+    win = MAX(old, 0);
   }
+  return win;
+}
 
+/**
+ * @brief 分配一个tcp数据包，并根据tcp对象的信息填充头部字段及选项
+ *
+ * @param tcp
+ * @param seq 数据包的序号
+ * @param syn 是否设置SYN标志位
+ * @param fin 是否设置FIN标志位
+ * @param ack 是否设置ACK标志位
+ * @return pktbuf_t*
+ */
+static pktbuf_t *tcp_pkt_alloc(tcp_t *tcp, uint32_t seq, int syn, int fin,
+                               int ack) {
   // 分配一个数据包用于存放tcp数据包
   pktbuf_t *buf = pktbuf_alloc(sizeof(tcp_hdr_t));  //!!! 分配数据包
   if (!buf) {
     dbg_warning(DBG_TCP, "no free pktbuf for tcp pkt.");
-    return NET_ERR_TCP;
+    return (pktbuf_t *)0;
   }
 
   // 获取tcp数据包头部, 并填充头部字段
   tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(buf);
   tcp_hdr->src_port = tcp->sock_base.local_port;
   tcp_hdr->dest_port = tcp->sock_base.remote_port;
-  tcp_hdr->seq = tcp->send.nxt;  // 设置序号位发送窗口的下一个待发送数据段序号
+  tcp_hdr->seq = seq;
   tcp_hdr->ack = tcp->recv.nxt;  // 设置确认号为接收窗口的下一个待接收数据段序号
   tcp_hdr->reserved = 0;  // 清空保留字段
   tcp_hdr->flag = 0;      // 清空标志位
-  // 根据tcp标志的syn_need_send位来设置SYN标志位，以请求连接
-  tcp_hdr->f_syn = tcp->flags.syn_need_send;
-  // 根据tcp标志的fin_need_send标志位来设置FIN标志位，以请求关闭连接,
-  // 且发送缓冲区中无待发送数据时，才能发送fin请求
-  tcp_hdr->f_fin = (wait_data_len == 0 ? tcp->flags.fin_need_send : 0);
-  // 根据tcp标志的recv_win_valid标志位来设置ACK标志位，确认已收到的tcp数据包
-  tcp_hdr->f_ack = tcp->flags.recv_win_valid;
-  tcp_hdr->win_size = tcp_recv_window(tcp);  // 设置窗口大小
-  tcp_hdr->urg_ptr = 0;      // 紧急指针
-  if (tcp_hdr->f_syn) {      // 若发送syn请求，则需要设置mss选项
-    err = tcp_write_options(tcp, buf);
-    if (err != NET_ERR_OK) {
-      goto tcp_transmit_failed;
-    }
+  tcp_hdr->f_syn = syn;
+  tcp_hdr->f_fin = fin;
+  tcp_hdr->f_ack = ack;
+  tcp_ecn_hdr_out(tcp, tcp_hdr);  // 设置ECE及CWR标志位
+  tcp_hdr->win_size = tcp_recv_wnd_advertise(tcp, syn);  // 设置窗口大小
+  tcp_hdr->urg_ptr = 0;                      // 紧急指针
+  tcp->recv.wnd_edge = tcp->recv.nxt + tcp_hdr->win_size;
+
+  // 填充tcp选项(mss及时间戳)
+  if (tcp_write_options(tcp, buf) != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp write options failed.");
+    pktbuf_free(buf);  //!!! 释放数据包
+    return (pktbuf_t *)0;
   }
   tcp_set_hdr_size(tcp_hdr, pktbuf_total_size(buf));  // 设置tcp数据包头部长度
 
-  // 记录tcp头部syn或fin标志位是否设置成功
-  int temp_syn = tcp_hdr->f_syn;
-  int temp_fin = tcp_hdr->f_fin;
+  // 记录最近一次发送的ack号, 用于更新需要回显的时间戳,
+  // 且该ack已捎带了对所有已接收数据的确认，取消延迟确认
+  if (ack) {
+    tcp->ts.last_ack_sent = tcp->recv.nxt;
+    tcp_delack_stop(tcp);
+  }
+
+  return buf;
+}
+
+/**
+ * @brief 判断是否推迟发送一个不足mss的小数据段
+ *        TCP_CORK: 塞住期间只发送满mss的数据段
+ *        Nagle算法(RFC 896): 有已发送但未确认的数据时，推迟发送小数据段,
+ *        等待ack到达或累积满mss后再发送, 可通过TCP_NODELAY关闭
+ *
+ * @param tcp
+ * @return int 1: 推迟发送, 0: 立即发送
+ */
+static int tcp_nagle_defer(tcp_t *tcp) {
+  if (tcp->flags.cork) {
+    return 1;
+  }
+
+  if (tcp->flags.nodelay) {
+    return 0;
+  }
+
+  return tcp_wait_ack_data(tcp) > 0;
+}
+
+/**
+ * @brief 获取一个tcp数据包(超级数据段)可携带的最大数据量,
+ *        为mss的整数倍, 且整个ip数据包不超过TCP_GSO_MAX_SIZE
+ *
+ * @param tcp
+ * @return int
+ */
+static int tcp_send_max(tcp_t *tcp) {
+  int mss = tcp_send_mss(tcp);
+  int max = TCP_GSO_MAX_SIZE - (int)sizeof(ipv4_hdr_t) -
+            (int)sizeof(tcp_hdr_t) - (tcp->mss - mss);
+  return max > mss ? max / mss * mss : mss;
+}
+
+/**
+ * @brief 获取tcp连接的发送速率: 拥塞控制算法给出的速率与SO_MAX_PACING_RATE中的较小值
+ *
+ * @param tcp
+ * @return uint32_t 字节/s, 为0表示不限制发送速率
+ */
+static uint32_t tcp_pacing_rate(tcp_t *tcp) {
+  uint32_t rate = tcp->pacing.rate;
+  uint32_t max_rate = tcp->pacing.max_rate;
+  if (!rate || (max_rate && max_rate < rate)) {
+    return max_rate;
+  }
+  return rate;
+}
+
+/**
+ * @brief 按经过的时间累积发送额度并返回当前的额度
+ *        额度不超过TCP_PACING_BURST_MS内按速率可发送的数据量(至少两个mss),
+ *        空闲一段时间后重新发送时不会突发发送大量数据
+ *
+ * @param tcp
+ * @param rate 发送速率(字节/s)
+ * @return int
+ */
+static int tcp_pacing_credit(tcp_t *tcp, uint32_t rate) {
+  uint32_t now = tcp_time_now();
+  int elapsed = (int)(now - tcp->pacing.stamp);
+  uint64_t add = elapsed > 0 ? (uint64_t)rate * elapsed / 1000 : 0;
+  if (add) {  // 速率较低时不足一个字节的部分留到下次累积
+    tcp->pacing.credit = (int)MIN(tcp->pacing.credit + (int64_t)add,
+                                  (int64_t)0x7fffffff);
+    tcp->pacing.stamp = now;
+  }
+
+  uint64_t burst = (uint64_t)rate * TCP_PACING_BURST_MS / 1000;
+  burst = MAX(burst, 2U * tcp_send_mss(tcp));
+  if (tcp->pacing.credit > 0 && (uint64_t)tcp->pacing.credit > burst) {
+    tcp->pacing.credit = (int)burst;
+  }
+  return tcp->pacing.credit;
+}
+
+/**
+ * @brief 发送节奏定时器超时处理函数, 发送额度已恢复, 继续发送数据
+ *
+ * @param timer
+ * @param arg
+ */
+static void tcp_pacing_tmo(net_timer_t *timer, void *arg) {
+  tcp_transmit((tcp_t *)arg);
+}
+
+/**
+ * @brief 发送额度已用完, 启动发送节奏定时器, 在额度恢复为正值后继续发送
+ *
+ * @param tcp
+ * @param rate 发送速率(字节/s)
+ */
+static void tcp_pacing_schedule(tcp_t *tcp, uint32_t rate) {
+  if (tcp->pacing.timer.flags & NET_TIMER_ACTIVE) {
+    return;
+  }
+
+  uint64_t need = (uint64_t)(1 - (int64_t)tcp->pacing.credit);
+  int tmo = (int)MIN((need * 1000 + rate - 1) / rate, (uint64_t)TCP_RTO_MAX);
+  net_timer_add(&tcp->pacing.timer, "tcp pacing", tcp_pacing_tmo, tcp,
+                MAX(tmo, 1), NET_TIMER_ACTIVE);
+}
+
+/**
+ * @brief 停止发送节奏定时器
+ *
+ * @param tcp
+ */
+void tcp_pacing_stop(tcp_t *tcp) {
+  if (tcp->pacing.timer.flags & NET_TIMER_ACTIVE) {
+    net_timer_remove(&tcp->pacing.timer);
+  }
+}
+
+/**
+ * @brief 从发送窗口的nxt处创建并发送一个tcp数据包
+ *
+ * @param tcp
+ * @param data_len 数据包携带的数据长度
+ * @param syn 是否设置SYN标志位
+ * @param fin 是否设置FIN标志位
+ * @return net_err_t
+ */
+static net_err_t tcp_transmit_seg(tcp_t *tcp, int data_len, int syn,
+                                  int fin) {
+  net_err_t err = NET_ERR_OK;
+
+  // 分配tcp数据包并填充头部,
+  // 根据tcp标志的recv_win_valid标志位来设置ACK标志位，确认已收到的tcp数据包
+  pktbuf_t *buf = tcp_pkt_alloc(tcp, tcp->send.nxt, syn, fin,
+                                tcp->flags.recv_win_valid);  //!!! 分配数据包
+  if (!buf) {
+    return NET_ERR_TCP;
+  }
+  tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(buf);
 
-  // 从发送缓冲区中读取数据到tcp数据包中,
+  // 数据超过一个mss时作为超级数据段下交，由网络接口按mss进行分段
+  if (data_len > tcp_send_mss(tcp)) {
+    buf->gso_size = tcp_send_mss(tcp);
+  }
+
+  // 携带新数据时设置ECT码点, SYN不能设置(RFC 3168)
+  if (data_len && !syn) {
+    tcp_ecn_data_out(tcp, tcp_hdr, buf);
+  }
+
+  // 从发送缓冲区中读取待发送的数据到tcp数据包中,
   // 并通过tcp_send将tcp数据包下交给网络层处理
-  int data_len = copy_send_data(tcp, buf);  //!!! 数据包传递
-  if (data_len < 0) {
-    goto tcp_transmit_failed;
+  if (copy_send_data(tcp, buf, tcp_wait_ack_data(tcp), data_len) <
+      0) {  //!!! 数据包传递
+    goto tcp_transmit_seg_failed;
   }
   err = tcp_send(tcp_hdr, buf, &tcp->sock_base.remote_ip,
                  &tcp->sock_base.local_ip);  //!!! 数据包传递
   if (err != NET_ERR_OK) {
-    goto tcp_transmit_failed;
+    goto tcp_transmit_seg_failed;
+  }
+
+  // 未协商时间戳选项时，选择一个数据段进行计时以采样rtt
+  if (!tcp->flags.ts_ok && !tcp->flags.rtt_timing) {
+    tcp->flags.rtt_timing = 1;
+    tcp->rtt.seq = tcp->send.nxt;
+    tcp->rtt.time = tcp_time_now();
+  }
+
+  // 使用BBR时选择一个数据段采样交付速率
+  if (data_len) {
+    tcp_bbr_on_send(tcp, data_len);
   }
 
   // tcp数据包发送成功，更新发送窗口信息(syn号和fin号都需要占用一个序号位)和标志位,
-  tcp->send.nxt += (temp_syn + temp_fin + data_len);
-  if (temp_syn) {
+  tcp->send.nxt += (syn + fin + data_len);
+  tcp->stats.segs_out++;
+  tcp_rack_on_send(tcp);
+  if (syn) {
     tcp->flags.syn_need_send = 0;
     tcp->flags.syn_need_ack = 1;
   }
-  if (temp_fin) {
+  if (fin) {
     tcp->flags.fin_need_send = 0;
     tcp->flags.fin_need_ack = 1;
   }
+
+  // 有数据等待确认，若重传定时器未启动则启动, 窗口已打开, 退出坚持状态
+  if (!(tcp->rtt.timer.flags & NET_TIMER_ACTIVE)) {
+    tcp_rto_start(tcp);
+  }
+  tcp_persist_stop(tcp);
   return NET_ERR_OK;
 
-tcp_transmit_failed:
+tcp_transmit_seg_failed:
   dbg_error(DBG_TCP, "tcp transmit failed.");
   pktbuf_free(buf);  //!!! 释放数据包
   return err == NET_ERR_OK ? NET_ERR_TCP : err;
 }
 
+/**
+ * @brief 根据tcp对象的状态，持续发送tcp数据包,
+ *        直到待发送的数据及请求发送完毕, 或填满发送窗口(对端接收窗口与拥塞窗口的较小值),
+ *        限制了发送速率时还需有发送额度, 额度用完后由发送节奏定时器继续发送
+ *
+ * @param tcp
+ * @return net_err_t
+ */
+net_err_t tcp_transmit(tcp_t *tcp) {
+  // 对端打开窗口时探测的字节可能未被确认(已被对端丢弃或仍在途中),
+  // 回退nxt, 该字节与之后的数据一起按窗口重新发送
+  if (tcp->persist.probe_sent && tcp->send.win) {
+    tcp->persist.probe_sent = 0;
+    tcp->send.nxt = tcp->send.una;
+  }
+
+  while (1) {
+    uint32_t rate = 0;  // 发送速率, 为0表示不限制
+
+    // 获取tcp对象的发送缓冲区中待发送数据的长度，并判断是否需要发送一个tcp数据包
+    int wait_data_len = tcp_wait_send_data(tcp);
+    if (wait_data_len < 0) {
+      dbg_error(DBG_TCP, "tcp send buf error, wait_send_data can't < 0.");
+      return NET_ERR_TCP;
+    }
+    int seq_len =
+        tcp->flags.syn_need_send + tcp->flags.fin_need_send + wait_data_len;
+    if (seq_len == 0) {  // 没有数据或请求需要发送，直接返回
+      return NET_ERR_OK;
+    }
+
+    // 根据tcp标志的syn_need_send位来设置SYN标志位，以请求连接,
+    // syn请求不受发送窗口限制, 只在快速打开时携带数据
+    int syn = tcp->flags.syn_need_send;
+    int data_len = 0;
+    if (syn) {
+      data_len = tcp_fastopen_syn_data(tcp, wait_data_len);
+    } else {
+      // 数据长度不能超过超级数据段的最大数据量及发送窗口中剩余的空间,
+      // 之后还有待发送的数据时，超级数据段只携带mss整数倍的数据，避免分段后产生小数据段
+      int win = tcp_send_window(tcp);
+      int mss = tcp_send_mss(tcp);
+      data_len = MIN(wait_data_len, tcp_send_max(tcp));
+      data_len = MIN(data_len, MAX(win, 0));
+      if (data_len > mss && data_len < wait_data_len) {
+        data_len -= data_len % mss;
+      }
+
+      // 对端接收窗口为0且没有未确认的数据时，进入坚持状态,
+      // 定时发送窗口探测，直到对端通告新的窗口(已在坚持状态时探测的字节可能在途)
+      if (data_len == 0 && wait_data_len > 0 && tcp->send.win == 0 &&
+          (tcp->send.una == tcp->send.nxt || tcp->persist.probe_sent)) {
+        tcp_persist_start(tcp);
+        return NET_ERR_OK;
+      }
+
+      // 限制了发送速率时, 数据量不超过当前的发送额度(至少一个mss),
+      // 额度已用完时等待发送节奏定时器在额度恢复后继续发送
+      rate = tcp_pacing_rate(tcp);
+      if (rate && data_len > 0) {
+        int credit = tcp_pacing_credit(tcp, rate);
+        if (credit <= 0) {
+          tcp_pacing_schedule(tcp, rate);
+          return NET_ERR_OK;
+        }
+        data_len = MIN(data_len, MAX(credit / mss * mss, mss));
+      }
+    }
+
+    // 根据tcp标志的fin_need_send标志位来设置FIN标志位，以请求关闭连接,
+    // 且待发送的数据全部发送后，才能发送fin请求
+    int fin = (data_len == wait_data_len ? tcp->flags.fin_need_send : 0);
+    if (syn + fin + data_len == 0) {  // 发送窗口已满
+      return NET_ERR_OK;
+    }
+
+    // 不足mss的小数据段:
+    // 受发送窗口限制时, 若还有未确认的数据则等待ack打开更大的窗口(避免糊涂窗口综合症),
+    // 否则根据Nagle算法及TCP_CORK决定是否推迟发送,
+    // 已请求关闭连接时不再推迟，以尽快发送剩余数据及fin
+    if (!syn && !tcp->flags.fin_need_send && data_len < tcp_send_mss(tcp)) {
+      int defer = (data_len < wait_data_len) ? tcp_wait_ack_data(tcp) > 0
+                                             : tcp_nagle_defer(tcp);
+      if (defer) {
+        return NET_ERR_OK;
+      }
+    }
+
+    net_err_t err = tcp_transmit_seg(tcp, data_len, syn, fin);
+    if (err != NET_ERR_OK) {
+      return err;
+    }
+    if (rate) {
+      tcp->pacing.credit -= data_len;
+    }
+  }
+}
+
+/**
+ * @brief 重传发送缓冲区中offset处data_len长度的已发送数据, 以及syn或fin请求
+ *
+ * @param tcp
+ * @param offset 数据在发送缓冲区中的偏移, 携带syn时只能为0
+ * @param data_len
+ * @param syn
+ * @param fin
+ * @return net_err_t
+ */
+static net_err_t tcp_retransmit_seg(tcp_t *tcp, int offset, int data_len,
+                                    int syn, int fin) {
+  net_err_t err = NET_ERR_OK;
+
+  // 分配tcp数据包并填充头部, 未确认的数据从una(syn已确认时)开始
+  uint32_t seq = tcp->send.una + offset;
+  pktbuf_t *buf = tcp_pkt_alloc(tcp, seq, syn, fin,
+                                tcp->flags.recv_win_valid);  //!!! 分配数据包
+  if (!buf) {
+    return NET_ERR_TCP;
+  }
+  tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(buf);
+
+  // 从发送缓冲区中读取待重传的数据到tcp数据包中，并发送
+  if (copy_send_data(tcp, buf, offset, data_len) < 0) {  //!!! 数据包传递
+    goto tcp_retransmit_failed;
+  }
+  err = tcp_send(tcp_hdr, buf, &tcp->sock_base.remote_ip,
+                 &tcp->sock_base.local_ip);  //!!! 数据包传递
+  if (err != NET_ERR_OK) {
+    goto tcp_retransmit_failed;
+  }
+
+  tcp_rack_on_retransmit(tcp, seq, seq + syn + data_len + fin);
+  tcp->stats.segs_out++;
+  tcp->stats.retrans++;
+  return NET_ERR_OK;
+
+tcp_retransmit_failed:
+  dbg_error(DBG_TCP, "tcp retransmit failed.");
+  pktbuf_free(buf);  //!!! 释放数据包
+  return err == NET_ERR_OK ? NET_ERR_TCP : err;
+}
+
+/**
+ * @brief 重传发送窗口中最早的一个未确认的数据段(包括syn和fin请求)
+ *
+ * @param tcp
+ * @return net_err_t
+ */
+net_err_t tcp_retransmit(tcp_t *tcp) {
+  // 计算需要重传的数据长度，并判断是否需要携带syn或fin请求
+  int wait_ack_len = tcp_wait_ack_data(tcp);
+  int data_len = MIN(wait_ack_len, tcp_send_mss(tcp));
+  int syn = tcp->flags.syn_need_ack;
+  int fin = (data_len == wait_ack_len ? tcp->flags.fin_need_ack : 0);
+  if (syn + fin + data_len == 0) {  // 没有未确认的数据或请求，直接返回
+    return NET_ERR_OK;
+  }
+
+  return tcp_retransmit_seg(tcp, 0, data_len, syn, fin);
+}
+
+/**
+ * @brief 重传发送窗口中最后一个已发送的数据段(包括fin请求), 用作尾部丢失探测
+ *
+ * @param tcp
+ * @return net_err_t
+ */
+net_err_t tcp_retransmit_tail(tcp_t *tcp) {
+  if (tcp->flags.syn_need_ack) {  // syn还未被确认, 只能从头重传
+    return tcp_retransmit(tcp);
+  }
+
+  int wait_ack_len = tcp_wait_ack_data(tcp);
+  int data_len = MIN(wait_ack_len, tcp_send_mss(tcp));
+  int fin = tcp->flags.fin_need_ack;
+  if (fin + data_len == 0) {
+    return NET_ERR_OK;
+  }
+
+  return tcp_retransmit_seg(tcp, wait_ack_len - data_len, data_len, 0, fin);
+}
+
+/**
+ * @brief 发送零窗口探测: 携带发送缓冲区中的一个字节(RFC 9293 3.8.6.1)
+ *        第一个探测发送下一个待发送的字节并将nxt推进一个字节, 之后的探测重发该字节(序号为una)
+ *        对端窗口仍为0时丢弃该字节并回复ack告知当前窗口; 窗口已打开时接收该字节并确认
+ *        探测的字节由坚持定时器重发, 不需要重传定时器
+ *
+ * @param tcp
+ * @return net_err_t
+ */
+static net_err_t tcp_send_probe(tcp_t *tcp) {
+  int probe_sent = tcp->send.una != tcp->send.nxt;
+  pktbuf_t *buf = tcp_pkt_alloc(tcp, tcp->send.una, 0, 0,
+                                tcp->flags.recv_win_valid);  //!!! 分配数据包
+  if (!buf) {
+    return NET_ERR_TCP;
+  }
+
+  net_err_t err = NET_ERR_TCP;
+  if (copy_send_data(tcp, buf, 0, 1) == 1) {  //!!! 数据包传递
+    err = tcp_send((tcp_hdr_t *)pktbuf_data_ptr(buf), buf,
+                   &tcp->sock_base.remote_ip,
+                   &tcp->sock_base.local_ip);  //!!! 数据包传递
+  }
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp send probe failed.");
+    pktbuf_free(buf);  //!!! 释放数据包
+    return err;
+  }
+  if (!probe_sent) {
+    tcp->send.nxt++;
+    tcp->persist.probe_sent = 1;
+  }
+  tcp->stats.segs_out++;
+  tcp->stats.zwnd_probes++;
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 以rto * 2^backoff(不超过TCP_RTO_MAX)为超时时间启动坚持定时器
+ *
+ * @param tcp
+ */
+static void tcp_persist_schedule(tcp_t *tcp) {
+  int tmo = MAX(tcp->rtt.rto, TCP_RTO_MIN);
+  for (int i = 0; i < tcp->persist.backoff && tmo < TCP_RTO_MAX; i++) {
+    tmo *= 2;
+  }
+  net_timer_add(&tcp->persist.timer, "tcp persist", tcp_persist_tmo, tcp,
+                MIN(tmo, TCP_RTO_MAX), NET_TIMER_ACTIVE);
+}
+
+/**
+ * @brief 坚持定时器超时处理函数: 对端仍为零窗口时发送窗口探测并加倍探测间隔,
+ *        对端响应的ack会清零未响应的探测数, 对端长时间零窗口不会中止连接,
+ *        连续TCP_RETRY_MAX个探测都未得到响应时认为连接已断开
+ *
+ * @param timer
+ * @param arg
+ */
+static void tcp_persist_tmo(net_timer_t *timer, void *arg) {
+  tcp_t *tcp = (tcp_t *)arg;
+
+  // 窗口已打开时按窗口继续发送(包括未被确认的探测字节), 发送缓冲区已空时无需探测
+  if (tcp->send.win) {
+    tcp_transmit(tcp);
+    return;
+  }
+  if (tcp_buf_cnt(&tcp->send.buf) <= 0) {
+    return;
+  }
+
+  if (++tcp->persist.probes > TCP_RETRY_MAX) {
+    dbg_warning(DBG_TCP, "tcp zero window probe no response, abort connect.");
+    tcp_abort_connect(tcp, NET_ERR_TIMEOUT);
+    return;
+  }
+
+  dbg_info(DBG_TCP, "tcp zero window probe, backoff: %d.", tcp->persist.backoff);
+  tcp_send_probe(tcp);
+  tcp->persist.backoff++;
+  tcp_persist_schedule(tcp);
+}
+
+/**
+ * @brief 对端零窗口且没有未确认的数据时进入坚持状态, 已在坚持状态时不重新计时
+ *
+ * @param tcp
+ */
+static void tcp_persist_start(tcp_t *tcp) {
+  if (tcp->persist.timer.flags & NET_TIMER_ACTIVE) {
+    return;
+  }
+  tcp->persist.backoff = 0;
+  tcp->persist.probes = 0;
+  tcp_persist_schedule(tcp);
+}
+
+/**
+ * @brief 退出坚持状态, 停止坚持定时器
+ *
+ * @param tcp
+ */
+void tcp_persist_stop(tcp_t *tcp) {
+  if (tcp->persist.timer.flags & NET_TIMER_ACTIVE) {
+    net_timer_remove(&tcp->persist.timer);
+  }
+}
+
+/**
+ * @brief 重传定时器超时处理函数, 重传最早的未确认数据段并加倍重传超时时间
+ *
+ * @param timer
+ * @param arg
+ */
+static void tcp_rto_tmo(net_timer_t *timer, void *arg) {
+  tcp_t *tcp = (tcp_t *)arg;
+
+  // 所有数据都已确认，无需重传(零窗口时由坚持定时器发送窗口探测)
+  if (tcp->send.una == tcp->send.nxt) {
+    return;
+  }
+
+  // 超过最大重传次数，认为连接已断开
+  if (++tcp->rtt.retry > TCP_RETRY_MAX) {
+    dbg_warning(DBG_TCP, "tcp retransmit too many times, abort connect.");
+    tcp_abort_connect(tcp, NET_ERR_TIMEOUT);
+    return;
+  }
+
+  // 指数退避，并放弃当前的rtt计时(Karn算法, 无法区分ack确认的是哪一次发送)
+  tcp->rtt.rto = MIN(tcp->rtt.rto * 2, TCP_RTO_MAX);
+  tcp->flags.rtt_timing = 0;
+
+  // 超时重传视为发生拥塞, 减半慢启动阈值并从一个mss重新开始慢启动(RFC 5681)
+  // 对端零窗口时的探测超时不是拥塞造成的
+  // BBR不因丢包减小带宽模型, 只从一个mss开始恢复拥塞窗口
+  if (tcp->send.win && tcp->cc == TCP_CC_BBR) {
+    tcp_bbr_on_rto(tcp);
+  } else if (tcp->send.win) {
+    uint32_t flight = tcp->send.nxt - tcp->send.una;
+    tcp->send.ssthresh = MAX(flight / 2, 2U * tcp->mss);
+    tcp->send.cwnd = tcp->mss;
+  }
+
+  // 进入恢复阶段, 之后超时前发送的数据每被部分确认一次, 就立即重传下一个未确认的数据段
+  if (!tcp->flags.recovery && tcp->send.win) {
+    tcp->flags.recovery = 1;
+    tcp->send.recover = tcp->send.nxt;
+  }
+
+  dbg_info(DBG_TCP, "tcp rto timeout, retry: %d, rto: %d ms.", tcp->rtt.retry,
+           tcp->rtt.rto);
+  tcp->stats.rto_cnt++;
+  tcp_rack_on_rto(tcp);
+  tcp_retransmit(tcp);
+  tcp_rto_start(tcp);
+}
+
+/**
+ * @brief 获取重传定时器的超时时间: 在途数据不超过一个数据段时对端可能正在延迟确认,
+ *        在重传超时时间上再加上最大延迟确认时间, 避免在对端的延迟确认到达前超时重传;
+ *        对端总是立即确认syn请求, 握手期间不需要等待
+ *
+ * @param tcp
+ * @return int 超时时间(ms)
+ */
+int tcp_rto_get(tcp_t *tcp) {
+  uint32_t flight = tcp->send.nxt - tcp->send.una;
+  if (!tcp->flags.syn_need_ack && flight <= (uint32_t)tcp_send_mss(tcp)) {
+    return tcp->rtt.rto + TCP_DELACK_TMO;
+  }
+  return tcp->rtt.rto;
+}
+
+/**
+ * @brief 以当前的重传超时时间(重新)启动重传定时器
+ *
+ * @param tcp
+ */
+void tcp_rto_start(tcp_t *tcp) {
+  tcp_rto_stop(tcp);
+  net_timer_add(&tcp->rtt.timer, "tcp rto", tcp_rto_tmo, tcp, tcp_rto_get(tcp),
+                NET_TIMER_ACTIVE);
+}
+
+/**
+ * @brief 停止重传定时器
+ *
+ * @param tcp
+ */
+void tcp_rto_stop(tcp_t *tcp) {
+  if (tcp->rtt.timer.flags & NET_TIMER_ACTIVE) {
+    net_timer_remove(&tcp->rtt.timer);
+  }
+}
+
+/**
+ * @brief 延迟确认定时器超时处理函数, 对已接收的数据发送ack确认
+ *
+ * @param timer
+ * @param arg
+ */
+static void tcp_delack_tmo(net_timer_t *timer, void *arg) {
+  tcp_send_ack((tcp_t *)arg, (tcp_info_t *)0);
+}
+
+/**
+ * @brief 接收到新的有序数据后，延迟发送ack确认(RFC 1122)
+ *        累积接收的数据超过一个满长度报文段(即至少两个报文段)时立即确认,
+ *        满足RFC 1122至少每两个满长度报文段确认一次的要求,
+ *        否则等待定时器超时确认, 期间若有数据发送，则ack由数据包捎带
+ *
+ * @param tcp
+ * @param len 新接收的数据长度
+ */
+void tcp_delack_schedule(tcp_t *tcp, int len) {
+  tcp->delack.bytes += len;
+
+  // 对端发送的满长度报文段同样需要携带选项，以此计算满长度报文段的数据量,
+  // 对端受窗口限制时可能只发送一个满长度报文段加一个小报文段，不能等满两个mss
+  if (tcp->flags.quick_ack || tcp->delack.bytes > tcp_send_mss(tcp)) {
+    tcp_send_ack(tcp, (tcp_info_t *)0);
+    return;
+  }
+
+  if (!(tcp->delack.timer.flags & NET_TIMER_ACTIVE)) {
+    net_timer_add(&tcp->delack.timer, "tcp delack", tcp_delack_tmo, tcp,
+                  TCP_DELACK_TMO, NET_TIMER_ACTIVE);
+  }
+}
+
+/**
+ * @brief 取消延迟确认
+ *
+ * @param tcp
+ */
+void tcp_delack_stop(tcp_t *tcp) {
+  tcp->delack.bytes = 0;
+  if (tcp->delack.timer.flags & NET_TIMER_ACTIVE) {
+    net_timer_remove(&tcp->delack.timer);
+  }
+}
+
 /**
  * @brief 单独对一个数据包发送ack确认
  *
@@ -223,24 +946,45 @@ tcp_transmit_failed:
  * @return net_err_t
  */
 net_err_t tcp_send_ack(tcp_t *tcp, tcp_info_t *info) {
-  pktbuf_t *buf = pktbuf_alloc(sizeof(tcp_hdr_t));  //!!! 分配数据包
+  // 分配tcp数据包并填充头部,
+  // 序号为发送窗口的下一个待发送数据段序号
+  pktbuf_t *buf =
+      tcp_pkt_alloc(tcp, tcp->send.nxt, 0, 0, 1);  //!!! 分配数据包
   if (!buf) {
     dbg_warning(DBG_TCP, "no free pktbuf for tcp ack pkt.");
     return NET_ERR_TCP;
   }
+  tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(buf);
 
-  // 获取tcp数据包头部, 并填充头部字段
+  // 将tcp数据包下交给网络层处理
+  net_err_t err = tcp_send(tcp_hdr, buf, &tcp->sock_base.remote_ip,
+                           &tcp->sock_base.local_ip);  //!!! 数据包传递
+  if (err != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp send failed.");
+    pktbuf_free(buf);  //!!! 释放数据包
+    return err;
+  }
+
+  tcp->stats.segs_out++;
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 向tcp对象的对端发送复位数据包，以中止当前连接
+ *
+ * @param tcp
+ * @return net_err_t
+ */
+net_err_t tcp_send_abort(tcp_t *tcp) {
+  // 分配tcp数据包并填充头部, 复位数据包不需要ack确认
+  pktbuf_t *buf =
+      tcp_pkt_alloc(tcp, tcp->send.nxt, 0, 0, 0);  //!!! 分配数据包
+  if (!buf) {
+    dbg_warning(DBG_TCP, "no free pktbuf for tcp reset pkt.");
+    return NET_ERR_TCP;
+  }
   tcp_hdr_t *tcp_hdr = (tcp_hdr_t *)pktbuf_data_ptr(buf);
-  tcp_hdr->src_port = tcp->sock_base.local_port;
-  tcp_hdr->dest_port = tcp->sock_base.remote_port;
-  tcp_hdr->seq = tcp->send.nxt;  // 设置序号位发送窗口的下一个待发送数据段序号
-  tcp_hdr->ack = tcp->recv.nxt;  // 设置确认号为接收窗口的下一个待接收数据段序号
-  tcp_set_hdr_size(tcp_hdr, sizeof(tcp_hdr_t));  // 设置头部长度
-  tcp_hdr->reserved = 0;                         // 清空保留字段
-  tcp_hdr->flag = 0;                             // 清空标志位
-  tcp_hdr->f_ack = 1;
-  tcp_hdr->win_size = tcp_recv_window(tcp);  // 设置窗口大小
-  tcp_hdr->urg_ptr = 0;      // 紧急指针
+  tcp_hdr->f_rst = 1;
 
   // 将tcp数据包下交给网络层处理
   net_err_t err = tcp_send(tcp_hdr, buf, &tcp->sock_base.remote_ip,
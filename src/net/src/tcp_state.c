@@ -11,8 +11,13 @@
 
 #include "tcp_state.h"
 
+#include "tcp_bbr.h"
+#include "tcp_ecn.h"
+#include "tcp_fastopen.h"
+#include "tcp_rack.h"
 #include "tcp_recv.h"
 #include "tcp_send.h"
+#include "tcp_tw.h"
 
 /**
  * @brief 返回tcp状态的字符串表示
@@ -55,26 +60,79 @@ void tcp_state_set(tcp_t *tcp, tcp_state_t state) {
 }
 
 /**
- * @brief 处理对端发来的ack确认，以更新本地tcp对象标志位以及发送窗口
+ * @brief 根据对端发来的报文段更新对端通告的接收窗口(RFC 793),
+ *        只使用比上次更新时更新的报文段，避免被乱序到达的旧报文段缩小窗口
  *
  * @param tcp
  * @param info
- * @return net_err_t
  */
-net_err_t tcp_ack_process(tcp_t *tcp, tcp_info_t *info) {
-  // 获取tcp数据包头部, 并检查ack号是否合法
+static void tcp_send_win_update(tcp_t *tcp, tcp_info_t *info) {
   tcp_hdr_t *tcp_hdr = info->tcp_hdr;
-  if (tcp_seq_after(tcp_hdr->ack, tcp->send.nxt) ||
-      tcp_seq_before_eq(tcp_hdr->ack, tcp->send.isn)) {
-    // ack号不合法：ack落在了待发送的窗口内, 或者ack小于等于初始序号
-    // 直接返回错误，相对于直接忽略该包，不继续向上层传递，本地不发送复位包也不会继续发送缓冲区中的数据
-    dbg_error(DBG_TCP, "tcp ack error, ack:%u, send.nxt:%u.", tcp_hdr->ack,
-              tcp->send.nxt);
-    return NET_ERR_TCP;
+  if (tcp_seq_before(tcp->send.wl1, info->seq) ||
+      (tcp->send.wl1 == info->seq &&
+       tcp_seq_before_eq(tcp->send.wl2, tcp_hdr->ack))) {
+    tcp->send.win = tcp_hdr->win_size;
+    tcp->send.wl1 = info->seq;
+    tcp->send.wl2 = tcp_hdr->ack;
   }
-  if (tcp_seq_before_eq(tcp_hdr->ack, tcp->send.una)) {
-    // ack落在已确认窗口内，即是重复的ack确认, 无需处理
-    return NET_ERR_OK;
+}
+
+/**
+ * @brief 有新的数据被确认时增大拥塞窗口(RFC 5681)
+ *        慢启动阶段每确认一个mss增大一个mss, 拥塞避免阶段每个rtt增大一个mss
+ *
+ * @param tcp
+ * @param acked 新确认的序号长度
+ */
+static void tcp_cwnd_update(tcp_t *tcp, int acked) {
+  if (tcp->send.cwnd < tcp->send.ssthresh) {
+    tcp->send.cwnd += MIN(acked, tcp->mss);
+  } else {
+    tcp->send.cwnd += MAX(1, tcp->mss * tcp->mss / tcp->send.cwnd);
+  }
+}
+
+/**
+ * @brief 恢复阶段(超时重传或RACK检测到丢包后)中处理确认了新数据的ack(NewReno, RFC 6582):
+ *        未越过进入恢复阶段时的nxt(recover)的部分确认表明下一个未确认的数据段很可能也已丢失,
+ *        立即重传而不是每个丢失的数据段都等待一次超时; 越过recover的完整确认结束恢复阶段
+ *
+ * @param tcp
+ */
+static void tcp_recovery_on_ack(tcp_t *tcp) {
+  if (!tcp->flags.recovery) {
+    return;
+  }
+
+  if (tcp_seq_before(tcp->send.una, tcp->send.recover)) {
+    tcp_retransmit(tcp);
+  } else {
+    tcp->flags.recovery = 0;
+  }
+}
+
+/**
+ * @brief 处理确认了新数据的ack(una < ack <= nxt)：更新拥塞窗口及往返时间,
+ *        移除发送缓冲区中已确认的数据并唤醒发送任务，调用前需已检查ack号的合法性
+ *
+ * @param tcp
+ * @param info
+ */
+void tcp_ack_advance(tcp_t *tcp, tcp_info_t *info) {
+  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
+  int acked = (int)(tcp_hdr->ack - tcp->send.una);
+
+  // 该ack确认了新的数据，采样往返时间以更新重传超时时间
+  // 优先使用对端回显的时间戳(重传期间同样有效)，否则使用正在计时的数据段
+  int rtt = -1;
+  if (tcp->flags.ts_ok && info->ts_valid && info->ts_ecr) {
+    rtt = (int)(tcp_time_now() - info->ts_ecr);
+    tcp_rtt_update(tcp, rtt);
+  } else if (tcp->flags.rtt_timing &&
+             tcp_seq_after(tcp_hdr->ack, tcp->rtt.seq)) {
+    rtt = (int)(tcp_time_now() - tcp->rtt.time);
+    tcp_rtt_update(tcp, rtt);
+    tcp->flags.rtt_timing = 0;
   }
 
   // 若tcp对象的syn_send标志位有效, 则该ack一定为syn请求的ack确认
@@ -91,25 +149,99 @@ net_err_t tcp_ack_process(tcp_t *tcp, tcp_info_t *info) {
     tcp->send.una += ack_cnt;  // 更新发送窗口的未确认的序号
     // 移除已确认的数据，若移除后ack_cnt ==
     // 1，则说明该ack确认包含对fin请求的确认
-    ack_cnt -= tcp_buf_remove(&tcp->send.buf, ack_cnt);
+    int removed = tcp_buf_remove(&tcp->send.buf, ack_cnt);
+    ack_cnt -= removed;
+    tcp->stats.bytes_acked += removed;
 
     // 若tcp对象的fin_need_ack标志位有效, 则判断该ack是否为fin请求的ack确认
     if (tcp->flags.fin_need_ack && ack_cnt) {
       tcp->flags.fin_need_ack = 0;  // 清除fin标志位发送缓存标志位
     }
 
+    // 回收已完成的零拷贝发送数据区
+    tcp_zc_collect(tcp);
+
     // 处理完ack确认后，发送缓冲区中有了空闲空间，可尝试唤醒等待在tcp对象上的发送任务
     sock_wakeup(&tcp->sock_base, SOCK_WAIT_WRITE, NET_ERR_OK);
   }
+
+  // 恢复阶段中的部分确认立即重传下一个未确认的数据段
+  tcp_recovery_on_ack(tcp);
+
+  // 由拥塞控制算法根据本次确认的数据量更新拥塞窗口(BBR同时更新发送速率)
+  if (tcp->cc == TCP_CC_BBR) {
+    tcp_bbr_on_ack(tcp, acked, rtt);
+  } else {
+    tcp_cwnd_update(tcp, acked);
+  }
+
+  // 有新的数据被确认，重置重传次数，并根据是否还有未确认的数据重启或停止重传定时器
+  tcp->rtt.retry = 0;
+  if (tcp->send.una == tcp->send.nxt) {
+    tcp_rto_stop(tcp);
+  } else {
+    tcp_rto_start(tcp);
+  }
+
+  // 移除已确认数据段的发送时间记录, 并重新启动尾部丢失探测定时器
+  tcp_rack_on_ack(tcp, info, rtt);
+}
+
+/**
+ * @brief 处理对端发来的ack确认，以更新本地tcp对象标志位以及发送窗口
+ *
+ * @param tcp
+ * @param info
+ * @return net_err_t
+ */
+net_err_t tcp_ack_process(tcp_t *tcp, tcp_info_t *info) {
+  // 获取tcp数据包头部
+  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
+
+  // 检查ack号是否合法
+  if (tcp_seq_after(tcp_hdr->ack, tcp->send.nxt) ||
+      tcp_seq_before_eq(tcp_hdr->ack, tcp->send.isn)) {
+    // ack号不合法：ack落在了待发送的窗口内, 或者ack小于等于初始序号
+    // 直接返回错误，相对于直接忽略该包，不继续向上层传递，本地不发送复位包也不会继续发送缓冲区中的数据
+    dbg_error(DBG_TCP, "tcp ack error, ack:%u, send.nxt:%u.", tcp_hdr->ack,
+              tcp->send.nxt);
+    return NET_ERR_TCP;
+  }
+
+  // 对端仍在响应, 坚持状态中的探测不会因对端长时间零窗口而中止连接
+  tcp->persist.probes = 0;
+
+  // 对端回显的拥塞通知, 重复的ack也可能携带
+  tcp_ecn_ack_in(tcp, info);
+
+  // 不携带数据且窗口未变化的重复ack表明之后发送的数据段已到达, 用于检测丢包(RFC 5681)
+  if (tcp_hdr->ack == tcp->send.una && tcp->send.una != tcp->send.nxt &&
+      !info->seq_len && tcp_hdr->win_size == tcp->send.win) {
+    tcp_rack_on_dupack(tcp);
+  }
+
+  // 重复的ack也可能携带窗口更新
+  tcp_send_win_update(tcp, info);
+  if (tcp_seq_before_eq(tcp_hdr->ack, tcp->send.una)) {
+    // ack落在已确认窗口内，即是重复的ack确认, 无需处理
+    return NET_ERR_OK;
+  }
+
+  tcp_ack_advance(tcp, info);
   return NET_ERR_OK;
 }
 
 /**
- * @brief 使用定时器来将tcp进入TIME_WAIT状态
+ * @brief 将tcp进入TIME_WAIT状态, 由TIME_WAIT记录代替tcp对象等待2MSL,
+ *        tcp对象不再接收报文段，随持有者的close()一同释放
  *
  */
 void tcp_state_time_wait(tcp_t *tcp) {
   tcp_state_set(tcp, TCP_STATE_TIME_WAIT);
+  tcp_tw_enter(tcp);
+
+  // 连接已完全关闭，唤醒等待在close()上的任务以释放tcp对象
+  sock_wakeup(&tcp->sock_base, SOCK_WAIT_CONN, NET_ERR_OK);
 }
 
 /***********************************************************************************************************
@@ -127,8 +259,144 @@ static net_err_t tcp_closed_recv(tcp_t *tcp, tcp_info_t *info) {
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 对端使用SYN cookie完成了三次握手，根据cookie恢复连接信息,
+ *        直接创建一个已建立连接的子连接并放入全连接队列
+ *
+ * @param tcp 监听tcp对象
+ * @param info 第三次握手的数据包信息
+ * @return tcp_t* 创建的子连接, 失败返回0
+ */
+static tcp_t *tcp_syncookie_accept(tcp_t *tcp, tcp_info_t *info) {
+#if TCP_SYNCOOKIE_ENABLE
+  uint16_t mss = 0;
+  if (!tcp_syncookie_check(info, &mss)) {
+    return (tcp_t *)0;
+  }
+
+  // 全连接队列已满，丢弃该ack，由对端重传
+  if (nlist_count(&tcp->listen.accept_list) >= tcp->listen.backlog) {
+    dbg_warning(DBG_TCP, "tcp accept queue full, drop syncookie ack.");
+    return (tcp_t *)0;
+  }
+
+  tcp_t *child = tcp_child_alloc(tcp, info);
+  if (!child) {
+    return (tcp_t *)0;
+  }
+
+  // 根据cookie恢复双方的初始序号及mss, cookie中不包含时间戳选项, 不启用时间戳
+  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
+  child->send.isn = tcp_hdr->ack - 1;
+  child->send.una = tcp_hdr->ack;
+  child->send.nxt = tcp_hdr->ack;
+  child->recv.isn = info->seq - 1;
+  child->recv.nxt = info->seq;
+  child->recv.unr = info->seq;
+  child->send.wl1 = child->recv.isn;
+  child->send.wl2 = child->send.isn;
+  child->flags.recv_win_valid = 1;
+  child->mss = MIN(child->mss, mss);
+
+  // 连接已建立，放入全连接队列并唤醒等待accept的任务
+  tcp_state_set(child, TCP_STATE_ESTABLISHED);
+  tcp_child_queue(child, &tcp->listen.accept_list);
+  sock_wakeup(&tcp->sock_base, SOCK_WAIT_CONN, NET_ERR_OK);
+
+  return child;
+#else
+  return (tcp_t *)0;
+#endif
+}
+
+/**
+ * @brief 处于LISTEN状态，处理新的连接请求
+ *        半连接队列未满时，为连接请求分配子连接并回复SYN+ACK，子连接进入SYN_RCVD状态
+ *        半连接队列已满或无空闲tcp对象时，使用SYN cookie回复，不保存连接状态
+ *
+ * @param tcp
+ * @param info
+ * @return net_err_t
+ */
 static net_err_t tcp_listen_recv(tcp_t *tcp, tcp_info_t *info) {
+  // 获取tcp数据包头部
+  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
+
+  // 监听对象没有可以复位的连接，忽略复位请求
+  if (tcp_hdr->f_rst) {
+    return NET_ERR_OK;
+  }
+
+  // 没有对应子连接的ack, 可能是使用SYN cookie建立连接的第三次握手
+  // 否则为无效的ack，发送复位数据包通知对端
+  if (tcp_hdr->f_ack) {
+    if (!tcp_hdr->f_syn) {
+      tcp_t *child = tcp_syncookie_accept(tcp, info);
+      if (child) {  // 由子连接继续处理ack携带的数据
+        return tcp_state_handler_recv(child, info);
+      }
+    }
+    tcp_send_reset(info);
+    return NET_ERR_OK;
+  }
+
+  // 只处理连接请求
+  if (!tcp_hdr->f_syn) {
+    return NET_ERR_OK;
+  }
+
+  // 全连接队列已满，应用程序来不及accept，丢弃连接请求，由对端重传
+  if (nlist_count(&tcp->listen.accept_list) >= tcp->listen.backlog) {
+    dbg_warning(DBG_TCP, "tcp accept queue full, drop syn.");
+    return NET_ERR_OK;
+  }
+
+  if (nlist_count(&tcp->listen.syn_list) < TCP_SYN_BACKLOG) {
+    tcp_t *child = tcp_child_alloc(tcp, info);
+    if (child) {
+      // 设置接收窗口的初始序号, 待接收序号和对应标志
+      child->recv.isn = info->seq;
+      child->recv.nxt = info->seq + 1;
+      child->recv.unr = info->seq + 1;  // syn请求不是可读取的数据
+      child->flags.recv_win_valid = 1;
+      child->send.win = tcp_hdr->win_size;  // 记录对端通告的接收窗口
+      child->send.wl1 = info->seq;
+      tcp_read_options(child, tcp_hdr);  // 协商mss及时间戳选项
+      tcp_ecn_syn_in(child, tcp_hdr);    // 协商显式拥塞通知
+
+      // 快速打开的cookie有效时, 接收SYN携带的数据并由SYN+ACK一同确认,
+      // 子连接直接放入全连接队列, 应用程序无需等待握手完成即可处理请求
+      int tfo = tcp_fastopen_syn_in(child, tcp, info);
+      if (tfo) {
+        tcp_recv_syn_data(child, info);
+      }
+
+      // 放入半连接队列，并回复SYN+ACK, SYN+ACK丢失时由重传定时器重传
+      tcp_child_queue(child, tfo ? &tcp->listen.accept_list
+                                 : &tcp->listen.syn_list);
+      tcp_state_set(child, TCP_STATE_SYN_RCVD);
+      if (tcp_send_syn(child) != NET_ERR_OK) {
+        dbg_error(DBG_TCP, "send syn ack failed.");
+        tcp_abort_connect(child, NET_ERR_TCP);
+        return NET_ERR_OK;
+      }
+      if (tfo) {
+        sock_wakeup(&tcp->sock_base, SOCK_WAIT_CONN, NET_ERR_OK);
+      }
+      return NET_ERR_OK;
+    }
+  }
+
+#if TCP_SYNCOOKIE_ENABLE
+  // 半连接队列已满，或没有空闲的tcp对象，使用SYN cookie回复
+  uint16_t mss = 0;
+  uint32_t isn = tcp_syncookie_make(info, &mss);
+  dbg_info(DBG_TCP, "tcp syn queue full, send syncookie.");
+  return tcp_send_syncookie(info, isn, mss);
+#else
+  dbg_warning(DBG_TCP, "tcp syn queue full, drop syn.");
   return NET_ERR_OK;
+#endif
 }
 
 static net_err_t tcp_syn_sent_recv(tcp_t *tcp, tcp_info_t *info) {
@@ -165,14 +433,24 @@ static net_err_t tcp_syn_sent_recv(tcp_t *tcp, tcp_info_t *info) {
     tcp->recv.nxt = tcp_hdr->seq + 1;
     tcp->recv.unr = tcp_hdr->seq + 1;  // syn请求不是可读取的数据
     tcp->flags.recv_win_valid = 1;
+    tcp->send.win = tcp_hdr->win_size;  // 记录对端通告的接收窗口
+    tcp->send.wl1 = tcp_hdr->seq;
     tcp_read_options(tcp, tcp_hdr);  // 读取tcp选项信息，主要是读取mss选项
+    tcp_ecn_syn_in(tcp, tcp_hdr);    // 协商显式拥塞通知
 
     if (tcp_hdr->f_ack) {
       // 完成三次握手,切换到ESTABLISHED状态，并唤醒等待在该连接事件上的任务
       tcp_ack_process(tcp, info);  // 处理连接请求的ack确认
-      tcp_send_ack(tcp, info);     // 对该请求发送ack确认
+      tcp_fastopen_synack_in(tcp, info);  // 缓存快速打开cookie
       tcp_state_set(tcp, TCP_STATE_ESTABLISHED);
       sock_wakeup(&tcp->sock_base, SOCK_WAIT_CONN, NET_ERR_OK);
+
+      // 发送握手期间写入的数据(快速打开), 没有数据可发送时对该请求发送ack确认
+      uint32_t nxt = tcp->send.nxt;
+      tcp_transmit(tcp);
+      if (tcp->send.nxt == nxt) {
+        tcp_send_ack(tcp, info);
+      }
     } else {  // 若对方同时发送syn请求, 则不会有ack确认
               // 进入SYN_RCVD状态,
               // 并再次发送syn请求，并且此次请求将携带对对方请求的ack确认，以进行四次握手
@@ -184,15 +462,85 @@ static net_err_t tcp_syn_sent_recv(tcp_t *tcp, tcp_info_t *info) {
 
   return NET_ERR_OK;
 }
+/**
+ * @brief 处于SYN_RCVD状态，等待对端对本地SYN+ACK的ack确认以完成三次握手
+ *        由监听对象创建的子连接完成握手后移入全连接队列，等待accept
+ *
+ * @param tcp
+ * @param info
+ * @return net_err_t
+ */
 static net_err_t tcp_syn_rcvd_recv(tcp_t *tcp, tcp_info_t *info) {
+  // 获取tcp数据包头部
+  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
+
+  // 若复位请求有效, 则接收复位请求，舍弃当前连接
+  if (tcp_hdr->f_rst) {
+    dbg_warning(DBG_TCP, "tcp recv rst in SYN_RCVD.");
+    return tcp_abort_connect(tcp, NET_ERR_TCP_RST);
+  }
+
+  // 对端重传的连接请求(SYN+ACK丢失), 重传SYN+ACK;
+  // 该syn位于接收窗口之前, 由tcp_state_handler_recv跳过序号检查直接交给本函数处理
+  if (tcp_hdr->f_syn && info->seq == tcp->recv.isn) {
+    return tcp_retransmit(tcp);
+  }
+
+  // 落在接收窗口内的syn请求，可能出现异常, 发送复位数据包通知对端，并舍弃当前连接
+  if (tcp_hdr->f_syn) {
+    dbg_warning(DBG_TCP, "tcp recv syn in SYN_RCVD.");
+    tcp_send_reset(info);
+    return tcp_abort_connect(tcp, NET_ERR_TCP_RST);
+  }
+
+  // 需要对端的ack确认才能完成三次握手
+  if (!tcp_hdr->f_ack) {
+    return NET_ERR_OK;
+  }
+
+  // 全连接队列已满，暂不完成握手，由对端重传,
+  // 快速打开的子连接已在全连接队列中(或已被accept)
+  tcp_t *parent = tcp->listen.parent;
+  if (parent && tcp->listen.queue != &parent->listen.syn_list) {
+    parent = (tcp_t *)0;
+  }
+  if (parent &&
+      nlist_count(&parent->listen.accept_list) >= parent->listen.backlog) {
+    dbg_warning(DBG_TCP, "tcp accept queue full, drop ack.");
+    return NET_ERR_OK;
+  }
+
+  // 处理对SYN+ACK的ack确认, ack不合法则发送复位数据包通知对端
+  if (tcp_ack_process(tcp, info) != NET_ERR_OK) {
+    dbg_error(DBG_TCP, "tcp ack process failed in SYN_RCVD.");
+    tcp_send_reset(info);
+    return NET_ERR_TCP;
+  }
+
+  // 完成三次握手，切换到ESTABLISHED状态
+  tcp_state_set(tcp, TCP_STATE_ESTABLISHED);
+  if (parent) {  // 子连接移入全连接队列，并唤醒等待accept的任务
+    tcp_child_queue(tcp, &parent->listen.accept_list);
+    sock_wakeup(&parent->sock_base, SOCK_WAIT_CONN, NET_ERR_OK);
+  } else {  // 同时打开的连接或快速打开的子连接，唤醒等待在connect()上的任务
+    sock_wakeup(&tcp->sock_base, SOCK_WAIT_CONN, NET_ERR_OK);
+  }
+
+  // ack可能同时携带了数据或fin请求
+  tcp_recv_data(tcp, info);
+  tcp_transmit(tcp);
+  if (tcp->flags.fin_recved) {
+    tcp_state_set(tcp, TCP_STATE_CLOSE_WAIT);
+  }
+
   return NET_ERR_OK;
 }
 
 /**
  * @brief 处于ESTABLISHED状态,
  * 接收对端的数据包，并进行数据接收处理及ack确认处理即可
- *        并发送缓冲区中剩余的数据，若对端请求关闭连接，则本地进入CLOSE_WAIT状态
- *        TODO: 每次只发送一个数据包，以后根据对端的接收窗口大小进行调整
+ *        并在对端接收窗口及拥塞窗口允许的范围内发送缓冲区中剩余的数据,
+ *        若对端请求关闭连接，则本地进入CLOSE_WAIT状态
  *
  * @param tcp
  * @param info
@@ -379,42 +727,6 @@ static net_err_t tcp_closing_recv(tcp_t *tcp, tcp_info_t *info) {
   return NET_ERR_OK;
 }
 
-static net_err_t tcp_time_wait_recv(tcp_t *tcp, tcp_info_t *info) {
-  // 获取tcp数据包头部
-  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
-
-  // 若复位请求有效, 则接收复位请求，舍弃当前连接
-  if (tcp_hdr->f_rst) {
-    dbg_warning(DBG_TCP, "tcp recv rst in TIME_WAIT.");
-    return tcp_abort_connect(tcp, NET_ERR_TCP_RST);
-  }
-
-  // 在连接建立后, 不应该再收到syn请求，若收到则可能出现异常
-  // 发送复位数据包通知对端，并舍弃当前连接
-  if (tcp_hdr->f_syn) {
-    dbg_warning(DBG_TCP, "tcp recv syn in TIME_WAIT.");
-    tcp_send_reset(info);
-    return tcp_abort_connect(tcp, NET_ERR_TCP_RST);
-  }
-
-  // 若ack有效, 则处理ack确认(更新发送窗口信息)
-  if (tcp_ack_process(tcp, info) != NET_ERR_OK) {
-    dbg_error(DBG_TCP, "tcp ack process failed in TIME_WAIT.");
-    return NET_ERR_TCP;
-  }
-
-  // 在TIME_WAIT状态下，双方都已关闭连接，不需要再进行有效数据的接收处理(之前已完成全部接收和确认，包括对端发送的fin请求)
-  // 只需要单独确认对端重传的fin请求(在之前ack丢失的情况下)
-  if (tcp_hdr->f_fin) {
-    // TODO: 暂时无法测试ack丢失的情况
-    tcp_send_ack(tcp, info);  // 发送ack确认
-    tcp_state_time_wait(
-        tcp);  // 重新进入TIME_WAIT状态(重置定时器，继续等待2MSL时长，以确保对端已经接收到ack确认)
-  }
-
-  return NET_ERR_OK;
-}
-
 static net_err_t tcp_close_wait_recv(tcp_t *tcp, tcp_info_t *info) {
   // 获取tcp数据包头部
   tcp_hdr_t *tcp_hdr = info->tcp_hdr;
@@ -511,7 +823,7 @@ net_err_t tcp_state_handler_recv(tcp_t *tcp, tcp_info_t *info) {
       [TCP_STATE_FIN_WAIT_1] = tcp_fin_wait_1_recv,
       [TCP_STATE_FIN_WAIT_2] = tcp_fin_wait_2_recv,
       [TCP_STATE_CLOSING] = tcp_closing_recv,
-      [TCP_STATE_TIME_WAIT] = tcp_time_wait_recv,
+      [TCP_STATE_TIME_WAIT] = tcp_closed_recv,  // 由TIME_WAIT记录处理，不会进入状态机
       [TCP_STATE_CLOSE_WAIT] = tcp_close_wait_recv,
       [TCP_STATE_LAST_ACK] = tcp_last_ack_recv,
   };
@@ -526,13 +838,35 @@ net_err_t tcp_state_handler_recv(tcp_t *tcp, tcp_info_t *info) {
     return NET_ERR_TCP;
   }
 
+  // SYN_RCVD状态下对端重传的连接请求的序号为recv.isn, 在接收窗口之前,
+  // 不经过序号检查, 由状态处理函数重传SYN+ACK, 而不是只回复ack
+  int syn_retry = tcp->state == TCP_STATE_SYN_RCVD && info->tcp_hdr->f_syn &&
+                  !info->tcp_hdr->f_ack && info->seq == tcp->recv.isn;
+
   // 在接收窗口有效的状态下，需要对接收到的数据包的序号进行合法性检查
   if ((tcp->state != TCP_STATE_CLOSED) && (tcp->state != TCP_STATE_SYN_SENT) &&
-      (tcp->state != TCP_STATE_LISTEN)) {
+      (tcp->state != TCP_STATE_LISTEN) && !syn_retry) {
         if (!tcp_seq_is_ok(tcp, info)) {
-          dbg_warning(DBG_TCP, "tcp seq is error.");
+          // 不可接受的报文段(如零窗口探测)，回复ack告知对端当前的接收位置及窗口
+          if (info->seq == tcp->recv.nxt && tcp_recv_window(tcp) == 0) {
+            dbg_info(DBG_TCP, "tcp zero window probe, seq: %u.", info->seq);
+          } else {
+            dbg_warning(DBG_TCP, "tcp seq is error.");
+          }
+          if (!info->tcp_hdr->f_rst) {
+            tcp_send_ack(tcp, info);
+          }
+          return NET_ERR_TCP;
+        }
+
+        // 防止序号回绕检查，丢弃过时的重复报文段，并发送ack告知对端当前的接收位置
+        if (tcp_paws_reject(tcp, info)) {
+          dbg_warning(DBG_TCP, "tcp paws reject, ts_val:%u, recent:%u.",
+                      info->ts_val, tcp->ts.recent);
+          tcp_send_ack(tcp, info);
           return NET_ERR_TCP;
         }
+        tcp_ts_update(tcp, info);
   }
 
   return tcp_state_handler_recv[tcp->state](tcp, info);
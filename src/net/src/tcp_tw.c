@@ -0,0 +1,221 @@
+/**
+ * @file tcp_tw.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp TIME_WAIT记录模块
+ *        主动关闭的连接需要在TIME_WAIT状态等待2MSL, 以应答对端重传的fin并使旧连接的报文段在网络中消失,
+ *        此期间只需要四元组、双方的序号及时间戳信息, 使用精简的记录代替tcp对象,
+ *        tcp对象及其收发缓冲区在连接进入TIME_WAIT状态后即可释放
+ * @version 0.1
+ * @date 2024-12-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "tcp_tw.h"
+
+#include "dbg.h"
+#include "mblock.h"
+#include "tcp_send.h"
+#include "timer.h"
+
+static tcp_tw_t tcp_tw_tbl[TCP_TW_MAXCNT];  // TIME_WAIT记录表
+static mblock_t tcp_tw_mblock;  // TIME_WAIT记录内存块管理对象
+static nlist_t tcp_tw_list;     // 按超时时间先后挂载的TIME_WAIT记录链表
+static net_timer_t tcp_tw_timer;  // 链表中最早超时的记录的定时器
+static sock_hash_t *tcp_tw_hash;  // 记录所挂载的连接哈希表
+
+static void tcp_tw_tmo(net_timer_t *timer, void *arg);
+
+/**
+ * @brief 初始化TIME_WAIT记录模块
+ *
+ * @param conn_hash 已连接tcp对象所在的哈希表, 记录挂载在该表中以接收旧连接的报文段
+ * @return net_err_t
+ */
+net_err_t tcp_tw_module_init(sock_hash_t *conn_hash) {
+  tcp_tw_hash = conn_hash;
+  nlist_init(&tcp_tw_list);
+
+  // 只由工作线程访问，不需要加锁
+  return mblock_init(&tcp_tw_mblock, tcp_tw_tbl, sizeof(tcp_tw_t),
+                     TCP_TW_MAXCNT, NLOCKER_NONE);
+}
+
+/**
+ * @brief 释放TIME_WAIT记录, 将其从哈希表及链表中移除
+ *
+ * @param tw
+ */
+static void tcp_tw_free(tcp_tw_t *tw) {
+  sock_hash_remove(&tw->sock_base);
+  nlist_remove(&tcp_tw_list, &tw->node);
+  mblock_free(&tcp_tw_mblock, tw);
+}
+
+/**
+ * @brief 从当前时间开始等待2MSL, 所有记录的等待时长相同, 挂载到链表尾部即可保持超时顺序
+ *
+ * @param tw
+ */
+static void tcp_tw_schedule(tcp_tw_t *tw) {
+  if (nlist_is_mount(&tw->node)) {
+    nlist_remove(&tcp_tw_list, &tw->node);
+  }
+  tw->expire = tcp_time_now() + TCP_TW_TMO;
+  nlist_insert_last(&tcp_tw_list, &tw->node);
+
+  if (!(tcp_tw_timer.flags & NET_TIMER_ACTIVE)) {
+    net_timer_add(&tcp_tw_timer, "tcp time wait", tcp_tw_tmo, (void *)0,
+                  TCP_TW_TMO, NET_TIMER_ACTIVE);
+  }
+}
+
+/**
+ * @brief 定时器超时处理: 释放所有已超时的记录, 并为下一个将要超时的记录重新启动定时器
+ *
+ * @param timer
+ * @param arg
+ */
+static void tcp_tw_tmo(net_timer_t *timer, void *arg) {
+  uint32_t now = tcp_time_now();
+  nlist_node_t *node = (nlist_node_t *)0;
+
+  while ((node = nlist_first(&tcp_tw_list)) != (nlist_node_t *)0) {
+    tcp_tw_t *tw = nlist_entry(node, tcp_tw_t, node);
+    int remain = (int)(tw->expire - now);
+    if (remain > 0) {
+      net_timer_add(&tcp_tw_timer, "tcp time wait", tcp_tw_tmo, (void *)0,
+                    remain, NET_TIMER_ACTIVE);
+      return;
+    }
+    tcp_tw_free(tw);
+  }
+}
+
+/**
+ * @brief 连接进入TIME_WAIT状态, 使用TIME_WAIT记录代替tcp对象挂载在连接哈希表中
+ *        tcp对象随即从哈希表中移除, 不再接收任何报文段, 只等待持有者调用close释放
+ *        记录表已满时不经过TIME_WAIT直接关闭连接
+ *
+ * @param tcp
+ * @return net_err_t
+ */
+net_err_t tcp_tw_enter(tcp_t *tcp) {
+  sock_hash_remove(&tcp->sock_base);
+
+  tcp_tw_t *tw = (tcp_tw_t *)mblock_alloc(&tcp_tw_mblock, -1);
+  if (!tw) {
+    dbg_warning(DBG_TCP, "tcp time wait table full, skip TIME_WAIT.");
+    return NET_ERR_MEM;
+  }
+  plat_memset(tw, 0, sizeof(tcp_tw_t));
+
+  sock_t *sock = &tw->sock_base;
+  ipaddr_copy(&sock->local_ip, &tcp->sock_base.local_ip);
+  ipaddr_copy(&sock->remote_ip, &tcp->sock_base.remote_ip);
+  sock->local_port = tcp->sock_base.local_port;
+  sock->remote_port = tcp->sock_base.remote_port;
+  sock->family = tcp->sock_base.family;
+  sock->protocol = tcp->sock_base.protocol;
+
+  tw->state = TCP_STATE_TIME_WAIT;
+  tw->snd_nxt = tcp->send.nxt;
+  tw->rcv_nxt = tcp->recv.nxt;
+  tw->rcv_wnd = (uint16_t)tcp_recv_window(tcp);
+  tw->ts_ok = tcp->flags.ts_ok;
+  tw->ts_recent = tcp->ts.recent;
+  tw->ts_recent_time = tcp->ts.recent_time;
+
+  sock_hash_insert(tcp_tw_hash, sock);
+  tcp_tw_schedule(tw);
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 判断对端发来的SYN能否作为新连接的请求(RFC 6191):
+ *        使用时间戳选项时要求时间戳比旧连接的更新, 否则要求序号在旧连接的序号之后
+ *
+ * @param tw
+ * @param info
+ * @return int
+ */
+static int tcp_tw_syn_ok(tcp_tw_t *tw, tcp_info_t *info) {
+  if (tw->ts_ok && info->ts_valid) {
+    return tcp_seq_after(info->ts_val, tw->ts_recent);
+  }
+
+  return tcp_seq_after(info->seq, tw->rcv_nxt);
+}
+
+/**
+ * @brief TIME_WAIT记录处理对端发来的报文段
+ *        重传的fin: 重新确认并重新等待2MSL; 其余携带序号的报文段: 发送ack告知当前的接收位置;
+ *        复位请求不提前结束TIME_WAIT(RFC 1337), 纯ack直接丢弃
+ *
+ * @param tw
+ * @param info
+ * @return int 1: 报文段为新连接的SYN, 记录已释放, 调用者需交由监听对象处理, 0: 已处理
+ */
+int tcp_tw_recv(tcp_tw_t *tw, tcp_info_t *info) {
+  tcp_hdr_t *tcp_hdr = info->tcp_hdr;
+
+  if (tcp_hdr->f_rst) {
+    return 0;
+  }
+
+  // 对端复用该四元组发起新连接, 释放记录
+  if (tcp_hdr->f_syn && !tcp_hdr->f_ack && tcp_tw_syn_ok(tw, info)) {
+    dbg_info(DBG_TCP, "tcp syn recycles TIME_WAIT tuple.");
+    tcp_tw_free(tw);
+    return 1;
+  }
+
+  // 防止序号回绕检查, 过时的重复报文段只回复ack
+  int paws_ok = !tw->ts_ok || !info->ts_valid ||
+                !tcp_seq_before(info->ts_val, tw->ts_recent);
+  if (paws_ok && tcp_hdr->f_fin &&
+      info->seq + info->seq_len == tw->rcv_nxt) {
+    // 对端没有收到对其fin的确认而重传了fin
+    if (tw->ts_ok && info->ts_valid) {
+      tw->ts_recent = info->ts_val;
+      tw->ts_recent_time = tcp_time_now();
+    }
+    tcp_tw_schedule(tw);
+  } else if (paws_ok && !info->seq_len) {
+    return 0;
+  }
+
+  tcp_send_tw_ack(tw);
+  return 0;
+}
+
+/**
+ * @brief 判断TIME_WAIT记录的四元组能否被本地主动发起的新连接安全复用:
+ *        旧连接使用了时间戳选项, 且距最近一次接收对端的报文段已超过TCP_TW_REUSE_DELAY,
+ *        新连接的时间戳必定更新, 对端可以通过PAWS丢弃旧连接残留的报文段
+ *
+ * @param tw
+ * @return int
+ */
+int tcp_tw_can_reuse(tcp_tw_t *tw) {
+#if TCP_TW_REUSE_ENABLE
+  return tw->ts_ok &&
+         tcp_time_now() - tw->ts_recent_time >= TCP_TW_REUSE_DELAY;
+#else
+  return 0;
+#endif
+}
+
+/**
+ * @brief 复用TIME_WAIT记录的四元组, 释放记录并返回新连接的初始序号,
+ *        初始序号越过旧连接可能使用过的整个窗口, 避免与旧连接的序号重叠
+ *
+ * @param tw
+ * @return uint32_t
+ */
+uint32_t tcp_tw_reuse(tcp_tw_t *tw) {
+  uint32_t isn = tw->snd_nxt + 0xffff + 2;
+  tcp_tw_free(tw);
+  return isn;
+}
@@ -53,7 +53,8 @@ static void display_timer_list(void) {
 net_err_t net_timer_module_init(void) {
   dbg_info(DBG_TIMER, "init timer module....");
 
-  nlist_init(&timer_list);  // 初始化定时器链表
+  nlist_init(&timer_list);     // 初始化定时器链表
+  nlist_init(&overtime_list);  // 初始化定时器超时链表
 
   dbg_info(DBG_TIMER, "init timer module ok.");
   return NET_ERR_OK;
@@ -95,8 +96,9 @@ static void insert_timer(net_timer_t *timer) {
     }
   }
 
-  if (!node) {  // 遍历完链表，证明定时器无法插入到链表中间,
-                // 需将定时器需要插入到链表末尾
+  // 遍历完链表(node回到哨兵头结点)，证明定时器无法插入到链表中间,
+  // 需将定时器需要插入到链表末尾
+  if (node == &timer_list.head) {
     nlist_insert_last(&timer_list, &timer->node);
   }
 }
@@ -154,6 +156,13 @@ void net_timer_remove(net_timer_t *timer) {
 
   dbg_info(DBG_TIMER, "remove timer %s", timer->name);
 
+  // 定时器已超时但尚未调用回调函数(由同一次扫描中先调用的回调函数删除), 从超时链表中删除
+  if (timer->flags & NET_TIMER_OVERTIME) {
+    nlist_remove(&overtime_list, &timer->node);
+    timer->flags &= ~(NET_TIMER_ACTIVE | NET_TIMER_OVERTIME);
+    return;
+  }
+
   // 获取timer的后一个定时器
   net_timer_t *next_timer =
       nlist_entry(nlist_next(&timer_list, &timer->node), net_timer_t, node);
@@ -191,9 +200,11 @@ net_err_t net_timer_check_tmo(int diff_ms) {
     if (timer->curr_ticks <= diff_ms) {  // timer需要触发
       diff_ms -= timer->curr_ticks;  // 更新时间间隔, 以便继续扫描后面的定时器
 
-      // 定时器超时, 移除定时器并加入超时链表
+      // 定时器超时, 移除定时器并加入超时链表,
+      // 调用回调函数前保持激活, 之前的回调函数仍可通过net_timer_remove取消该定时器
       timer->curr_ticks = 0;
       net_timer_remove(timer);
+      timer->flags |= NET_TIMER_ACTIVE | NET_TIMER_OVERTIME;
       nlist_insert_last(&overtime_list, &timer->node);
 
     } else {  // timer及后面的定时器不需要触发
@@ -205,9 +216,12 @@ net_err_t net_timer_check_tmo(int diff_ms) {
   // 遍历超时链表, 调用定时器回调函数
   while ((node = nlist_remove_first(&overtime_list)) != (nlist_node_t *)0) {
     timer = nlist_entry(node, net_timer_t, node);
+    timer->flags &= ~(NET_TIMER_ACTIVE | NET_TIMER_OVERTIME);
     timer->handle(timer, timer->arg);
 
-    if (timer->flags & NET_TIMER_RELOAD) {  // 定时器支持重载
+    // 定时器支持重载, 且回调函数中没有重新添加该定时器
+    if ((timer->flags & NET_TIMER_RELOAD) &&
+        !(timer->flags & NET_TIMER_ACTIVE)) {
       timer->curr_ticks = timer->reload_ticks;
       timer->flags |= NET_TIMER_ACTIVE;
       insert_timer(timer);
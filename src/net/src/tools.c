@@ -140,4 +140,23 @@ uint16_t tools_checksum16_pseudo_head(pktbuf_t *buf, const ipaddr_t *dest_ip,
   sum = pktbuf_checksum16(buf, pktbuf_total_size(buf), sum, 1);
 
   return (uint16_t)sum;
-}
\ No newline at end of file
+}
+
+/**
+ * @brief 计算一段数据的哈希值(FNV-1a算法)
+ *
+ * @param data
+ * @param len
+ * @param seed 哈希初始值的扰动值
+ * @return uint32_t
+ */
+uint32_t tools_hash32(const void *data, int len, uint32_t seed) {
+  const uint8_t *p = (const uint8_t *)data;
+  uint32_t hash = 2166136261U ^ seed;
+  for (int i = 0; i < len; i++) {
+    hash ^= p[i];
+    hash *= 16777619U;
+  }
+
+  return hash;
+}
@@ -15,12 +15,17 @@
 #include "nlist.h"
 #include "protocol.h"
 #include "route.h"
+#include "sock_hash.h"
 #include "tools.h"
 
 static udp_t udp_tbl[UDP_MAXCNT];  // udp socket对象表
 static mblock_t udp_mblock;        // udp socket对象内存块管理对象
 static nlist_t udp_list;           // 挂载已分配的udp socket对象链表
 
+static nlist_t udp_port_bucket[UDP_PORT_HASH_SIZE];
+static sock_hash_t udp_port_hash;  // 已绑定本地端口的udp对象, 以本地端口为键
+static uint32_t udp_flow_seed;     // 计算流哈希值的扰动值, 用于SO_REUSEPORT分流
+
 #if DBG_DISP_ENABLED(DBG_UDP)
 
 /**
@@ -81,6 +86,13 @@ net_err_t udp_module_init(void) {
   // 初始化udp socket对象挂载链表
   nlist_init(&udp_list);
 
+  // 初始化按本地端口查找使用的哈希表, 使用启动时间生成扰动值
+  net_time_t time;
+  sys_time_curr(&time);
+  udp_flow_seed = tools_hash32(&time, sizeof(time), (uint32_t)(uintptr_t)udp_tbl);
+  sock_hash_init(&udp_port_hash, SOCK_HASH_LOCAL, udp_port_bucket,
+                 UDP_PORT_HASH_SIZE, udp_flow_seed ^ 0x5bd1e995U);
+
   dbg_info(DBG_UDP, "init udp module ok.");
 
   return NET_ERR_OK;
@@ -107,10 +119,11 @@ static udp_t *udp_alloc(void) {
  * @return void*
  */
 static void *udp_free(udp_t *udp) {
-  // 将udp对象从挂载链表中移除
+  // 将udp对象从挂载链表及端口哈希表中移除
   if (nlist_is_mount(&udp->sock_base.node)) {
     nlist_remove(&udp_list, &udp->sock_base.node);
   }
+  sock_hash_remove(&udp->sock_base);
 
   // 将udp对象内存块释放
   mblock_free(&udp_mblock, udp);
@@ -126,8 +139,8 @@ static int udp_port_is_used(uint16_t port) {
   nlist_node_t *node = (nlist_node_t *)0;
   sock_t *sock = (sock_t *)0;
 
-  nlist_for_each(node, &udp_list) {
-    sock = nlist_entry(node, sock_t, node);
+  nlist_for_each(node, sock_hash_local_bucket(&udp_port_hash, port)) {
+    sock = nlist_entry(node, sock_t, hash_node);
     if (sock->local_port == port) {
       return 1;
     }
@@ -148,8 +161,9 @@ static net_err_t udp_port_alloc(sock_t *sock) {
     last_alloc_port = (last_alloc_port + 1 % NET_PORT_END);
     last_alloc_port = last_alloc_port ? last_alloc_port : NET_PORT_START;
     if (!udp_port_is_used(last_alloc_port)) {
-      // 本地端口号未被使用，分配该端口号
+      // 本地端口号未被使用，分配该端口号, 并挂载到端口哈希表以接收数据包
       sock->local_port = last_alloc_port;
+      sock_hash_insert(&udp_port_hash, sock);
       udp_disp_list();
       return NET_ERR_OK;
     }
@@ -194,9 +208,11 @@ static net_err_t udp_send(ipaddr_t *dest_ip, uint16_t dest_port,
   udp_hdr->total_len = net_htons(pktbuf_total_size(buf));
   udp_hdr->checksum = 0;
 
-  // 计算udp头部校验和(携带伪头部)
-  udp_hdr->checksum =
-      tools_checksum16_pseudo_head(buf, dest_ip, src_ip, NET_PROTOCOL_UDP);
+  // 计算udp头部校验和(携带伪头部), 超级数据报由网络接口切分后为每个数据报计算
+  if (!buf->gso_size) {
+    udp_hdr->checksum =
+        tools_checksum16_pseudo_head(buf, dest_ip, src_ip, NET_PROTOCOL_UDP);
+  }
 
   // 通过ipv4传输协议发送数据
   err = ipv4_send(NET_PROTOCOL_UDP, dest_ip, src_ip, buf);
@@ -252,6 +268,32 @@ static net_err_t udp_sendto(struct _sock_t *sock, const void *buf,
     return sock->err_code;
   }
 
+  // 设置了UDP_SEGMENT且数据超过一个数据报时, 作为超级数据报下交,
+  // 只经过一次udp及ip层处理(路由查找、头部构造), 由网络接口在发送前切分为多个数据报
+  udp_t *udp = (udp_t *)sock;
+  int gso_size = 0;
+  if (udp->gso_size && buf_len > udp->gso_size) {
+    if (buf_len > UDP_MAX_PAYLOAD ||
+        (buf_len + udp->gso_size - 1) / udp->gso_size > UDP_GSO_MAX_SEGS) {
+      dbg_error(DBG_UDP, "udp segment too many.");
+      return NET_ERR_PARAM;
+    }
+
+    // 切分后的数据报不进行ip分片, 每个数据报都不能超过网络接口的mtu
+    route_entry_t *rt_entry = route_find(&remote_ip);
+    if (!rt_entry) {
+      dbg_error(DBG_UDP, "route entry not found.");
+      return NET_ERR_UDP;
+    }
+    int mtu = rt_entry->netif->mtu;
+    if (mtu && udp->gso_size + (int)(sizeof(udp_hdr_t) + sizeof(ipv4_hdr_t)) >
+                   mtu) {
+      dbg_error(DBG_UDP, "udp segment size exceeds mtu.");
+      return NET_ERR_PARAM;
+    }
+    gso_size = udp->gso_size;
+  }
+
   // TODO: 若分配的数据包缓冲区大小不足，将数据分多次发送
   // 为待发送数据分配一个数据包缓冲区
   pktbuf_t *pktbuf = pktbuf_alloc(buf_len);  //!!! 获取数据包
@@ -259,6 +301,7 @@ static net_err_t udp_sendto(struct _sock_t *sock, const void *buf,
     dbg_error(DBG_UDP, "no memory for pktbuf.");
     return NET_ERR_UDP;
   }
+  pktbuf->gso_size = gso_size;
 
   // 将待发送数据拷包到数据包缓冲区
   net_err_t err = pktbuf_write(pktbuf, buf, buf_len);
@@ -291,19 +334,20 @@ static net_err_t udp_sendto(struct _sock_t *sock, const void *buf,
  *       ! 上层应用必须保证buf缓冲区大小足够大，以接收一个完整的数据包。
  *       ! 若无法接收完整的数据包，将导致数据丢失，返回错误。
  *       ! 读取成功后返回的一定是该数据包的大小。
+ *       设置了UDP_GRO时, 数据包可能由同一个流的多个数据报合并而成, 通过segsize返回每个数据报的大小
  *
  * @param sock 基类socket对象
  * @param buf 接收数据缓冲区
  * @param buf_len 缓冲区大小
- * @param flags 选项设置标志位
  * @param src 源socket地址
  * @param src_len socket地址对象大小
+ * @param segsize 返回合并的数据报大小, 未合并时为0, 可为空
  * @param ret_recv_len 实际接收数据大小
  * @return net_err_t
  */
-static net_err_t udp_recvfrom(struct _sock_t *sock, void *buf, size_t buf_len,
-                              int flags, struct net_sockaddr *src,
-                              net_socklen_t *src_len, ssize_t *ret_recv_len) {
+static net_err_t udp_recv_pkt(struct _sock_t *sock, void *buf, size_t buf_len,
+                              struct net_sockaddr *src, net_socklen_t *src_len,
+                              int *segsize, ssize_t *ret_recv_len) {
   // 将基类sock对象转换为udp对象，并从其接收缓冲区链表中获取数据包
   udp_t *udp = (udp_t *)sock;
   nlist_node_t *node = nlist_remove_first(&udp->recv_buf_list);
@@ -327,6 +371,9 @@ static net_err_t udp_recvfrom(struct _sock_t *sock, void *buf, size_t buf_len,
   int data_len = pktbuf_total_size(pktbuf);
   int copy_len = data_len > buf_len ? buf_len : data_len;
   net_err_t err = pktbuf_read(pktbuf, buf, copy_len);
+  if (segsize) {
+    *segsize = pktbuf->gso_size;
+  }
   pktbuf_free(pktbuf);  //!!! 释放数据包
   if (err != NET_ERR_OK) {
     dbg_error(DBG_UDP, "pktbuf read failed.");
@@ -341,6 +388,42 @@ static net_err_t udp_recvfrom(struct _sock_t *sock, void *buf, size_t buf_len,
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 从sock对象中接收一个数据包，并记录发送方socket地址
+ *
+ * @param sock 基类socket对象
+ * @param buf 接收数据缓冲区
+ * @param buf_len 缓冲区大小
+ * @param flags 选项设置标志位
+ * @param src 源socket地址
+ * @param src_len socket地址对象大小
+ * @param ret_recv_len 实际接收数据大小
+ * @return net_err_t
+ */
+static net_err_t udp_recvfrom(struct _sock_t *sock, void *buf, size_t buf_len,
+                              int flags, struct net_sockaddr *src,
+                              net_socklen_t *src_len, ssize_t *ret_recv_len) {
+  return udp_recv_pkt(sock, buf, buf_len, src, src_len, (int *)0,
+                      ret_recv_len);
+}
+
+/**
+ * @brief 从sock对象中接收一个数据包, 通过msg返回发送方socket地址及合并的数据报大小
+ *
+ * @param sock 基类socket对象
+ * @param msg 应用程序的消息结构
+ * @param flags 选项设置标志位
+ * @param ret_recv_len 实际接收数据大小
+ * @return net_err_t
+ */
+static net_err_t udp_recvmsg(struct _sock_t *sock, struct net_msghdr *msg,
+                             int flags, ssize_t *ret_recv_len) {
+  msg->msg_namelen = 0;
+  msg->msg_segsize = 0;
+  return udp_recv_pkt(sock, msg->msg_buf, msg->msg_buflen, msg->msg_name,
+                      &msg->msg_namelen, &msg->msg_segsize, ret_recv_len);
+}
+
 /**
  * @brief 释放一个原始socket对象
  *
@@ -399,16 +482,19 @@ static net_err_t udp_bind(sock_t *sock, const struct net_sockaddr *addr,
     return NET_ERR_UDP;
   }
 
-  // 获取端口号, 并判断端口号是否已被绑定
+  // 获取端口号, 并判断端口号是否已被绑定,
+  // 只有双方都设置了SO_REUSEPORT时才允许绑定同一地址及端口
   const struct net_sockaddr_in *addr_in = (const struct net_sockaddr_in *)addr;
   ipaddr_t local_ip;
   ipaddr_from_bytes(&local_ip, addr_in->sin_addr.s_addr_bytes);
   uint16_t local_port = net_ntohs(addr_in->sin_port);
+  int reuseport = ((udp_t *)sock)->reuseport;
   nlist_node_t *node = (nlist_node_t *)0;
-  nlist_for_each(node, &udp_list) {
-    sock_t *sock = nlist_entry(node, sock_t, node);
-    if (sock->local_port == local_port &&
-        ipaddr_is_equal(&sock->local_ip, &local_ip)) {
+  nlist_for_each(node, sock_hash_local_bucket(&udp_port_hash, local_port)) {
+    sock_t *other = nlist_entry(node, sock_t, hash_node);
+    if (other->local_port == local_port &&
+        ipaddr_is_equal(&other->local_ip, &local_ip) &&
+        !(reuseport && ((udp_t *)other)->reuseport)) {
       dbg_error(DBG_UDP, "port has bind.");
       return NET_ERR_UDP;
     }
@@ -416,11 +502,114 @@ static net_err_t udp_bind(sock_t *sock, const struct net_sockaddr *addr,
 
   // socket未进行绑定，且端口号未被使用，绑定本地ip和端口号
   net_err_t err = sock_bind(sock, &local_ip, local_port);
+  if (err == NET_ERR_OK) {
+    sock_hash_insert(&udp_port_hash, sock);
+  }
   udp_disp_list();
 
   return err;
 }
 
+/**
+ * @brief 设置udp socket选项, SO_REUSEPORT只能在绑定端口前设置, 其余选项由基类处理
+ *
+ * @param sock
+ * @param level
+ * @param optname
+ * @param optval
+ * @param optlen
+ * @return net_err_t
+ */
+static net_err_t udp_setopt(sock_t *sock, int level, int optname,
+                            const char *optval, int optlen) {
+  udp_t *udp = (udp_t *)sock;
+
+  if (level == SOL_UDP) {
+    if (optlen != sizeof(int)) {
+      dbg_error(DBG_UDP, "invalid UDP option value: optlen != sizeof(int).");
+      return NET_ERR_UDP;
+    }
+
+    int val = *((int *)optval);
+    switch (optname) {
+      case UDP_SEGMENT: {  // 分段发送的数据报大小
+        if (val < 0 || val > UDP_MAX_PAYLOAD) {
+          dbg_error(DBG_UDP, "invalid UDP segment size.");
+          return NET_ERR_UDP;
+        }
+        udp->gso_size = val;
+      } break;
+      case UDP_GRO: {  // 接收合并, 只影响之后到达的数据报
+        udp->gro = val ? 1 : 0;
+      } break;
+      default: {
+        dbg_error(DBG_UDP, "invalid UDP option name.");
+        return NET_ERR_UDP;
+      } break;
+    }
+    return NET_ERR_OK;
+  }
+
+  if (level == SOL_SOCKET && optname == SO_REUSEPORT) {
+    if (optlen != sizeof(int)) {
+      dbg_error(DBG_UDP, "invalid UDP option value: optlen != sizeof(int).");
+      return NET_ERR_UDP;
+    }
+    if (sock->local_port) {  // 已与其他socket共享的端口上不能再修改
+      dbg_error(DBG_UDP, "socket has bind, can't set SO_REUSEPORT.");
+      return NET_ERR_UDP;
+    }
+    ((udp_t *)sock)->reuseport = *((int *)optval) ? 1 : 0;
+    return NET_ERR_OK;
+  }
+
+  return sock_setopt(sock, level, optname, optval, optlen);
+}
+
+/**
+ * @brief 获取udp socket选项
+ *
+ * @param sock
+ * @param level
+ * @param optname
+ * @param optval
+ * @param optlen 传入缓冲区大小, 返回选项值的实际长度
+ * @return net_err_t
+ */
+static net_err_t udp_getopt(sock_t *sock, int level, int optname, char *optval,
+                            int *optlen) {
+  udp_t *udp = (udp_t *)sock;
+
+  if (level == SOL_UDP) {
+    if (*optlen < (int)sizeof(int)) {
+      dbg_error(DBG_UDP, "invalid UDP option len.");
+      return NET_ERR_UDP;
+    }
+    if (optname == UDP_SEGMENT) {
+      *((int *)optval) = udp->gso_size;
+    } else if (optname == UDP_GRO) {
+      *((int *)optval) = udp->gro;
+    } else {
+      dbg_error(DBG_UDP, "invalid UDP option name.");
+      return NET_ERR_UDP;
+    }
+    *optlen = sizeof(int);
+    return NET_ERR_OK;
+  }
+
+  if (level == SOL_SOCKET && optname == SO_REUSEPORT) {
+    if (*optlen < (int)sizeof(int)) {
+      dbg_error(DBG_UDP, "invalid UDP option len.");
+      return NET_ERR_UDP;
+    }
+    *((int *)optval) = ((udp_t *)sock)->reuseport;
+    *optlen = sizeof(int);
+    return NET_ERR_OK;
+  }
+
+  return sock_getopt(sock, level, optname, optval, optlen);
+}
+
 /**
  * @brief 内部接口，创建一个udp socket对象
  *
@@ -432,7 +621,9 @@ sock_t *udp_create(int family, int protocol) {
   static const sock_ops_t udp_ops = {
       .sendto = udp_sendto,      // 独立实现接口
       .recvfrom = udp_recvfrom,  // 独立实现接口
-      .setopt = sock_setopt,     // 继承基类的实现
+      .recvmsg = udp_recvmsg,    // 独立实现接口
+      .setopt = udp_setopt,      // 独立实现接口
+      .getopt = udp_getopt,      // 独立实现接口
       .close = udp_close,        // 独立实现接口
       .connect = udp_connect,    // 独立实现接口
       .bind = udp_bind,
@@ -453,6 +644,9 @@ sock_t *udp_create(int family, int protocol) {
 
   // 初始化udp的数据包接收缓存链表
   nlist_init(&udp->recv_buf_list);
+  udp->reuseport = 0;
+  udp->gso_size = 0;
+  udp->gro = 0;
 
   // 使用基类sock记录udp sock的wait对象, 并初始化
   udp->sock_base.recv_wait = &udp->recv_wait;
@@ -469,15 +663,75 @@ sock_t *udp_create(int family, int protocol) {
 }
 
 /**
- * @brief 根据源ip地址、源端口号、目的ip地址、目的端口号查找udp
+ * @brief 计算udp对象与数据包地址信息的匹配程度, 绑定的地址项越具体得分越高
  *
  * local_ip | local_port | remote_ip | remote_port |
- * 0       | 指定        | 0         | 0           |
- * 可接收任意源ip地址和端口号的udp数据包(服务器模式) 指定    | 指定        | 0
- * | 0           | 从指定网络接口接任意源ip地址和端口号的udp数据包(限制接收网卡)
- * 0       | 0           | 指定      | 指定        |
- * 只与指定的目的ip地址和端口号之间收发udp数据包(客户端模式)
- * TODO: 细化匹配规则，若端口号重复，则采用匹配项数最多的规则
+ * 0        | 指定       | 0         | 0           | 可接收任意源地址的udp数据包(服务器模式)
+ * 指定     | 指定       | 0         | 0           | 只接收发往指定本地ip的udp数据包(限制接收网卡)
+ * 任意     | 指定       | 指定      | 指定        | 只与指定的远端地址收发udp数据包(客户端模式)
+ *
+ * @param sock
+ * @param src_ip
+ * @param src_port
+ * @param dest_ip
+ * @param dest_port
+ * @return int 匹配的地址项数量, 不匹配时返回-1
+ */
+static int udp_match_score(sock_t *sock, ipaddr_t *src_ip, uint16_t src_port,
+                           ipaddr_t *dest_ip, uint16_t dest_port) {
+  if (sock->local_port != dest_port) {  // 目的端口号不匹配
+    return -1;
+  }
+
+  int score = 0;
+  if (!ipaddr_is_any(&sock->local_ip)) {
+    if (!ipaddr_is_equal(&sock->local_ip, dest_ip)) {
+      return -1;  // 已绑定本地ip地址，但与目的ip地址不匹配
+    }
+    score++;
+  }
+  if (!ipaddr_is_any(&sock->remote_ip)) {
+    if (!ipaddr_is_equal(&sock->remote_ip, src_ip)) {
+      return -1;  // 已绑定远端ip地址，但与源ip地址不匹配
+    }
+    score++;
+  }
+  if (sock->remote_port) {
+    if (sock->remote_port != src_port) {
+      return -1;  // 已绑定远端端口号，但与源端口号不匹配
+    }
+    score++;
+  }
+
+  return score;
+}
+
+/**
+ * @brief 计算数据报所属流的哈希值, 同一个流(四元组)的数据报哈希值相同
+ *
+ * @param src_ip
+ * @param src_port
+ * @param dest_ip
+ * @param dest_port
+ * @return uint32_t
+ */
+static uint32_t udp_flow_hash(ipaddr_t *src_ip, uint16_t src_port,
+                              ipaddr_t *dest_ip, uint16_t dest_port) {
+  uint8_t data[IP_ADDR_SIZE * 2 + 4];
+  plat_memcpy(data, src_ip->addr_bytes, IP_ADDR_SIZE);
+  plat_memcpy(data + IP_ADDR_SIZE, dest_ip->addr_bytes, IP_ADDR_SIZE);
+  data[IP_ADDR_SIZE * 2] = (uint8_t)(src_port >> 8);
+  data[IP_ADDR_SIZE * 2 + 1] = (uint8_t)src_port;
+  data[IP_ADDR_SIZE * 2 + 2] = (uint8_t)(dest_port >> 8);
+  data[IP_ADDR_SIZE * 2 + 3] = (uint8_t)dest_port;
+  return tools_hash32(data, sizeof(data), udp_flow_seed);
+}
+
+/**
+ * @brief 根据源ip地址、源端口号、目的ip地址、目的端口号查找udp对象,
+ *        在目的端口所在的哈希桶中选出匹配项最多的对象;
+ *        多个设置了SO_REUSEPORT的对象匹配程度相同时, 按流的哈希值选择其中之一,
+ *        使同一个流的数据报总是交给同一个socket, 不同的流分散到各个socket
  *
  * @param src_ip
  * @param src_port
@@ -487,38 +741,48 @@ sock_t *udp_create(int family, int protocol) {
  */
 static udp_t *udp_find(ipaddr_t *src_ip, uint16_t src_port, ipaddr_t *dest_ip,
                        uint16_t dest_port) {
+  nlist_t *bucket = sock_hash_local_bucket(&udp_port_hash, dest_port);
   nlist_node_t *node = (nlist_node_t *)0;
-  sock_t *sock = (sock_t *)0;
-
-  // TODO: 优化查找算法，选出四元组匹配项最多的udp sock对象
-  nlist_for_each(node, &udp_list) {
-    sock = nlist_entry(node, sock_t, node);
-    if (sock->local_port != dest_port) {  // 目的端口号不匹配
+  udp_t *best = (udp_t *)0;
+  int best_score = -1;
+  int reuse_cnt = 0;  // 与best匹配程度相同且设置了SO_REUSEPORT的对象数量
+
+  nlist_for_each(node, bucket) {
+    sock_t *sock = nlist_entry(node, sock_t, hash_node);
+    int score = udp_match_score(sock, src_ip, src_port, dest_ip, dest_port);
+    if (score < 0 || score < best_score) {
       continue;
     }
 
-    if (!ipaddr_is_any(&sock->local_ip) &&
-        !ipaddr_is_equal(&sock->local_ip, dest_ip)) {
-      // udp sock对象已绑定本地ip地址，但与指定的目的ip地址不匹配
-      continue;
+    if (score > best_score) {
+      best = (udp_t *)sock;
+      best_score = score;
+      reuse_cnt = 0;
     }
-
-    if (!ipaddr_is_any(&sock->remote_ip) &&
-        !ipaddr_is_equal(&sock->remote_ip, src_ip)) {
-      // udp sock对象已绑定远端ip地址，但与指定的源ip地址不匹配
-      continue;
+    if (((udp_t *)sock)->reuseport) {
+      reuse_cnt++;
     }
+  }
 
-    if (sock->remote_port && sock->remote_port != src_port) {
-      // udp sock对象已绑定远端端口号，但与指定的源端口号不匹配
-      continue;
-    }
+  if (!best || !best->reuseport || reuse_cnt <= 1) {
+    return best;
+  }
 
-    // 找到匹配的udp sock对象
-    return (udp_t *)sock;
+  // 在共享端口的对象中按流的哈希值选择,
+  // FNV哈希值的低位只取决于输入的低位, 使用高位映射到[0, reuse_cnt)
+  uint32_t hash = udp_flow_hash(src_ip, src_port, dest_ip, dest_port);
+  int index = (int)(((uint64_t)hash * (uint32_t)reuse_cnt) >> 32);
+  nlist_for_each(node, bucket) {
+    sock_t *sock = nlist_entry(node, sock_t, hash_node);
+    if (((udp_t *)sock)->reuseport &&
+        udp_match_score(sock, src_ip, src_port, dest_ip, dest_port) ==
+            best_score &&
+        index-- == 0) {
+      return (udp_t *)sock;
+    }
   }
 
-  return (udp_t *)0;
+  return best;
 }
 
 /**
@@ -556,6 +820,46 @@ static net_err_t udp_check(pktbuf_t *udp_buf, ipaddr_t *src_ip,
   return NET_ERR_OK;
 }
 
+/**
+ * @brief 接收合并(UDP_GRO): 将数据报合并到接收队列中最后一个未读取的数据包,
+ *        要求两者来自同一个流(源地址相同), 已合并的数据报都是等长的且本数据报不超过该长度;
+ *        较短的数据报只能作为最后一个, 合并后该数据包不再接受合并,
+ *        使应用程序可以根据数据报大小还原每个数据报的边界
+ *
+ * @param udp
+ * @param buf 已通过检查的数据报, udp头部已修改为远端地址信息
+ * @return int 1: 已合并, 数据包已转交, 0: 不能合并
+ */
+static int udp_gro_merge(udp_t *udp, pktbuf_t *buf) {
+  nlist_node_t *node = nlist_last(&udp->recv_buf_list);
+  if (!node) {
+    return 0;
+  }
+  pktbuf_t *last = nlist_entry(node, pktbuf_t, node);
+
+  // 比较远端地址信息, 两个数据包的头部都已设置为内存连续
+  if (plat_memcmp(pktbuf_data_ptr(buf), pktbuf_data_ptr(last),
+                  sizeof(udp_remote_info_t)) != 0) {
+    return 0;
+  }
+
+  int size = pktbuf_total_size(buf) - sizeof(udp_hdr_t);
+  int last_size = pktbuf_total_size(last) - sizeof(udp_hdr_t);
+  int seg_size = last->gso_size ? last->gso_size : last_size;
+  if (size <= 0 || size > seg_size || last_size % seg_size ||
+      last_size + size > UDP_MAX_PAYLOAD) {
+    return 0;
+  }
+
+  // 去掉udp头部, 将数据报的数据块链接到上一个数据包之后
+  if (pktbuf_header_remove(buf, sizeof(udp_hdr_t)) != NET_ERR_OK) {
+    return 0;
+  }
+  pktbuf_join(last, buf);  //!!! 数据包转交
+  last->gso_size = seg_size;
+  return 1;
+}
+
 /**
  * @brief udp协议层接收数据包
  *
@@ -601,6 +905,11 @@ net_err_t udp_recv(pktbuf_t *buf, ipaddr_t *src_ip, ipaddr_t *dest_ip) {
   *(uint32_t *)remote_info->ip =
       src_ip->addr;  // 端口号不需要修改，默认在前两个字节
 
+  // 与同一个流之前到达且还未读取的数据报合并, 不需要再唤醒接收线程
+  if (udp->gro && udp_gro_merge(udp, buf)) {
+    return NET_ERR_OK;
+  }
+
   // 将数据包放入udp sock对象的接收缓存链表，等待应用层接收
   if (nlist_count(&udp->recv_buf_list) <
       UDP_RECV_MAXCNT) {  // 接收缓冲区链表未满, 缓存数据包
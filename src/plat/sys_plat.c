@@ -319,7 +319,8 @@ void sys_time_curr (net_time_t * time) {
 }
 
 /**
- * @brief 返回当前时间与传入的time之间时间差值, 调用完成之后，time被更新为当前时间
+ * @brief 返回当前时间与传入的time之间时间差值(整毫秒), 调用完成之后，time推进返回的毫秒数,
+ * 不足1ms的部分保留到下次调用(定时器扫描及发送节奏定时器每毫秒左右调用一次, 截断会使时钟变慢)
  * 
  * 第一次调用时，返回的时间差值无效
  */
@@ -329,10 +330,14 @@ int sys_time_goes (net_time_t * pre) {
     gettimeofday(&curr, NULL);
 
     // 记录过去了多少毫秒
-    int diff_ms = (curr.tv_sec - pre->tv_sec) * 1000 + (curr.tv_usec - pre->tv_usec) / 1000;
-
-    // 记录下这次调用的时间
-    *pre  = curr;
+    long diff_us = (curr.tv_sec - pre->tv_sec) * 1000000L + (curr.tv_usec - pre->tv_usec);
+    int diff_ms = (int)(diff_us / 1000);
+
+    // 只将记录的时间推进已计入的整毫秒数, 不足1ms的部分留到下次调用,
+    // 否则频繁调用时每次都会丢弃不足1ms的部分, 导致时钟变慢
+    long usec = pre->tv_usec + (long)diff_ms * 1000;
+    pre->tv_sec += usec / 1000000;
+    pre->tv_usec = usec % 1000000;
     return diff_ms;
 }
 
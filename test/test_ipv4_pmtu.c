@@ -0,0 +1,146 @@
+/**
+ * @file test_ipv4_pmtu.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 路径mtu发现测试: 通过原始socket向环回接口发送icmp"需要分片"报文,
+ *        验证路径mtu缓存按报文中的下一跳mtu更新、只接受更小的值,
+ *        以及路由器未填写下一跳mtu时按常用mtu表估计
+ * @version 0.1
+ * @date 2024-12-08
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ipv4.h"
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+
+/**
+ * @brief 计算icmp报文的校验和
+ *
+ * @param data
+ * @param len
+ * @return uint16_t
+ */
+static uint16_t test_checksum16(const uint8_t *data, int len) {
+  uint32_t sum = 0;
+  for (int i = 0; i + 1 < len; i += 2) {
+    sum += data[i] | (data[i + 1] << 8);
+  }
+  if (len & 1) {
+    sum += data[len - 1];
+  }
+  while (sum >> 16) {
+    sum = (sum & 0xffff) + (sum >> 16);
+  }
+  return (uint16_t)~sum;
+}
+
+/**
+ * @brief 向本机发送一个icmp"需要分片"报文, 报文中引用的原始数据包发往dest
+ *
+ * @param raw 原始socket
+ * @param dest 原始数据包的目的地址
+ * @param total_len 原始数据包的总长度
+ * @param next_mtu 下一跳mtu, 0表示未填写
+ * @return int 0: 成功, -1: 失败
+ */
+static int test_send_frag_needed(int raw, const char *dest, int total_len,
+                                 int next_mtu) {
+  uint8_t msg[8 + 20 + 8];
+  plat_memset(msg, 0, sizeof(msg));
+
+  // icmp头部: 类型3(不可达), 代码4(需要分片), 16位未使用 + 16位下一跳mtu
+  msg[0] = 3;
+  msg[1] = 4;
+  msg[6] = (uint8_t)(next_mtu >> 8);
+  msg[7] = (uint8_t)next_mtu;
+
+  // 原始数据包的ipv4头部(网络字节序), 传输层为udp
+  uint8_t *ip = msg + 8;
+  ip[0] = 0x45;
+  ip[2] = (uint8_t)(total_len >> 8);
+  ip[3] = (uint8_t)total_len;
+  ip[6] = 0x40;  // 禁止分片
+  ip[8] = 64;
+  ip[9] = 17;
+  uint32_t src = inet_addr("127.0.0.1");
+  uint32_t dst = inet_addr(dest);
+  plat_memcpy(ip + 12, &src, 4);
+  plat_memcpy(ip + 16, &dst, 4);
+
+  uint16_t chksum = test_checksum16(msg, sizeof(msg));
+  plat_memcpy(msg + 2, &chksum, 2);
+
+  struct sockaddr_in addr;
+  plat_memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  int len = sendto(raw, msg, sizeof(msg), 0, (const struct sockaddr *)&addr,
+                   sizeof(addr));
+  sys_sleep(50);  // 等待工作线程处理
+  return len == sizeof(msg) ? 0 : -1;
+}
+
+/**
+ * @brief 获取到达dest的路径mtu
+ *
+ * @param dest
+ * @return int
+ */
+static int test_pmtu(const char *dest) {
+  ipaddr_t ip;
+  ipaddr_from_str(&ip, dest);
+  return ipv4_pmtu_get(&ip, NET_MAC_FRAME_MTU);
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  int raw = socket(AF_INET, SOCK_RAW, IPPROTO_ICMP);
+  if (raw < 0) {
+    plat_printf("create raw socket error\n");
+    return -1;
+  }
+
+  int err = 0;
+
+  // 按报文中的下一跳mtu更新路径mtu
+  err |= test_send_frag_needed(raw, "10.0.0.1", 1500, 1200);
+  int pmtu = test_pmtu("10.0.0.1");
+  plat_printf("ipv4 pmtu: next mtu 1200 -> %d (expect 1200)\n", pmtu);
+  err |= pmtu != 1200;
+
+  // 只接受更小的路径mtu
+  err |= test_send_frag_needed(raw, "10.0.0.1", 1500, 1400);
+  pmtu = test_pmtu("10.0.0.1");
+  plat_printf("ipv4 pmtu: larger next mtu 1400 -> %d (expect 1200)\n", pmtu);
+  err |= pmtu != 1200;
+
+  // 过小的下一跳mtu被限制在IPV4_PMTU_MIN
+  err |= test_send_frag_needed(raw, "10.0.0.1", 1200, 100);
+  pmtu = test_pmtu("10.0.0.1");
+  plat_printf("ipv4 pmtu: next mtu 100 -> %d (expect %d)\n", pmtu,
+              IPV4_PMTU_MIN);
+  err |= pmtu != IPV4_PMTU_MIN;
+
+  // 未填写下一跳mtu, 按原始数据包大小从常用mtu表中估计
+  err |= test_send_frag_needed(raw, "10.0.0.2", 1500, 0);
+  pmtu = test_pmtu("10.0.0.2");
+  plat_printf("ipv4 pmtu: no next mtu, 1500 bytes -> %d (expect 1492)\n", pmtu);
+  err |= pmtu != 1492;
+
+  // 没有缓存的目的主机使用网络接口的mtu
+  pmtu = test_pmtu("10.0.0.3");
+  plat_printf("ipv4 pmtu: uncached -> %d (expect %d)\n", pmtu,
+              NET_MAC_FRAME_MTU);
+  err |= pmtu != NET_MAC_FRAME_MTU;
+
+  close(raw);
+  return err ? -1 : 0;
+}
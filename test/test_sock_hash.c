@@ -0,0 +1,148 @@
+/**
+ * @file test_sock_hash.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief socket地址哈希表查找性能测试: 分别在10, 1k, 100k个已连接sock对象中,
+ *        比较链表线性查找与四元组哈希表查找每次所需的时间
+ * @version 0.1
+ * @date 2024-11-30
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "nlist.h"
+#include "sock.h"
+#include "sock_hash.h"
+#include "sys_plat.h"
+
+#define TEST_LOOKUP_CNT 1000000        // 哈希表查找的总次数
+#define TEST_LINEAR_WORK (200000000LL)  // 线性查找比较次数的上限，避免测试时间过长
+
+/**
+ * @brief 线性遍历链表查找四元组匹配的sock对象(哈希表之前tcp_find的做法)
+ *
+ * @param list
+ * @param local_ip
+ * @param local_port
+ * @param remote_ip
+ * @param remote_port
+ * @return sock_t*
+ */
+static sock_t *linear_find(nlist_t *list, const ipaddr_t *local_ip,
+                           uint16_t local_port, const ipaddr_t *remote_ip,
+                           uint16_t remote_port) {
+  nlist_node_t *node = (nlist_node_t *)0;
+  nlist_for_each(node, list) {
+    sock_t *sock = nlist_entry(node, sock_t, node);
+    if (sock->local_port == local_port && sock->remote_port == remote_port &&
+        ipaddr_is_equal(&sock->remote_ip, remote_ip) &&
+        ipaddr_is_equal(&sock->local_ip, local_ip)) {
+      return sock;
+    }
+  }
+
+  return (sock_t *)0;
+}
+
+/**
+ * @brief 获取经过的时间(ns)
+ *
+ * @param start
+ * @return double
+ */
+static double elapsed_ns(clock_t start) {
+  return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief 以指定数量的已连接sock对象进行一轮测试
+ *
+ * @param sock_cnt
+ * @return int 0: 成功, -1: 失败
+ */
+static int test_round(int sock_cnt) {
+  // 哈希桶数量取不小于对象数量的2的幂, 对应按连接规模配置TCP_CONN_HASH_SIZE
+  int bucket_cnt = 1;
+  while (bucket_cnt < sock_cnt) {
+    bucket_cnt <<= 1;
+  }
+
+  sock_t *sock_tbl = (sock_t *)calloc(sock_cnt, sizeof(sock_t));
+  nlist_t *bucket_tbl = (nlist_t *)calloc(bucket_cnt, sizeof(nlist_t));
+  int *order = (int *)calloc(TEST_LOOKUP_CNT, sizeof(int));
+  if (!sock_tbl || !bucket_tbl || !order) {
+    plat_printf("no memory\n");
+    return -1;
+  }
+
+  sock_hash_t hash;
+  nlist_t list;
+  sock_hash_init(&hash, SOCK_HASH_CONN, bucket_tbl, bucket_cnt, 0x12345678);
+  nlist_init(&list);
+
+  // 模拟一个服务端端口上来自不同客户端的连接
+  for (int i = 0; i < sock_cnt; i++) {
+    sock_t *sock = &sock_tbl[i];
+    ipaddr_from_str(&sock->local_ip, "192.168.1.100");
+    sock->local_port = 80;
+    sock->remote_ip.addr_bytes[0] = 10;
+    sock->remote_ip.addr_bytes[1] = (uint8_t)(i >> 16);
+    sock->remote_ip.addr_bytes[2] = (uint8_t)(i >> 8);
+    sock->remote_ip.addr_bytes[3] = (uint8_t)i;
+    sock->remote_port = (uint16_t)(1024 + (i * 7) % 60000);
+    nlist_insert_last(&list, &sock->node);
+    sock_hash_insert(&hash, sock);
+  }
+
+  // 随机选择被查找的连接, 使最近命中缓存不起作用, 测量的是最坏情况
+  srand(1);
+  for (int i = 0; i < TEST_LOOKUP_CNT; i++) {
+    order[i] = rand() % sock_cnt;
+  }
+
+  int err = 0;
+  clock_t start = clock();
+  for (int i = 0; i < TEST_LOOKUP_CNT; i++) {
+    sock_t *target = &sock_tbl[order[i]];
+    if (sock_hash_find(&hash, &target->local_ip, target->local_port,
+                       &target->remote_ip, target->remote_port,
+                       (sock_hash_match_t)0) != target) {
+      err = -1;
+    }
+  }
+  double hash_ns = elapsed_ns(start) / TEST_LOOKUP_CNT;
+
+  long long linear_cnt = TEST_LINEAR_WORK / sock_cnt;
+  linear_cnt = linear_cnt < TEST_LOOKUP_CNT ? linear_cnt : TEST_LOOKUP_CNT;
+  start = clock();
+  for (int i = 0; i < linear_cnt; i++) {
+    sock_t *target = &sock_tbl[order[i]];
+    if (linear_find(&list, &target->local_ip, target->local_port,
+                    &target->remote_ip, target->remote_port) != target) {
+      err = -1;
+    }
+  }
+  double linear_ns = elapsed_ns(start) / linear_cnt;
+
+  plat_printf("%6d socks: linear %10.1f ns/lookup, hash %6.1f ns/lookup "
+              "(%d buckets)\n",
+              sock_cnt, linear_ns, hash_ns, bucket_cnt);
+
+  free(order);
+  free(bucket_tbl);
+  free(sock_tbl);
+  return err;
+}
+
+int main(void) {
+  int err = 0;
+  err |= test_round(10);
+  err |= test_round(1000);
+  err |= test_round(100000);
+  return err;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file test_tcp_accept.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp被动打开性能测试: 通过环回接口反复建立并关闭连接,
+ *        统计监听socket每秒可以accept的连接数;
+ *        并检查已建立连接使用的本地端口不能再被其他socket绑定
+ * @version 0.1
+ * @date 2024-11-22
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6000       // 监听端口
+#define TEST_BIND_PORT 6016  // 客户端绑定的本地端口
+#define TEST_CONN_CNT 1000   // 建立连接的总次数
+
+static test_server_t server;   // 服务端
+static int accept_cnt = 0;     // 服务端已accept的连接数
+
+/**
+ * @brief 服务端处理一个连接: 等待客户端主动关闭后再关闭, 使TIME_WAIT留在客户端
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  char buf[16];
+  while (recv(client, buf, sizeof(buf), 0) > 0) {
+  }
+  accept_cnt++;
+}
+
+/**
+ * @brief 客户端绑定端口后建立连接(之后只挂载在连接哈希表中), 检查该端口不能再被绑定
+ *
+ * @return int 0: 绑定被拒绝, -1: 出错或绑定成功
+ */
+static int bind_conflict_check(void) {
+  struct sockaddr_in addr;
+  test_addr_init(&addr, (const char *)0, TEST_BIND_PORT);
+
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  if (client < 0 ||
+      bind(client, (const struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      test_tcp_connect(client, "127.0.0.1", TEST_PORT) < 0) {
+    plat_printf("bind client error\n");
+    return -1;
+  }
+
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  int used = s >= 0 &&
+             bind(s, (const struct sockaddr *)&addr, sizeof(addr)) < 0;
+  plat_printf("tcp bind port of a connection: %s\n",
+              used ? "refused" : "accepted");
+  close(s);
+  close(client);
+  return used ? 0 : -1;
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  net_time_t start;
+  sys_time_curr(&start);
+
+  int conn_cnt = 0;
+  for (int i = 0; i < TEST_CONN_CNT; i++) {
+    int client = socket(AF_INET, SOCK_STREAM, 0);
+    if (client < 0) {
+      plat_printf("create client socket error\n");
+      break;
+    }
+
+    if (test_tcp_connect(client, "127.0.0.1", TEST_PORT) < 0) {
+      plat_printf("connect error\n");
+      close(client);
+      break;
+    }
+    conn_cnt++;
+    close(client);
+  }
+
+  int ms = sys_time_goes(&start);
+  ms = ms ? ms : 1;
+  plat_printf("tcp accept: %d conns in %d ms, %d conns/s\n", conn_cnt, ms,
+              conn_cnt * 1000 / ms);
+
+  if (bind_conflict_check() < 0) {
+    return -1;
+  }
+  return conn_cnt == TEST_CONN_CNT ? 0 : -1;
+}
@@ -0,0 +1,232 @@
+/**
+ * @file test_tcp_bbr.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp拥塞控制及发送节奏控制测试: 打开一个模拟瓶颈链路的网络接口,
+ *        数据方向的报文先进入容量较小(浅缓冲)的瓶颈队列, 按固定的链路速率出队,
+ *        两个方向的报文再经过固定的传播时延后由接口接收,
+ *        分别使用Reno突发发送、BBR按速率发送、Reno限制发送速率(SO_MAX_PACING_RATE)
+ *        及Reno启用ECN(瓶颈队列积压超过阈值时为ECT报文标记CE)四种方式发送相同的数据,
+ *        统计吞吐量、报文在瓶颈队列中的排队时延、丢包数及拥塞标记数, 服务端校验接收数据的正确性,
+ *        并检查每种方式的吞吐量不低于链路速率的1/4, 丢包恢复不会退化为每轮只补上一个空缺
+ * @version 0.1
+ * @date 2024-12-10
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "ipv4.h"
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp_ecn.h"
+#include "test_util.h"
+#include "tools.h"
+
+#define TEST_PORT 6006                    // 监听端口
+#define TEST_IP "10.10.0.1"               // 模拟链路接口的ip地址
+#define TEST_WRITE_SIZE (256 * 1024)      // 每次发送调用的数据量
+#define TEST_DATA_SIZE (1024 * 1024)      // 每轮测试发送的数据量
+
+#define LINK_RATE 1250000     // 瓶颈链路速率(字节/s), 10Mbit/s
+#define LINK_DELAY 10         // 单向传播时延(ms), rtt为20ms, 带宽时延积约25KB
+#define LINK_QUEUE_SIZE (16 * 1024)  // 瓶颈队列容量(字节), 小于带宽时延积
+#define LINK_ECN_MARK (LINK_QUEUE_SIZE / 2)  // 瓶颈队列积压超过该字节数时为ECT报文标记CE
+#define TEST_RATE_MIN (LINK_RATE / 4)  // 每轮吞吐量的最小值(字节/s)
+
+static int link_marks;           // 本轮被标记了CE的报文数
+
+static test_server_t server;     // 服务端
+static volatile int recv_total;  // 服务端本轮已接收的数据量
+static volatile int recv_err;    // 服务端本轮接收到的错误数据量
+
+/**
+ * @brief 数据流中offset处的字节值, 每次发送调用使用同一个数据区
+ *
+ * @param offset
+ * @return uint8_t
+ */
+static uint8_t test_pattern(int offset) {
+  return (uint8_t)(offset % TEST_WRITE_SIZE % 251);
+}
+
+/**
+ * @brief 为支持ECN的报文标记CE, 并重新计算ip头部校验和
+ *
+ * @param buf
+ * @return int 1: 已标记, 0: 报文不支持ECN
+ */
+static int link_ecn_mark(pktbuf_t *buf) {
+  if (pktbuf_set_cont(buf, sizeof(ipv4_hdr_t)) != NET_ERR_OK) {
+    return 0;
+  }
+  uint8_t *ip = pktbuf_data_ptr(buf);
+  if ((ip[1] & 0x3) == IPV4_ECN_NOT_ECT) {
+    return 0;
+  }
+
+  int hdr_size = (ip[0] & 0xf) * 4;
+  ip[1] |= IPV4_ECN_CE;
+  ip[10] = ip[11] = 0;
+  uint16_t chksum = tools_checksum16(ip, hdr_size, 0, 0, 1);
+  plat_memcpy(ip + 10, &chksum, sizeof(chksum));
+  return 1;
+}
+
+/**
+ * @brief 服务端(接收方)发出的ack不经过瓶颈队列;
+ *        数据方向的报文进入瓶颈队列前, 积压超过阈值时为ECT报文标记拥塞
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) == 0 && seg.sport == TEST_PORT) {
+    return TEST_LINK_DIRECT;
+  }
+
+  int queued = test_link_queued();
+  if (queued >= LINK_ECN_MARK &&
+      queued + buf->total_size <= LINK_QUEUE_SIZE && link_ecn_mark(buf)) {
+    link_marks++;
+  }
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收并校验数据直到连接关闭
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[16 * 1024];
+  int len;
+  while ((len = recv(client, buf, sizeof(buf), 0)) > 0) {
+    for (int i = 0; i < len; i++) {
+      if (buf[i] != test_pattern(recv_total + i)) {
+        recv_err++;
+      }
+    }
+    recv_total += len;
+  }
+}
+
+/**
+ * @brief 以指定的拥塞控制算法及发送速率上限进行一轮测试
+ *        发送缓冲区只有TCP_SBUF_SIZE, 使用零拷贝发送使在途数据量不受其限制, 能够填满瓶颈队列,
+ *        数据区在整个测试期间不被修改, 不需要等待完成通知
+ *
+ * @param cc 拥塞控制算法
+ * @param max_rate 发送速率上限(字节/s), 为0表示不限制
+ * @param ecn 是否启用ECN, 启用时还需瓶颈队列标记过拥塞且发送方据此降低过拥塞窗口
+ * @param name 测试名称
+ * @return int 0: 成功, -1: 失败
+ */
+static int test_round(const char *cc, int max_rate, int ecn, const char *name) {
+  static uint8_t data[TEST_WRITE_SIZE];
+  for (int i = 0; i < TEST_WRITE_SIZE; i++) {
+    data[i] = test_pattern(i);
+  }
+
+  test_link_lock();
+  link_marks = 0;
+  test_link_unlock();
+  test_link_stats_get((test_link_stats_t *)0, 1);
+  recv_total = 0;
+  recv_err = 0;
+  tcp_ecn_stats_t ecn_start;
+  tcp_ecn_stats_get(&ecn_start);
+
+  int on = 1;
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  if (client < 0 ||
+      setsockopt(client, SOL_TCP, TCP_CONGESTION, cc, plat_strlen(cc)) < 0 ||
+      setsockopt(client, SOL_SOCKET, SO_ZEROCOPY, (const char *)&on,
+                 sizeof(int)) < 0 ||
+      setsockopt(client, SOL_SOCKET, SO_MAX_PACING_RATE,
+                 (const char *)&max_rate, sizeof(int)) < 0 ||
+      setsockopt(client, SOL_TCP, TCP_ECN, (const char *)&ecn, sizeof(int)) <
+          0 ||
+      test_tcp_connect(client, TEST_IP, TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  net_time_t start;
+  sys_time_curr(&start);
+
+  int err = 0;
+  for (int sent = 0; sent < TEST_DATA_SIZE && !err; sent += TEST_WRITE_SIZE) {
+    if (send(client, data, TEST_WRITE_SIZE, MSG_ZEROCOPY) != TEST_WRITE_SIZE) {
+      err = -1;
+    }
+  }
+  close(client);
+  test_server_wait(&server);
+
+  int ms = sys_time_goes(&start);
+  ms = ms ? ms : 1;
+
+  tcp_ecn_stats_t ecn_end;
+  tcp_ecn_stats_get(&ecn_end);
+  int reduces = ecn_end.ece_recv - ecn_start.ece_recv;
+
+  test_link_stats_t stats;
+  test_link_stats_get(&stats, 0);
+  test_link_lock();
+  int marks = link_marks;
+  test_link_unlock();
+  int sent = stats.sent ? stats.sent : 1;
+  plat_printf("tcp %s: %d bytes in %d ms, %d KB/s, queue delay avg %d ms "
+              "max %d ms, %d drops, %d marks, %d ecn reduces, %d bad bytes\n",
+              name, recv_total, ms, recv_total / ms,
+              (int)(stats.delay_sum / sent), stats.delay_max, stats.drops,
+              marks, reduces, recv_err);
+
+  if (ecn && (!marks || !reduces)) {
+    err = -1;
+  }
+  if ((int64_t)recv_total * 1000 / ms < TEST_RATE_MIN) {
+    err = -1;
+  }
+  return (!err && recv_total == TEST_DATA_SIZE && !recv_err) ? 0 : -1;
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "bottleneck",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .rate = LINK_RATE,
+      .queue_size = LINK_QUEUE_SIZE,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open bottleneck netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  plat_printf("bottleneck: %d KB/s, rtt %d ms, queue %d bytes\n",
+              LINK_RATE / 1000, 2 * LINK_DELAY, LINK_QUEUE_SIZE);
+
+  int err = 0;
+  err |= test_round("reno", 0, 0, "reno burst");
+  err |= test_round("bbr", 0, 0, "bbr paced");
+  err |= test_round("reno", LINK_RATE, 0, "reno max pacing rate");
+  err |= test_round("reno", 0, 1, "reno ecn");
+  return err;
+}
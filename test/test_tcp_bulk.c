@@ -0,0 +1,195 @@
+/**
+ * @file test_tcp_bulk.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp单连接批量传输吞吐量测试: 分别通过环回接口及模拟有传播时延的网络接口发送相同的数据,
+ *        统计吞吐量, 服务端校验接收数据的正确性; 在有传播时延的链路上, 链路记录在途数据量的最大值,
+ *        检查发送方在一个rtt内持续发送多个数据段直到窗口用尽, 而不是每收到一个ack只发送一个数据段
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6021                // 监听端口
+#define TEST_IP "10.10.9.1"           // 模拟链路接口的ip地址
+#define TEST_WRITE_SIZE (256 * 1024)  // 每次发送调用的数据量
+#define TEST_DATA_SIZE (1024 * 1024)  // 每轮测试发送的数据量
+#define TEST_FLIGHT_SEGS 8            // 在途数据量的最小值(mss的倍数)
+#define TEST_RATE_SEGS 8              // 吞吐量的最小值(每个rtt发送的mss数)
+
+#define LINK_DELAY 10  // 单向传播时延(ms), rtt为20ms
+
+static uint32_t link_data_end;   // 客户端已发送的数据的结束序号
+static uint32_t link_ack_end;    // 服务端确认到的最大序号
+static int link_flight_max;      // 在途数据量的最大值
+
+static test_server_t server;     // 服务端
+static int server_ok;            // 服务端本轮接收的数据是否正确
+
+/**
+ * @brief 数据流中offset处的字节值, 每次发送调用使用同一个数据区
+ *
+ * @param offset
+ * @return uint8_t
+ */
+static uint8_t test_pattern(int offset) {
+  return (uint8_t)(offset % TEST_WRITE_SIZE % 251);
+}
+
+/**
+ * @brief 记录客户端发送的数据与服务端确认之间的在途数据量
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.flags & TEST_TCP_SYN) {
+    return TEST_LINK_PASS;
+  }
+  if (seg.sport == TEST_PORT) {
+    if ((int32_t)(seg.ack - link_ack_end) > 0) {
+      link_ack_end = seg.ack;
+    }
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.len > 0 && (!link_data_end ||
+                      (int32_t)(seg.seq + seg.len - link_data_end) > 0)) {
+    link_data_end = seg.seq + seg.len;
+    if (link_ack_end) {
+      link_flight_max =
+          MAX(link_flight_max, (int)(link_data_end - link_ack_end));
+    }
+  }
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收全部数据并校验
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[4096];
+  int total = 0;
+  int ok = 1;
+  while (total < TEST_DATA_SIZE) {
+    int len = recv(client, buf, sizeof(buf), 0);
+    if (len <= 0) {
+      break;
+    }
+    for (int i = 0; i < len; i++) {
+      if (buf[i] != test_pattern(total + i)) {
+        ok = 0;
+      }
+    }
+    total += len;
+  }
+  server_ok = ok && total == TEST_DATA_SIZE;
+}
+
+/**
+ * @brief 建立一个连接并发送TEST_DATA_SIZE字节, 等待服务端接收完成后统计吞吐量
+ *
+ * @param ip 服务端地址
+ * @param zerocopy 是否零拷贝发送, 此时在途数据量不受发送缓冲区大小的限制
+ * @param name 本轮测试名称
+ * @param info 返回连接的统计信息
+ * @return int 吞吐量(字节/s), 出错时返回-1
+ */
+static int test_run(const char *ip, int zerocopy, const char *name,
+                    struct net_tcp_info *info) {
+  static uint8_t buf[TEST_WRITE_SIZE];
+  for (int i = 0; i < sizeof(buf); i++) {
+    buf[i] = test_pattern(i);
+  }
+
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0 ||
+      setsockopt(s, SOL_SOCKET, SO_ZEROCOPY, (const char *)&zerocopy,
+                 sizeof(int)) < 0 ||
+      test_tcp_connect(s, ip, TEST_PORT) < 0) {
+    plat_printf("tcp bulk %s: connect error\n", name);
+    return -1;
+  }
+
+  // 服务端收到全部数据后关闭连接, 关闭需等待客户端也关闭
+  net_time_t time;
+  sys_time_curr(&time);
+  int err = 0;
+  for (int sent = 0; sent < TEST_DATA_SIZE && !err; sent += sizeof(buf)) {
+    err = zerocopy ? send(s, buf, sizeof(buf), MSG_ZEROCOPY) != sizeof(buf)
+                   : test_send_all(s, buf, sizeof(buf)) < 0;
+  }
+  err |= recv(s, buf, sizeof(buf), 0) != 0;
+  int ms = sys_time_goes(&time);
+  err |= test_tcp_info_get(s, info) < 0;
+  close(s);
+  test_server_wait(&server);
+
+  int rate = (int)((int64_t)TEST_DATA_SIZE * 1000 / (ms ? ms : 1));
+  plat_printf("tcp bulk %s: %d bytes in %d ms, %d KB/s, mss %d, cwnd %u, "
+              "%u retrans, server ok %d\n",
+              name, TEST_DATA_SIZE, ms, rate / 1024, info->mss,
+              info->snd_cwnd, info->total_retrans, server_ok);
+  return (err || !server_ok) ? -1 : rate;
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "bulk",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open bulk netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  // 环回接口上只统计吞吐量
+  struct net_tcp_info info;
+  if (test_run("127.0.0.1", 0, "loop", &info) < 0) {
+    plat_printf("tcp bulk test failed\n");
+    return -1;
+  }
+
+  // 每收到一个ack只发送一个数据段时, 在途数据不超过两个数据段, 每个rtt最多发送两个mss
+  int rate = test_run(TEST_IP, 1, "link", &info);
+  test_link_lock();
+  int flight_max = link_flight_max;
+  test_link_unlock();
+  int rate_min = TEST_RATE_SEGS * info.mss * 1000 / (2 * LINK_DELAY);
+  plat_printf("tcp bulk link: max flight %d bytes, min rate %d KB/s\n",
+              flight_max, rate_min / 1024);
+
+  if (rate < rate_min || flight_max < TEST_FLIGHT_SEGS * info.mss) {
+    plat_printf("tcp bulk test failed\n");
+    return -1;
+  }
+  return 0;
+}
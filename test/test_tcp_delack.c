@@ -0,0 +1,171 @@
+/**
+ * @file test_tcp_delack.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp延迟确认测试: 打开一个模拟有传播时延的网络接口, 链路记录客户端新数据段经过的时间
+ *        及服务端确认该数据的ack经过的时间, 检查单个小数据段的ack由延迟确认定时器发出,
+ *        且发送方在ack到达前不重传该数据段(尾部丢失探测及超时重传需等待对端的延迟确认),
+ *        连续两个满长度数据段的ack则立即发出
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6017          // 监听端口
+#define TEST_IP "10.10.5.1"     // 模拟链路接口的ip地址
+#define TEST_SMALL_SIZE 100     // 小数据段的数据量
+#define TEST_ROUND_CNT 3        // 每种情况的测试次数
+
+#define LINK_DELAY 5  // 单向传播时延(ms), rtt为10ms
+
+static int link_waiting;          // 是否在等待服务端确认data_end之前的数据
+static uint32_t link_data_end;    // 客户端最近发送的数据的结束序号
+static net_time_t link_data_time; // 该数据段经过链路的时间
+static int link_ack_ms;           // 数据段经过链路到其ack经过链路的时间(ms)
+static int link_retrans_cnt;      // ack到达前客户端重传该数据的次数
+
+static test_server_t server;      // 服务端
+
+/**
+ * @brief 记录客户端新数据段经过的时间, 以及服务端确认该数据段的ack经过的时间
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.dport == TEST_PORT && seg.len > 0) {
+    // 重传的数据段使接收方立即确认, 记录后放行
+    if (link_waiting && (int32_t)(seg.seq + seg.len - link_data_end) <= 0) {
+      link_retrans_cnt++;
+      return TEST_LINK_PASS;
+    }
+    link_data_end = seg.seq + seg.len;
+    sys_time_curr(&link_data_time);
+    link_waiting = 1;
+  } else if (seg.sport == TEST_PORT && link_waiting &&
+             (int32_t)(seg.ack - link_data_end) >= 0) {
+    link_ack_ms = sys_time_goes(&link_data_time);
+    link_waiting = 0;
+  }
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 服务端处理一个连接: 读取数据直到客户端关闭, 不发送任何数据
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  char buf[4096];
+  while (recv(client, buf, sizeof(buf), 0) > 0) {
+  }
+}
+
+/**
+ * @brief 发送size字节后等待服务端确认, 返回数据段到ack之间的时间
+ *
+ * @param s
+ * @param buf
+ * @param size
+ * @param retrans 返回ack到达前客户端重传该数据的次数
+ * @return int ack时延(ms), 出错时返回-1
+ */
+static int ack_delay_get(int s, const uint8_t *buf, int size, int *retrans) {
+  test_link_lock();
+  link_ack_ms = -1;
+  link_retrans_cnt = 0;
+  test_link_unlock();
+
+  if (send(s, buf, size, 0) != size) {
+    return -1;
+  }
+  sys_sleep(2 * TCP_DELACK_TMO);
+
+  test_link_lock();
+  int ms = link_waiting ? -1 : link_ack_ms;
+  *retrans = link_retrans_cnt;
+  test_link_unlock();
+  return ms;
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "delack",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open delack netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int on = 1;
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  struct net_tcp_info info;
+  if (s < 0 ||
+      setsockopt(s, SOL_TCP, TCP_NODELAY, (const char *)&on, sizeof(int)) <
+          0 ||
+      test_tcp_connect(s, TEST_IP, TEST_PORT) < 0 ||
+      test_tcp_info_get(s, &info) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  // 两个满长度数据段在一次发送中连续发出
+  static uint8_t buf[4096];
+  int full_size = 2 * info.mss;
+  if (full_size > sizeof(buf)) {
+    plat_printf("mss %d too large\n", info.mss);
+    return -1;
+  }
+
+  int err = 0;
+  for (int i = 0; i < TEST_ROUND_CNT; i++) {
+    int small_retrans, full_retrans;
+    int small_ms = ack_delay_get(s, buf, TEST_SMALL_SIZE, &small_retrans);
+    int full_ms = ack_delay_get(s, buf, full_size, &full_retrans);
+    plat_printf("tcp delack: %d bytes acked in %d ms (%d retrans), "
+                "%d bytes acked in %d ms (%d retrans)\n",
+                TEST_SMALL_SIZE, small_ms, small_retrans, full_size, full_ms,
+                full_retrans);
+
+    // 单个小数据段等待延迟确认定时器且不被重传, 两个满长度数据段立即确认(只需一次传播时延)
+    if (small_ms < TCP_DELACK_TMO / 2 || small_retrans || full_ms < 0 ||
+        full_ms >= TCP_DELACK_TMO / 2) {
+      err = 1;
+    }
+  }
+
+  close(s);
+  test_server_wait(&server);
+  if (err) {
+    plat_printf("tcp delack test failed\n");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,166 @@
+/**
+ * @file test_tcp_fastopen.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp快速打开测试: 打开一个模拟有传播时延的网络接口, 客户端反复建立短连接, 发送一个请求并等待响应,
+ *        分别使用connect+send及sendto(MSG_FASTOPEN)统计从发起连接到收到响应的时延,
+ *        快速打开的请求由SYN携带, 时延应比普通连接少约一个rtt
+ * @version 0.1
+ * @date 2024-12-12
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp_fastopen.h"
+#include "test_util.h"
+
+#define TEST_PORT 6008          // 监听端口
+#define TEST_IP "10.10.2.1"     // 模拟链路接口的ip地址
+#define TEST_REQ_SIZE 64        // 请求大小
+#define TEST_RESP_SIZE 64       // 响应大小
+#define TEST_CONN_CNT 20        // 每轮建立的连接数
+
+#define LINK_DELAY 10     // 单向传播时延(ms), rtt为20ms
+
+static test_server_t server;      // 服务端
+
+/**
+ * @brief 监听前允许快速打开
+ *
+ * @param sock
+ * @return int
+ */
+static int server_setup(int sock) {
+  int on = 1;
+  return setsockopt(sock, SOL_TCP, TCP_FASTOPEN, (const char *)&on,
+                    sizeof(int));
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收一个请求, 回复响应后关闭连接
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[TEST_REQ_SIZE];
+  if (test_recv_all(client, buf, TEST_REQ_SIZE) == 0) {
+    send(client, buf, TEST_RESP_SIZE, 0);
+  }
+}
+
+/**
+ * @brief 比较函数, 用于对时延排序
+ */
+static int cmp_int(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+/**
+ * @brief 进行一轮短连接请求, 统计从发起连接到收到完整响应的时延
+ *
+ * @param server_addr
+ * @param fastopen 是否使用sendto(MSG_FASTOPEN)发起连接
+ * @param name 测试名称
+ * @return int 时延中位数(ms), 出错时返回-1
+ */
+static int test_round(struct sockaddr_in *server_addr, int fastopen,
+                      const char *name) {
+  static uint8_t buf[TEST_RESP_SIZE];
+  int delay[TEST_CONN_CNT];
+
+  tcp_fastopen_stats_t start;
+  tcp_fastopen_stats_get(&start);
+
+  for (int i = 0; i < TEST_CONN_CNT; i++) {
+    net_time_t time;
+    sys_time_curr(&time);
+
+    int s = socket(AF_INET, SOCK_STREAM, 0);
+    if (s < 0) {
+      plat_printf("create socket error\n");
+      return -1;
+    }
+
+    plat_memset(buf, i, TEST_REQ_SIZE);
+    int err;
+    if (fastopen) {
+      err = sendto(s, buf, TEST_REQ_SIZE, MSG_FASTOPEN,
+                   (const struct sockaddr *)server_addr,
+                   sizeof(*server_addr)) != TEST_REQ_SIZE;
+    } else {
+      err = connect(s, (const struct sockaddr *)server_addr,
+                    sizeof(*server_addr)) < 0 ||
+            send(s, buf, TEST_REQ_SIZE, 0) != TEST_REQ_SIZE;
+    }
+    if (err || test_recv_all(s, buf, TEST_RESP_SIZE) < 0 || buf[0] != (uint8_t)i) {
+      plat_printf("rpc error\n");
+      close(s);
+      return -1;
+    }
+    delay[i] = sys_time_goes(&time);
+    close(s);
+  }
+
+  tcp_fastopen_stats_t end;
+  tcp_fastopen_stats_get(&end);
+
+  qsort(delay, TEST_CONN_CNT, sizeof(int), cmp_int);
+  int p50 = delay[TEST_CONN_CNT / 2];
+  plat_printf("tcp %s: %d conns, connect + first byte p50 %d ms, max %d ms, "
+              "%u cookie reqs, %u syn data sent, %u syn data acked\n",
+              name, TEST_CONN_CNT, p50, delay[TEST_CONN_CNT - 1],
+              end.cookie_req - start.cookie_req,
+              end.syn_data_sent - start.syn_data_sent,
+              end.syn_data_acked - start.syn_data_acked);
+  return p50;
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "delay",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open delay netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.setup = server_setup;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  struct sockaddr_in server_addr;
+  test_addr_init(&server_addr, TEST_IP, TEST_PORT);
+
+  plat_printf("link: rtt %d ms\n", 2 * LINK_DELAY);
+
+  tcp_fastopen_stats_t start, end;
+  int normal = test_round(&server_addr, 0, "connect");
+  tcp_fastopen_stats_get(&start);
+  int tfo = test_round(&server_addr, 1, "fastopen");
+  tcp_fastopen_stats_get(&end);
+
+  // 只有第一个连接需要请求cookie, 之后的请求都由SYN携带, 节省约一个rtt
+  if (normal < 0 || tfo < 0 || end.cookie_req - start.cookie_req != 1 ||
+      end.syn_data_acked - start.syn_data_acked != TEST_CONN_CNT - 1 ||
+      tfo > normal - LINK_DELAY) {
+    plat_printf("tcp fastopen test failed\n");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,117 @@
+/**
+ * @file test_tcp_gso.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp分段卸载测试: 通过环回接口批量发送数据, 分别在软件分段(GSO)及驱动分段(TSO)
+ *        两种模式下检查数据全部到达, 发送方只构造了少量超级数据段,
+ *        GSO模式下接收方收到的是按mss切分后的数据段, TSO模式下环回接口直接递交超级数据段
+ * @version 0.1
+ * @date 2024-11-28
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "netif.h"
+#include "route.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6001                 // 监听端口
+#define TEST_DATA_SIZE (4 * 1024 * 1024)  // 每轮测试发送的数据量
+
+static test_server_t server;           // 服务端
+static volatile int recv_total;        // 服务端本轮已接收的数据量
+static struct net_tcp_info recv_info;  // 服务端本轮连接的统计信息
+
+/**
+ * @brief 服务端处理一个连接: 接收数据直到对端关闭, 并记录连接的统计信息
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static char buf[4096];
+  int len;
+  while ((len = recv(client, buf, sizeof(buf), 0)) > 0) {
+    recv_total += len;
+  }
+  test_tcp_info_get(client, &recv_info);
+}
+
+/**
+ * @brief 以指定的网络接口卸载特性进行一轮测试
+ *
+ * @param netif 环回接口
+ * @param features 卸载特性
+ * @param name 测试模式名称
+ * @return int 0: 成功, -1: 失败
+ */
+static int test_round(netif_t *netif, uint32_t features, const char *name) {
+  static char data[TEST_DATA_SIZE];
+
+  // 两轮测试之间没有数据在传输，可直接修改环回接口的卸载特性
+  netif->features = features;
+  recv_total = 0;
+
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  if (client < 0 || test_tcp_connect(client, "127.0.0.1", TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  net_time_t start;
+  sys_time_curr(&start);
+
+  struct net_tcp_info info;
+  int err = test_send_all(client, data, TEST_DATA_SIZE);
+  err |= test_tcp_info_get(client, &info);
+  close(client);
+  test_server_wait(&server);
+
+  int ms = sys_time_goes(&start);
+  ms = ms ? ms : 1;
+  int mss_segs = TEST_DATA_SIZE / info.mss;  // 数据按mss切分后的数据段数
+  plat_printf("tcp %s: %d bytes in %d ms, %d KB/s, %u segs sent, %u segs "
+              "received, %d mss segs\n",
+              name, recv_total, ms, recv_total / ms, info.segs_out,
+              recv_info.segs_in, mss_segs);
+
+  // 发送方每次构造一个超级数据段, 数据段数不到按mss切分数量的一半;
+  // 软件分段时接收方收到的数据段数不少于按mss切分的数量, 驱动分段时环回接口不切分
+  if (err || recv_total != TEST_DATA_SIZE || info.segs_out * 2 > mss_segs) {
+    return -1;
+  }
+  if (features & NETIF_F_TSO) {
+    return recv_info.segs_in * 2 <= mss_segs ? 0 : -1;
+  }
+  return recv_info.segs_in >= mss_segs ? 0 : -1;
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  ipaddr_t loop_ip;
+  ipaddr_from_str(&loop_ip, "127.0.0.1");
+  route_entry_t *rt_entry = route_find(&loop_ip);
+  if (!rt_entry) {
+    plat_printf("loop route not found\n");
+    return -1;
+  }
+
+  int err = 0;
+  err |= test_round(rt_entry->netif, 0, "gso(software)");
+  err |= test_round(rt_entry->netif, NETIF_F_TSO, "tso(driver)");
+  return err;
+}
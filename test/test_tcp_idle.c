@@ -0,0 +1,120 @@
+/**
+ * @file test_tcp_idle.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp大量并发连接测试: 通过环回接口同时保持大量空闲连接,
+ *        并在每个连接上收发一次数据, 验证收发缓冲区按需分配、空闲时归还,
+ *        统计保持这些连接所占用的内存
+ * @version 0.1
+ * @date 2024-12-02
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp.h"
+#include "test_util.h"
+
+#define TEST_PORT 6002     // 监听端口
+#define TEST_CONN_CNT 5000  // 客户端连接数, 加上服务端的子连接共 2 * TEST_CONN_CNT 个tcp对象
+
+static int server;            // 监听socket
+static sys_sem_t accept_sem;  // 服务端已accept所有连接的信号
+static sys_sem_t done_sem;    // 服务端已处理完所有连接的信号
+static int server_fd[TEST_CONN_CNT];  // 服务端accept的子连接
+static int client_fd[TEST_CONN_CNT];  // 客户端连接
+static int echo_cnt = 0;              // 服务端回显的次数
+
+/**
+ * @brief 服务端线程: accept所有连接, 在每个连接上回显一次数据, 等待客户端关闭后关闭
+ *
+ * @param arg
+ */
+static void server_entry(void *arg) {
+  for (int i = 0; i < TEST_CONN_CNT; i++) {
+    server_fd[i] = accept(server, (struct sockaddr *)0, (net_socklen_t *)0);
+    if (server_fd[i] < 0) {
+      plat_printf("accept error\n");
+      break;
+    }
+  }
+  sys_sem_notify(accept_sem);
+
+  // 客户端按建立连接的顺序在每个连接上发送一次数据
+  for (int i = 0; i < TEST_CONN_CNT; i++) {
+    char buf[16];
+    int len = recv(server_fd[i], buf, sizeof(buf), 0);
+    if (len > 0 && send(server_fd[i], buf, len, 0) == len) {
+      echo_cnt++;
+    }
+  }
+
+  for (int i = 0; i < TEST_CONN_CNT; i++) {
+    char buf[16];
+    while (recv(server_fd[i], buf, sizeof(buf), 0) > 0) {
+    }
+    close(server_fd[i]);
+  }
+
+  close(server);
+  sys_sem_notify(done_sem);
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  server = test_tcp_listen(TEST_PORT, 0);
+  if (server < 0) {
+    return -1;
+  }
+  accept_sem = sys_sem_create(0);
+  done_sem = sys_sem_create(0);
+  sys_thread_create(server_entry, (void *)0);
+
+  net_time_t start;
+  sys_time_curr(&start);
+
+  int conn_cnt = 0;
+  for (int i = 0; i < TEST_CONN_CNT; i++) {
+    client_fd[i] = socket(AF_INET, SOCK_STREAM, 0);
+    if (client_fd[i] < 0 ||
+        test_tcp_connect(client_fd[i], "127.0.0.1", TEST_PORT) < 0) {
+      plat_printf("connect error at %d\n", i);
+      break;
+    }
+    conn_cnt++;
+  }
+  sys_sem_wait(accept_sem, 0);
+  int conn_ms = sys_time_goes(&start);
+
+  // 所有连接都处于空闲状态时, 只有控制块占用内存
+  plat_printf("tcp idle: %d conns (%d tcp objs) in %d ms, tcp_t %d bytes, "
+              "control blocks %d KB, shared buf pool %d KB\n",
+              conn_cnt, conn_cnt * 2, conn_ms, (int)sizeof(tcp_t),
+              (int)(conn_cnt * 2 * sizeof(tcp_t) / 1024),
+              TCP_BUF_PAGE_CNT * TCP_BUF_PAGE_SIZE / 1024);
+
+  // 依次在每个连接上收发一次数据, 数据读取完后缓冲区页面归还, 共享的页面池可以满足所有连接
+  int ok_cnt = 0;
+  for (int i = 0; i < conn_cnt; i++) {
+    char buf[16];
+    if (send(client_fd[i], "ping", 4, 0) == 4 &&
+        recv(client_fd[i], buf, sizeof(buf), 0) == 4) {
+      ok_cnt++;
+    }
+  }
+  plat_printf("tcp idle: echo ok %d/%d\n", ok_cnt, conn_cnt);
+
+  for (int i = 0; i < conn_cnt; i++) {
+    close(client_fd[i]);
+  }
+  sys_sem_wait(done_sem, 0);
+
+  return (conn_cnt == TEST_CONN_CNT && ok_cnt == conn_cnt) ? 0 : -1;
+}
@@ -0,0 +1,162 @@
+/**
+ * @file test_tcp_info.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp连接统计信息测试: 通过环回接口发送一段数据并等待对端的应答,
+ *        之后在两端分别使用getsockopt(TCP_INFO)读取连接的状态及统计信息,
+ *        检查收发的数据量、数据段数及发送缓冲区的占用与实际传输一致
+ * @version 0.1
+ * @date 2024-12-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp.h"
+#include "test_util.h"
+
+#define TEST_PORT 6009          // 监听端口
+#define TEST_DATA_SIZE (256 * 1024)  // 客户端发送的数据量
+#define TEST_RESP_SIZE 16       // 服务端应答的数据量
+
+static test_server_t server;    // 服务端
+static sys_sem_t check_sem;     // 服务端完成检查信号
+static int server_ok = 0;       // 服务端的检查结果
+
+/**
+ * @brief 读取并打印socket的TCP_INFO
+ *
+ * @param s
+ * @param name
+ * @param info
+ * @return int 0: 成功, -1: 失败
+ */
+static int info_get(int s, const char *name, struct net_tcp_info *info) {
+  if (test_tcp_info_get(s, info) < 0) {
+    plat_printf("%s: getsockopt TCP_INFO error\n", name);
+    return -1;
+  }
+
+  plat_printf("%s: state %d, opts 0x%x, mss %d, rtt %u/%u ms, rto %u ms, "
+              "cwnd %u, unacked %u, notsent %u, rcv_queued %u, "
+              "segs %u/%u, retrans %u, acked %llu, received %llu\n",
+              name, info->state, info->options, info->mss, info->rtt,
+              info->rttvar, info->rto, info->snd_cwnd, info->unacked,
+              info->notsent, info->rcv_queued, info->segs_out, info->segs_in,
+              info->total_retrans, (unsigned long long)info->bytes_acked,
+              (unsigned long long)info->bytes_received);
+  return 0;
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收客户端的全部数据后检查连接的统计信息并发送应答
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[4096];
+  int total = 0;
+  while (total < TEST_DATA_SIZE) {
+    int len = recv(client, buf, sizeof(buf), 0);
+    if (len <= 0) {
+      break;
+    }
+    total += len;
+  }
+
+  // 数据已全部读取, 接收队列为空
+  struct net_tcp_info info;
+  server_ok = total == TEST_DATA_SIZE &&
+              info_get(client, "server", &info) == 0 &&
+              info.state == TCP_STATE_ESTABLISHED &&
+              info.bytes_received == TEST_DATA_SIZE && info.rcv_queued == 0 &&
+              info.segs_in > 0 && info.segs_out > 0;
+
+  send(client, buf, TEST_RESP_SIZE, 0);
+  sys_sem_notify(check_sem);
+
+  while (recv(client, buf, sizeof(buf), 0) > 0) {
+  }
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  check_sem = sys_sem_create(0);
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  // 监听对象只有状态有效
+  struct net_tcp_info info;
+  if (info_get(server.sock, "listen", &info) < 0 ||
+      info.state != TCP_STATE_LISTEN || info.segs_in != 0) {
+    plat_printf("tcp info test failed\n");
+    return -1;
+  }
+
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0) {
+    plat_printf("create client socket error\n");
+    return -1;
+  }
+
+  // 未建立连接时只有状态有效
+  if (info_get(s, "closed", &info) < 0 || info.state != TCP_STATE_CLOSED ||
+      info.segs_out != 0) {
+    plat_printf("tcp info test failed\n");
+    return -1;
+  }
+
+  if (test_tcp_connect(s, "127.0.0.1", TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    close(s);
+    return -1;
+  }
+
+  static uint8_t buf[4096];
+  plat_memset(buf, 0x5a, sizeof(buf));
+  for (int total = 0; total < TEST_DATA_SIZE;) {
+    int len = send(s, buf, MIN(sizeof(buf), TEST_DATA_SIZE - total), 0);
+    if (len <= 0) {
+      plat_printf("send error\n");
+      close(s);
+      return -1;
+    }
+    total += len;
+  }
+
+  int resp_err = test_recv_all(s, buf, TEST_RESP_SIZE);
+  sys_sem_wait(check_sem, 0);
+
+  // 应答到达时客户端的数据已全部被确认, 发送缓冲区为空
+  int client_ok = !resp_err && info_get(s, "client", &info) == 0 &&
+                  info.state == TCP_STATE_ESTABLISHED &&
+                  (info.options & NET_TCPI_OPT_TIMESTAMPS) &&
+                  info.bytes_acked == TEST_DATA_SIZE &&
+                  info.bytes_received == TEST_RESP_SIZE && info.unacked == 0 &&
+                  info.notsent == 0 && info.rto > 0 &&
+                  info.segs_out >= TEST_DATA_SIZE / 65536;
+
+  // 缓冲区较小时只返回结构的前面部分
+  struct net_tcp_info part;
+  int len = 4;
+  int part_ok = getsockopt(s, SOL_TCP, TCP_INFO, (char *)&part, &len) == 0 &&
+                len == 4 && part.state == TCP_STATE_ESTABLISHED;
+
+  close(s);
+  if (!client_ok || !server_ok || !part_ok) {
+    plat_printf("tcp info test failed\n");
+    return -1;
+  }
+  return 0;
+}
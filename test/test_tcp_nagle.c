@@ -0,0 +1,187 @@
+/**
+ * @file test_tcp_nagle.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp Nagle算法测试: 打开一个模拟有传播时延的网络接口, 客户端连续写入几个小数据块,
+ *        链路记录每个数据段经过时服务端是否已确认之前的数据; 未设置TCP_NODELAY时第一个小数据段
+ *        立即发出, 之后的小数据块在ack到达前被推迟并合并为一个数据段; 设置TCP_NODELAY后
+ *        每个小数据块不等待ack立即发出
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6019          // 监听端口
+#define TEST_IP "10.10.7.1"     // 模拟链路接口的ip地址
+#define TEST_SMALL_SIZE 100     // 每次写入的数据量
+#define TEST_WRITE_CNT 3        // 每轮连续写入的次数
+#define TEST_SEG_MAXCNT 8       // 每轮最多记录的数据段数
+
+#define LINK_DELAY 20  // 单向传播时延(ms), rtt为40ms
+
+// 定义链路记录的客户端数据段
+typedef struct _link_seg_t {
+  uint32_t seq;   // 序号
+  int len;        // 数据长度
+  int acked;      // 经过链路时服务端是否已确认该数据段之前的数据
+} link_seg_t;
+
+static link_seg_t link_seg[TEST_SEG_MAXCNT];  // 本轮经过链路的客户端新数据段
+static int link_seg_cnt;                      // 本轮经过链路的客户端新数据段数
+static uint32_t link_data_end;                // 客户端已发送的数据的结束序号
+static uint32_t link_ack_end;                 // 服务端确认到的最大序号
+
+static test_server_t server;  // 服务端
+
+/**
+ * @brief 记录客户端新数据段, 以及其经过链路时服务端是否已确认之前的数据
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.sport == TEST_PORT) {
+    if ((int32_t)(seg.ack - link_ack_end) > 0) {
+      link_ack_end = seg.ack;
+    }
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.len <= 0 || (link_data_end &&
+                       (int32_t)(seg.seq + seg.len - link_data_end) <= 0)) {
+    return TEST_LINK_PASS;
+  }
+  link_data_end = seg.seq + seg.len;
+  if (link_seg_cnt < TEST_SEG_MAXCNT) {
+    link_seg_t *s = &link_seg[link_seg_cnt++];
+    s->seq = seg.seq;
+    s->len = seg.len;
+    s->acked = link_ack_end == seg.seq;
+  }
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 服务端处理一个连接: 读取数据直到客户端关闭, 不发送任何数据
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  char buf[1024];
+  while (recv(client, buf, sizeof(buf), 0) > 0) {
+  }
+}
+
+/**
+ * @brief 连续写入TEST_WRITE_CNT个小数据块, 等待数据全部被确认后返回本轮经过链路的数据段数
+ *
+ * @param s
+ * @param name 本轮测试名称
+ * @return int 数据段数, 出错时返回-1
+ */
+static int test_round(int s, const char *name) {
+  static uint8_t buf[TEST_SMALL_SIZE];
+
+  test_link_lock();
+  link_seg_cnt = 0;
+  test_link_unlock();
+
+  for (int i = 0; i < TEST_WRITE_CNT; i++) {
+    if (send(s, buf, sizeof(buf), 0) != sizeof(buf)) {
+      return -1;
+    }
+  }
+  // 服务端不发送数据, 每个ack最多被延迟TCP_DELACK_TMO
+  sys_sleep(TEST_WRITE_CNT * (TCP_DELACK_TMO + 2 * LINK_DELAY));
+
+  test_link_lock();
+  int cnt = link_seg_cnt;
+  plat_printf("tcp nagle %s: %d segs:", name, cnt);
+  for (int i = 0; i < cnt; i++) {
+    plat_printf(" %d%s", link_seg[i].len, link_seg[i].acked ? "(acked)" : "");
+  }
+  plat_printf("\n");
+  test_link_unlock();
+  return cnt;
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "nagle",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open nagle netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0 || test_tcp_connect(s, TEST_IP, TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  // 第一个小数据段立即发出; 之后的小数据块在其ack到达前被推迟, 并合并为一个数据段
+  int err = 0;
+  int cnt = test_round(s, "on");
+  test_link_lock();
+  if (cnt != 2 || link_seg[0].len != TEST_SMALL_SIZE ||
+      link_seg[1].len != (TEST_WRITE_CNT - 1) * TEST_SMALL_SIZE ||
+      !link_seg[1].acked) {
+    err = 1;
+  }
+  test_link_unlock();
+
+  // 关闭Nagle算法后每个小数据块立即发出, 不等待之前的数据被确认
+  int on = 1;
+  if (setsockopt(s, SOL_TCP, TCP_NODELAY, (const char *)&on, sizeof(int)) <
+      0) {
+    plat_printf("set nodelay error\n");
+    return -1;
+  }
+  cnt = test_round(s, "off");
+  test_link_lock();
+  if (cnt != TEST_WRITE_CNT) {
+    err = 1;
+  }
+  for (int i = 1; i < cnt; i++) {
+    if (link_seg[i].len != TEST_SMALL_SIZE || link_seg[i].acked) {
+      err = 1;
+    }
+  }
+  test_link_unlock();
+
+  close(s);
+  test_server_wait(&server);
+  if (err) {
+    plat_printf("tcp nagle test failed\n");
+    return -1;
+  }
+  return 0;
+}
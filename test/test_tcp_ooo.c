@@ -0,0 +1,295 @@
+/**
+ * @file test_tcp_ooo.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp乱序队列测试: 先直接操作乱序队列, 检查重叠及相邻的数据段被合并、SACK块的内容及顺序,
+ *        以及空缺填补后数据被转移到接收队列; 之后打开一个模拟有传播时延的网络接口,
+ *        链路丢弃客户端的一个数据段, 检查服务端对之后乱序到达的数据段立即回复重复ack,
+ *        客户端重传后服务端确认全部数据且数据正确到达
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp_ooo.h"
+#include "tcp_rcvq.h"
+#include "test_util.h"
+
+#define TEST_PORT 6018          // 监听端口
+#define TEST_IP "10.10.6.1"     // 模拟链路接口的ip地址
+#define TEST_SEG_SIZE 200       // 每次发送的数据量
+#define TEST_SEG_CNT 8          // 发送次数
+#define TEST_DROP_SEG 1         // 丢弃第几个新数据段(从0开始)
+
+#define OOO_ISN 1000            // 乱序队列测试的起始序号
+#define OOO_DATA_SIZE 1000      // 乱序队列测试的数据量
+
+#define LINK_DELAY 5  // 单向传播时延(ms), rtt为10ms
+
+static uint8_t ooo_data[OOO_DATA_SIZE];  // 乱序队列测试的数据, 序号为OOO_ISN + 下标
+
+static int link_data_cnt;       // 经过链路的客户端新数据段数
+static uint32_t link_drop_seq;  // 被丢弃的数据段的序号
+static uint32_t link_data_end;  // 客户端已发送的数据的结束序号
+static int link_retrans;        // 是否已看到被丢弃数据段的重传
+static int link_dup_cnt;        // 重传之前服务端确认号停留在被丢弃数据段的ack数
+static uint32_t link_ack_end;   // 服务端确认到的最大序号
+
+static test_server_t server;    // 服务端
+static int server_ok;           // 服务端接收的数据是否正确
+
+/**
+ * @brief 将ooo_data中[offset, offset + len)的数据作为一个数据段插入乱序队列
+ *
+ * @param ooo
+ * @param offset
+ * @param len
+ * @return int 0: 成功, -1: 失败
+ */
+static int ooo_insert(tcp_ooo_t *ooo, int offset, int len) {
+  pktbuf_t *buf = pktbuf_alloc(len);
+  if (!buf) {
+    return -1;
+  }
+  pktbuf_write(buf, ooo_data + offset, len);
+  pktbuf_acc_reset(buf);
+
+  if (tcp_ooo_insert(ooo, buf, OOO_ISN + offset, len, 0, OOO_DATA_SIZE) !=
+      NET_ERR_OK) {
+    pktbuf_free(buf);  //!!! 释放数据包
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief 检查乱序队列的数据量及SACK块, 期望的块以[start, end)偏移给出, 第一个为最近插入的块
+ *
+ * @param ooo
+ * @param size 期望的数据量
+ * @param expect 期望的SACK块
+ * @param cnt 期望的SACK块数量
+ * @return int 0: 一致, -1: 不一致
+ */
+static int ooo_blocks_check(tcp_ooo_t *ooo, int size, const int expect[][2],
+                            int cnt) {
+  tcp_sack_block_t blocks[4];
+  int n = tcp_ooo_sack_blocks(ooo, blocks, 4);
+  if (ooo->size != size || n != cnt) {
+    plat_printf("tcp ooo: size %d, %d blocks, expect size %d, %d blocks\n",
+                ooo->size, n, size, cnt);
+    return -1;
+  }
+
+  for (int i = 0; i < n; i++) {
+    if (blocks[i].start != OOO_ISN + expect[i][0] ||
+        blocks[i].end != OOO_ISN + expect[i][1]) {
+      plat_printf("tcp ooo: block %d [%u, %u), expect [%d, %d)\n", i,
+                  blocks[i].start - OOO_ISN, blocks[i].end - OOO_ISN,
+                  expect[i][0], expect[i][1]);
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief 直接操作乱序队列: 插入乱序、相邻及重叠的数据段, 检查合并结果及SACK块,
+ *        填补空缺后将连续的数据转移到接收队列并校验
+ *
+ * @return int 0: 成功, -1: 失败
+ */
+static int ooo_check(void) {
+  static const int one[][2] = {{300, 400}};
+  static const int two[][2] = {{500, 600}, {300, 400}};
+  static const int merged[][2] = {{300, 600}};
+  static const int overlap[][2] = {{250, 600}};
+  static const int tail[][2] = {{800, 900}, {250, 600}};
+
+  for (int i = 0; i < OOO_DATA_SIZE; i++) {
+    ooo_data[i] = (uint8_t)(i * 7 + (i >> 8));
+  }
+
+  tcp_ooo_t ooo;
+  tcp_rcvq_t rcvq;
+  tcp_ooo_init(&ooo);
+  tcp_rcvq_init(&rcvq, OOO_DATA_SIZE);
+
+  // 最近插入的数据段所在的范围作为第一个SACK块; 相邻及重叠的数据段合并为一个块
+  int err = ooo_insert(&ooo, 300, 100) < 0 ||
+            ooo_blocks_check(&ooo, 100, one, 1) < 0 ||
+            ooo_insert(&ooo, 500, 100) < 0 ||
+            ooo_blocks_check(&ooo, 200, two, 2) < 0 ||
+            ooo_insert(&ooo, 400, 100) < 0 ||
+            ooo_blocks_check(&ooo, 300, merged, 1) < 0 ||
+            ooo_insert(&ooo, 250, 100) < 0 ||
+            ooo_blocks_check(&ooo, 350, overlap, 1) < 0 ||
+            ooo_insert(&ooo, 800, 100) < 0 ||
+            ooo_blocks_check(&ooo, 450, tail, 2) < 0;
+
+  // 仍有空缺时不转移数据; 按序数据填补空缺后转移与其连续的块, 之后的块保留在队列中
+  uint32_t nxt = OOO_ISN;
+  int fin = 0;
+  if (!err && tcp_ooo_drain(&ooo, &rcvq, &nxt, &fin) != 0) {
+    err = 1;
+  }
+
+  pktbuf_t *buf = pktbuf_alloc(250);
+  if (!err && buf) {
+    pktbuf_write(buf, ooo_data, 250);
+    err = tcp_rcvq_put(&rcvq, buf, 0, 250) != 250;
+    nxt += 250;
+  }
+  if (buf) {
+    pktbuf_free(buf);  //!!! 释放数据包
+  }
+
+  static uint8_t rx[OOO_DATA_SIZE];
+  if (err || tcp_ooo_drain(&ooo, &rcvq, &nxt, &fin) != 350 ||
+      nxt != OOO_ISN + 600 || fin || ooo_blocks_check(&ooo, 100, tail, 1) < 0 ||
+      tcp_rcvq_read(&rcvq, rx, sizeof(rx)) != 600 ||
+      plat_memcmp(rx, ooo_data, 600) != 0) {
+    err = 1;
+  }
+
+  tcp_ooo_clear(&ooo);
+  tcp_rcvq_clear(&rcvq);
+  plat_printf("tcp ooo: merge and drain %s\n", err ? "failed" : "ok");
+  return (err || !tcp_ooo_is_empty(&ooo) || ooo.size) ? -1 : 0;
+}
+
+/**
+ * @brief 丢弃客户端的一个数据段, 并观察服务端的重复ack
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.sport == TEST_PORT) {
+    if ((int32_t)(seg.ack - link_ack_end) > 0) {
+      link_ack_end = seg.ack;
+    }
+    if (link_data_cnt > TEST_DROP_SEG && !link_retrans &&
+        seg.ack == link_drop_seq) {
+      link_dup_cnt++;
+    }
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.len <= 0) {
+    return TEST_LINK_PASS;
+  }
+  if (link_data_cnt > TEST_DROP_SEG && seg.seq == link_drop_seq) {
+    link_retrans = 1;
+    return TEST_LINK_PASS;
+  }
+  if ((int32_t)(seg.seq + seg.len - link_data_end) <= 0) {  // 其他重传的数据段
+    return TEST_LINK_PASS;
+  }
+
+  link_data_end = seg.seq + seg.len;
+  if (link_data_cnt++ == TEST_DROP_SEG) {
+    link_drop_seq = seg.seq;
+    return TEST_LINK_DROP;
+  }
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收全部数据并校验
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[TEST_SEG_SIZE * TEST_SEG_CNT];
+  server_ok = test_recv_all(client, buf, sizeof(buf)) == 0;
+  for (int i = 0; i < sizeof(buf); i++) {
+    if (buf[i] != (uint8_t)i) {
+      server_ok = 0;
+    }
+  }
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "ooo",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+
+  // 工作线程启动之前由当前线程直接操作乱序队列
+  if (ooo_check() < 0) {
+    plat_printf("tcp ooo test failed\n");
+    return -1;
+  }
+
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open ooo netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int on = 1;
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0 ||
+      setsockopt(s, SOL_TCP, TCP_NODELAY, (const char *)&on, sizeof(int)) <
+          0 ||
+      test_tcp_connect(s, TEST_IP, TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  // 在一个rtt内逐个发出数据段, 被丢弃的数据段之后的数据段先于重传到达
+  static uint8_t buf[TEST_SEG_SIZE * TEST_SEG_CNT];
+  for (int i = 0; i < sizeof(buf); i++) {
+    buf[i] = (uint8_t)i;
+  }
+  for (int i = 0; i < TEST_SEG_CNT; i++) {
+    if (send(s, buf + i * TEST_SEG_SIZE, TEST_SEG_SIZE, 0) != TEST_SEG_SIZE) {
+      plat_printf("send error\n");
+      return -1;
+    }
+    sys_sleep(1);
+  }
+
+  // 关闭前检查服务端已确认全部数据(之后的fin会使确认号再加1)
+  sys_sleep(100 * LINK_DELAY);
+  test_link_lock();
+  plat_printf("tcp ooo: %d dup acks, retransmitted %d, ack end %u, data end "
+              "%u\n",
+              link_dup_cnt, link_retrans, link_ack_end, link_data_end);
+  int err = !link_dup_cnt || !link_retrans || link_ack_end != link_data_end;
+  test_link_unlock();
+
+  // 服务端收到全部数据后关闭连接, 关闭需等待客户端也关闭
+  close(s);
+  test_server_wait(&server);
+
+  if (err || !server_ok) {
+    plat_printf("tcp ooo test failed\n");
+    return -1;
+  }
+  return 0;
+}
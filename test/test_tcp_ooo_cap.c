@@ -0,0 +1,176 @@
+/**
+ * @file test_tcp_ooo_cap.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp乱序队列容量测试: 打开一个模拟有传播时延的网络接口, 客户端持续发送数据使服务端的
+ *        接收缓冲区自动扩大, 之后链路丢弃客户端的一个数据段; 检查该数据段被重传后服务端的确认号
+ *        一次推进的数据量超过扩大后接收缓冲区的一半加一个mss, 即乱序队列能缓存整个接收窗口内的数据,
+ *        而不是丢弃超出固定上限或接收缓冲区一半的乱序数据, 并检查数据正确到达
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6023                // 监听端口
+#define TEST_IP "10.10.11.1"          // 模拟链路接口的ip地址
+#define TEST_WRITE_SIZE (64 * 1024)   // 每次发送调用的数据量
+#define TEST_DATA_SIZE (512 * 1024)   // 发送的数据量
+#define TEST_DROP_OFFSET (256 * 1024)  // 丢弃数据流中该偏移之后的第一个数据段
+
+#define LINK_DELAY 10  // 单向传播时延(ms), rtt为20ms
+
+static int link_data_valid;     // 是否已记录数据流的起始序号
+static uint32_t link_data_isn;  // 客户端数据流的起始序号
+static int link_dropped;        // 是否已丢弃数据段
+static uint32_t link_drop_seq;  // 被丢弃的数据段的序号
+static uint32_t link_ack_end;   // 丢弃之后服务端确认到的最大序号
+static int link_jump;           // 重传后确认号越过被丢弃数据段时一次推进的数据量
+
+static test_server_t server;    // 服务端
+static int server_ok;           // 服务端接收的数据是否正确
+
+/**
+ * @brief 数据流中offset处的字节值, 每次发送调用使用同一个数据区
+ *
+ * @param offset
+ * @return uint8_t
+ */
+static uint8_t test_pattern(int offset) {
+  return (uint8_t)(offset % TEST_WRITE_SIZE % 251);
+}
+
+/**
+ * @brief 丢弃数据流中TEST_DROP_OFFSET之后的第一个数据段,
+ *        并记录其重传被确认时确认号一次推进的数据量
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0 || (seg.flags & TEST_TCP_SYN)) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.sport == TEST_PORT) {
+    if (link_dropped && !link_jump &&
+        (int32_t)(seg.ack - link_drop_seq) > 0) {
+      link_jump = (int)(seg.ack - link_ack_end);
+    }
+    if (link_dropped && (int32_t)(seg.ack - link_ack_end) > 0) {
+      link_ack_end = seg.ack;
+    }
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.len <= 0) {
+    return TEST_LINK_PASS;
+  }
+  if (!link_data_valid) {
+    link_data_valid = 1;
+    link_data_isn = seg.seq;
+  }
+  if (!link_dropped && (int)(seg.seq - link_data_isn) >= TEST_DROP_OFFSET) {
+    link_dropped = 1;
+    link_drop_seq = seg.seq;
+    link_ack_end = seg.seq;
+    return TEST_LINK_DROP;
+  }
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收全部数据并校验
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[4096];
+  int total = 0;
+  int ok = 1;
+  while (total < TEST_DATA_SIZE) {
+    int len = recv(client, buf, sizeof(buf), 0);
+    if (len <= 0) {
+      break;
+    }
+    for (int i = 0; i < len; i++) {
+      if (buf[i] != test_pattern(total + i)) {
+        ok = 0;
+      }
+    }
+    total += len;
+  }
+  server_ok = ok && total == TEST_DATA_SIZE;
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "ooocap",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open ooocap netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  // 零拷贝发送, 在途数据量不受发送缓冲区大小的限制
+  int on = 1;
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  struct net_tcp_info info;
+  if (s < 0 ||
+      setsockopt(s, SOL_SOCKET, SO_ZEROCOPY, (const char *)&on, sizeof(int)) <
+          0 ||
+      test_tcp_connect(s, TEST_IP, TEST_PORT) < 0 ||
+      test_tcp_info_get(s, &info) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  static uint8_t buf[TEST_WRITE_SIZE];
+  for (int i = 0; i < sizeof(buf); i++) {
+    buf[i] = test_pattern(i);
+  }
+  int err = 0;
+  for (int sent = 0; sent < TEST_DATA_SIZE && !err; sent += sizeof(buf)) {
+    err = send(s, buf, sizeof(buf), MSG_ZEROCOPY) != sizeof(buf);
+  }
+
+  // 服务端收到全部数据后关闭连接, 关闭需等待客户端也关闭
+  err |= recv(s, buf, sizeof(buf), 0) != 0;
+  close(s);
+  test_server_wait(&server);
+
+  test_link_lock();
+  plat_printf("tcp ooo cap: dropped %d, ack jump %d bytes after the "
+              "retransmission, max rcvbuf %d, mss %d, server ok %d\n",
+              link_dropped, link_jump, TCP_RBUF_MAX, info.mss, server_ok);
+  err |= !link_dropped || link_jump <= TCP_RBUF_MAX / 2 + info.mss;
+  test_link_unlock();
+
+  if (err || !server_ok) {
+    plat_printf("tcp ooo cap test failed\n");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,170 @@
+/**
+ * @file test_tcp_paws.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp防止序号回绕(PAWS)测试: 打开一个模拟有传播时延的网络接口, 客户端逐个发送小数据段,
+ *        链路将其中一个新数据段的时间戳改为早于对端已记录的时间戳, 检查服务端丢弃该数据段
+ *        (回复的ack仍停留在该数据段的起始序号), 客户端重传后数据全部正确到达
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6015          // 监听端口
+#define TEST_IP "10.10.4.1"     // 模拟链路接口的ip地址
+#define TEST_SEG_SIZE 100       // 每次发送的数据量
+#define TEST_SEG_CNT 8          // 发送次数
+#define TEST_OLD_SEG 4          // 修改第几次发送的数据段的时间戳
+#define TEST_TS_BACK 1000       // 时间戳回退的数值
+
+#define LINK_DELAY 5  // 单向传播时延(ms), rtt为10ms
+
+static int link_old_armed;      // 下一个新数据段的时间戳需要修改
+static uint32_t link_old_seq;   // 被修改时间戳的数据段序号
+static int link_old_cnt;        // 修改了时间戳的数据段数
+static int link_retrans;        // 是否已看到该数据段的重传
+static int link_early_ack;      // 重传之前服务端是否已确认了该数据段
+
+static test_server_t server;    // 服务端
+static int server_ok;           // 服务端接收的数据是否正确
+
+/**
+ * @brief 修改一个客户端新数据段的时间戳, 并观察服务端对该数据段的确认
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.sport == TEST_PORT) {
+    if (link_old_cnt && !link_retrans &&
+        (int32_t)(seg.ack - link_old_seq) > 0) {
+      link_early_ack = 1;
+    }
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.len <= 0 || !seg.ts) {
+    return TEST_LINK_PASS;
+  }
+  if (link_old_cnt && seg.seq == link_old_seq) {  // 重传的数据段携带新的时间戳
+    link_retrans = 1;
+    return TEST_LINK_PASS;
+  }
+  if (link_old_armed) {
+    uint32_t ts_val = seg.ts_val - TEST_TS_BACK;
+    uint8_t *val = seg.ts + 2;
+    val[0] = (uint8_t)(ts_val >> 24);
+    val[1] = (uint8_t)(ts_val >> 16);
+    val[2] = (uint8_t)(ts_val >> 8);
+    val[3] = (uint8_t)ts_val;
+    test_tcp_seg_changed(&seg);
+
+    link_old_armed = 0;
+    link_old_seq = seg.seq;
+    link_old_cnt++;
+  }
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收全部数据并校验
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[TEST_SEG_SIZE * TEST_SEG_CNT];
+  server_ok = test_recv_all(client, buf, sizeof(buf)) == 0;
+  for (int i = 0; i < sizeof(buf); i++) {
+    if (buf[i] != (uint8_t)i) {
+      server_ok = 0;
+    }
+  }
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "paws",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open paws netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int on = 1;
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0 ||
+      setsockopt(s, SOL_TCP, TCP_NODELAY, (const char *)&on, sizeof(int)) <
+          0 ||
+      test_tcp_connect(s, TEST_IP, TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  // 每次发送后等待数据段到达对端, 对端已记录的时间戳来自之前的数据段
+  static uint8_t buf[TEST_SEG_SIZE * TEST_SEG_CNT];
+  for (int i = 0; i < sizeof(buf); i++) {
+    buf[i] = (uint8_t)i;
+  }
+  for (int i = 0; i < TEST_SEG_CNT; i++) {
+    if (i == TEST_OLD_SEG) {
+      test_link_lock();
+      link_old_armed = 1;
+      test_link_unlock();
+    }
+    if (send(s, buf + i * TEST_SEG_SIZE, TEST_SEG_SIZE, 0) != TEST_SEG_SIZE) {
+      plat_printf("send error\n");
+      return -1;
+    }
+    sys_sleep(4 * LINK_DELAY);
+  }
+
+  // 服务端延迟确认时rtt采样值较大, 等待被丢弃的数据段由RACK或超时重传修复
+  sys_sleep(TCP_RTO_MIN + TCP_DELACK_TMO);
+
+  // 服务端收到全部数据后关闭连接, 关闭需等待客户端也关闭
+  struct net_tcp_info info;
+  int err = test_tcp_info_get(s, &info);
+  close(s);
+  test_server_wait(&server);
+
+  test_link_lock();
+  plat_printf("tcp paws: %d old timestamps, retransmitted %d, acked before "
+              "retransmission %d, %u retrans, server ok %d\n",
+              link_old_cnt, link_retrans, link_early_ack, info.total_retrans,
+              server_ok);
+  err |= link_old_cnt != 1 || !link_retrans || link_early_ack;
+  test_link_unlock();
+
+  if (err || !server_ok || info.total_retrans == 0) {
+    plat_printf("tcp paws test failed\n");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,183 @@
+/**
+ * @file test_tcp_persist.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp坚持定时器测试: 打开一个模拟有传播时延的网络接口, 客户端持续快速写入,
+ *        服务端每隔一段时间才读取一次接收缓冲区, 使客户端反复遇到零窗口;
+ *        链路丢弃服务端每次重新打开窗口的ack, 客户端只能通过零窗口探测得知窗口已打开,
+ *        检查数据全部正确到达, 且每次丢弃窗口更新后都由探测在有限时间内恢复发送
+ * @version 0.1
+ * @date 2024-12-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp.h"
+#include "test_util.h"
+
+#define TEST_PORT 6010             // 监听端口
+#define TEST_IP "10.10.3.1"        // 模拟链路接口的ip地址
+#define TEST_READ_SIZE 4096        // 服务端每次读取的数据量, 与接收缓冲区大小相同
+#define TEST_READ_CNT 6            // 服务端读取的次数
+#define TEST_DATA_SIZE (TEST_READ_SIZE * TEST_READ_CNT)  // 客户端写入的数据量
+#define TEST_READ_PAUSE 300        // 服务端每次读取前的等待时间(ms)
+
+#define LINK_DELAY 5      // 单向传播时延(ms), rtt为10ms
+
+static int link_zero_wnd;         // 服务端最近通告的窗口是否为0
+static int link_update_dropped;   // 本次零窗口后是否已丢弃了打开窗口的ack
+static int link_drops;            // 丢弃的窗口更新数
+
+static test_server_t server;      // 服务端
+static sys_sem_t read_sem;        // 服务端读取完成信号
+static int server_total;          // 服务端读取的数据量
+static int server_ok;             // 服务端读取的数据是否正确
+
+/**
+ * @brief 服务端通告零窗口后, 丢弃其第一个重新打开窗口的纯ack(应用程序读取数据后的窗口更新)
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0 || seg.sport != TEST_PORT) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.win == 0) {
+    if (!link_zero_wnd) {
+      link_zero_wnd = 1;
+      link_update_dropped = 0;
+    }
+    return TEST_LINK_PASS;
+  }
+
+  if (link_zero_wnd && !link_update_dropped && seg.len == 0) {
+    link_update_dropped = 1;
+    link_drops++;
+    return TEST_LINK_DROP;
+  }
+  link_zero_wnd = 0;
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 监听前设置接收缓冲区为TEST_READ_SIZE, 接收停滞超过5s时认为连接已死锁
+ *
+ * @param sock
+ * @return int
+ */
+static int server_setup(int sock) {
+  int rcvbuf = TEST_READ_SIZE;
+  struct timeval tmo = {.tv_sec = 5, .tv_usec = 0};
+  if (setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char *)&rcvbuf,
+                 sizeof(int)) < 0 ||
+      setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tmo,
+                 sizeof(tmo)) < 0) {
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief 服务端处理一个连接: 每隔TEST_READ_PAUSE读取一次数据并校验
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[TEST_READ_SIZE];
+  server_ok = 1;
+  while (server_total < TEST_DATA_SIZE) {
+    sys_sleep(TEST_READ_PAUSE);
+    int len = recv(client, buf, sizeof(buf), 0);
+    if (len <= 0) {
+      plat_printf("server recv stalled at %d bytes\n", server_total);
+      server_ok = 0;
+      break;
+    }
+    for (int i = 0; i < len; i++) {
+      if (buf[i] != (uint8_t)(server_total + i)) {
+        server_ok = 0;
+      }
+    }
+    server_total += len;
+  }
+  sys_sem_notify(read_sem);
+
+  while (recv(client, buf, sizeof(buf), 0) > 0) {
+  }
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "zwnd",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open zwnd netif error\n");
+    return -1;
+  }
+  net_start();
+
+  read_sem = sys_sem_create(0);
+  server.port = TEST_PORT;
+  server.setup = server_setup;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0 || test_tcp_connect(s, TEST_IP, TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  net_time_t time;
+  sys_time_curr(&time);
+
+  static uint8_t buf[TEST_DATA_SIZE];
+  for (int i = 0; i < TEST_DATA_SIZE; i++) {
+    buf[i] = (uint8_t)i;
+  }
+  if (test_send_all(s, buf, TEST_DATA_SIZE) < 0) {
+    plat_printf("send error\n");
+    close(s);
+    return -1;
+  }
+  sys_sem_wait(read_sem, 0);
+  int ms = sys_time_goes(&time);
+
+  struct net_tcp_info info;
+  if (test_tcp_info_get(s, &info) < 0) {
+    plat_printf("getsockopt TCP_INFO error\n");
+    close(s);
+    return -1;
+  }
+  close(s);
+
+  plat_printf("tcp persist: %d bytes in %d ms, %d window updates dropped, "
+              "%u zero window probes, %u rto\n",
+              server_total, ms, link_drops, info.zwnd_probes, info.rto_cnt);
+
+  // 每次丢弃窗口更新后由探测恢复, 探测间隔退避两次以内即可遇到已打开的窗口
+  int limit = TEST_READ_CNT * (TEST_READ_PAUSE + 4 * TCP_RTO_MIN);
+  if (!server_ok || server_total != TEST_DATA_SIZE || link_drops == 0 ||
+      info.zwnd_probes < (uint32_t)link_drops || ms > limit) {
+    plat_printf("tcp persist test failed\n");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,225 @@
+/**
+ * @file test_tcp_rack.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp RACK-TLP丢包检测测试: 打开一个模拟有传播时延的网络接口, 客户端在同一个连接上
+ *        反复发送小请求, 服务端回复由多个数据段组成的响应, 分别在不丢包、丢弃每个响应第一个数据段之后的
+ *        所有数据段(尾部丢包, 由尾部丢失探测修复)及丢弃每个响应的第一个数据段(之后的数据段触发重复ack,
+ *        由RACK检测)三种情况下统计请求的时延分布, 丢包时的p99时延应远小于最小重传超时时间;
+ *        尾部丢失两个数据段, 使探测超时按多个数据段在途计算, 只剩一个数据段在途时探测超时需等待对端的
+ *        延迟确认, 由test_tcp_delack检查
+ * @version 0.1
+ * @date 2024-12-11
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp_rack.h"
+#include "test_util.h"
+
+#define TEST_PORT 6007             // 监听端口
+#define TEST_IP "10.10.1.1"        // 模拟链路接口的ip地址
+#define TEST_REQ_SIZE 64           // 请求大小
+#define TEST_RESP_SIZE 4000        // 响应大小, 三个数据段
+#define TEST_WARMUP 5              // 每轮开始时不丢包的请求数, 用于采样rtt
+#define TEST_RPC_CNT 40            // 每轮统计时延的请求数
+
+#define LINK_DELAY 10     // 单向传播时延(ms), rtt为20ms
+
+// 丢包方式
+typedef enum _link_drop_t {
+  LINK_DROP_NONE = 0,  // 不丢包
+  LINK_DROP_TAIL,      // 丢弃每个响应第一个数据段之后的所有数据段
+  LINK_DROP_HEAD,      // 丢弃每个响应的第一个数据段
+} link_drop_t;
+
+static link_drop_t link_drop;     // 当前的丢包方式
+static int link_new_resp;         // 客户端发送了请求, 下一个服务端数据段为响应的开始
+static uint32_t link_resp_seq;    // 当前响应的起始序号
+static uint32_t link_drop_end;    // 已丢弃的数据的结束序号, 重传的数据段不再丢弃
+static int link_drops;            // 本轮丢弃的报文数
+
+static test_server_t server;      // 服务端
+
+/**
+ * @brief 按当前的丢包方式判断是否丢弃报文, 每个丢弃的数据段只丢弃一次
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0 || seg.len <= 0) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.sport != TEST_PORT) {  // 客户端的请求
+    link_new_resp = 1;
+    return TEST_LINK_PASS;
+  }
+
+  if (link_new_resp) {
+    link_new_resp = 0;
+    link_resp_seq = seg.seq;
+    link_drop_end = seg.seq;
+  }
+
+  int drop = 0;
+  if (link_drop == LINK_DROP_TAIL) {
+    drop = seg.seq != link_resp_seq;
+  } else if (link_drop == LINK_DROP_HEAD) {
+    drop = seg.seq == link_resp_seq;
+  }
+  if (!drop || (int32_t)(seg.seq + seg.len - link_drop_end) <= 0) {
+    return TEST_LINK_PASS;
+  }
+
+  link_drop_end = seg.seq + seg.len;
+  link_drops++;
+  return TEST_LINK_DROP;
+}
+
+/**
+ * @brief 服务端处理一个连接: 每收到一个请求, 回复请求中指定大小的响应
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  // 响应的多个数据段需立即发出, 不能被Nagle算法推迟
+  int on = 1;
+  setsockopt(client, SOL_TCP, TCP_NODELAY, (const char *)&on, sizeof(int));
+
+  static uint8_t buf[TEST_RESP_SIZE];
+  while (test_recv_all(client, buf, TEST_REQ_SIZE) == 0) {
+    int size = *(int *)buf;
+    if (send(client, buf, size, 0) != size) {
+      break;
+    }
+  }
+}
+
+/**
+ * @brief 比较函数, 用于对时延排序
+ */
+static int cmp_int(const void *a, const void *b) {
+  return *(const int *)a - *(const int *)b;
+}
+
+/**
+ * @brief 以指定的丢包方式进行一轮请求, 统计时延分布
+ *
+ * @param s 客户端socket
+ * @param drop 丢包方式
+ * @param resp_size 响应大小
+ * @param name 测试名称
+ * @return int p99时延(ms), 出错时返回-1
+ */
+static int test_round(int s, link_drop_t drop, int resp_size,
+                      const char *name) {
+  static uint8_t buf[TEST_RESP_SIZE];
+  int delay[TEST_RPC_CNT];
+
+  test_link_lock();
+  link_drop = LINK_DROP_NONE;
+  link_drops = 0;
+  test_link_unlock();
+
+  tcp_rack_stats_t start;
+  tcp_rack_stats_get(&start);
+
+  for (int i = 0; i < TEST_WARMUP + TEST_RPC_CNT; i++) {
+    if (i == TEST_WARMUP) {
+      test_link_lock();
+      link_drop = drop;
+      test_link_unlock();
+    }
+
+    net_time_t time;
+    sys_time_curr(&time);
+    plat_memset(buf, 0, TEST_REQ_SIZE);
+    *(int *)buf = resp_size;
+    if (send(s, buf, TEST_REQ_SIZE, 0) != TEST_REQ_SIZE ||
+        test_recv_all(s, buf, resp_size) < 0) {
+      plat_printf("rpc error\n");
+      return -1;
+    }
+    if (i >= TEST_WARMUP) {
+      delay[i - TEST_WARMUP] = sys_time_goes(&time);
+    }
+  }
+
+  tcp_rack_stats_t end;
+  tcp_rack_stats_get(&end);
+
+  qsort(delay, TEST_RPC_CNT, sizeof(int), cmp_int);
+  int p50 = delay[TEST_RPC_CNT / 2];
+  int p99 = delay[TEST_RPC_CNT * 99 / 100];
+  plat_printf("tcp %s: %d rpcs, %d drops, p50 %d ms, p99 %d ms, "
+              "%u tlp probes, %u tlp recoveries, %u rack lost\n",
+              name, TEST_RPC_CNT, link_drops, p50, p99,
+              end.tlp_probes - start.tlp_probes,
+              end.tlp_recoveries - start.tlp_recoveries,
+              end.rack_lost - start.rack_lost);
+  return p99;
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "lossy",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open lossy netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int on = 1;
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0 ||
+      setsockopt(s, SOL_TCP, TCP_NODELAY, (const char *)&on, sizeof(int)) <
+          0 ||
+      test_tcp_connect(s, TEST_IP, TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  plat_printf("link: rtt %d ms, min rto %d ms\n", 2 * LINK_DELAY, TCP_RTO_MIN);
+
+  tcp_rack_stats_t start, end;
+  tcp_rack_stats_get(&start);
+  int none = test_round(s, LINK_DROP_NONE, TEST_RESP_SIZE, "no loss");
+  int tail = test_round(s, LINK_DROP_TAIL, TEST_RESP_SIZE, "tail loss");
+  tcp_rack_stats_get(&end);
+  int tlp = end.tlp_probes - start.tlp_probes;
+  int head = test_round(s, LINK_DROP_HEAD, TEST_RESP_SIZE, "head loss");
+  tcp_rack_stats_get(&start);
+  int rack = start.rack_lost - end.rack_lost;
+  close(s);
+
+  // 丢包后应在几个rtt内恢复, 而不是等待重传超时
+  if (none < 0 || tail < 0 || head < 0 || tail >= TCP_RTO_MIN ||
+      head >= TCP_RTO_MIN || !tlp || !rack) {
+    plat_printf("tcp rack test failed\n");
+    return -1;
+  }
+  return 0;
+}
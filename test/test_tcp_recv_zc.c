@@ -0,0 +1,177 @@
+/**
+ * @file test_tcp_recv_zc.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp接收路径测试: 通过环回接口批量发送数据,
+ *        服务端分别使用普通接收(recv, 拷贝一次)及零拷贝接收(net_recv_zc)两种方式,
+ *        校验接收数据的正确性, 并检查大部分报文段命中首部预测、接收缓冲区随吞吐量自动扩大
+ * @version 0.1
+ * @date 2024-12-05
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp_rcvbuf.h"
+#include "tcp_recv.h"
+#include "test_util.h"
+
+#define TEST_PORT 6004                  // 监听端口
+#define TEST_WRITE_SIZE (64 * 1024)     // 每次发送调用的数据量
+#define TEST_DATA_SIZE (16 * 1024 * 1024)  // 每轮测试发送的数据总量
+#define TEST_READ_SIZE 4096             // 普通接收时每次读取的数据量
+
+static test_server_t server;     // 服务端
+static volatile int recv_zc;     // 服务端本轮是否使用零拷贝接收
+static volatile int recv_total;  // 服务端本轮已接收的数据量
+static volatile int recv_err;    // 服务端本轮接收到的错误数据量
+
+/**
+ * @brief 数据流中offset处的字节值
+ *
+ * @param offset
+ * @return uint8_t
+ */
+static inline uint8_t test_pattern(int offset) { return (uint8_t)(offset % 251); }
+
+/**
+ * @brief 校验接收的一段数据
+ *
+ * @param data
+ * @param len
+ */
+static void test_check(const uint8_t *data, int len) {
+  for (int i = 0; i < len; i++) {
+    if (data[i] != test_pattern(recv_total + i)) {
+      recv_err++;
+    }
+  }
+  recv_total += len;
+}
+
+/**
+ * @brief 零拷贝接收: 直接遍历数据包的数据块校验数据, 不拷贝到应用程序缓冲区
+ *
+ * @param client
+ * @return int 接收的数据量, 0表示对端已关闭, -1表示失败
+ */
+static int test_recv_zc(int client) {
+  pktbuf_t *buf;
+  int len = net_recv_zc(client, &buf, 0);
+  if (len <= 0) {
+    return len;
+  }
+
+  for (pktblk_t *blk = pktbuf_blk_first(buf); blk;
+       blk = pktbuf_blk_next(buf, blk)) {
+    test_check(blk->data, blk->data_size);
+  }
+  net_recv_zc_free(buf);
+  return len;
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收数据直到对端关闭, 校验接收的数据
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[TEST_READ_SIZE];
+  int len;
+  do {
+    if (recv_zc) {
+      len = test_recv_zc(client);
+    } else if ((len = recv(client, buf, sizeof(buf), 0)) > 0) {
+      test_check(buf, len);
+    }
+  } while (len > 0);
+}
+
+/**
+ * @brief 以指定的接收方式进行一轮测试
+ *
+ * @param zc 服务端是否使用零拷贝接收
+ * @param name 测试模式名称
+ * @return int 0: 成功, -1: 失败
+ */
+static int test_round(int zc, const char *name) {
+  static uint8_t data[TEST_WRITE_SIZE + 251];
+  for (int i = 0; i < sizeof(data); i++) {
+    data[i] = test_pattern(i);
+  }
+
+  recv_zc = zc;
+  recv_total = 0;
+  recv_err = 0;
+
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  if (client < 0 || test_tcp_connect(client, "127.0.0.1", TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  tcp_pred_stats_t pred_start;
+  tcp_pred_stats_get(&pred_start);
+
+  net_time_t start;
+  sys_time_curr(&start);
+
+  // 数据流按251字节循环, 从data中对应的偏移处开始发送即可保持连续
+  int err = 0;
+  for (int sent = 0; sent < TEST_DATA_SIZE && !err; sent += TEST_WRITE_SIZE) {
+    if (send(client, data + sent % 251, TEST_WRITE_SIZE, 0) !=
+        TEST_WRITE_SIZE) {
+      err = -1;
+    }
+  }
+  int rmem = tcp_rcvbuf_mem_used();  // 服务端连接仍未关闭, 统计其接收缓冲区扩大的部分
+  close(client);
+  test_server_wait(&server);
+
+  int ms = sys_time_goes(&start);
+  ms = ms ? ms : 1;
+  plat_printf("tcp recv %s: %d bytes in %d ms, %d KB/s, %d bad bytes\n", name,
+              recv_total, ms, recv_total / ms, recv_err);
+
+  // 首部预测命中率: 统计的是收发双方在已建立连接上接收到的所有报文段
+  tcp_pred_stats_t pred;
+  tcp_pred_stats_get(&pred);
+  int pred_total = (int)(pred.total - pred_start.total);
+  int pred_ack = (int)(pred.ack_hit - pred_start.ack_hit);
+  int pred_data = (int)(pred.data_hit - pred_start.data_hit);
+  plat_printf("tcp recv %s: header prediction %d/%d segments (%d%%), "
+              "%d pure ack, %d pure data\n",
+              name, pred_ack + pred_data, pred_total,
+              pred_total ? (pred_ack + pred_data) * 100 / pred_total : 0,
+              pred_ack, pred_data);
+  plat_printf("tcp recv %s: rcvbuf autotune +%d bytes\n", name, rmem);
+
+  // 批量传输中大部分报文段都应命中首部预测, 接收缓冲区应随吞吐量自动扩大
+  if (pred_total == 0 || (pred_ack + pred_data) * 2 < pred_total ||
+      pred_data == 0 || rmem <= 0) {
+    err = -1;
+  }
+  return (!err && recv_total == TEST_DATA_SIZE && !recv_err) ? 0 : -1;
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int err = 0;
+  err |= test_round(0, "copy");
+  err |= test_round(1, "zerocopy");
+  return err;
+}
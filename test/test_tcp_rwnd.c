@@ -0,0 +1,183 @@
+/**
+ * @file test_tcp_rwnd.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp接收窗口通告测试(接收方避免糊涂窗口综合症): 打开一个模拟有传播时延的网络接口,
+ *        客户端持续发送数据直到服务端的接收窗口关闭, 之后服务端每次只读取少量数据;
+ *        链路记录服务端通告的窗口右边界, 检查右边界从不收回, 每次推进至少min(mss, 接收缓冲区的一半),
+ *        且窗口关闭后由服务端读取数据触发窗口更新, 不需要等待客户端的零窗口探测
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6020            // 监听端口
+#define TEST_IP "10.10.8.1"       // 模拟链路接口的ip地址
+#define TEST_RCVBUF TCP_RBUF_SIZE  // 服务端接收缓冲区大小(不自动扩大)
+#define TEST_DATA_SIZE (4 * TEST_RCVBUF)  // 客户端发送的数据量
+#define TEST_READ_SIZE 100        // 服务端每次读取的数据量
+#define TEST_READ_DELAY 50        // 服务端开始读取前等待的时间(ms)
+
+#define LINK_DELAY 5  // 单向传播时延(ms), rtt为10ms
+
+static int link_thresh;          // 窗口右边界每次推进的最小值
+static int link_edge_valid;      // 是否已记录服务端通告的右边界
+static uint32_t link_edge;       // 服务端最近通告的窗口右边界
+static int link_zero_cnt;        // 服务端通告零窗口的次数
+static int link_update_cnt;      // 零窗口之后右边界推进的次数
+static int link_small_cnt;       // 右边界推进不足阈值或收回的次数
+static int link_probe_cnt;       // 首次零窗口之后到首次窗口更新之前客户端发送的数据段数
+
+static test_server_t server;     // 服务端
+static int server_ok;            // 服务端接收的数据是否正确
+
+/**
+ * @brief 记录服务端通告的窗口右边界的变化
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.dport == TEST_PORT) {
+    if (seg.len > 0 && link_zero_cnt && !link_update_cnt) {
+      link_probe_cnt++;
+    }
+    return TEST_LINK_PASS;
+  }
+  if ((seg.flags & TEST_TCP_SYN) || !(seg.flags & TEST_TCP_ACK)) {
+    return TEST_LINK_PASS;
+  }
+
+  uint32_t edge = seg.ack + seg.win;
+  if (link_edge_valid && edge != link_edge) {
+    int advance = (int32_t)(edge - link_edge);
+    if (advance < link_thresh) {
+      link_small_cnt++;
+    }
+    if (link_zero_cnt) {
+      link_update_cnt++;
+    }
+  }
+  link_edge_valid = 1;
+  link_edge = edge;
+
+  if (seg.win == 0) {
+    link_zero_cnt++;
+  }
+  return TEST_LINK_PASS;
+}
+
+/**
+ * @brief 限制接收缓冲区的大小, 由accept得到的连接继承
+ *
+ * @param sock
+ * @return int
+ */
+static int server_setup(int sock) {
+  int size = TEST_RCVBUF;
+  return setsockopt(sock, SOL_SOCKET, SO_RCVBUF, (const char *)&size,
+                    sizeof(int));
+}
+
+/**
+ * @brief 服务端处理一个连接: 等待接收窗口关闭后每次读取少量数据, 并校验
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[TEST_DATA_SIZE];
+  sys_sleep(TEST_READ_DELAY);
+
+  int total = 0;
+  while (total < sizeof(buf)) {
+    int len = recv(client, buf + total, TEST_READ_SIZE, 0);
+    if (len <= 0) {
+      break;
+    }
+    total += len;
+    sys_sleep(1);
+  }
+
+  server_ok = total == sizeof(buf);
+  for (int i = 0; i < total; i++) {
+    if (buf[i] != (uint8_t)i) {
+      server_ok = 0;
+    }
+  }
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "rwnd",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open rwnd netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.setup = server_setup;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  struct net_tcp_info info;
+  if (s < 0 || test_tcp_connect(s, TEST_IP, TEST_PORT) < 0 ||
+      test_tcp_info_get(s, &info) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  // 两端的mss相同
+  test_link_lock();
+  link_thresh = MIN(info.mss, TEST_RCVBUF / 2);
+  test_link_unlock();
+
+  static uint8_t buf[TEST_DATA_SIZE];
+  for (int i = 0; i < sizeof(buf); i++) {
+    buf[i] = (uint8_t)i;
+  }
+  int err = test_send_all(s, buf, sizeof(buf));
+
+  // 服务端收到全部数据后关闭连接, 关闭需等待客户端也关闭
+  close(s);
+  test_server_wait(&server);
+
+  test_link_lock();
+  plat_printf("tcp rwnd: thresh %d, %d zero windows, %d updates, %d small "
+              "updates, %d probes before the first update, server ok %d\n",
+              link_thresh, link_zero_cnt, link_update_cnt, link_small_cnt,
+              link_probe_cnt, server_ok);
+  err |= !link_zero_cnt || !link_update_cnt || link_small_cnt ||
+         link_probe_cnt;
+  test_link_unlock();
+
+  if (err || !server_ok) {
+    plat_printf("tcp rwnd test failed\n");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,136 @@
+/**
+ * @file test_tcp_synack.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp SYN+ACK丢失测试: 打开一个模拟有传播时延的网络接口, 链路丢弃服务端的第一个SYN+ACK,
+ *        客户端超时后重传SYN, 检查处于SYN_RCVD状态的服务端对重传的SYN回复SYN+ACK,
+ *        而不是将其作为接收窗口之前的报文段只回复ack, 握手完成后数据正确到达
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6022          // 监听端口
+#define TEST_IP "10.10.10.1"    // 模拟链路接口的ip地址
+#define TEST_DATA_SIZE 100      // 握手完成后发送的数据量
+
+#define LINK_DELAY 5  // 单向传播时延(ms), rtt为10ms
+
+static int link_syn_cnt;        // 客户端发送的SYN数
+static int link_synack_cnt;     // 服务端发送的SYN+ACK数
+static int link_plain_cnt;      // 握手完成前服务端发送的不带SYN的报文段数
+static int link_established;    // 客户端是否已确认SYN+ACK
+
+static test_server_t server;    // 服务端
+static int server_ok;           // 服务端接收的数据是否正确
+
+/**
+ * @brief 丢弃服务端的第一个SYN+ACK, 并记录握手完成前双方发送的报文段
+ *
+ * @param buf
+ * @return int
+ */
+static int link_filter(pktbuf_t *buf) {
+  test_tcp_seg_t seg;
+  if (test_tcp_parse(buf, &seg) < 0) {
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.dport == TEST_PORT) {
+    if (seg.flags & TEST_TCP_SYN) {
+      link_syn_cnt++;
+    } else if (link_synack_cnt > 1) {
+      link_established = 1;
+    }
+    return TEST_LINK_PASS;
+  }
+
+  if (seg.sport != TEST_PORT || link_established) {
+    return TEST_LINK_PASS;
+  }
+  if (!(seg.flags & TEST_TCP_SYN)) {
+    link_plain_cnt++;
+    return TEST_LINK_PASS;
+  }
+  return link_synack_cnt++ == 0 ? TEST_LINK_DROP : TEST_LINK_PASS;
+}
+
+/**
+ * @brief 服务端处理一个连接: 接收全部数据并校验
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[TEST_DATA_SIZE];
+  server_ok = test_recv_all(client, buf, sizeof(buf)) == 0;
+  for (int i = 0; i < sizeof(buf); i++) {
+    if (buf[i] != (uint8_t)i) {
+      server_ok = 0;
+    }
+  }
+}
+
+int main(void) {
+  static const test_link_cfg_t link_cfg = {
+      .name = "synack",
+      .ip = TEST_IP,
+      .delay = LINK_DELAY,
+      .filter = link_filter,
+  };
+
+  net_init();
+  if (test_link_open(&link_cfg) < 0) {
+    plat_printf("open synack netif error\n");
+    return -1;
+  }
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  // 第一个SYN+ACK被丢弃, 握手在客户端重传SYN后完成
+  net_time_t time;
+  sys_time_curr(&time);
+  int s = socket(AF_INET, SOCK_STREAM, 0);
+  if (s < 0 || test_tcp_connect(s, TEST_IP, TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+  int ms = sys_time_goes(&time);
+
+  static uint8_t buf[TEST_DATA_SIZE];
+  for (int i = 0; i < sizeof(buf); i++) {
+    buf[i] = (uint8_t)i;
+  }
+  int err = test_send_all(s, buf, sizeof(buf));
+
+  // 服务端收到全部数据后关闭连接, 关闭需等待客户端也关闭
+  close(s);
+  test_server_wait(&server);
+
+  test_link_lock();
+  plat_printf("tcp synack: connected in %d ms, %d syns, %d syn+acks, "
+              "%d plain segs before established, server ok %d\n",
+              ms, link_syn_cnt, link_synack_cnt, link_plain_cnt, server_ok);
+  err |= link_syn_cnt < 2 || link_synack_cnt < 2 || link_plain_cnt;
+  test_link_unlock();
+
+  if (err || !server_ok) {
+    plat_printf("tcp synack test failed\n");
+    return -1;
+  }
+  return 0;
+}
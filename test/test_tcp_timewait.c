@@ -0,0 +1,127 @@
+/**
+ * @file test_tcp_timewait.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp TIME_WAIT测试: 通过环回接口使用固定的客户端端口反复建立连接,
+ *        验证主动关闭的连接由TIME_WAIT记录代替tcp对象等待2MSL,
+ *        四元组在TIME_WAIT期间不能立即复用, 满足时间戳条件后可以安全复用,
+ *        以及对端复用四元组发起的新连接请求可以结束本地的TIME_WAIT
+ * @version 0.1
+ * @date 2024-12-06
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "tcp_tw.h"
+#include "test_util.h"
+
+#define TEST_PORT 6005         // 监听端口
+#define TEST_CLIENT_PORT 7005  // 客户端固定使用的本地端口
+
+static test_server_t server;          // 服务端
+static volatile int server_close_first;  // 服务端是否主动关闭连接
+static volatile int echo_cnt;         // 服务端回显的次数
+
+/**
+ * @brief 服务端处理一个连接: 回显一次数据, 根据server_close_first主动关闭连接或等待客户端关闭
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  char buf[16];
+  int len = recv(client, buf, sizeof(buf), 0);
+  if (len > 0 && send(client, buf, len, 0) == len) {
+    echo_cnt++;
+  }
+  if (!server_close_first) {
+    while (recv(client, buf, sizeof(buf), 0) > 0) {
+    }
+  }
+}
+
+/**
+ * @brief 使用固定的本地端口连接服务端, 收发一次数据后关闭连接
+ *
+ * @return int 0: 成功, -1: 连接失败, -2: 收发失败
+ */
+static int test_conn(void) {
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  if (client < 0) {
+    return -1;
+  }
+
+  struct sockaddr_in addr;
+  test_addr_init(&addr, (const char *)0, TEST_CLIENT_PORT);
+  if (bind(client, (const struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      test_tcp_connect(client, "127.0.0.1", TEST_PORT) < 0) {
+    close(client);
+    return -1;
+  }
+
+  char buf[16];
+  int err = 0;
+  if (send(client, "ping", 4, 0) != 4 || recv(client, buf, sizeof(buf), 0) != 4) {
+    err = -2;
+  }
+
+  // 服务端主动关闭时等待其fin, 使本地成为被动关闭的一方
+  if (server_close_first) {
+    while (recv(client, buf, sizeof(buf), 0) > 0) {
+    }
+  }
+  close(client);
+  test_server_wait(&server);
+  return err;
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  plat_printf("tcp timewait: tcp_t %d bytes, tcp_tw_t %d bytes\n",
+              (int)sizeof(tcp_t), (int)sizeof(tcp_tw_t));
+
+  int err = 0;
+
+  // 客户端主动关闭, 四元组进入TIME_WAIT, 立即复用会失败
+  int first = test_conn();
+  int busy = test_conn();
+  plat_printf("tcp timewait: first conn %d, immediate reuse %d (expect -1)\n",
+              first, busy);
+  err |= first != 0 || busy != -1;
+
+  // 超过复用延迟后, 使用时间戳的四元组可以安全复用
+  sys_sleep(TCP_TW_REUSE_DELAY + 100);
+  int reuse = test_conn();
+  plat_printf("tcp timewait: reuse after %d ms %d (expect 0)\n",
+              TCP_TW_REUSE_DELAY + 100, reuse);
+  err |= reuse != 0;
+
+  // 服务端主动关闭, 服务端的四元组进入TIME_WAIT,
+  // 客户端复用四元组发起的新连接请求携带更新的时间戳, 结束服务端的TIME_WAIT
+  server_close_first = 1;
+  sys_sleep(TCP_TW_REUSE_DELAY + 100);  // 等待客户端自身的TIME_WAIT可以复用
+  int passive = test_conn();
+  sys_sleep(10);
+  int recycle = test_conn();
+  plat_printf("tcp timewait: server close %d, syn recycles server TIME_WAIT "
+              "%d (expect 0)\n",
+              passive, recycle);
+  err |= passive != 0 || recycle != 0;
+
+  plat_printf("tcp timewait: echo %d/4\n", echo_cnt);
+  return (err || echo_cnt != 4) ? -1 : 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file test_tcp_zerocopy.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief tcp零拷贝发送测试: 通过环回接口以1MB为单位批量发送数据,
+ *        分别在普通发送(拷贝)及零拷贝发送(MSG_ZEROCOPY)两种模式下检查数据全部正确到达,
+ *        零拷贝模式下收到完成通知后才重新写入数据区, 且每次发送调用都按序收到完成通知,
+ *        普通发送模式下不产生完成通知
+ * @version 0.1
+ * @date 2024-12-04
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+#include "test_util.h"
+
+#define TEST_PORT 6003                     // 监听端口
+#define TEST_WRITE_SIZE (1024 * 1024)      // 每次发送调用的数据量
+#define TEST_WRITE_CNT 16                  // 每轮测试的发送调用次数
+#define TEST_DATA_SIZE (TEST_WRITE_SIZE * TEST_WRITE_CNT)
+#define TEST_BUF_CNT 2                     // 轮流使用的发送数据区数量
+
+static test_server_t server;     // 服务端
+static volatile int recv_total;  // 服务端本轮已接收的数据量
+static volatile int recv_err;    // 服务端本轮接收到的错误数据量
+
+/**
+ * @brief 数据流中offset处的字节值
+ *
+ * @param offset
+ * @return uint8_t
+ */
+static inline uint8_t test_pattern(int offset) { return (uint8_t)(offset % 251); }
+
+/**
+ * @brief 服务端处理一个连接: 接收数据直到对端关闭, 校验接收的数据
+ *
+ * @param server
+ * @param client
+ */
+static void server_handle(test_server_t *server, int client) {
+  static uint8_t buf[4096];
+  int len;
+  while ((len = recv(client, buf, sizeof(buf), 0)) > 0) {
+    for (int i = 0; i < len; i++) {
+      if (buf[i] != test_pattern(recv_total + i)) {
+        recv_err++;
+      }
+    }
+    recv_total += len;
+  }
+}
+
+/**
+ * @brief 等待序号为id的零拷贝发送调用完成
+ *
+ * @param sock
+ * @param id
+ * @param done 已完成调用的下一个序号
+ * @return int 0: 成功, -1: 失败
+ */
+static int wait_zc_done(int sock, uint32_t id, uint32_t *done) {
+  while (*done <= id) {
+    struct net_zc_notify notify;
+    int len = recv(sock, &notify, sizeof(notify), MSG_ERRQUEUE);
+    if (len < 0) {
+      return -1;
+    } else if (len == 0) {  // 还没有完成通知
+      sys_sleep(1);
+      continue;
+    }
+
+    if (notify.lo != *done) {
+      plat_printf("zerocopy notify out of order: %u != %u\n", notify.lo,
+                  *done);
+      return -1;
+    }
+    *done = notify.hi + 1;
+  }
+
+  return 0;
+}
+
+/**
+ * @brief 以指定的发送模式进行一轮测试
+ *
+ * @param zerocopy 是否使用零拷贝发送
+ * @param name 测试模式名称
+ * @return int 0: 成功, -1: 失败
+ */
+static int test_round(int zerocopy, const char *name) {
+  static uint8_t data[TEST_BUF_CNT][TEST_WRITE_SIZE];
+
+  recv_total = 0;
+  recv_err = 0;
+
+  int client = socket(AF_INET, SOCK_STREAM, 0);
+  if (client < 0 ||
+      setsockopt(client, SOL_SOCKET, SO_ZEROCOPY, (const char *)&zerocopy,
+                 sizeof(int)) < 0 ||
+      test_tcp_connect(client, "127.0.0.1", TEST_PORT) < 0) {
+    plat_printf("connect error\n");
+    return -1;
+  }
+
+  net_time_t start;
+  sys_time_curr(&start);
+
+  int err = 0;
+  uint32_t done = 0;  // 已完成的零拷贝发送调用的下一个序号
+  for (int i = 0; i < TEST_WRITE_CNT && !err; i++) {
+    uint8_t *buf = data[i % TEST_BUF_CNT];
+
+    // 零拷贝模式下, 数据区在上一次使用它的发送调用完成后才能重新写入
+    if (zerocopy && i >= TEST_BUF_CNT &&
+        wait_zc_done(client, (uint32_t)(i - TEST_BUF_CNT), &done) < 0) {
+      err = -1;
+      break;
+    }
+    for (int j = 0; j < TEST_WRITE_SIZE; j++) {
+      buf[j] = test_pattern(i * TEST_WRITE_SIZE + j);
+    }
+
+    if (send(client, buf, TEST_WRITE_SIZE, zerocopy ? MSG_ZEROCOPY : 0) !=
+        TEST_WRITE_SIZE) {
+      err = -1;
+    }
+  }
+
+  // 零拷贝模式下等待所有发送调用完成; 普通发送模式下不应产生完成通知
+  struct net_zc_notify notify;
+  if (zerocopy) {
+    err |= wait_zc_done(client, TEST_WRITE_CNT - 1, &done);
+  } else if (recv(client, &notify, sizeof(notify), MSG_ERRQUEUE) != 0) {
+    err = -1;
+  }
+  close(client);
+  test_server_wait(&server);
+
+  int ms = sys_time_goes(&start);
+  ms = ms ? ms : 1;
+  plat_printf("tcp %s: %d bytes in %d ms, %d KB/s, %u sends notified, %d bad "
+              "bytes\n",
+              name, recv_total, ms, recv_total / ms, done, recv_err);
+
+  if (zerocopy && done != TEST_WRITE_CNT) {
+    err = -1;
+  }
+  return (!err && recv_total == TEST_DATA_SIZE && !recv_err) ? 0 : -1;
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  server.port = TEST_PORT;
+  server.handle = server_handle;
+  if (test_server_start(&server) < 0) {
+    return -1;
+  }
+
+  int err = 0;
+  err |= test_round(0, "copy");
+  err |= test_round(1, "zerocopy");
+  return err;
+}
@@ -0,0 +1,260 @@
+/**
+ * @file test_udp_gso.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief udp分段发送及接收合并测试: 客户端设置UDP_SEGMENT后通过环回接口发送超级数据报,
+ *        检查未设置UDP_GRO的接收方逐个收到正确切分的数据报,
+ *        设置了UDP_GRO的接收方通过recvmsg一次收到合并后的数据及数据报大小;
+ *        之后分别使用超级数据报及逐个sendto/recvfrom统计每秒传输的数据报数量
+ * @version 0.1
+ * @date 2024-12-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+
+#define TEST_GRO_PORT 6013      // 设置了UDP_GRO的接收端口
+#define TEST_PLAIN_PORT 6014    // 普通接收端口
+#define TEST_SEG_SIZE 1000      // 每个数据报的大小
+#define TEST_SEG_CNT 16         // 每个超级数据报包含的完整数据报数量
+#define TEST_TAIL_SIZE 500      // 超级数据报末尾不足一个数据报的数据量
+#define TEST_DATA_SIZE (TEST_SEG_SIZE * TEST_SEG_CNT + TEST_TAIL_SIZE)
+#define TEST_ROUND_CNT 256      // 性能统计的轮数
+
+static uint8_t tx_buf[TEST_DATA_SIZE];
+static uint8_t rx_buf[TEST_DATA_SIZE];
+
+/**
+ * @brief 打开一个udp socket, 绑定到指定端口并设置接收超时
+ *
+ * @param port 绑定的端口, 0表示不绑定
+ * @param gro 是否设置UDP_GRO
+ * @return int socket, 失败时返回-1
+ */
+static int sock_open(uint16_t port, int gro) {
+  int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s < 0) {
+    return -1;
+  }
+
+  struct timeval tmo = {.tv_sec = 1, .tv_usec = 0};
+  struct sockaddr_in addr;
+  plat_memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = INADDR_ANY;
+  addr.sin_port = htons(port);
+  if (setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tmo,
+                 sizeof(tmo)) < 0 ||
+      (gro && setsockopt(s, SOL_UDP, UDP_GRO, (const char *)&gro,
+                         sizeof(int)) < 0) ||
+      (port && bind(s, (const struct sockaddr *)&addr, sizeof(addr)) < 0)) {
+    close(s);
+    return -1;
+  }
+  return s;
+}
+
+/**
+ * @brief 设置发送方的分段大小
+ *
+ * @param s
+ * @param size
+ * @return int 0: 成功, -1: 失败
+ */
+static int seg_set(int s, int size) {
+  return setsockopt(s, SOL_UDP, UDP_SEGMENT, (const char *)&size, sizeof(int));
+}
+
+/**
+ * @brief 检查接收的数据与发送缓冲区中对应位置的数据一致
+ *
+ * @param offset 数据在发送缓冲区中的偏移
+ * @param len
+ * @return int 1: 一致, 0: 不一致
+ */
+static int data_check(int offset, int len) {
+  return plat_memcmp(rx_buf, tx_buf + offset, len) == 0;
+}
+
+/**
+ * @brief 通过recvmsg接收合并后的数据, 直到收到size字节
+ *
+ * @param s
+ * @param size 期望接收的数据量
+ * @param segsize 返回合并的数据报大小
+ * @return int 实际接收的数据量, 出错时返回-1
+ */
+static int gro_recv(int s, int size, int *segsize) {
+  int total = 0;
+  *segsize = 0;
+  while (total < size) {
+    struct sockaddr_in from;
+    struct msghdr msg;
+    msg.msg_buf = rx_buf + total;
+    msg.msg_buflen = size - total;
+    msg.msg_name = (struct sockaddr *)&from;
+    msg.msg_namelen = sizeof(from);
+    int len = recvmsg(s, &msg, 0);
+    if (len <= 0 || msg.msg_namelen != sizeof(from)) {
+      return -1;
+    }
+    if (msg.msg_segsize) {
+      *segsize = msg.msg_segsize;
+    }
+    total += len;
+  }
+  return total;
+}
+
+/**
+ * @brief 进行多轮传输, 统计每秒传输的数据报数量
+ *
+ * @param s 发送方socket
+ * @param r 接收方socket
+ * @param to 接收方地址
+ * @param gso 是否使用超级数据报发送并合并接收
+ * @param name 测试名称
+ * @return int 每秒传输的数据报数量, 出错时返回-1
+ */
+static int test_run(int s, int r, struct sockaddr_in *to, int gso,
+                    const char *name) {
+  const int size = TEST_SEG_SIZE * TEST_SEG_CNT;
+  net_time_t time;
+  sys_time_curr(&time);
+
+  for (int round = 0; round < TEST_ROUND_CNT; round++) {
+    if (gso) {
+      int segsize;
+      if (sendto(s, tx_buf, size, 0, (const struct sockaddr *)to,
+                 sizeof(*to)) != size ||
+          gro_recv(r, size, &segsize) != size || !data_check(0, size)) {
+        plat_printf("udp %s: error at round %d\n", name, round);
+        return -1;
+      }
+      continue;
+    }
+
+    for (int i = 0; i < TEST_SEG_CNT; i++) {
+      if (sendto(s, tx_buf + i * TEST_SEG_SIZE, TEST_SEG_SIZE, 0,
+                 (const struct sockaddr *)to, sizeof(*to)) != TEST_SEG_SIZE) {
+        plat_printf("udp %s: sendto error at round %d\n", name, round);
+        return -1;
+      }
+    }
+    for (int i = 0; i < TEST_SEG_CNT; i++) {
+      struct sockaddr_in from;
+      net_socklen_t from_len = sizeof(from);
+      if (recvfrom(r, rx_buf, TEST_SEG_SIZE, 0, (struct sockaddr *)&from,
+                   &from_len) != TEST_SEG_SIZE ||
+          !data_check(i * TEST_SEG_SIZE, TEST_SEG_SIZE)) {
+        plat_printf("udp %s: recvfrom error at round %d\n", name, round);
+        return -1;
+      }
+    }
+  }
+
+  int ms = sys_time_goes(&time);
+  int pps =
+      (int)((int64_t)TEST_ROUND_CNT * TEST_SEG_CNT * 1000 / (ms ? ms : 1));
+  plat_printf("udp %s: %d pkts in %d ms, %d pkts/s\n", name,
+              TEST_ROUND_CNT * TEST_SEG_CNT, ms, pps);
+  return pps;
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  for (int i = 0; i < TEST_DATA_SIZE; i++) {
+    tx_buf[i] = (uint8_t)(i * 7 + (i >> 8));
+  }
+
+  int s = sock_open(0, 0);
+  int gro = sock_open(TEST_GRO_PORT, 1);
+  int plain = sock_open(TEST_PLAIN_PORT, 0);
+  if (s < 0 || gro < 0 || plain < 0) {
+    plat_printf("create socket error\n");
+    return -1;
+  }
+
+  struct sockaddr_in gro_addr, plain_addr;
+  plat_memset(&gro_addr, 0, sizeof(gro_addr));
+  gro_addr.sin_family = AF_INET;
+  gro_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  gro_addr.sin_port = htons(TEST_GRO_PORT);
+  plain_addr = gro_addr;
+  plain_addr.sin_port = htons(TEST_PLAIN_PORT);
+
+  // 切分后的数据报不能超过环回接口的mtu
+  int seg = 0;
+  int len = sizeof(int);
+  if (seg_set(s, 1500) < 0 ||
+      sendto(s, tx_buf, TEST_DATA_SIZE, 0, (const struct sockaddr *)&gro_addr,
+             sizeof(gro_addr)) > 0 ||
+      seg_set(s, TEST_SEG_SIZE) < 0 ||
+      getsockopt(s, SOL_UDP, UDP_SEGMENT, (char *)&seg, &len) < 0 ||
+      seg != TEST_SEG_SIZE) {
+    plat_printf("udp segment option error\n");
+    return -1;
+  }
+
+  // 普通接收方逐个收到切分后的数据报, 最后一个数据报较短
+  if (sendto(s, tx_buf, TEST_DATA_SIZE, 0, (const struct sockaddr *)&plain_addr,
+             sizeof(plain_addr)) != TEST_DATA_SIZE) {
+    plat_printf("udp gso sendto error\n");
+    return -1;
+  }
+  for (int offset = 0; offset < TEST_DATA_SIZE; offset += TEST_SEG_SIZE) {
+    int size = MIN(TEST_SEG_SIZE, TEST_DATA_SIZE - offset);
+    struct sockaddr_in from;
+    net_socklen_t from_len = sizeof(from);
+    if (recvfrom(plain, rx_buf, sizeof(rx_buf), 0, (struct sockaddr *)&from,
+                 &from_len) != size ||
+        !data_check(offset, size)) {
+      plat_printf("udp gso segment error at %d\n", offset);
+      return -1;
+    }
+  }
+
+  // 设置了UDP_GRO的接收方在数据报全部到达后一次读取合并的数据
+  if (sendto(s, tx_buf, TEST_DATA_SIZE, 0, (const struct sockaddr *)&gro_addr,
+             sizeof(gro_addr)) != TEST_DATA_SIZE) {
+    plat_printf("udp gso sendto error\n");
+    return -1;
+  }
+  sys_sleep(50);
+
+  struct sockaddr_in from;
+  struct msghdr msg;
+  msg.msg_buf = rx_buf;
+  msg.msg_buflen = sizeof(rx_buf);
+  msg.msg_name = (struct sockaddr *)&from;
+  msg.msg_namelen = sizeof(from);
+  len = recvmsg(gro, &msg, 0);
+  plat_printf("udp gro: recv %d bytes, segsize %d\n", len, msg.msg_segsize);
+  if (len != TEST_DATA_SIZE || msg.msg_segsize != TEST_SEG_SIZE ||
+      !data_check(0, TEST_DATA_SIZE)) {
+    plat_printf("udp gro merge error\n");
+    return -1;
+  }
+
+  // 超级数据报每轮只需一次发送及少量接收调用, 逐个收发则需要2 * TEST_SEG_CNT次
+  int gso_pps = test_run(s, gro, &gro_addr, 1, "gso/gro");
+  seg_set(s, 0);
+  int plain_pps = test_run(s, plain, &plain_addr, 0, "sendto/recvfrom");
+
+  close(s);
+  close(gro);
+  close(plain);
+  if (gso_pps < 0 || plain_pps < 0) {
+    plat_printf("udp gso test failed\n");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,196 @@
+/**
+ * @file test_udp_mmsg.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief udp批量收发测试: 通过环回接口启动udp回显服务器(使用recvmmsg/sendmmsg),
+ *        客户端每轮发送一批数据报并等待全部回显, 分别使用逐个sendto/recvfrom
+ *        及批量sendmmsg/recvmmsg统计每秒回显的数据报数量, 并检查回显的数据正确
+ * @version 0.1
+ * @date 2024-12-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "echo/udp_echo_server.h"
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+
+#define TEST_PORT 6011       // 回显服务器端口
+#define TEST_BATCH 16        // 每轮发送的数据报数量
+#define TEST_ROUND_CNT 1024  // 轮数
+#define TEST_PKT_SIZE 64     // 数据报大小
+
+static struct sockaddr_in server_addr;
+static uint8_t tx_buf[TEST_BATCH][TEST_PKT_SIZE];
+static uint8_t rx_buf[TEST_BATCH][TEST_PKT_SIZE];
+
+/**
+ * @brief 填充一轮待发送的数据报, 每个数据报携带其全局序号
+ *
+ * @param round
+ */
+static void batch_fill(int round) {
+  for (int i = 0; i < TEST_BATCH; i++) {
+    uint32_t seq = round * TEST_BATCH + i;
+    plat_memset(tx_buf[i], (uint8_t)seq, TEST_PKT_SIZE);
+    plat_memcpy(tx_buf[i], &seq, sizeof(seq));
+  }
+}
+
+/**
+ * @brief 检查回显的数据报是否属于本轮且内容正确, 环回接口不会乱序
+ *
+ * @param i 在本轮中的序号
+ * @param len 回显的数据量
+ * @return int 1: 正确, 0: 错误
+ */
+static int batch_check(int i, int len) {
+  return len == TEST_PKT_SIZE &&
+         plat_memcmp(rx_buf[i], tx_buf[i], TEST_PKT_SIZE) == 0;
+}
+
+/**
+ * @brief 逐个调用sendto/recvfrom完成一轮回显
+ *
+ * @param s
+ * @return int 0: 成功, -1: 失败
+ */
+static int round_single(int s) {
+  for (int i = 0; i < TEST_BATCH; i++) {
+    if (sendto(s, tx_buf[i], TEST_PKT_SIZE, 0,
+               (const struct sockaddr *)&server_addr,
+               sizeof(server_addr)) != TEST_PKT_SIZE) {
+      return -1;
+    }
+  }
+
+  for (int i = 0; i < TEST_BATCH; i++) {
+    struct sockaddr_in from;
+    net_socklen_t from_len = sizeof(from);
+    int len = recvfrom(s, rx_buf[i], TEST_PKT_SIZE, 0,
+                       (struct sockaddr *)&from, &from_len);
+    if (!batch_check(i, len)) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * @brief 调用sendmmsg/recvmmsg批量完成一轮回显
+ *
+ * @param s
+ * @return int 0: 成功, -1: 失败
+ */
+static int round_batch(int s) {
+  struct mmsghdr msgs[TEST_BATCH];
+  struct sockaddr_in from[TEST_BATCH];
+  for (int i = 0; i < TEST_BATCH; i++) {
+    msgs[i].msg_buf = tx_buf[i];
+    msgs[i].msg_buflen = TEST_PKT_SIZE;
+    msgs[i].msg_name = (struct sockaddr *)&server_addr;
+    msgs[i].msg_namelen = sizeof(server_addr);
+  }
+  if (sendmmsg(s, msgs, TEST_BATCH, 0) != TEST_BATCH) {
+    return -1;
+  }
+
+  for (int total = 0; total < TEST_BATCH;) {
+    for (int i = total; i < TEST_BATCH; i++) {
+      msgs[i].msg_buf = rx_buf[i];
+      msgs[i].msg_buflen = TEST_PKT_SIZE;
+      msgs[i].msg_name = (struct sockaddr *)&from[i];
+      msgs[i].msg_namelen = sizeof(from[i]);
+    }
+    int cnt = recvmmsg(s, msgs + total, TEST_BATCH - total, 0);
+    if (cnt <= 0) {
+      return -1;
+    }
+    for (int i = total; i < total + cnt; i++) {
+      if (!batch_check(i, msgs[i].msg_len) ||
+          from[i].sin_port != server_addr.sin_port) {
+        return -1;
+      }
+    }
+    total += cnt;
+  }
+  return 0;
+}
+
+/**
+ * @brief 进行多轮回显, 统计每秒回显的数据报数量
+ *
+ * @param s
+ * @param batch 是否使用批量收发接口
+ * @param name 测试名称
+ * @return int 每秒回显的数据报数量, 出错时返回-1
+ */
+static int test_run(int s, int batch, const char *name) {
+  net_time_t time;
+  sys_time_curr(&time);
+
+  for (int round = 0; round < TEST_ROUND_CNT; round++) {
+    batch_fill(round);
+    if ((batch ? round_batch(s) : round_single(s)) < 0) {
+      plat_printf("udp %s: echo error at round %d\n", name, round);
+      return -1;
+    }
+  }
+
+  int ms = sys_time_goes(&time);
+  int pps = (int)((int64_t)TEST_ROUND_CNT * TEST_BATCH * 1000 / (ms ? ms : 1));
+  plat_printf("udp %s: %d pkts in %d ms, %d pkts/s\n", name,
+              TEST_ROUND_CNT * TEST_BATCH, ms, pps);
+  return pps;
+}
+
+int main(void) {
+  net_init();
+  net_start();
+  udp_echo_server_start(TEST_PORT);
+
+  plat_memset(&server_addr, 0, sizeof(server_addr));
+  server_addr.sin_family = AF_INET;
+  server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  server_addr.sin_port = htons(TEST_PORT);
+
+  int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  struct timeval tmo = {.tv_sec = 1, .tv_usec = 0};
+  if (s < 0 || setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tmo,
+                          sizeof(tmo)) < 0) {
+    plat_printf("create client socket error\n");
+    return -1;
+  }
+
+  // 等待回显服务器完成绑定
+  int ready = 0;
+  for (int i = 0; i < 10 && !ready; i++) {
+    batch_fill(0);
+    struct sockaddr_in from;
+    net_socklen_t from_len = sizeof(from);
+    ready = sendto(s, tx_buf[0], TEST_PKT_SIZE, 0,
+                   (const struct sockaddr *)&server_addr,
+                   sizeof(server_addr)) == TEST_PKT_SIZE &&
+            batch_check(0, recvfrom(s, rx_buf[0], TEST_PKT_SIZE, 0,
+                                    (struct sockaddr *)&from, &from_len));
+  }
+  if (!ready) {
+    plat_printf("udp echo server not ready\n");
+    return -1;
+  }
+
+  // 批量接口每轮只需两次工作线程调用, 逐个收发则需要2 * TEST_BATCH次
+  int single = test_run(s, 0, "sendto/recvfrom");
+  int batch = test_run(s, 1, "sendmmsg/recvmmsg");
+  close(s);
+
+  if (single < 0 || batch < 0 || batch <= single) {
+    plat_printf("udp mmsg test failed\n");
+    return -1;
+  }
+  return 0;
+}
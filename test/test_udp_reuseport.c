@@ -0,0 +1,189 @@
+/**
+ * @file test_udp_reuseport.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief udp端口共享测试: 多个服务端线程各自打开一个设置了SO_REUSEPORT的socket并绑定同一端口,
+ *        客户端通过环回接口使用多个不同的源端口(流)发送数据报,
+ *        检查每个数据报都恰好被接收一次, 同一个流的数据报总是由同一个服务端接收,
+ *        且各服务端都分担了部分流; 同时检查未设置SO_REUSEPORT时不能重复绑定
+ * @version 0.1
+ * @date 2024-12-13
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "net.h"
+#include "net_api.h"
+#include "sys_plat.h"
+
+#define TEST_PORT 6012        // 共享的服务端口
+#define TEST_SERVER_CNT 4     // 服务端socket数量
+#define TEST_FLOW_CNT 64      // 客户端流的数量
+#define TEST_FLOW_PKT_CNT 8   // 每个流发送的数据报数量
+#define TEST_PKT_SIZE 32      // 数据报大小
+
+static sys_mutex_t stat_mutex;                 // 保护统计信息
+static int server_sock[TEST_SERVER_CNT];       // 服务端socket
+static int server_recv_cnt[TEST_SERVER_CNT];   // 各服务端接收的数据报数量
+static int flow_owner[TEST_FLOW_CNT];          // 各流的接收者, -1表示还未收到
+static int flow_recv_cnt[TEST_FLOW_CNT];       // 各流被接收的数据报数量
+static int total_recv_cnt;                     // 接收的数据报总数
+static int flow_split;                         // 是否有流被多个服务端接收
+
+/**
+ * @brief 打开一个udp socket并绑定到服务端口
+ *
+ * @param reuseport 是否设置SO_REUSEPORT
+ * @return int socket, 失败时返回-1
+ */
+static int server_open(int reuseport) {
+  int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+  if (s < 0) {
+    return -1;
+  }
+
+  struct sockaddr_in addr;
+  plat_memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = INADDR_ANY;
+  addr.sin_port = htons(TEST_PORT);
+  if ((reuseport && setsockopt(s, SOL_SOCKET, SO_REUSEPORT,
+                               (const char *)&reuseport, sizeof(int)) < 0) ||
+      bind(s, (const struct sockaddr *)&addr, sizeof(addr)) < 0) {
+    close(s);
+    return -1;
+  }
+  return s;
+}
+
+/**
+ * @brief 服务端线程: 接收数据报并记录每个流的接收者
+ *
+ * @param arg 服务端序号
+ */
+static void server_entry(void *arg) {
+  int id = (int)(intptr_t)arg;
+  uint8_t buf[TEST_PKT_SIZE];
+
+  while (1) {
+    struct sockaddr_in from;
+    net_socklen_t from_len = sizeof(from);
+    int len = recvfrom(server_sock[id], buf, sizeof(buf), 0,
+                       (struct sockaddr *)&from, &from_len);
+    if (len != TEST_PKT_SIZE || buf[0] >= TEST_FLOW_CNT) {
+      continue;
+    }
+
+    int flow = buf[0];
+    sys_mutex_lock(stat_mutex);
+    if (flow_owner[flow] < 0) {
+      flow_owner[flow] = id;
+    } else if (flow_owner[flow] != id) {
+      flow_split = 1;
+    }
+    flow_recv_cnt[flow]++;
+    server_recv_cnt[id]++;
+    total_recv_cnt++;
+    sys_mutex_unlock(stat_mutex);
+  }
+}
+
+/**
+ * @brief 获取已接收的数据报总数
+ *
+ * @return int
+ */
+static int recv_total(void) {
+  sys_mutex_lock(stat_mutex);
+  int total = total_recv_cnt;
+  sys_mutex_unlock(stat_mutex);
+  return total;
+}
+
+int main(void) {
+  net_init();
+  net_start();
+
+  stat_mutex = sys_mutex_create();
+  for (int i = 0; i < TEST_FLOW_CNT; i++) {
+    flow_owner[i] = -1;
+  }
+
+  // 设置了SO_REUSEPORT的socket可以绑定同一端口
+  for (int i = 0; i < TEST_SERVER_CNT; i++) {
+    server_sock[i] = server_open(1);
+    if (server_sock[i] < 0) {
+      plat_printf("reuseport bind %d error\n", i);
+      return -1;
+    }
+  }
+
+  // 未设置SO_REUSEPORT的socket不能加入
+  int other = server_open(0);
+  if (other >= 0) {
+    plat_printf("bind without SO_REUSEPORT should fail\n");
+    return -1;
+  }
+
+  for (int i = 0; i < TEST_SERVER_CNT; i++) {
+    sys_thread_create(server_entry, (void *)(intptr_t)i);
+  }
+
+  struct sockaddr_in server_addr;
+  plat_memset(&server_addr, 0, sizeof(server_addr));
+  server_addr.sin_family = AF_INET;
+  server_addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+  server_addr.sin_port = htons(TEST_PORT);
+
+  // 每个流使用一个新的客户端socket, 由协议栈分配不同的源端口
+  uint8_t buf[TEST_PKT_SIZE];
+  for (int flow = 0; flow < TEST_FLOW_CNT; flow++) {
+    int s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s < 0) {
+      plat_printf("create client socket error\n");
+      return -1;
+    }
+
+    for (int i = 0; i < TEST_FLOW_PKT_CNT; i++) {
+      plat_memset(buf, i, sizeof(buf));
+      buf[0] = (uint8_t)flow;
+      if (sendto(s, buf, sizeof(buf), 0, (const struct sockaddr *)&server_addr,
+                 sizeof(server_addr)) != sizeof(buf)) {
+        plat_printf("sendto error\n");
+        return -1;
+      }
+    }
+    close(s);
+
+    // 等待本流的数据报被接收, 避免数据包池耗尽
+    int expect = (flow + 1) * TEST_FLOW_PKT_CNT;
+    for (int i = 0; i < 1000 && recv_total() < expect; i++) {
+      sys_sleep(1);
+    }
+  }
+  sys_sleep(100);
+
+  sys_mutex_lock(stat_mutex);
+  int ok = total_recv_cnt == TEST_FLOW_CNT * TEST_FLOW_PKT_CNT && !flow_split;
+  for (int i = 0; i < TEST_FLOW_CNT; i++) {
+    ok = ok && flow_recv_cnt[i] == TEST_FLOW_PKT_CNT;
+  }
+  int used = 0;
+  for (int i = 0; i < TEST_SERVER_CNT; i++) {
+    plat_printf("udp reuseport: server %d recv %d pkts\n", i,
+                server_recv_cnt[i]);
+    used += server_recv_cnt[i] > 0;
+  }
+  sys_mutex_unlock(stat_mutex);
+
+  plat_printf("udp reuseport: %d flows, %d pkts, %d servers used, split %d\n",
+              TEST_FLOW_CNT, total_recv_cnt, used, flow_split);
+  if (!ok || used != TEST_SERVER_CNT) {
+    plat_printf("udp reuseport test failed\n");
+    return -1;
+  }
+  return 0;
+}
@@ -0,0 +1,463 @@
+/**
+ * @file test_util.c
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 测试公共模块: socket收发辅助函数、监听并逐个处理连接的服务端线程,
+ *        以及模拟传播时延/瓶颈队列/丢包的网络接口(发往指定ip的数据包经过该接口回到本机)
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#include "test_util.h"
+
+#include "ipv4.h"
+#include "netif.h"
+#include "protocol.h"
+#include "tcp.h"
+#include "tools.h"
+
+// 链路中的报文: 在瓶颈队列中为入队时间, 在传播过程中为到达时间
+typedef struct _link_pkt_t {
+  pktbuf_t *buf;
+  int time;
+} link_pkt_t;
+
+// 先进先出的报文队列
+typedef struct _link_queue_t {
+  link_pkt_t pkt[TEST_LINK_PKT_CNT];
+  int head;
+  int cnt;
+  int bytes;
+} link_queue_t;
+
+static test_link_cfg_t link_cfg;    // 模拟链路的配置
+static netif_t *link_netif;         // 模拟链路的网络接口
+static sys_mutex_t link_mutex;      // 保护链路中的队列及统计信息
+static link_queue_t link_btl;       // 瓶颈队列
+static link_queue_t link_wire;      // 正在传播的报文
+static int link_now;                // 链路时钟(ms)
+static test_link_stats_t link_stats;  // 瓶颈队列的统计信息
+
+/**
+ * @brief 初始化ipv4地址结构
+ *
+ * @param addr
+ * @param ip 点分十进制ip地址, 为空表示INADDR_ANY
+ * @param port
+ */
+void test_addr_init(struct sockaddr_in *addr, const char *ip, uint16_t port) {
+  plat_memset(addr, 0, sizeof(struct sockaddr_in));
+  addr->sin_family = AF_INET;
+  addr->sin_addr.s_addr = ip ? inet_addr(ip) : INADDR_ANY;
+  addr->sin_port = htons(port);
+}
+
+/**
+ * @brief 使用已创建(并已设置好选项)的socket连接ip:port
+ *
+ * @param sock
+ * @param ip
+ * @param port
+ * @return int 0: 成功, -1: 失败
+ */
+int test_tcp_connect(int sock, const char *ip, uint16_t port) {
+  struct sockaddr_in addr;
+  test_addr_init(&addr, ip, port);
+  return connect(sock, (const struct sockaddr *)&addr, sizeof(addr)) < 0 ? -1
+                                                                         : 0;
+}
+
+/**
+ * @brief 发送指定长度的数据
+ *
+ * @param sock
+ * @param buf
+ * @param size
+ * @return int 0: 成功, -1: 连接已关闭或出错
+ */
+int test_send_all(int sock, const void *buf, int size) {
+  for (int total = 0; total < size;) {
+    int len = send(sock, (const uint8_t *)buf + total, size - total, 0);
+    if (len <= 0) {
+      return -1;
+    }
+    total += len;
+  }
+  return 0;
+}
+
+/**
+ * @brief 接收指定长度的数据
+ *
+ * @param sock
+ * @param buf
+ * @param size
+ * @return int 0: 成功, -1: 连接已关闭或出错
+ */
+int test_recv_all(int sock, void *buf, int size) {
+  for (int total = 0; total < size;) {
+    int len = recv(sock, (uint8_t *)buf + total, size - total, 0);
+    if (len <= 0) {
+      return -1;
+    }
+    total += len;
+  }
+  return 0;
+}
+
+/**
+ * @brief 读取tcp连接的状态及统计信息(TCP_INFO)
+ *
+ * @param sock
+ * @param info
+ * @return int 0: 成功, -1: 失败
+ */
+int test_tcp_info_get(int sock, struct net_tcp_info *info) {
+  int len = sizeof(struct net_tcp_info);
+  if (getsockopt(sock, SOL_TCP, TCP_INFO, (char *)info, &len) < 0 ||
+      len != sizeof(struct net_tcp_info)) {
+    return -1;
+  }
+  return 0;
+}
+
+/**
+ * @brief 创建监听socket, 绑定到port并开始监听
+ *
+ * @param port
+ * @param setup 监听前设置socket选项, 可为空
+ * @return int 监听socket, 失败时返回-1
+ */
+int test_tcp_listen(uint16_t port, int (*setup)(int sock)) {
+  int sock = socket(AF_INET, SOCK_STREAM, 0);
+  if (sock < 0) {
+    return -1;
+  }
+
+  struct sockaddr_in addr;
+  test_addr_init(&addr, (const char *)0, port);
+  if ((setup && setup(sock) < 0) ||
+      bind(sock, (const struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(sock, 8) < 0) {
+    plat_printf("port %d: bind or listen error\n", port);
+    close(sock);
+    return -1;
+  }
+  return sock;
+}
+
+/**
+ * @brief 服务端线程: 逐个accept连接并交给handle处理, 处理完后关闭连接
+ *
+ * @param arg 服务端结构
+ */
+static void server_entry(void *arg) {
+  test_server_t *server = (test_server_t *)arg;
+
+  server->sock = test_tcp_listen(server->port, server->setup);
+  sys_sem_notify(server->listen_sem);
+  if (server->sock < 0) {
+    return;
+  }
+
+  while (1) {
+    int client = accept(server->sock, (struct sockaddr *)0, (net_socklen_t *)0);
+    if (client < 0) {
+      continue;
+    }
+    server->handle(server, client);
+    close(client);
+    sys_sem_notify(server->done_sem);
+  }
+}
+
+/**
+ * @brief 创建服务端线程, 并等待其开始监听
+ *
+ * @param server 服务端结构, 需先设置port及handle
+ * @return int 0: 成功, -1: 失败
+ */
+int test_server_start(test_server_t *server) {
+  server->sock = -1;
+  server->listen_sem = sys_sem_create(0);
+  server->done_sem = sys_sem_create(0);
+  if (server->listen_sem == SYS_SEM_INVALID ||
+      server->done_sem == SYS_SEM_INVALID ||
+      sys_thread_create(server_entry, (void *)server) == SYS_THREAD_INVALID) {
+    return -1;
+  }
+
+  sys_sem_wait(server->listen_sem, 0);
+  return server->sock < 0 ? -1 : 0;
+}
+
+/**
+ * @brief 等待服务端处理完一个连接
+ *
+ * @param server
+ */
+void test_server_wait(test_server_t *server) {
+  sys_sem_wait(server->done_sem, 0);
+}
+
+/**
+ * @brief 报文入队, 队列已满时返回-1
+ *
+ * @param q
+ * @param buf
+ * @param time
+ * @return int
+ */
+static int link_queue_put(link_queue_t *q, pktbuf_t *buf, int time) {
+  if (q->cnt >= TEST_LINK_PKT_CNT) {
+    return -1;
+  }
+  link_pkt_t *pkt = &q->pkt[(q->head + q->cnt) % TEST_LINK_PKT_CNT];
+  pkt->buf = buf;
+  pkt->time = time;
+  q->cnt++;
+  q->bytes += buf->total_size;
+  return 0;
+}
+
+/**
+ * @brief 报文出队
+ *
+ * @param q
+ * @return link_pkt_t
+ */
+static link_pkt_t link_queue_get(link_queue_t *q) {
+  link_pkt_t pkt = q->pkt[q->head];
+  q->head = (q->head + 1) % TEST_LINK_PKT_CNT;
+  q->cnt--;
+  q->bytes -= pkt.buf->total_size;
+  return pkt;
+}
+
+static net_err_t link_open(netif_t *netif, void *data) {
+  netif->type = NETIF_TYPE_LOOP;  // 不需要链路层处理
+  netif->mtu = NET_MAC_FRAME_MTU;
+  return NET_ERR_OK;
+}
+
+static void link_close(netif_t *netif) {}
+
+/**
+ * @brief 网络接口发送数据包: 先由过滤函数决定报文的去向,
+ *        有瓶颈时报文进入瓶颈队列, 队列满时丢弃; 否则直接开始传播
+ *
+ * @param netif
+ * @return net_err_t
+ */
+static net_err_t link_send(netif_t *netif) {
+  pktbuf_t *buf = netif_sendq_get(netif, -1);  //!!! 获取数据包
+  if (!buf) {
+    return NET_ERR_OK;
+  }
+
+  sys_mutex_lock(link_mutex);
+  int action = link_cfg.filter ? link_cfg.filter(buf) : TEST_LINK_PASS;
+  int err = -1;
+  if (action == TEST_LINK_DIRECT || (action == TEST_LINK_PASS && !link_cfg.rate)) {
+    err = link_queue_put(&link_wire, buf, link_now + link_cfg.delay);
+  } else if (action == TEST_LINK_PASS) {
+    if (link_btl.bytes + buf->total_size > link_cfg.queue_size) {
+      link_stats.drops++;
+    } else {
+      err = link_queue_put(&link_btl, buf, link_now);
+    }
+  }
+  sys_mutex_unlock(link_mutex);
+
+  if (err < 0) {
+    pktbuf_free(buf);  //!!! 释放数据包
+  }
+  return NET_ERR_OK;
+}
+
+/**
+ * @brief 链路线程: 每毫秒按链路速率从瓶颈队列中取出报文开始传播, 并将到达的报文交给网络接口接收
+ *
+ * @param arg
+ */
+static void link_entry(void *arg) {
+  net_time_t time;
+  sys_time_curr(&time);
+  int credit = 0;  // 瓶颈链路当前可发送的字节数
+
+  while (1) {
+    sys_sleep(1);
+    int ms = sys_time_goes(&time);
+
+    link_pkt_t arrived[TEST_LINK_PKT_CNT];
+    int arrived_cnt = 0;
+
+    sys_mutex_lock(link_mutex);
+    link_now += ms;
+    // 空闲时累积的额度限制为两个报文, 保证每个报文都能在额度内发出且不丢失链路速率
+    credit = MIN(credit + link_cfg.rate / 1000 * ms, 2 * NET_MAC_FRAME_MTU);
+    while (link_btl.cnt &&
+           credit >= link_btl.pkt[link_btl.head].buf->total_size) {
+      link_pkt_t pkt = link_queue_get(&link_btl);
+      credit -= pkt.buf->total_size;
+
+      int delay = link_now - pkt.time;
+      link_stats.sent++;
+      link_stats.delay_sum += delay;
+      link_stats.delay_max = MAX(link_stats.delay_max, delay);
+      if (link_queue_put(&link_wire, pkt.buf, link_now + link_cfg.delay) < 0) {
+        pktbuf_free(pkt.buf);  //!!! 释放数据包
+      }
+    }
+    while (link_wire.cnt && link_wire.pkt[link_wire.head].time <= link_now) {
+      arrived[arrived_cnt++] = link_queue_get(&link_wire);
+    }
+    sys_mutex_unlock(link_mutex);
+
+    for (int i = 0; i < arrived_cnt; i++) {
+      if (netif_recvq_put(link_netif, arrived[i].buf, -1) != NET_ERR_OK) {
+        pktbuf_free(arrived[i].buf);  //!!! 释放数据包
+      }
+    }
+  }
+}
+
+/**
+ * @brief 打开模拟链路的网络接口, 需在net_init之后、net_start之前调用
+ *
+ * @param cfg 链路配置
+ * @return int 0: 成功, -1: 失败
+ */
+int test_link_open(const test_link_cfg_t *cfg) {
+  static const netif_ops_t link_ops = {
+      .open = link_open,
+      .close = link_close,
+      .send = link_send,
+  };
+
+  link_cfg = *cfg;
+  link_mutex = sys_mutex_create();
+  link_netif = netif_open(cfg->name, &link_ops, (void *)0);
+  if (!link_netif) {
+    return -1;
+  }
+
+  ipaddr_t ip, mask;
+  ipaddr_from_str(&ip, cfg->ip);
+  ipaddr_from_str(&mask, "255.255.255.0");
+  netif_set_addr(link_netif, &ip, &mask, (ipaddr_t *)0);
+  netif_set_acticve(link_netif);
+
+  sys_thread_create(link_entry, (void *)0);
+  return 0;
+}
+
+/**
+ * @brief 锁定模拟链路, 用于修改过滤函数使用的状态
+ */
+void test_link_lock(void) { sys_mutex_lock(link_mutex); }
+
+/**
+ * @brief 解锁模拟链路
+ */
+void test_link_unlock(void) { sys_mutex_unlock(link_mutex); }
+
+/**
+ * @brief 获取瓶颈队列中积压的字节数, 只能在过滤函数中或锁定链路后调用
+ *
+ * @return int
+ */
+int test_link_queued(void) { return link_btl.bytes; }
+
+/**
+ * @brief 获取瓶颈队列的统计信息
+ *
+ * @param stats
+ * @param reset 获取后是否清零
+ */
+void test_link_stats_get(test_link_stats_t *stats, int reset) {
+  sys_mutex_lock(link_mutex);
+  if (stats) {
+    *stats = link_stats;
+  }
+  if (reset) {
+    plat_memset(&link_stats, 0, sizeof(link_stats));
+  }
+  sys_mutex_unlock(link_mutex);
+}
+
+/**
+ * @brief 解析报文中的tcp头部及时间戳、SACK选项
+ *
+ * @param buf ip数据包
+ * @param seg 解析结果
+ * @return int 0: 成功, -1: 不是tcp报文
+ */
+int test_tcp_parse(pktbuf_t *buf, test_tcp_seg_t *seg) {
+  if (pktbuf_set_cont(buf, sizeof(ipv4_hdr_t) + sizeof(tcp_hdr_t)) !=
+      NET_ERR_OK) {
+    return -1;
+  }
+  uint8_t *ip = pktbuf_data_ptr(buf);
+  int ip_hdr_size = (ip[0] & 0xf) * 4;
+  int tcp_hdr_size = (ip[ip_hdr_size + 12] >> 4) * 4;
+  if (ip[9] != NET_PROTOCOL_TCP ||
+      pktbuf_set_cont(buf, ip_hdr_size + tcp_hdr_size) != NET_ERR_OK) {
+    return -1;
+  }
+
+  ip = pktbuf_data_ptr(buf);
+  uint8_t *tcp = ip + ip_hdr_size;
+  plat_memset(seg, 0, sizeof(test_tcp_seg_t));
+  seg->sport = (tcp[0] << 8) | tcp[1];
+  seg->dport = (tcp[2] << 8) | tcp[3];
+  seg->seq = ((uint32_t)tcp[4] << 24) | (tcp[5] << 16) | (tcp[6] << 8) | tcp[7];
+  seg->ack =
+      ((uint32_t)tcp[8] << 24) | (tcp[9] << 16) | (tcp[10] << 8) | tcp[11];
+  seg->flags = tcp[13];
+  seg->win = (tcp[14] << 8) | tcp[15];
+  seg->len = ((ip[2] << 8) | ip[3]) - ip_hdr_size - tcp_hdr_size;
+  seg->hdr = tcp;
+
+  uint8_t *opt = tcp + sizeof(tcp_hdr_t);
+  uint8_t *end = tcp + tcp_hdr_size;
+  while (opt < end && *opt != TCP_OPT_END) {
+    if (*opt == TCP_OPT_NOP) {
+      opt++;
+      continue;
+    }
+    if (opt + 1 >= end || opt[1] < 2 || opt + opt[1] > end) {
+      break;
+    }
+
+    uint8_t *val = opt + 2;
+    if (*opt == TCP_OPT_TS && opt[1] == sizeof(tcp_opt_ts_t)) {
+      seg->ts = opt;
+      seg->ts_val = ((uint32_t)val[0] << 24) | (val[1] << 16) | (val[2] << 8) |
+                    val[3];
+    } else if (*opt == TCP_OPT_SACK) {
+      for (int i = 0; i < (opt[1] - 2) / 8 && i < 4; i++, val += 8) {
+        for (int j = 0; j < 2; j++) {
+          uint8_t *p = val + j * 4;
+          seg->sack[i][j] =
+              ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+        }
+        seg->sack_cnt++;
+      }
+    }
+    opt += opt[1];
+  }
+  return 0;
+}
+
+/**
+ * @brief 修改tcp头部后调用: 校验和置为0, 接收方不再进行校验
+ *
+ * @param seg
+ */
+void test_tcp_seg_changed(test_tcp_seg_t *seg) {
+  seg->hdr[16] = 0;
+  seg->hdr[17] = 0;
+}
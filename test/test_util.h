@@ -0,0 +1,100 @@
+/**
+ * @file test_util.h
+ * @author kbpoyo (kbpoyo@qq.com)
+ * @brief 测试公共模块: socket收发辅助函数、监听并逐个处理连接的服务端线程,
+ *        以及模拟传播时延/瓶颈队列/丢包的网络接口(发往指定ip的数据包经过该接口回到本机)
+ * @version 0.1
+ * @date 2024-12-14
+ *
+ * @copyright Copyright (c) 2024
+ *
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdint.h>
+
+#include "net_api.h"
+#include "pktbuf.h"
+#include "sys_plat.h"
+
+#define TEST_LINK_PKT_CNT 256  // 模拟链路的每个队列可同时容纳的报文数量
+
+// 链路过滤函数的返回值: 报文的去向
+#define TEST_LINK_PASS 0    // 经过瓶颈队列(若有)后传播
+#define TEST_LINK_DROP 1    // 丢弃
+#define TEST_LINK_DIRECT 2  // 不经过瓶颈队列, 直接开始传播
+
+// 定义服务端结构: 服务端线程监听port, 每accept一个连接交给handle处理,
+// handle返回后关闭该连接并通知done_sem
+typedef struct _test_server_t test_server_t;
+struct _test_server_t {
+  uint16_t port;                                  // 监听端口
+  int (*setup)(int sock);                         // 监听前设置socket选项, 可为空
+  void (*handle)(test_server_t *server, int client);  // 处理一个已建立的连接
+
+  int sock;               // 监听socket
+  sys_sem_t listen_sem;   // 监听socket就绪信号
+  sys_sem_t done_sem;     // 处理完一个连接的信号
+};
+
+// 定义模拟链路的配置
+typedef struct _test_link_cfg_t {
+  const char *name;  // 网络接口名称
+  const char *ip;    // 网络接口的ip地址, 发往该网段的数据包经过模拟链路
+  int delay;         // 单向传播时延(ms)
+  int rate;          // 瓶颈链路速率(字节/s), 0表示没有瓶颈队列
+  int queue_size;    // 瓶颈队列容量(字节)
+  int (*filter)(pktbuf_t *buf);  // 报文进入链路前调用(链路已加锁), 返回TEST_LINK_*, 可为空
+} test_link_cfg_t;
+
+// 定义模拟链路瓶颈队列的统计信息
+typedef struct _test_link_stats_t {
+  int drops;          // 瓶颈队列满而丢弃的报文数
+  int sent;           // 通过瓶颈的报文数
+  int64_t delay_sum;  // 报文在瓶颈队列中的排队时延之和(ms)
+  int delay_max;      // 最大排队时延(ms)
+} test_link_stats_t;
+
+// 定义从报文中解析出的tcp头部信息
+typedef struct _test_tcp_seg_t {
+  uint16_t sport;         // 源端口
+  uint16_t dport;         // 目的端口
+  uint32_t seq;           // 序号
+  uint32_t ack;           // 确认号
+  uint8_t flags;          // 标志位(tcp头部第13字节)
+  uint16_t win;           // 通告的窗口
+  int len;                // 数据长度
+  uint8_t *hdr;           // tcp头部, 修改后需调用test_tcp_seg_changed
+  uint8_t *ts;            // 时间戳选项, 不存在时为空
+  uint32_t ts_val;        // 时间戳
+  int sack_cnt;           // SACK块的数量
+  uint32_t sack[4][2];    // SACK块[start, end)
+} test_tcp_seg_t;
+
+#define TEST_TCP_FIN 0x01
+#define TEST_TCP_SYN 0x02
+#define TEST_TCP_RST 0x04
+#define TEST_TCP_ACK 0x10
+
+void test_addr_init(struct sockaddr_in *addr, const char *ip, uint16_t port);
+int test_tcp_connect(int sock, const char *ip, uint16_t port);
+int test_send_all(int sock, const void *buf, int size);
+int test_recv_all(int sock, void *buf, int size);
+int test_tcp_info_get(int sock, struct net_tcp_info *info);
+
+int test_tcp_listen(uint16_t port, int (*setup)(int sock));
+int test_server_start(test_server_t *server);
+void test_server_wait(test_server_t *server);
+
+int test_link_open(const test_link_cfg_t *cfg);
+void test_link_lock(void);
+void test_link_unlock(void);
+int test_link_queued(void);
+void test_link_stats_get(test_link_stats_t *stats, int reset);
+
+int test_tcp_parse(pktbuf_t *buf, test_tcp_seg_t *seg);
+void test_tcp_seg_changed(test_tcp_seg_t *seg);
+
+#endif  // TEST_UTIL_H